@@ -1670,7 +1670,29 @@ async function deriveSessionKeys(serverPrivPkcs8, clientPubRaw, salt) {
   // pre-deploy tokens until they expire.
   const masterBytes = await hkdf(shared, "enc:master-aes", 32, salt);
   const hmacBytes = await hkdf(shared, "enc:req-hmac", 32, salt);
-  return { masterBytes, hmacBytes };
+  // AES-256-CTR session (token requested with cipher="aes-ctr"): key plus
+  // the 8-byte counter-block prefix, for clients that decrypt in WASM
+  const ctrKeyBytes = await hkdf(shared, "enc:master-ctr", 32, salt);
+  const ctrNonce = await hkdf(shared, "enc:ctr-nonce", 8, salt);
+  return { masterBytes, hmacBytes, ctrKeyBytes, ctrNonce };
+}
+
+// AES-256-CTR over `plaintext` sitting at file offset `offset`. The counter
+// block is ctrNonce || 64-bit BE index of the 16-byte block holding the
+// offset, so the client can start decrypting at any offset (movi_crypt.c).
+async function aesCtrAt(key, nonce, offset, plaintext) {
+  const skip = offset % 16;
+  const counter = new Uint8Array(16);
+  counter.set(nonce);
+  new DataView(counter.buffer).setBigUint64(8, BigInt(Math.floor(offset / 16)));
+  const padded = new Uint8Array(skip + plaintext.length);
+  padded.set(plaintext, skip);
+  const ct = await crypto.subtle.encrypt(
+    { name: "AES-CTR", counter, length: 64 },
+    key,
+    padded,
+  );
+  return new Uint8Array(ct, skip);
 }
 
 function constantTimeEqual(a, b) {
@@ -1821,6 +1843,7 @@ async function handleEncToken(request, env) {
     return jsonResponse({ error: "Invalid JSON body" }, 400);
   }
   const { fingerprint, clientPubKey } = body || {};
+  const ctr = body?.cipher === "aes-ctr";
   const rawUrl = body?.url || body?.videoId;
   if (!rawUrl || !fingerprint || !clientPubKey) {
     return jsonResponse(
@@ -1905,6 +1928,7 @@ async function handleEncToken(request, env) {
     wrappedServerPriv, // AES-wrapped with the current wrap epoch's key
     wrapEpoch,         // which rotating wrap key sealed wrappedServerPriv
     hkdfSalt: hkdfSaltB64, // per-token HKDF salt for session key derivation
+    ...(ctr ? { cipher: "aes-ctr" } : {}), // CTR frames instead of AES-GCM
   };
   const payloadB64 = b64urlEncode(new TextEncoder().encode(JSON.stringify(payload)));
   const sig = await hmacSha256Hex(env.ENC_SERVER_SECRET, payloadB64);
@@ -1931,6 +1955,8 @@ async function handleEncToken(request, env) {
       // payload copy so a network attacker can't substitute a different
       // salt on either side.
       hkdfSalt: hkdfSaltB64,
+      // Echoed when the CTR session was granted; absent = AES-GCM frames
+      ...(ctr ? { cipher: "aes-ctr" } : {}),
     }),
     {
       headers: {
@@ -2015,6 +2041,8 @@ async function handleEncVideo(request, env) {
   // window the unwrap helper throws and we return the generic error.
   let masterBytes;
   let hmacBytes;
+  let ctrKeyBytes;
+  let ctrNonce;
   try {
     const serverPrivPkcs8 = await unwrapServerPriv(
       payload.wrappedServerPriv,
@@ -2031,6 +2059,8 @@ async function handleEncVideo(request, env) {
     const derived = await deriveSessionKeys(serverPrivPkcs8, clientPubRaw, saltBytes);
     masterBytes = derived.masterBytes;
     hmacBytes = derived.hmacBytes;
+    ctrKeyBytes = derived.ctrKeyBytes;
+    ctrNonce = derived.ctrNonce;
   } catch (err) {
     return jsonResponse({ error: "Key derivation failed" }, 400);
   }
@@ -2176,11 +2206,18 @@ async function handleEncVideo(request, env) {
   // Repeated for every frame until the upstream stream closes. Frame
   // length is bounded so the worker's memory per decrypt stays < 3MB
   // regardless of how large the client's requested range is.
+  //
+  // A CTR session (payload.cipher) frames bare ciphertext instead:
+  //
+  //   [4-byte BE length of ciphertext][AES-256-CTR ciphertext]
+  //
+  // with the counter at each frame's file offset (aesCtrAt).
   const FRAME_PLAINTEXT = 2 * 1024 * 1024;
+  const ctr = payload.cipher === "aes-ctr";
   const aesKey = await crypto.subtle.importKey(
     "raw",
-    masterBytes,
-    { name: "AES-GCM" },
+    ctr ? ctrKeyBytes : masterBytes,
+    { name: ctr ? "AES-CTR" : "AES-GCM" },
     false,
     ["encrypt"],
   );
@@ -2189,7 +2226,7 @@ async function handleEncVideo(request, env) {
     "Content-Type": "application/octet-stream",
     "Cache-Control": "no-store, no-cache",
     "Cross-Origin-Resource-Policy": "cross-origin",
-    "X-Enc-Envelope": "aes-gcm-framed-iv12-tag16",
+    "X-Enc-Envelope": ctr ? "aes-ctr-framed" : "aes-gcm-framed-iv12-tag16",
     "X-Enc-Frame-Size": String(FRAME_PLAINTEXT),
     ...CORS_HEADERS,
   });
@@ -2250,8 +2287,21 @@ async function handleEncVideo(request, env) {
       // to be framed and pushed to the response stream.
       const pipeline = [];
 
+      // File offset of the next frame's first byte (CTR counter position)
+      let frameOffset = start;
+
       const kickEncrypt = (plaintext) => {
         if (plaintext.length === 0) return;
+        if (ctr) {
+          pipeline.push(
+            aesCtrAt(aesKey, ctrNonce, frameOffset, plaintext).then((ct) => ({
+              iv: null,
+              ctTag: ct,
+            })),
+          );
+          frameOffset += plaintext.length;
+          return;
+        }
         const iv = crypto.getRandomValues(new Uint8Array(12));
         const p = crypto.subtle
           .encrypt({ name: "AES-GCM", iv }, aesKey, plaintext)
@@ -2262,10 +2312,12 @@ async function handleEncVideo(request, env) {
       const drainOneFrame = async () => {
         const { iv, ctTag } = await pipeline.shift();
         const header = new Uint8Array(4);
-        // Big-endian length of (IV + ciphertext + tag).
-        new DataView(header.buffer).setUint32(0, iv.length + ctTag.length, false);
+        // Big-endian length of (IV + ciphertext + tag); CTR frames have
+        // neither IV nor tag.
+        const ivLength = iv ? iv.length : 0;
+        new DataView(header.buffer).setUint32(0, ivLength + ctTag.length, false);
         controller.enqueue(header);
-        controller.enqueue(iv);
+        if (iv) controller.enqueue(iv);
         controller.enqueue(ctTag);
       };
 
@@ -2,39 +2,94 @@
 set -e
 
 DAV1D_SRC=/opt/dav1d
-DAV1D_PREFIX=/src/dist/dav1d
 
-# Build dav1d for WASM (software AV1 decoder)
-if [ -z "$FORCE_DAV1D" ] && [ -f "${DAV1D_PREFIX}/lib/libdav1d.a" ]; then
-    echo "=== dav1d library found, skipping build (set FORCE_DAV1D=true to rebuild) ==="
-else
-    echo "=== Building dav1d for WASM ==="
-    
+# ---- Build flavors ---------------------------------------------------------
+# Every flavor links the same wasm/*.c(pp) sources against its own dav1d +
+# FFmpeg build, so the libraries are installed to per-flavor prefixes and the
+# "skip if already built" cache works per flavor.
+#
+#   st — single-threaded, size-optimized (dist/wasm/movi.js). Always built;
+#        it's what the bundles import statically and the universal fallback.
+#   simd — WASM SIMD128, -O3 (dist/wasm/movi-simd.js). Speed over size: no
+#        --enable-small, compiler autovectorization across dav1d/swscale/
+#        swresample, FFmpeg's wasm simd128 kernels where the FFmpeg tree has
+#        them, and movi's own SIMD YUV→RGBA path. FFmpegLoader picks it when
+#        WebAssembly.validate accepts a SIMD module. Skip with MOVI_BUILD_SIMD=0.
+#   mt — pthreads + SharedArrayBuffer + SIMD128 (dist/wasm/movi-mt.js). Lets
+#        the software decoders run frame/slice threads. Only usable on a
+#        cross-origin-isolated page; FFmpegLoader picks it at runtime and falls
+#        back to `simd`/`st` otherwise. Skip with MOVI_BUILD_MT=0.
+#   stretch — Signalsmith Stretch alone, no FFmpeg and no Emscripten JS glue
+#        (dist/wasm/movi-stretch.wasm). Instantiated inside the movi-pcm-ring
+#        AudioWorklet so time-stretch runs on the audio thread. Built twice:
+#        scalar and SIMD128 (movi-stretch-simd.wasm, picked when the engine
+#        validates SIMD). Skip with MOVI_BUILD_STRETCH=0.
+#
+# MOVI_BUILD_BENCH=1 additionally builds wasm/bench/stretch_bench.cpp for node,
+# scalar and SIMD128, and runs both (movi_stretch_process throughput for 1, 2,
+# 6 and 8 channels). It also links the core for node (simd flavor when built,
+# with MOVI_STATS) and runs wasm/bench/movi_bench.mjs over the clips of
+# wasm/bench/corpus/ (make-corpus.sh), writing dist/bench/movi-bench.json.
+# MOVI_BENCH_BASELINE=<json> compares against an earlier run and fails the
+# build on regressions.
+#
+# MOVI_BUILD_STATS=1 compiles the per-stage counters and latency histograms
+# (wasm/movi_stats.c, -DMOVI_STATS) into every movi flavor. Off by default: the
+# exports stay, but movi_get_stats reports the module as uninstrumented.
+MOVI_BUILD_SIMD=${MOVI_BUILD_SIMD:-1}
+MOVI_BUILD_MT=${MOVI_BUILD_MT:-1}
+MOVI_BUILD_STRETCH=${MOVI_BUILD_STRETCH:-1}
+MOVI_BUILD_BENCH=${MOVI_BUILD_BENCH:-0}
+MOVI_BUILD_STATS=${MOVI_BUILD_STATS:-0}
+
+# Pre-spawned pthread workers for the mt flavor. Workers can't be created while
+# the main thread is blocked inside a decode call, so the pool must already
+# cover the largest thread count JS asks for (SoftwareVideoDecoder caps it at
+# 4 frame threads) plus dav1d's own per-tile/per-frame workers, plus the 3
+# row-band helpers of the RGBA conversion (movi_tonemap.c), plus the decode and
+# convert threads of one software decode pipeline (movi_pipeline.c).
+# movi_set_decoder_threads clamps to what's left (MOVI_PTHREAD_POOL_SIZE).
+MT_POOL_SIZE=${MT_POOL_SIZE:-13}
+
+# build_dav1d <prefix> <opt-level> <flavor-cflags...>
+build_dav1d() {
+    local prefix=$1
+    local opt=$2
+    shift 2
+    local flavor_args=""
+    for a in "$@"; do flavor_args="${flavor_args}, '${a}'"; done
+
+    if [ -z "$FORCE_DAV1D" ] && [ -f "${prefix}/lib/libdav1d.a" ]; then
+        echo "=== dav1d found at ${prefix}, skipping build (set FORCE_DAV1D=true to rebuild) ==="
+        return
+    fi
+    echo "=== Building dav1d for WASM (${prefix}) ==="
+
     cd ${DAV1D_SRC}
-    
+
     # Clean previous build
     rm -rf build || true
-    
+
     # Create Emscripten cross-file for meson
-    cat > /tmp/emscripten.txt << 'EOF'
+    cat > /tmp/emscripten.txt << CROSS
 [binaries]
 c = 'emcc'
 cpp = 'em++'
 ar = 'emar'
 strip = 'emstrip'
 [built-in options]
-c_args = ['-Oz', '-flto', '-D_FILE_OFFSET_BITS=64']
-c_link_args = ['-Oz', '-flto']
+c_args = ['${opt}', '-flto', '-D_FILE_OFFSET_BITS=64'${flavor_args}]
+c_link_args = ['${opt}', '-flto'${flavor_args}]
 [host_machine]
 system = 'emscripten'
 cpu_family = 'wasm32'
 cpu = 'wasm32'
 endian = 'little'
-EOF
+CROSS
 
     # Configure dav1d for WASM
     meson setup build \
-        --prefix=${DAV1D_PREFIX} \
+        --prefix=${prefix} \
         --cross-file=/tmp/emscripten.txt \
         --default-library=static \
         --buildtype=release \
@@ -42,69 +97,94 @@ EOF
         -Denable_tools=false \
         -Denable_tests=false \
         -Denable_examples=false
-    
+
     echo "=== Compiling dav1d ==="
     ninja -C build
-    
+
     echo "=== Installing dav1d ==="
     ninja -C build install
+}
 
-    # Strip PTHREADS flags from dav1d pkg-config — dav1d auto-enables threads
-    # for Emscripten but our WASM build uses USE_PTHREADS=0, causing FFmpeg
-    # configure to fail on conflicting flags.
-    sed -i 's/-s USE_PTHREADS=[0-9]*//g; s/-s PTHREAD_POOL_SIZE=[0-9]*//g' \
-        "${DAV1D_PREFIX}/lib/pkgconfig/dav1d.pc"
-fi
+# build_ffmpeg <prefix> <dav1d-prefix> <opt-level> <flavor-cflags>
+build_ffmpeg() {
+    local prefix=$1
+    local dav1d_prefix=$2
+    local opt=$3
+    local flavor_cflags=$4
+    local thread_flags="--disable-pthreads"
+    case "$flavor_cflags" in
+        *-pthread*) thread_flags="--enable-pthreads" ;;
+    esac
+    # Size flavor keeps --enable-small; speed flavors drop it (it swaps
+    # unrolled/table-driven code for smaller, slower loops).
+    local size_flags="--enable-small"
+    [ "$opt" = "-Oz" ] || size_flags=""
+    # x86_32 + --disable-asm is the historical "generic C" target. For SIMD
+    # flavors, trees that know the wasm arch (FFmpeg >= 7.1: hevc IDCT/SAO
+    # simd128 kernels) get --arch=wasm with only simd128 enabled; older trees
+    # keep the generic target and rely on -msimd128 autovectorization.
+    local arch_flags="--arch=x86_32 --disable-asm"
 
-ls -R /src/dist/ffmpeg/lib || echo "Directory not found"
-if [ -z "$FORCE_FFMPEG" ] && [ -f "/src/dist/ffmpeg/lib/libavformat.a" ]; then
-    if [ -d "${FFMPEG_SRC}" ]; then
-        echo "FFmpeg Source Version:"
-        cd ${FFMPEG_SRC} && (git describe --tags --always || echo "Unknown (git describe failed)")
-        cd - > /dev/null
+    ls -R ${prefix}/lib || echo "Directory not found"
+    if [ -z "$FORCE_FFMPEG" ] && [ -f "${prefix}/lib/libavformat.a" ]; then
+        if [ -d "${FFMPEG_SRC}" ]; then
+            echo "FFmpeg Source Version:"
+            cd ${FFMPEG_SRC} && (git describe --tags --always || echo "Unknown (git describe failed)")
+            cd - > /dev/null
+        fi
+        echo "=== FFmpeg found at ${prefix}, skipping build (set FORCE_FFMPEG=true to rebuild) ==="
+        return
     fi
-    echo "=== FFmpeg libraries found, skipping build (set FORCE_FFMPEG=true to rebuild) ==="
-else
-    echo "=== Building FFmpeg for WASM (with libdav1d) ==="
-    
+    echo "=== Building FFmpeg for WASM (with libdav1d, ${prefix}) ==="
+
     cd ${FFMPEG_SRC}
-    
+
+    case "$flavor_cflags" in
+        *-msimd128*)
+            if ./configure --help | grep -q -- "--disable-simd128"; then
+                arch_flags="--arch=wasm --disable-inline-asm --disable-x86asm --enable-simd128"
+            fi
+            ;;
+    esac
+
     # Clean previous build
     make clean 2>/dev/null || true
     make distclean 2>/dev/null || true
 
     # Set PKG_CONFIG_PATH so FFmpeg can find dav1d
-    export PKG_CONFIG_PATH="${DAV1D_PREFIX}/lib/pkgconfig:${PKG_CONFIG_PATH}"
-    
+    export PKG_CONFIG_PATH="${dav1d_prefix}/lib/pkgconfig:${PKG_CONFIG_PATH}"
+
     # Debug: verify pkg-config can find dav1d
     echo "=== Verifying dav1d pkg-config ==="
     pkg-config --libs --cflags dav1d || echo "WARNING: pkg-config cannot find dav1d"
-    
-    # Configure FFmpeg for WASM with size optimizations
+
+    # Configure FFmpeg for WASM (st flavor: size optimizations)
     # Using libdav1d for AV1 - pure software decoder that works in WASM
-    # -Oz: Maximum size optimization (instead of -O3 speed)
-    # --enable-small: Trade speed for size
+    # -Oz: Maximum size optimization (simd/mt flavors: -O3 speed)
+    # --enable-small: Trade speed for size (st flavor only)
     # -flto: Link-time optimization
+    # pthreads: --disable-autodetect would drop them silently, so the thread
+    # backend is chosen explicitly per flavor.
     # Note: Using --pkg-config to use native pkg-config, and EM_PKG_CONFIG_PATH for emscripten
-    EM_PKG_CONFIG_PATH="${DAV1D_PREFIX}/lib/pkgconfig" \
-    PKG_CONFIG_PATH="${DAV1D_PREFIX}/lib/pkgconfig" \
+    EM_PKG_CONFIG_PATH="${dav1d_prefix}/lib/pkgconfig" \
+    PKG_CONFIG_PATH="${dav1d_prefix}/lib/pkgconfig" \
     emconfigure ./configure \
         --pkg-config=pkg-config \
-        --prefix=/src/dist/ffmpeg \
+        --prefix=${prefix} \
         --target-os=none \
-        --arch=x86_32 \
+        ${arch_flags} \
         --cc=emcc \
         --cxx=em++ \
         --ar=emar \
         --ranlib=emranlib \
         --nm=emnm \
         --disable-all \
-        --disable-asm \
         --disable-debug \
         --disable-programs \
         --disable-doc \
         --disable-autodetect \
-        --enable-small \
+        ${thread_flags} \
+        ${size_flags} \
         --enable-zlib \
         --enable-avcodec \
         --enable-avformat \
@@ -117,15 +197,46 @@ else
         --enable-decoder=h264,hevc,vp9,vp8,libdav1d,vvc,apv,mpeg1video,mpeg2video,mpeg4,h261,h263,h263p,mjpeg,dvvideo,theora,aac,aac_latm,mp3,mp2,mp1,opus,vorbis,flac,ac3,eac3,dca,truehd,mlp,pcm_s16le,pcm_s24le,pcm_s16be,pcm_f32le,pcm_mulaw,pcm_alaw,subrip,ass,ssa,mov_text,pgssub,dvbsub,dvdsub,webvtt,srt \
         --enable-parser=h264,hevc,vp8,vp9,av1,vvc,apv,lcevc,mpeg4video,mpegvideo,h261,h263,mjpeg,aac,mp3,opus,vorbis,flac,hdmv_pgs_subtitle \
         --enable-bsf=aac_adtstoasc,h264_mp4toannexb,hevc_mp4toannexb,vvc_mp4toannexb,vvc_metadata,av1_metadata,av1_frame_merge,av1_frame_split,lcevc_metadata,pgs_frame_merge,iso_media_metadata_manipulator,extract_extradata,vp9_superframe \
-        --extra-cflags="-Oz -flto -s USE_PTHREADS=0 -s USE_ZLIB=1 -D_FILE_OFFSET_BITS=64 -I${DAV1D_PREFIX}/include" \
-        --extra-cxxflags="-Oz -flto -s USE_ZLIB=1 -D_FILE_OFFSET_BITS=64 -I${DAV1D_PREFIX}/include" \
-        --extra-ldflags="-s WASM=1 -s USE_ZLIB=1 -Oz -flto -L${DAV1D_PREFIX}/lib"
+        --extra-cflags="${opt} -flto ${flavor_cflags} -s USE_ZLIB=1 -D_FILE_OFFSET_BITS=64 -I${dav1d_prefix}/include" \
+        --extra-cxxflags="${opt} -flto ${flavor_cflags} -s USE_ZLIB=1 -D_FILE_OFFSET_BITS=64 -I${dav1d_prefix}/include" \
+        --extra-ldflags="-s WASM=1 -s USE_ZLIB=1 ${opt} -flto ${flavor_cflags} -L${dav1d_prefix}/lib"
 
     echo "=== Compiling FFmpeg ==="
     emmake make -j$(nproc)
 
     echo "=== Installing FFmpeg ==="
     emmake make install
+}
+
+# ---- st flavor libraries ----------------------------------------------------
+DAV1D_PREFIX=/src/dist/dav1d
+FFMPEG_PREFIX=/src/dist/ffmpeg
+build_dav1d ${DAV1D_PREFIX} -Oz
+# Strip PTHREADS flags from dav1d pkg-config — dav1d auto-enables threads
+# for Emscripten but our WASM build uses USE_PTHREADS=0, causing FFmpeg
+# configure to fail on conflicting flags.
+sed -i 's/-s USE_PTHREADS=[0-9]*//g; s/-s PTHREAD_POOL_SIZE=[0-9]*//g' \
+    "${DAV1D_PREFIX}/lib/pkgconfig/dav1d.pc"
+build_ffmpeg ${FFMPEG_PREFIX} ${DAV1D_PREFIX} -Oz "-s USE_PTHREADS=0"
+
+# ---- simd flavor libraries --------------------------------------------------
+DAV1D_SIMD_PREFIX=/src/dist/dav1d-simd
+FFMPEG_SIMD_PREFIX=/src/dist/ffmpeg-simd
+if [ "$MOVI_BUILD_SIMD" != "0" ]; then
+    build_dav1d ${DAV1D_SIMD_PREFIX} -O3 -msimd128
+    sed -i 's/-s USE_PTHREADS=[0-9]*//g; s/-s PTHREAD_POOL_SIZE=[0-9]*//g' \
+        "${DAV1D_SIMD_PREFIX}/lib/pkgconfig/dav1d.pc"
+    build_ffmpeg ${FFMPEG_SIMD_PREFIX} ${DAV1D_SIMD_PREFIX} -O3 "-msimd128 -s USE_PTHREADS=0"
+fi
+
+# ---- mt flavor libraries ----------------------------------------------------
+# dav1d keeps its pthread flags here: its pkg-config -pthread is exactly what
+# the threaded FFmpeg configure wants.
+DAV1D_MT_PREFIX=/src/dist/dav1d-mt
+FFMPEG_MT_PREFIX=/src/dist/ffmpeg-mt
+if [ "$MOVI_BUILD_MT" != "0" ]; then
+    build_dav1d ${DAV1D_MT_PREFIX} -O3 -msimd128 -pthread
+    build_ffmpeg ${FFMPEG_MT_PREFIX} ${DAV1D_MT_PREFIX} -O3 "-msimd128 -pthread"
 fi
 
 echo "=== Building movi WASM module ==="
@@ -155,69 +266,177 @@ mkdir -p /src/dist/wasm
 # Signalsmith Stretch wrapper. em++ on .c files defaults them to C++ which
 # breaks the existing FFmpeg-side code (EM_JS extern "C" mismatches, implicit
 # void* casts), so a single-step build doesn't work.
-OBJDIR=/tmp/movi-objs
-rm -rf "$OBJDIR"
-mkdir -p "$OBJDIR"
-
-C_COMMON_FLAGS=(
-    -I/src/dist/ffmpeg/include
-    -I${DAV1D_PREFIX}/include
-    -Oz -flto -D_FILE_OFFSET_BITS=64
-)
-CXX_COMMON_FLAGS=(
-    -I/src/wasm/signalsmith/signalsmith-stretch/include
-    -I/src/wasm/signalsmith/signalsmith-linear/include
-    -std=c++17 -fno-exceptions -fno-rtti
-    -Oz -flto
-)
-
-for f in /src/wasm/*.c; do
-    emcc "$f" -c -o "$OBJDIR/$(basename "$f" .c).o" "${C_COMMON_FLAGS[@]}"
-done
-for f in /src/wasm/*.cpp; do
-    em++ "$f" -c -o "$OBJDIR/$(basename "$f" .cpp).o" "${CXX_COMMON_FLAGS[@]}"
-done
-
-em++ "$OBJDIR"/*.o \
-    -L/src/dist/ffmpeg/lib \
-    -L${DAV1D_PREFIX}/lib \
-    -lavformat -lavcodec -ldav1d -lavutil -lswresample -lswscale \
-    -Oz \
-    -flto \
-    -fno-exceptions \
-    -fno-rtti \
-    -D_FILE_OFFSET_BITS=64 \
-    -s WASM=1 \
-    -s EXPORT_ES6=1 \
-    -s MODULARIZE=1 \
-    -s EXPORT_NAME="createMoviModule" \
-    -s ENVIRONMENT=web,worker \
-    -s INITIAL_MEMORY=256MB \
-    -s MAXIMUM_MEMORY=4GB \
-    -s ALLOW_MEMORY_GROWTH=1 \
-    -s ASYNCIFY=1 \
-    -s ASYNCIFY_STACK_SIZE=524288 \
-    -s "ASYNCIFY_ADD=['movi_open','movi_read_frame','movi_seek_to','movi_thumbnail_open','movi_thumbnail_read_keyframe','movi_prefetch_subtitle_cues']" \
-    -s "ASYNCIFY_IMPORTS=['js_read_async','js_seek_async','js_thumbnail_packet_ready']" \
-    -s EXPORTED_RUNTIME_METHODS='["ccall", "cwrap", "FS", "stringToNewUTF8", "UTF8ToString", "lengthBytesUTF8", "addFunction", "HEAPU8", "HEAPF32"]' \
-    -s EXPORTED_FUNCTIONS='["_malloc", "_free", "_movi_create", "_movi_destroy", "_movi_open", "_movi_read_frame", "_movi_seek_to", "_movi_get_duration", "_movi_get_start_time", "_movi_get_stream_count", "_movi_get_stream_info", "_movi_get_extradata", "_movi_set_log_level", "_movi_set_file_size", "_movi_enable_decoder", "_movi_set_stream_discard", "_movi_send_packet", "_movi_receive_frame", "_movi_decode_audio_batch", "_movi_audio_batch_samples", "_movi_audio_batch_channels", "_movi_audio_batch_sample_rate", "_movi_audio_batch_pts", "_movi_audio_batch_plane", "_movi_decode_subtitle", "_movi_get_subtitle_text", "_movi_get_subtitle_times", "_movi_get_subtitle_image_info", "_movi_get_subtitle_image_data", "_movi_free_subtitle", "_movi_prefetch_subtitle_cues", "_movi_get_prefetched_cue_count", "_movi_get_prefetched_cue", "_movi_clear_prefetched_cues", "_movi_get_frame_width", "_movi_get_frame_height", "_movi_get_frame_format", "_movi_get_frame_linesize", "_movi_get_frame_data", "_movi_get_frame_samples", "_movi_get_frame_channels", "_movi_get_frame_sample_rate", "_movi_enable_audio_downmix", "_movi_thumbnail_create", "_movi_thumbnail_destroy", "_movi_thumbnail_open", "_movi_thumbnail_read_keyframe", "_movi_thumbnail_get_packet_data", "_movi_thumbnail_decode_frame", "_movi_thumbnail_decode_frame_yuv", "_movi_thumbnail_get_plane_data", "_movi_thumbnail_get_plane_linesize", "_movi_thumbnail_get_frame_width", "_movi_thumbnail_get_frame_height", "_movi_thumbnail_clear_buffer", "_movi_thumbnail_get_extradata", "_movi_thumbnail_get_stream_info", "_movi_stretch_new", "_movi_stretch_delete", "_movi_stretch_reset", "_movi_stretch_set_transpose_semitones", "_movi_stretch_input_latency", "_movi_stretch_output_latency", "_movi_stretch_process"]' \
-    -s ASSERTIONS=0 \
-    -s DISABLE_EXCEPTION_THROWING=1 \
-    -s ALLOW_TABLE_GROWTH=1 \
-    -s INVOKE_RUN=0 \
-    -s SINGLE_FILE=1 \
-    -s LEGACY_RUNTIME=0 \
-    -g0 \
-    -s MINIFY_HTML=0 \
-    -s ELIMINATE_DUPLICATE_FUNCTIONS=1 \
-    -s STACK_OVERFLOW_CHECK=0 \
-    -s TEXTDECODER=2 \
-    -s SUPPORT_LONGJMP=0 \
-    -s SUPPORT_ERRNO=0 \
-    -sUSE_ZLIB=1 \
-    --closure 0 \
-    --js-library /src/wasm/library_movi.js \
-    -o /src/dist/wasm/movi.js
+#
+# link_movi <output.js> <ffmpeg-prefix> <dav1d-prefix> <opt-level> <flavor-cflags> [extra link flags...]
+link_movi() {
+    local output=$1
+    local ffmpeg_prefix=$2
+    local dav1d_prefix=$3
+    local opt=$4
+    local flavor_cflags=$5
+    shift 5
+
+    local objdir=/tmp/movi-objs-$(basename "$output" .js)
+    rm -rf "$objdir"
+    mkdir -p "$objdir"
+
+    local c_common_flags=(
+        -I${ffmpeg_prefix}/include
+        -I${dav1d_prefix}/include
+        ${opt} -flto -D_FILE_OFFSET_BITS=64
+        ${flavor_cflags}
+    )
+    if [ "$MOVI_BUILD_STATS" != "0" ]; then
+        c_common_flags+=(-DMOVI_STATS)
+    fi
+    local cxx_common_flags=(
+        -I/src/wasm/signalsmith/signalsmith-stretch/include
+        -I/src/wasm/signalsmith/signalsmith-linear/include
+        -std=c++17 -fno-exceptions -fno-rtti
+        ${opt} -flto
+        ${flavor_cflags}
+    )
+
+    for f in /src/wasm/*.c; do
+        emcc "$f" -c -o "$objdir/$(basename "$f" .c).o" "${c_common_flags[@]}"
+    done
+    for f in /src/wasm/*.cpp; do
+        em++ "$f" -c -o "$objdir/$(basename "$f" .cpp).o" "${cxx_common_flags[@]}"
+    done
+
+    em++ "$objdir"/*.o \
+        -L${ffmpeg_prefix}/lib \
+        -L${dav1d_prefix}/lib \
+        -lavformat -lavcodec -ldav1d -lavutil -lswresample -lswscale \
+        ${opt} \
+        -flto \
+        -fno-exceptions \
+        -fno-rtti \
+        -D_FILE_OFFSET_BITS=64 \
+        ${flavor_cflags} \
+        -s WASM=1 \
+        -s EXPORT_ES6=1 \
+        -s MODULARIZE=1 \
+        -s EXPORT_NAME="createMoviModule" \
+        -s ENVIRONMENT=web,worker \
+        -s INITIAL_MEMORY=256MB \
+        -s MAXIMUM_MEMORY=4GB \
+        -s ALLOW_MEMORY_GROWTH=1 \
+        -s ASYNCIFY=1 \
+        -s ASYNCIFY_STACK_SIZE=524288 \
+        -s "ASYNCIFY_ADD=['movi_open','movi_read_frame','movi_read_frame_ref','movi_read_frames','movi_seek_to','movi_index_step','movi_cues_begin','movi_cues_step','movi_thumbnail_open','movi_thumbnail_read_keyframe','movi_thumbnail_scrub_keyframe','movi_thumbnail_storyboard_add','movi_prefetch_subtitle_cues']" \
+        -s "ASYNCIFY_IMPORTS=['js_read_async','js_seek_async','js_live_wait','js_thumbnail_packet_ready']" \
+        -s EXPORTED_RUNTIME_METHODS='["ccall", "cwrap", "FS", "stringToNewUTF8", "UTF8ToString", "lengthBytesUTF8", "addFunction", "HEAPU8", "HEAPF32"]' \
+        -s EXPORTED_FUNCTIONS='["_malloc", "_free", "_movi_create", "_movi_destroy", "_movi_open", "_movi_set_live", "_movi_push_bytes", "_movi_push_eof", "_movi_live_buffered", "_movi_set_ctr_key", "_movi_read_frame", "_movi_read_frame_ref", "_movi_packet_release", "_movi_read_frames", "_movi_set_read_frames_limit", "_movi_shed_enable", "_movi_shed_report", "_movi_shed_tier", "_movi_shed_dropped", "_movi_set_max_temporal_layer", "_movi_temporal_layers", "_movi_temporal_dropped", "_movi_set_avio_buffer_size", "_movi_context_memory", "_movi_module_memory", "_movi_trim", "_movi_scratch_release", "_movi_pipeline_start", "_movi_pipeline_send", "_movi_pipeline_receive", "_movi_pipeline_flush", "_movi_pipeline_set_rgba", "_movi_pipeline_stats", "_movi_pipeline_stop", "_movi_stats_size", "_movi_get_stats", "_movi_reset_stats", "_movi_seek_to", "_movi_index_needed", "_movi_index_begin", "_movi_index_step", "_movi_index_progress", "_movi_index_export", "_movi_index_import", "_movi_probe_export", "_movi_probe_import", "_movi_probe_applied", "_movi_get_duration", "_movi_get_start_time", "_movi_get_stream_count", "_movi_get_stream_info", "_movi_get_extradata", "_movi_set_log_level", "_movi_set_file_size", "_movi_enable_decoder", "_movi_set_decoder_threads", "_movi_threads_supported", "_movi_set_stream_discard", "_movi_send_packet", "_movi_send_packet_owned", "_movi_receive_frame", "_movi_decode_audio_batch", "_movi_audio_batch_samples", "_movi_audio_batch_channels", "_movi_audio_batch_sample_rate", "_movi_audio_batch_pts", "_movi_audio_batch_plane", "_movi_decode_audio_batch_stretch", "_movi_audio_batch_stretched_frames", "_movi_decode_subtitle", "_movi_get_subtitle_text", "_movi_get_subtitle_times", "_movi_get_subtitle_image_info", "_movi_get_subtitle_image_data", "_movi_free_subtitle", "_movi_decode_subtitle_batch", "_movi_subtitle_batch_info", "_movi_subtitle_batch_set_palettized", "_movi_subtitle_style_name", "_movi_prefetch_subtitle_cues", "_movi_get_prefetched_cue_count", "_movi_get_prefetched_cue", "_movi_clear_prefetched_cues", "_movi_cues_begin", "_movi_cues_step", "_movi_cues_progress", "_movi_cues_count", "_movi_get_cues_in_range", "_movi_cues_export", "_movi_cues_import", "_movi_get_frame_width", "_movi_get_frame_height", "_movi_get_frame_format", "_movi_get_frame_linesize", "_movi_get_frame_data", "_movi_frame_retain", "_movi_frame_handle_info", "_movi_frame_release", "_movi_set_hdr_tonemap", "_movi_get_frame_samples", "_movi_get_frame_channels", "_movi_get_frame_sample_rate", "_movi_enable_audio_downmix", "_movi_thumbnail_create", "_movi_thumbnail_destroy", "_movi_thumbnail_open", "_movi_thumbnail_read_keyframe", "_movi_thumbnail_get_packet_data", "_movi_thumbnail_decode_frame", "_movi_thumbnail_decode_frame_yuv", "_movi_thumbnail_get_plane_data", "_movi_thumbnail_get_plane_linesize", "_movi_thumbnail_get_frame_width", "_movi_thumbnail_get_frame_height", "_movi_thumbnail_clear_buffer", "_movi_thumbnail_get_extradata", "_movi_thumbnail_get_stream_info", "_movi_thumbnail_import_index", "_movi_thumbnail_import_probe", "_movi_thumbnail_set_fast_decode", "_movi_thumbnail_set_header_only", "_movi_thumbnail_scrub_keyframe", "_movi_thumbnail_scrub_next_pts", "_movi_thumbnail_scrub_end", "_movi_thumbnail_storyboard_begin", "_movi_thumbnail_storyboard_add", "_movi_thumbnail_storyboard_tiles", "_movi_thumbnail_storyboard_pts", "_movi_thumbnail_storyboard_end", "_movi_stretch_new", "_movi_stretch_new_preset", "_movi_stretch_new_grouped", "_movi_stretch_delete", "_movi_stretch_reset", "_movi_stretch_set_transpose_semitones", "_movi_stretch_input_latency", "_movi_stretch_output_latency", "_movi_stretch_process", "_movi_stretch_process_planar", "_movi_stretch_channels", "_movi_stretch_output_plane"]' \
+        -s ASSERTIONS=0 \
+        -s DISABLE_EXCEPTION_THROWING=1 \
+        -s ALLOW_TABLE_GROWTH=1 \
+        -s INVOKE_RUN=0 \
+        -s SINGLE_FILE=1 \
+        -s LEGACY_RUNTIME=0 \
+        -g0 \
+        -s MINIFY_HTML=0 \
+        -s ELIMINATE_DUPLICATE_FUNCTIONS=1 \
+        -s STACK_OVERFLOW_CHECK=0 \
+        -s TEXTDECODER=2 \
+        -s SUPPORT_LONGJMP=0 \
+        -s SUPPORT_ERRNO=0 \
+        -sUSE_ZLIB=1 \
+        --closure 0 \
+        --js-library /src/wasm/library_movi.js \
+        "$@" \
+        -o "$output"
+}
+
+link_movi /src/dist/wasm/movi.js ${FFMPEG_PREFIX} ${DAV1D_PREFIX} -Oz ""
+
+# simd: not inlined into the bundles (that would double their size for every
+# user); it ships next to them and FFmpegLoader imports it on demand.
+if [ "$MOVI_BUILD_SIMD" != "0" ]; then
+    link_movi /src/dist/wasm/movi-simd.js ${FFMPEG_SIMD_PREFIX} ${DAV1D_SIMD_PREFIX} -O3 "-msimd128"
+fi
+
+# mt: the pthread workers re-import movi-mt.js by its own URL, so this file is
+# served next to the bundles (never inlined into them) and FFmpegLoader loads it
+# with a dynamic import. PTHREAD_POOL_SIZE_STRICT=0 lets an over-subscribed
+# decoder spawn an extra worker instead of failing avcodec_open2.
+if [ "$MOVI_BUILD_MT" != "0" ]; then
+    link_movi /src/dist/wasm/movi-mt.js ${FFMPEG_MT_PREFIX} ${DAV1D_MT_PREFIX} -O3 "-msimd128 -pthread -DMOVI_PTHREAD_POOL_SIZE=${MT_POOL_SIZE}" \
+        -s PTHREAD_POOL_SIZE=${MT_POOL_SIZE} \
+        -s PTHREAD_POOL_SIZE_STRICT=0
+fi
+
+# stretch: AudioWorkletGlobalScope has no fetch/importScripts/dynamic import,
+# so there's no loading a regular Emscripten module there. STANDALONE_WASM +
+# --no-entry gives a bare reactor module (exports + memory, WASI stubs as the
+# only imports); FFmpegLoader compiles it on the main thread and the processor
+# instantiates the WebAssembly.Module it's handed.
+# -msimd128 selects the SIMD128 FFT (signalsmith-linear/platform/fft-simd128.h)
+# in the simd variant; also vectorises the stretch's own spectral loops.
+link_stretch() {
+    local output=$1
+    local flavor_cflags=$2
+
+    em++ /src/wasm/movi_stretch.cpp \
+        -I/src/wasm/signalsmith/signalsmith-stretch/include \
+        -I/src/wasm/signalsmith/signalsmith-linear/include \
+        -std=c++17 -fno-exceptions -fno-rtti \
+        -O3 -flto \
+        ${flavor_cflags} \
+        -s STANDALONE_WASM=1 \
+        --no-entry \
+        -s INITIAL_MEMORY=16MB \
+        -s MAXIMUM_MEMORY=256MB \
+        -s ALLOW_MEMORY_GROWTH=1 \
+        -s EXPORTED_FUNCTIONS='["_malloc", "_free", "_movi_stretch_new_preset", "_movi_stretch_delete", "_movi_stretch_reset", "_movi_stretch_set_transpose_semitones", "_movi_stretch_input_latency", "_movi_stretch_output_latency", "_movi_stretch_process_planar", "_movi_stretch_channels", "_movi_stretch_output_plane"]' \
+        -s ASSERTIONS=0 \
+        -s DISABLE_EXCEPTION_THROWING=1 \
+        -s STACK_OVERFLOW_CHECK=0 \
+        -s SUPPORT_ERRNO=0 \
+        -g0 \
+        -o "$output"
+}
+
+if [ "$MOVI_BUILD_STRETCH" != "0" ]; then
+    link_stretch /src/dist/wasm/movi-stretch.wasm ""
+    link_stretch /src/dist/wasm/movi-stretch-simd.wasm "-msimd128"
+fi
+
+# bench: same stretch sources, with main() and wall-clock timing instead of
+# the worklet exports. Output goes to /tmp, nothing is shipped.
+if [ "$MOVI_BUILD_BENCH" != "0" ]; then
+    for variant in scalar simd; do
+        bench_flags=""
+        [ "$variant" = "simd" ] && bench_flags="-msimd128"
+        em++ /src/wasm/movi_stretch.cpp /src/wasm/bench/stretch_bench.cpp \
+            -I/src/wasm/signalsmith/signalsmith-stretch/include \
+            -I/src/wasm/signalsmith/signalsmith-linear/include \
+            -std=c++17 -fno-exceptions -fno-rtti \
+            -O3 -flto \
+            ${bench_flags} \
+            -s ENVIRONMENT=node \
+            -s ALLOW_MEMORY_GROWTH=1 \
+            -o /tmp/stretch-bench-${variant}.js
+        echo "=== stretch bench (${variant}) ==="
+        node /tmp/stretch-bench-${variant}.js
+    done
+
+    echo "=== core bench ==="
+    if [ "$MOVI_BUILD_SIMD" != "0" ]; then
+        link_movi /tmp/movi-bench.mjs ${FFMPEG_SIMD_PREFIX} ${DAV1D_SIMD_PREFIX} -O3 "-msimd128 -DMOVI_STATS" \
+            -s ENVIRONMENT=node
+    else
+        link_movi /tmp/movi-bench.mjs ${FFMPEG_PREFIX} ${DAV1D_PREFIX} -O3 "-DMOVI_STATS" \
+            -s ENVIRONMENT=node
+    fi
+    mkdir -p /src/dist/bench
+    bench_args=(--module /tmp/movi-bench.mjs --corpus /src/wasm/bench/corpus
+                --out /src/dist/bench/movi-bench.json)
+    if [ -n "$MOVI_BENCH_BASELINE" ]; then
+        bench_args+=(--baseline "$MOVI_BENCH_BASELINE" --fail-on-regression)
+    fi
+    node /src/wasm/bench/movi_bench.mjs "${bench_args[@]}"
+fi
 
 echo "=== Build complete ==="
 ls -la /src/dist/wasm/
@@ -8,9 +8,9 @@
  *
  * Wire protocol (identical to the Cloudflare worker):
  *   POST /api/token
- *     Request:  { url | videoId, fingerprint, clientPubKey }
+ *     Request:  { url | videoId, fingerprint, clientPubKey, cipher? }
  *     Response: { token, expiresAt, fileSize, chunkSize,
- *                 serverPubKey, hkdfSalt }
+ *                 serverPubKey, hkdfSalt, cipher? }
  *     Token = base64url(payload).hmac-sha256-hex(payload)
  *     Payload = { videoId, ip, fingerprint, expiresAt,
  *                 clientPubKey, wrappedServerPriv, hkdfSalt }
@@ -24,6 +24,12 @@
  *     Response body: framed AES-GCM
  *       [4-byte BE length][12-byte IV][ciphertext || 16-byte tag]
  *     encryption key derived with HKDF(info="enc:master-aes", salt=hkdfSalt).
+ *     With cipher="aes-ctr" in the token request (echoed in the response
+ *     and the signed payload), frames are bare AES-256-CTR ciphertext
+ *       [4-byte BE length][ciphertext]
+ *     keyed with HKDF(info="enc:master-ctr"), counter block = 8-byte
+ *     HKDF(info="enc:ctr-nonce") || 64-bit BE index of the 16-byte block
+ *     at the file offset, so the client can decrypt any offset in WASM.
  *
  * On-disk storage: encrypt.js emits .enc files with chunk-level AES-GCM
  * (per-chunk IV + tag). Here we decrypt each requested chunk with the
@@ -282,7 +288,27 @@ async function deriveSessionKeys(serverPrivPkcs8, clientPubRaw, salt) {
   const shared = new Uint8Array(sharedBits);
   const masterBytes = await hkdf(shared, "enc:master-aes", 32, salt);
   const hmacBytes = await hkdf(shared, "enc:req-hmac", 32, salt);
-  return { masterBytes, hmacBytes };
+  const ctrKeyBytes = await hkdf(shared, "enc:master-ctr", 32, salt);
+  const ctrNonce = await hkdf(shared, "enc:ctr-nonce", 8, salt);
+  return { masterBytes, hmacBytes, ctrKeyBytes, ctrNonce };
+}
+
+// AES-256-CTR over `plaintext` sitting at file offset `offset`: the counter
+// starts at that offset's 16-byte block, matching the client's in-WASM
+// decryption (movi_crypt.c).
+async function aesCtrAt(key, nonce, offset, plaintext) {
+  const skip = offset % 16;
+  const counter = new Uint8Array(16);
+  counter.set(nonce);
+  new DataView(counter.buffer).setBigUint64(8, BigInt(Math.floor(offset / 16)));
+  const padded = new Uint8Array(skip + plaintext.length);
+  padded.set(plaintext, skip);
+  const ct = await subtle.encrypt(
+    { name: "AES-CTR", counter, length: 64 },
+    key,
+    padded,
+  );
+  return new Uint8Array(ct, skip);
 }
 
 async function verifyEncToken(token) {
@@ -343,6 +369,7 @@ app.post("/api/token", async (req, res) => {
     const body = req.body || {};
     const videoId = body.videoId || body.url;
     const { fingerprint, clientPubKey } = body;
+    const ctr = body.cipher === "aes-ctr";
     const ip = getClientIP(req);
 
     if (!videoId || !fingerprint || !clientPubKey) {
@@ -389,6 +416,7 @@ app.post("/api/token", async (req, res) => {
       clientPubKey,
       wrappedServerPriv,
       hkdfSalt: hkdfSaltB64,
+      ...(ctr ? { cipher: "aes-ctr" } : {}),
     };
     const payloadBytes = new TextEncoder().encode(JSON.stringify(payload));
     const payloadB64 = b64urlEncode(payloadBytes);
@@ -406,6 +434,7 @@ app.post("/api/token", async (req, res) => {
       serverPubKey: b64Encode(serverPubRaw),
       hkdfSalt: hkdfSaltB64,
       contentDispositionFilename: basename(video.keyInfo.originalFile),
+      ...(ctr ? { cipher: "aes-ctr" } : {}),
     });
 
     console.log(
@@ -460,6 +489,8 @@ app.get("/api/video", async (req, res) => {
     // keys the client also derived locally.
     let masterBytes;
     let hmacBytes;
+    let ctrKeyBytes;
+    let ctrNonce;
     try {
       const serverPrivPkcs8 = await unwrapServerPriv(payload.wrappedServerPriv);
       const clientPubRaw = b64Decode(payload.clientPubKey);
@@ -473,6 +504,8 @@ app.get("/api/video", async (req, res) => {
       );
       masterBytes = derived.masterBytes;
       hmacBytes = derived.hmacBytes;
+      ctrKeyBytes = derived.ctrKeyBytes;
+      ctrNonce = derived.ctrNonce;
     } catch {
       return res.status(400).json({ error: "Key derivation failed" });
     }
@@ -542,11 +575,13 @@ app.get("/api/video", async (req, res) => {
 
     // Re-encrypt with the session master key in FRAME_PLAINTEXT-sized
     // frames, matching the worker's wire format. Each frame is its
-    // own AES-GCM message so the client can decrypt progressively.
+    // own AES-GCM message so the client can decrypt progressively —
+    // or, for a CTR session, bare ciphertext at its file offset.
+    const ctr = payload.cipher === "aes-ctr";
     const aesKey = await subtle.importKey(
       "raw",
-      masterBytes,
-      { name: "AES-GCM" },
+      ctr ? ctrKeyBytes : masterBytes,
+      { name: ctr ? "AES-CTR" : "AES-GCM" },
       false,
       ["encrypt"],
     );
@@ -556,7 +591,7 @@ app.get("/api/video", async (req, res) => {
       "Cache-Control": "no-store, no-cache",
       "Accept-Ranges": "bytes",
       "Cross-Origin-Resource-Policy": "cross-origin",
-      "X-Enc-Envelope": "aes-gcm-framed-iv12-tag16",
+      "X-Enc-Envelope": ctr ? "aes-ctr-framed" : "aes-gcm-framed-iv12-tag16",
       "X-Enc-Frame-Size": String(FRAME_PLAINTEXT),
       ...(range ? { "Content-Range": `bytes ${start}-${end}/${fileSize}` } : {}),
     });
@@ -566,6 +601,15 @@ app.get("/api/video", async (req, res) => {
         off,
         Math.min(off + FRAME_PLAINTEXT, plaintext.length),
       );
+      if (ctr) {
+        const ct = await aesCtrAt(aesKey, ctrNonce, start + off, framePlain);
+        const header = Buffer.alloc(4);
+        header.writeUInt32BE(ct.length, 0);
+        if (!res.write(header)) await new Promise((r) => res.once("drain", r));
+        if (!res.write(Buffer.from(ct.buffer, ct.byteOffset, ct.byteLength)))
+          await new Promise((r) => res.once("drain", r));
+        continue;
+      }
       const iv = webcrypto.getRandomValues(new Uint8Array(12));
       const ctTag = new Uint8Array(
         await subtle.encrypt({ name: "AES-GCM", iv }, aesKey, framePlain),
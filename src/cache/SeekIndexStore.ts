@@ -0,0 +1,152 @@
+/**
+ * SeekIndexStore - Persistent storage for demuxer seek indexes
+ *
+ * Holds the keyframe tables exported by WasmBindings.exportSeekIndex, keyed by
+ * a source fingerprint (generateSourceFingerprint), so a file without a usable
+ * container index is only scanned once. Backed by IndexedDB; falls back to an
+ * in-memory map where IndexedDB is unavailable (private mode, workers without
+ * it, SSR), which still saves the rescan within the page's lifetime.
+ *
+ * Subtitle cue indexes (WasmBindings.exportCueIndex) share the store under
+ * `<fingerprint>:cues:<streamIndex>`, and probed stream descriptors
+ * (WasmBindings.exportProbeDescriptor) under `<fingerprint>:probe`.
+ */
+
+import { Logger } from '../utils/Logger';
+
+const TAG = 'SeekIndexStore';
+
+const DB_NAME = 'movi-seek-index';
+const DB_VERSION = 1;
+const STORE_NAME = 'indexes';
+
+interface SeekIndexRecord {
+  fingerprint: string;
+  data: Uint8Array;
+  storedAt: number;
+}
+
+export class SeekIndexStore {
+  private static dbPromise: Promise<IDBDatabase | null> | null = null;
+  private static memory: Map<string, Uint8Array> = new Map();
+
+  // Oldest records beyond this are evicted on put. Indexes are small (~24
+  // bytes per keyframe, so a few hundred KB for a feature film at most).
+  private static readonly MAX_RECORDS = 200;
+
+  private static openDb(): Promise<IDBDatabase | null> {
+    if (this.dbPromise) return this.dbPromise;
+    this.dbPromise = new Promise((resolve) => {
+      if (typeof indexedDB === 'undefined') {
+        resolve(null);
+        return;
+      }
+      try {
+        const request = indexedDB.open(DB_NAME, DB_VERSION);
+        request.onupgradeneeded = () => {
+          const db = request.result;
+          if (!db.objectStoreNames.contains(STORE_NAME)) {
+            const store = db.createObjectStore(STORE_NAME, { keyPath: 'fingerprint' });
+            store.createIndex('storedAt', 'storedAt');
+          }
+        };
+        request.onsuccess = () => resolve(request.result);
+        request.onerror = () => {
+          Logger.warn(TAG, 'IndexedDB unavailable, using in-memory store', request.error);
+          resolve(null);
+        };
+      } catch (e) {
+        Logger.warn(TAG, 'IndexedDB unavailable, using in-memory store', e);
+        resolve(null);
+      }
+    });
+    return this.dbPromise;
+  }
+
+  /**
+   * Look up a stored index; resolves to null when none exists
+   */
+  static async get(fingerprint: string): Promise<Uint8Array | null> {
+    const cached = this.memory.get(fingerprint);
+    if (cached) return cached;
+
+    const db = await this.openDb();
+    if (!db) return null;
+    return new Promise((resolve) => {
+      try {
+        const request = db
+          .transaction(STORE_NAME, 'readonly')
+          .objectStore(STORE_NAME)
+          .get(fingerprint);
+        request.onsuccess = () => {
+          const record = request.result as SeekIndexRecord | undefined;
+          if (record?.data) this.memory.set(fingerprint, record.data);
+          resolve(record?.data ?? null);
+        };
+        request.onerror = () => resolve(null);
+      } catch {
+        resolve(null);
+      }
+    });
+  }
+
+  /**
+   * Store an index, evicting the oldest records beyond MAX_RECORDS
+   */
+  static async put(fingerprint: string, data: Uint8Array): Promise<void> {
+    this.memory.set(fingerprint, data);
+
+    const db = await this.openDb();
+    if (!db) return;
+    await new Promise<void>((resolve) => {
+      try {
+        const tx = db.transaction(STORE_NAME, 'readwrite');
+        const store = tx.objectStore(STORE_NAME);
+        const record: SeekIndexRecord = { fingerprint, data, storedAt: Date.now() };
+        store.put(record);
+
+        const countRequest = store.count();
+        countRequest.onsuccess = () => {
+          let excess = countRequest.result - this.MAX_RECORDS;
+          if (excess <= 0) return;
+          const cursorRequest = store.index('storedAt').openCursor();
+          cursorRequest.onsuccess = () => {
+            const cursor = cursorRequest.result;
+            if (!cursor || excess <= 0) return;
+            cursor.delete();
+            excess--;
+            cursor.continue();
+          };
+        };
+
+        tx.oncomplete = () => resolve();
+        tx.onerror = () => {
+          Logger.warn(TAG, 'Failed to persist seek index', tx.error);
+          resolve();
+        };
+      } catch (e) {
+        Logger.warn(TAG, 'Failed to persist seek index', e);
+        resolve();
+      }
+    });
+  }
+
+  /**
+   * Forget a stored index (e.g. one the WASM rejected as not matching)
+   */
+  static async delete(fingerprint: string): Promise<void> {
+    this.memory.delete(fingerprint);
+    const db = await this.openDb();
+    if (!db) return;
+    await new Promise<void>((resolve) => {
+      try {
+        const tx = db.transaction(STORE_NAME, 'readwrite');
+        tx.objectStore(STORE_NAME).delete(fingerprint);
+        tx.oncomplete = () => resolve();
+        tx.onerror = () => resolve();
+      } catch {
+        resolve();
+      }
+    });
+  }
+}
@@ -1,2 +1,3 @@
 export { LRUCache } from './LRUCache';
 export type { CacheAdapter } from './CacheAdapter';
+export { SeekIndexStore } from './SeekIndexStore';
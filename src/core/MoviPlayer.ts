@@ -23,10 +23,12 @@ import {
   FileSource,
   ThumbnailHttpSource,
   EncryptedHttpSource,
+  LiveSource,
   analyzeDashFallback,
   type SourceAdapter,
 } from "../source";
-import { LRUCache } from "../cache";
+import { LRUCache, SeekIndexStore } from "../cache";
+import { generateSourceFingerprint } from "../utils/Fingerprint";
 import { Demuxer } from "../demux";
 import { TrackManager } from "./TrackManager";
 import { Clock } from "./Clock";
@@ -37,12 +39,22 @@ import { MoviAudioDecoder } from "../decode/AudioDecoder";
 import { SubtitleDecoder } from "../decode/SubtitleDecoder";
 import { CanvasRenderer, type VRView } from "../render/CanvasRenderer";
 import { AudioRenderer } from "../render/AudioRenderer";
-import { updateAllBindingsLogLevel, ThumbnailBindings } from "../wasm/bindings";
+import type { PCMRingStats } from "../render/PCMRing";
+import {
+  updateAllBindingsLogLevel,
+  ThumbnailBindings,
+  type WasmInstrumentation,
+} from "../wasm/bindings";
 import { loadWasmModuleNew } from "../wasm/FFmpegLoader";
 import { ShakaPlayerWrapper } from "../render/ShakaPlayerWrapper";
 import { HLSPlayerWrapper } from "../render/HLSPlayerWrapper";
 import { DASHPlayerWrapper } from "../render/DASHPlayerWrapper";
 import { ThumbnailRenderer } from "../utils/ThumbnailRenderer";
+import {
+  StoryboardGenerator,
+  type Storyboard,
+  type StoryboardOptions,
+} from "../utils/Storyboard";
 
 // Any of the three adaptive-streaming engines (Shaka primary; hls.js / dash.js
 // as fallbacks). They share the same surface; the Shaka-only extras (isLive,
@@ -54,6 +66,15 @@ type StreamWrapper =
 
 const TAG = "MoviPlayer";
 
+// Width hover previews are decoded and scaled to in the software path
+const PREVIEW_DECODE_WIDTH = 320;
+
+// Live latency control (startLiveLatencyControl): how often latency is checked,
+// how far over the target it may drift before catching up, and how fast
+const LIVE_LATENCY_INTERVAL_MS = 500;
+const LIVE_CATCHUP_MARGIN = 0.5;
+const LIVE_CATCHUP_RATE = 1.08;
+
 export class MoviPlayer extends EventEmitter<PlayerEventMap> {
   // One-shot UA classification: mobile devices get the same conservative
   // decode/render budgets as 4K+ desktop, since mobile GPUs and Chrome's
@@ -172,6 +193,8 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     // audio-only sources from opening a useless second WASM context
     // (the cover-art extractor already spins up its own short-lived one).
     if (this.trackManager.getVideoTracks().length === 0) return false;
+    // A live feed can't be read a second time by a thumbnail context
+    if (this.source instanceof LiveSource) return false;
     return true;
   }
 
@@ -220,7 +243,21 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
   private isPreviewGenerating: boolean = false;
   private audioRenderer: AudioRenderer;
   private previewInitPromise: Promise<void> | null = null; // Guard for preview initialization
+  // Serialised keyframe index for the current file (movi_index.c), once
+  // imported or built. Kept so the thumbnail context can load it too.
+  private seekIndexBlob: Uint8Array | null = null;
+  // Probed stream parameters of the current file (movi_probe.c), handed to
+  // the preview and storyboard contexts so they open without probing
+  private probeDescriptor: Uint8Array | null = null;
+  // Storyboards built for the current source, keyed by generation options
+  private storyboards: Map<string, Storyboard> = new Map();
   private previewInitAttempts: number = 0; // Bounded retries for preview pipeline init
+  // GOP ([start, end) media time) of the keyframe the last scrub preview came
+  // from. The thumbnail renderer holds its decoded picture, so a seek landing
+  // in the GOP shows it at once instead of waiting for the keyframe decode.
+  private scrubGop: { start: number; end: number } | null = null;
+  // Tile built from that keyframe, reused while a drag stays inside its GOP
+  private lastPreview: { pts: number; blob: Blob } | null = null;
   private previewInitGaveUp: boolean = false; // Stop retrying once init has failed too often
 
   // Debug flag to disable audio processing
@@ -302,6 +339,25 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
   // buffers on AudioContext which would start audio playback early.
   private pendingPrebufferPackets: Packet[] = [];
 
+  // Closed-loop load shedding (movi_shed.c): set when the demuxer picks the
+  // frame-drop tier from the renderer's decode-budget reports, which replaces
+  // the one-way setPerformanceSkip below. _dropTier is the tier in effect.
+  private _loadShedding: boolean = false;
+  private _dropTier: number = 0;
+
+  // Temporal sub-layer scaling (movi_nal.c): the video track whose upper
+  // sub-layers the demuxer drops to match the display refresh rate, and the
+  // highest TemporalId kept (-1 = every layer).
+  private _temporalTrack: number = -1;
+  private _temporalLayer: number = -1;
+
+  // Live ingest (movi_live.c): the latency controller's timer, whether it's
+  // currently running playback fast to catch up, and the rate the user asked
+  // for (catch-up only runs at 1x and never overrides a user rate).
+  private _liveLatencyTimer: ReturnType<typeof setInterval> | null = null;
+  private _liveCatchingUp: boolean = false;
+  private _liveUserRate: number = 1;
+
   // Audio packets collected during the current demux burst, handed to the
   // decoder as ONE batch when the tick ends. Only used when the software path
   // is active (see AudioDecoder.canBatch): TrueHD/MLP emits a 40-sample access
@@ -315,6 +371,16 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     keyframe: boolean;
   }[] = [];
 
+  // Subtitle packets from the current demux burst, decoded as one batch with
+  // the audio batch when the module has movi_decode_subtitle_batch (see
+  // SubtitleDecoder.canBatch). Karaoke ASS tracks carry hundreds of events a
+  // minute; per packet that is four WASM crossings and a buffer each.
+  private _subtitleBatchPending: {
+    data: Uint8Array;
+    timestamp: number;
+    duration: number;
+  }[] = [];
+
   // Post-seek throttling to prevent stuttering on low-end devices
   private justSeeked: boolean = false;
   private seekTime: number = 0;
@@ -386,6 +452,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
         // software path, skip non-reference frames to cut CPU. No-op on
         // hardware — the present-side cap is the only lever there.
         this.videoRenderer.setOnPerformanceDegrade(() => {
+          if (this._loadShedding) return; // the demuxer already adapts
           this.videoDecoder?.setPerformanceSkip(true);
         });
 
@@ -504,6 +571,9 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       // doesn't implement.
       this.audioRenderer.renderPCM(frame);
     });
+    // At non-1x rates the software batches stretch in WASM straight into
+    // the renderer's Signalsmith instance instead of round-tripping via JS.
+    this.audioDecoder.setStretchProvider(() => this.audioRenderer.getFusedStretch());
 
     this.audioDecoder.setOnError((error) => {
       Logger.error(TAG, "Audio decoder error", error);
@@ -550,6 +620,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       this.audioDecoder.setOnPCM((frame) => {
         this.audioRenderer.renderPCM(frame);
       });
+      this.audioDecoder.setStretchProvider(() => this.audioRenderer.getFusedStretch());
 
       this.audioDecoder.setOnError((error) => {
         Logger.error(TAG, "Audio decoder error", error);
@@ -760,17 +831,30 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       // Create demuxer (getSize will be called lazily in bindings.open())
       this.demuxer = new Demuxer(this.source, this.config.wasmBinary);
 
+      // A stream descriptor cached by an earlier load of this file lets the
+      // open skip stream probing
+      const probeKey = await this.loadProbeDescriptor(this.demuxer, this.source);
+
       // Open and get media info
       this.mediaInfo = await this.demuxer.open();
       // Destroyed by a rapid source switch during the (WASM + network) open —
       // bail before standing up the split-audio demuxer and decoders.
       if (this._destroyed) return;
 
+      this.probeDescriptor = this.demuxer.exportProbeDescriptor();
+      if (probeKey && this.probeDescriptor && !this.demuxer.isProbeDescriptorApplied()) {
+        void SeekIndexStore.put(probeKey, this.probeDescriptor);
+      }
+
       // Cache file size for buffer calculations (getSize was called in bindings.open())
       this.fileSize = await this.source.getSize();
 
       const bindings = this.demuxer.getBindings();
       if (bindings) {
+        // The budget covers every player sharing this WASM module
+        if (this.config.memoryBudget !== undefined) {
+          bindings.getContextManager().setMemoryBudget(this.config.memoryBudget);
+        }
         this.videoDecoder.setBindings(bindings);
         this.audioDecoder.setBindings(bindings);
         if (this.subtitleDecoder) {
@@ -816,6 +900,10 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       // so callers don't need to await this.
       void this.extractCoverArt();
 
+      // Seek index for containers without one. Fire-and-forget as well: a
+      // cached index lands in milliseconds, a fresh build runs behind playback.
+      void this.setupSeekIndex();
+
       // Configure decoders for active tracks
       await this.configureDecoders();
 
@@ -823,7 +911,10 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       // Clock operates in media time (PTS), so it runs from startTime to startTime + duration
       this.startTime = this.mediaInfo.startTime || 0;
       this.seekKeyframeOffset = 0;
-      this.clock.setDuration(this.mediaInfo.duration + this.startTime);
+      // A live feed has no duration to clamp to
+      this.clock.setDuration(
+        this.demuxer.isLive() ? 0 : this.mediaInfo.duration + this.startTime,
+      );
       this.clock.seek(this.startTime);
 
       // Emit duration
@@ -836,6 +927,8 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       this.stateManager.setState("ready");
       this.emit("loadEnd", undefined);
 
+      if (this.demuxer.isLive()) this.startLiveLatencyControl();
+
       // Initialize preview pipeline in background (fire-and-forget).
       // Skipped only for sources with no video track — see previewsAllowed().
       if (this.previewsAllowed()) {
@@ -886,6 +979,12 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       });
     }
 
+    if (config.type === "url" && config.url && this.config.live) {
+      const source = new LiveSource(config.url, config.headers);
+      source.setOnError((error) => this.emit("error", error));
+      return source;
+    }
+
     if (config.type === "url" && config.url) {
       const maxBufferSizeMB = this.config.cache?.maxSizeMB;
       const source = new HttpSource(
@@ -902,11 +1001,139 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     throw new Error("Invalid source configuration");
   }
 
+  /**
+   * Hand frame-drop decisions to the demuxer when the module supports it: the
+   * renderer reports a decode-budget miss ratio per window and movi_shed.c
+   * steps through NONREF → no loop filter → BIDIR → NONKEY and back, dropping
+   * disposable packets before they're copied out. Tier changes are emitted as
+   * `dropTier` for QoE.
+   */
+  private setupLoadShedding(trackId: number): boolean {
+    const bindings = this.demuxer?.getBindings();
+    if (!this.videoRenderer || !bindings?.supportsLoadShedding()) return false;
+    bindings.enableLoadShedding(trackId);
+    this._dropTier = 0;
+    this.videoRenderer.setOnDecodeBudget((missRatio) => {
+      const tier = bindings.reportDecodeBudget(missRatio);
+      if (tier === this._dropTier) return;
+      this._dropTier = tier;
+      const dropped = bindings.getLoadShedDropped();
+      Logger.info(
+        TAG,
+        `Load shedding tier ${tier} (decode-budget miss ratio ${missRatio.toFixed(2)}, ${dropped} packets dropped)`,
+      );
+      this.emit("dropTier", { tier, dropped });
+    });
+    return true;
+  }
+
+  /**
+   * Decode only the temporal sub-layers the display can show: a 120fps HEVC
+   * stream with two sub-layers on a 60Hz panel keeps layer 0, and the demuxer
+   * drops layer 1 before it's copied out or decoded. No picture references a
+   * higher sub-layer, so unlike non-reference skipping the result is an even
+   * 60fps. Re-evaluated whenever the renderer's refresh-rate estimate
+   * changes; the layer count is read each time since some streams only show
+   * it in their packets.
+   */
+  private setupTemporalScaling(trackId: number, sourceFps: number): void {
+    const bindings = this.demuxer?.getBindings();
+    if (this._temporalTrack >= 0 && this._temporalTrack !== trackId) {
+      bindings?.setMaxTemporalLayer(this._temporalTrack, -1);
+    }
+    this._temporalTrack = -1;
+    this._temporalLayer = -1;
+    const renderer = this.videoRenderer;
+    if (!renderer) return;
+    // An explicit frameRate override already decides the presentation rate
+    if (
+      !bindings?.supportsTemporalLayers() ||
+      !(sourceFps > 0) ||
+      this.config.frameRate
+    ) {
+      renderer.setOnDisplayRate(null);
+      return;
+    }
+    this._temporalTrack = trackId;
+    renderer.setOnDisplayRate((hz) => {
+      const layers = bindings.getTemporalLayers(trackId);
+      if (layers <= 1 && this._temporalLayer < 0) return;
+      // Each sub-layer doubles the rate of the ones below it (the dyadic
+      // hierarchy encoders build); keep the most that fit the display
+      let maxTid = layers - 1;
+      while (maxTid > 0 && sourceFps / 2 ** (layers - 1 - maxTid) > hz * 1.05) {
+        maxTid--;
+      }
+      const limit = maxTid === layers - 1 ? -1 : maxTid;
+      if (limit === this._temporalLayer) return;
+      this._temporalLayer = limit;
+      bindings.setMaxTemporalLayer(trackId, limit);
+      const fps = sourceFps / 2 ** (layers - 1 - maxTid);
+      renderer.setSourceFrameRate(fps);
+      Logger.info(
+        TAG,
+        `Temporal scaling: ${hz}Hz display, decoding ${maxTid + 1}/${layers} sub-layers (${fps.toFixed(0)}fps of ${sourceFps.toFixed(0)})`,
+      );
+    });
+  }
+
+  /**
+   * Hold a live feed near its target latency (config.live.latency, default
+   * 1s) behind the newest demuxed packet. A feed that has drifted behind —
+   * startup buffering, a network stall — plays slightly fast through the
+   * pitch-preserving stretcher until it's back at the target, instead of
+   * jumping ahead. Runs only at the user's 1x; the margin keeps the rate
+   * from flapping around the target.
+   */
+  private startLiveLatencyControl(): void {
+    this.stopLiveLatencyControl();
+    const live = this.config.live;
+    const target =
+      typeof live === "object" && live.latency !== undefined ? live.latency : 1;
+    this._liveLatencyTimer = setInterval(() => {
+      const demuxer = this.demuxer;
+      if (!demuxer?.isLive()) {
+        this.stopLiveLatencyControl();
+        return;
+      }
+      if (this.stateManager.getState() !== "playing") return;
+      if (this._liveUserRate !== 1) return;
+      const latency = demuxer.getLiveEdge() - this.clock.getTime();
+      if (!this._liveCatchingUp && latency > target + LIVE_CATCHUP_MARGIN) {
+        this._liveCatchingUp = true;
+        this.applyLiveRate(LIVE_CATCHUP_RATE);
+        Logger.info(TAG, `Live latency ${latency.toFixed(2)}s over ${target}s target — catching up`);
+      } else if (this._liveCatchingUp && latency <= target) {
+        this._liveCatchingUp = false;
+        this.applyLiveRate(1);
+        Logger.info(TAG, `Live latency back at ${latency.toFixed(2)}s`);
+      }
+    }, LIVE_LATENCY_INTERVAL_MS);
+  }
+
+  private stopLiveLatencyControl(): void {
+    if (this._liveLatencyTimer) {
+      clearInterval(this._liveLatencyTimer);
+      this._liveLatencyTimer = null;
+    }
+    this._liveCatchingUp = false;
+  }
+
+  // The catch-up rate, applied to the clock and renderers only. Unlike
+  // setPlaybackRate there's no corrective seek and the user rate is untouched.
+  private applyLiveRate(rate: number): void {
+    this.clock.setPlaybackRate(rate);
+    this.audioRenderer?.setPlaybackRate(rate);
+    this.videoRenderer?.setPlaybackRate(rate);
+  }
+
   /**
    * Configure decoders for active tracks
    */
   private async configureDecoders(): Promise<void> {
     if (!this.demuxer) return;
+    this._loadShedding = false;
+    this._dropTier = 0;
 
     // Configure video renderer/decoder
     const videoTrack = this.trackManager.getActiveVideoTrack();
@@ -927,6 +1154,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
           TAG,
           `Video decoder configured: ${videoTrack.codec} ${videoTrack.width}x${videoTrack.height}`,
         );
+        this._loadShedding = this.setupLoadShedding(videoTrack.id);
         if (this.videoRenderer) {
           // Pass color space metadata for HDR detection and frame rate for 60fps conversion
           // Support manual frame rate override (fps parameter)
@@ -942,6 +1170,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
             videoTrack.isHDR,
             videoTrack.pixelFormat,
           );
+          this.setupTemporalScaling(videoTrack.id, videoTrack.frameRate);
         }
       } else {
         Logger.warn(TAG, "Failed to configure video decoder");
@@ -2861,16 +3090,24 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
                 TAG,
                 `Processing subtitle packet: stream=${packet.streamIndex}, size=${packet.data.length}, timestamp=${packet.timestamp.toFixed(3)}s, duration=${duration > 0 ? duration.toFixed(3) : "fallback"}s`,
               );
-              this.subtitleDecoder
-                .decode(
-                  packet.data,
-                  packet.timestamp,
-                  packet.keyframe,
+              if (this.subtitleDecoder.canBatch()) {
+                this._subtitleBatchPending.push({
+                  data: packet.data,
+                  timestamp: packet.timestamp,
                   duration,
-                )
-                .catch((error) => {
-                  Logger.error(TAG, "Subtitle decode error", error);
                 });
+              } else {
+                this.subtitleDecoder
+                  .decode(
+                    packet.data,
+                    packet.timestamp,
+                    packet.keyframe,
+                    duration,
+                  )
+                  .catch((error) => {
+                    Logger.error(TAG, "Subtitle decode error", error);
+                  });
+              }
             }
           }
         }
@@ -2944,6 +3181,13 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
         this._audioBatchPending = [];
         this.submitAudioPackets(batch);
       }
+      if (this._subtitleBatchPending.length > 0 && this.subtitleDecoder) {
+        const batch = this._subtitleBatchPending;
+        this._subtitleBatchPending = [];
+        this.subtitleDecoder.decodeBatch(batch).catch((error) => {
+          Logger.error(TAG, "Subtitle batch decode error", error);
+        });
+      }
     }
   };
 
@@ -3198,12 +3442,15 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       // stale timestamps. play() re-seeks, which is why pause→play was enough
       // to trigger it: the batch stranded by the pause got replayed on resume.
       this._audioBatchPending = [];
+      this._subtitleBatchPending = [];
       Logger.info(TAG, `seek: decoders flushed`);
 
       // Clear video frame queue to prevent old frames from being displayed
       if (this.videoRenderer) {
         this.videoRenderer.clearQueue();
       }
+      // A user seek released on a scrub preview shows its keyframe now
+      if (!opts) this.presentScrubFrame(seconds + this.startTime);
 
       // Flush audio renderer (clears buffers)
       this.audioRenderer.reset();
@@ -3373,6 +3620,24 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     return false;
   }
 
+  /**
+   * Draw the keyframe the preview pipeline decoded for the scrub position on
+   * the main canvas when `mediaTime` falls in its GOP. The seek still decodes
+   * its exact target; this only fills the wait for the keyframe decode.
+   */
+  private presentScrubFrame(mediaTime: number): void {
+    const gop = this.scrubGop;
+    if (!gop || !this.videoRenderer || !this.thumbnailRenderer) return;
+    if (mediaTime < gop.start || !(mediaTime < gop.end)) return;
+    const frame = this.thumbnailRenderer.getHeldFrame(gop.start);
+    if (!frame) return;
+    try {
+      this.videoRenderer.render(frame);
+    } catch (e) {
+      Logger.debug(TAG, "Scrub frame hand-off failed", e);
+    }
+  }
+
   /**
    * Initialize WebGL context for thumbnail rendering
    */
@@ -3445,9 +3710,10 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       // output callback. Null (2D sources) keeps the flat passthrough path.
       this.thumbnailRenderer.setProjection(view ?? null);
 
-      // Read keyframe from thumbnailer
-      // Convert time to media time (PTS) by adding startTime
-      const packetSize = await this.thumbnailBindings.readKeyframe(time);
+      // Read keyframe from thumbnailer (through the scrub cursor when the
+      // module has it). Takes UI time; the packet pts comes back in media time.
+      const scrub = this.thumbnailBindings.supportsScrub();
+      const packetSize = await this.thumbnailBindings.scrubKeyframe(time);
       Logger.debug(
         TAG,
         `Thumbnail readKeyframe(${time.toFixed(2)}s): size=${packetSize}`,
@@ -3462,6 +3728,13 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       }
 
       const timestamp = this.thumbnailBindings.getPacketPts();
+      const gopEnd = scrub ? this.thumbnailBindings.getScrubGopEnd() : -1;
+      // Still inside the last preview's GOP: same keyframe, same tile (360°
+      // previews depend on the view too, so they're always redrawn)
+      if (!view && this.lastPreview?.pts === timestamp) {
+        this.scrubGop = { start: timestamp, end: gopEnd };
+        return this.lastPreview.blob;
+      }
       const dataPtr = this.thumbnailBindings.getPacketData();
 
       Logger.debug(
@@ -3768,12 +4041,14 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
         try {
           // Get width/height from active video track
           const videoTrack = this.trackManager.getActiveVideoTrack();
-          let width = 320; // Default small
+          let width = PREVIEW_DECODE_WIDTH;
           let height = 180;
 
-          if (videoTrack) {
-            width = videoTrack.width;
-            height = videoTrack.height;
+          // Scale straight to preview size: the hover tile is small, and
+          // full-resolution RGBA of a 4K frame is ~33MB per hover
+          if (videoTrack?.width && videoTrack?.height) {
+            width = Math.min(PREVIEW_DECODE_WIDTH, videoTrack.width) & ~1;
+            height = Math.max(2, Math.round((width * videoTrack.height) / videoTrack.width) & ~1);
           }
 
           const rgba = this.thumbnailBindings!.decodeCurrentPacket(
@@ -3793,21 +4068,27 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
       }
 
       if (rendered) {
+        // Only a WebCodecs decode leaves a held frame for seek hand-off
+        this.scrubGop = this.thumbnailRenderer!.getHeldFrame(timestamp)
+          ? { start: timestamp, end: gopEnd }
+          : null;
         const canvas = this.thumbnailRenderer!.getCanvas();
+        let blob: Blob | null = null;
         if ("toBlob" in canvas) {
-          return new Promise<Blob | null>((resolve) => {
+          blob = await new Promise<Blob | null>((resolve) => {
             // @ts-ignore
             canvas.toBlob((blob) => resolve(blob), "image/jpeg", 0.7);
           });
-        }
-        // If OffscreenCanvas (unlikely here but possible if strict types used)
-        if ("convertToBlob" in canvas) {
+        } else if ("convertToBlob" in canvas) {
+          // If OffscreenCanvas (unlikely here but possible if strict types used)
           // @ts-ignore
-          return await canvas.convertToBlob({
+          blob = await canvas.convertToBlob({
             type: "image/jpeg",
             quality: 0.7,
           });
         }
+        this.lastPreview = blob && !view && scrub ? { pts: timestamp, blob } : null;
+        return blob;
       }
 
       return null;
@@ -3852,6 +4133,48 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     return results;
   }
 
+  /**
+   * Build a seekbar storyboard: `count` evenly spaced keyframe tiles in one
+   * sprite sheet plus a timestamp map (see findStoryboardCue). Extraction is
+   * swept in parallel over several isolated thumbnail contexts; the result
+   * is cached per options for the lifetime of the current source.
+   */
+  async generateStoryboard(options: StoryboardOptions = {}): Promise<Storyboard | null> {
+    if (this._audioOnly || this.streamWrapper || !this.previewsAllowed()) return null;
+    const duration = this.mediaInfo?.duration ?? 0;
+    const track = this.trackManager.getActiveVideoTrack() ?? this.trackManager.getVideoTracks()[0];
+    if (duration <= 0 || !track || this.fileSize <= 0) return null;
+
+    const count = Math.max(1, Math.round(options.count ?? 100));
+    const key = `${count}:${options.tileWidth ?? ""}:${options.columns ?? ""}`;
+    const cached = this.storyboards.get(key);
+    if (cached) return cached;
+
+    const demuxer = this.demuxer;
+    const interval = duration / count;
+    // Tile centres, in media time (PTS) like getPreviewFrame's callers
+    const times = Array.from({ length: count }, (_, i) => this.startTime + interval * (i + 0.5));
+    const generator = new StoryboardGenerator({
+      createSource: () => this.createAuxiliarySource(true),
+      releaseSource: (source) => {
+        if (source !== this.source) source.close();
+      },
+      fileSize: this.fileSize,
+      videoWidth: track.width,
+      videoHeight: track.height,
+      wasmBinary: this.config.wasmBinary,
+      seekIndex: this.seekIndexBlob,
+      probeDescriptor: this.probeDescriptor,
+    });
+    const board = await generator.generate(
+      times,
+      options,
+      () => this._destroyed || this.demuxer !== demuxer,
+    );
+    if (board && this.demuxer === demuxer) this.storyboards.set(key, board);
+    return board;
+  }
+
   private async initPreviewPipeline() {
     if (this.thumbnailBindings) return; // Already initialized
 
@@ -3945,12 +4268,29 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     Logger.debug(TAG, `Thumbnail context create result: ${created}`);
     if (!created) throw new Error("Failed to create thumbnail context");
 
+    // Previews are small: let the software decoder skip in-loop filtering,
+    // film grain and (where supported) full-resolution output
+    this.thumbnailBindings.setFastDecode(PREVIEW_DECODE_WIDTH);
+    // The preview decoder is configured from this player's probed track below,
+    // so the cursor needs nothing from a second stream probe
+    this.thumbnailBindings.setHeaderOnlyOpen(true);
+    if (this.probeDescriptor) {
+      this.thumbnailBindings.setProbeDescriptor(this.probeDescriptor);
+    }
+
     const opened = await this.thumbnailBindings.open();
     Logger.debug(TAG, `Thumbnail context open result: ${opened}`);
     if (!opened) throw new Error("Failed to open thumbnail media");
 
+    if (this.seekIndexBlob) {
+      this.thumbnailBindings.importSeekIndex(this.seekIndexBlob);
+    }
+
     // Initialize Renderer
     this.thumbnailRenderer = new ThumbnailRenderer();
+    if (this.thumbnailBindings.supportsScrub()) {
+      this.thumbnailRenderer.setHoldLastFrame(true);
+    }
 
     let videoTrack = this.trackManager.getActiveVideoTrack();
     if (!videoTrack) {
@@ -3999,6 +4339,8 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
   }
 
   private destroyPreviewPipeline() {
+    this.scrubGop = null;
+    this.lastPreview = null;
     if (this.thumbnailBindings) {
       this.thumbnailBindings.destroy();
       this.thumbnailBindings = null;
@@ -4401,6 +4743,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
    */
   setHDREnabled(enabled: boolean): void {
     this.thumbnailHDREnabled = enabled;
+    this.lastPreview = null;
     if (this.videoRenderer && (this.videoRenderer as any).setHDREnabled) {
       (this.videoRenderer as any).setHDREnabled(enabled);
     }
@@ -4541,6 +4884,8 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
    * Set playback rate
    */
   setPlaybackRate(rate: number): void {
+    this._liveUserRate = rate;
+    this._liveCatchingUp = false;
     if (this.streamWrapper) {
       this.streamWrapper.setPlaybackRate(rate);
     }
@@ -5334,6 +5679,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
 
   /** True for a live (dynamic) adaptive stream — drives the LIVE indicator. */
   isLiveStream(): boolean {
+    if (this.demuxer?.isLive()) return true;
     // Shaka-only extras — undefined on the hls.js/dash.js fallback wrappers.
     return (this.streamWrapper as any)?.isLive?.() ?? false;
   }
@@ -5345,6 +5691,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
 
   /** Live-edge time of a live stream (seekable range end). */
   getLiveEdge(): number {
+    if (this.demuxer?.isLive()) return this.demuxer.getLiveEdge();
     return (this.streamWrapper as any)?.getLiveEdge?.() ?? this.getDuration();
   }
 
@@ -5543,12 +5890,66 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     return this.videoRenderer.getAllCues();
   }
 
+  /**
+   * Seed the renderer from a cue index: read back from SeekIndexStore when
+   * this track was indexed before, otherwise built on an isolated context
+   * over an auxiliary reader while playback carries on. Returns false when
+   * the module or source can't do that, so the caller falls back to the
+   * in-place scan; true otherwise, including when the build was abandoned
+   * because the file or subtitle track changed underneath it.
+   */
+  private async loadCueIndex(trackId: number): Promise<boolean> {
+    const demuxer = this.demuxer;
+    const source = this.source;
+    if (!demuxer || !source || this.fileSize <= 0) return false;
+    if (!demuxer.getBindings()?.supportsCueIndex()) return false;
+    const stale = () =>
+      this._destroyed ||
+      this.demuxer !== demuxer ||
+      this.trackManager.getActiveSubtitleTrack()?.id !== trackId;
+
+    const key = `${await this.getSourceFingerprint(source)}:cues:${trackId}`;
+    if (stale()) return true;
+
+    let blob = await SeekIndexStore.get(key);
+    if (stale()) return true;
+    if (blob && !demuxer.importCueIndex(blob)) {
+      await SeekIndexStore.delete(key);
+      blob = null;
+    }
+
+    if (!blob) {
+      const cueSource = this.createAuxiliarySource(false);
+      if (!cueSource) return false;
+      Logger.info(TAG, `Building cue index for subtitle stream ${trackId}...`);
+      blob = await Demuxer.buildCueIndex(cueSource, trackId, this.config.wasmBinary, stale);
+      if (cueSource !== this.source) cueSource.close();
+      if (stale()) return true;
+      if (!blob || !demuxer.importCueIndex(blob)) return false;
+      await SeekIndexStore.put(key, blob);
+      if (stale()) return true;
+    }
+
+    const cues = demuxer.getCuesInRange(-Infinity, Infinity) ?? [];
+    if (!this.videoRenderer) return true;
+    if (cues.length > 0) {
+      this.videoRenderer.setSubtitleCues(cues);
+      Logger.info(TAG, `Loaded ${cues.length} subtitle cues for stream ${trackId}`);
+    } else {
+      Logger.warn(TAG, `Cue index has no cues for stream ${trackId}`);
+    }
+    // An empty index is still an answer; rescanning wouldn't find more.
+    this.prefetchedSubtitleStream = trackId;
+    return true;
+  }
+
   /**
    * Scan the active subtitle stream and seed the renderer with every cue.
    * No-op when the same stream has already been prefetched, when no
-   * subtitle is selected, or when a prefetch is in flight. The demuxer is
-   * left at EOF after the C-side scan, so we re-seek back to the current
-   * playback position before returning.
+   * subtitle is selected, or when a prefetch is in flight. Prefers the cue
+   * index (loadCueIndex), which leaves playback alone; otherwise the C-side
+   * scan runs on the playback context, leaving the demuxer at EOF, so we
+   * re-seek back to the current playback position before returning.
    */
   private async prefetchActiveSubtitleStream(): Promise<void> {
     if (this.prefetchInFlight) return;
@@ -5563,6 +5964,16 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     // and which the user-shift UI doesn't apply to anyway.
     if (subtitleTrack.subtitleType && subtitleTrack.subtitleType !== "text") return;
 
+    this.prefetchInFlight = true;
+    try {
+      if (await this.loadCueIndex(subtitleTrack.id)) return;
+    } catch (err) {
+      Logger.warn(TAG, "Cue index unavailable, falling back to in-place scan", err);
+    } finally {
+      this.prefetchInFlight = false;
+    }
+    if (!this.demuxer || !this.videoRenderer) return;
+
     this.prefetchInFlight = true;
     const resumeTime = this.clock.getTime();
     const wasPlaying = this.stateManager.getState() === "playing";
@@ -5765,6 +6176,27 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     return this.audioRenderer.getStableAudio();
   }
 
+  /**
+   * Play software-decoded audio through a SharedArrayBuffer ring drained by an
+   * AudioWorklet, so main-thread stalls no longer starve audio output.
+   * Requires a cross-origin-isolated page; applies from the next seek/load.
+   */
+  setWorkletAudio(enabled: boolean): void {
+    this.audioRenderer.setWorkletOutput(enabled);
+  }
+
+  getWorkletAudio(): boolean {
+    return this.audioRenderer.getWorkletOutput();
+  }
+
+  /**
+   * Fill level and underrun counters of the worklet audio ring (null when
+   * the ring isn't active)
+   */
+  getAudioRingStats(): PCMRingStats | null {
+    return this.audioRenderer.getRingStats();
+  }
+
   /**
    * Get comprehensive player stats for "Stats for nerds" overlay
    */
@@ -5783,6 +6215,14 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     };
   }
 
+  /**
+   * Cumulative WASM stage timings and byte counters for this player's
+   * context; null unless the module was built with MOVI_STATS
+   */
+  getWasmStats(): WasmInstrumentation | null {
+    return this.demuxer?.getBindings()?.getWasmStats() ?? null;
+  }
+
   getStats(): Record<string, string | number | boolean> {
     // HLS mode: delegate to HLS wrapper
     if (this.streamWrapper) {
@@ -5871,9 +6311,39 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     stats["Audio Buffer"] = `${audioBuffered.toFixed(2)}s`;
     stats["Video Queue"] = `${rendererStats?.frameQueueSize ?? 0} frames`;
     stats["Frames Rendered"] = rendererStats?.framesPresented ?? 0;
+    if (this._loadShedding) {
+      stats["Drop Tier"] = this._dropTier;
+      stats["Dropped Packets"] = this.demuxer?.getBindings()?.getLoadShedDropped() ?? 0;
+    }
+    if (this._temporalLayer >= 0) {
+      stats["Temporal Layers"] = `0-${this._temporalLayer} (${this.demuxer?.getBindings()?.getTemporalDropped(this._temporalTrack) ?? 0} packets dropped)`;
+    }
+    if (this.demuxer?.isLive()) {
+      const latency = this.demuxer.getLiveEdge() - this.clock.getTime();
+      const queued = this.demuxer.getBindings()?.getLiveBuffered() ?? 0;
+      stats["Live Latency"] = `${latency.toFixed(2)}s${this._liveCatchingUp ? " (catching up)" : ""}, ${(queued / 1024).toFixed(0)} KB queued`;
+    }
     stats["Video Decoder Queue"] = videoDecoderStats.queueSize;
+    const pipeline = videoDecoderStats.pipeline;
+    if (pipeline) {
+      // Ring occupancy per stage (queued/capacity) and how often each stage
+      // had to wait on the next one
+      const cap = pipeline.capacity;
+      stats["Decode Pipeline"] =
+        `packets ${pipeline.packetsQueued}/${cap}, decoded ${pipeline.decodedQueued}/${cap}, ` +
+        `ready ${pipeline.outputQueued}/${cap}`;
+      stats["Pipeline Stalls"] =
+        `demux ${pipeline.sendsRefused}, decode ${pipeline.decodeStalls}, convert ${pipeline.convertStalls}`;
+    }
     stats["Audio Decoder Queue"] = audioDecoderStats.queueSize;
 
+    // WASM heap, shared by every player on the module
+    const wasmMem = this.demuxer?.getBindings()?.getContextManager().getUsage();
+    if (wasmMem) {
+      stats["WASM Heap"] = `${(wasmMem.heapSize / 1048576).toFixed(0)} MB`;
+      stats["WASM Allocated"] = `${(wasmMem.allocated / 1048576).toFixed(0)} MB (${wasmMem.contexts.length} contexts)`;
+    }
+
     // Memory usage (Chrome only)
     const mem = (performance as any).memory;
     if (mem) {
@@ -6789,6 +7259,106 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
    * project memory "Album Art Crashes WASM"). Using only the existing
    * thumbnail read/packet exports keeps the WASM binary byte-identical.
    */
+  private async setupSeekIndex(): Promise<void> {
+    const demuxer = this.demuxer;
+    const source = this.source;
+    const track = this.trackManager.getVideoTracks()[0];
+    if (!demuxer || !source || !track || this.fileSize <= 0) return;
+    if (!demuxer.isSeekIndexNeeded(track.id)) return;
+
+    try {
+      const fingerprint = await this.getSourceFingerprint(source);
+      if (this.demuxer !== demuxer) return;
+
+      const cached = await SeekIndexStore.get(fingerprint);
+      if (this.demuxer !== demuxer) return;
+      if (cached) {
+        if (demuxer.importSeekIndex(cached)) {
+          this.seekIndexBlob = cached;
+          this.thumbnailBindings?.importSeekIndex(cached);
+          return;
+        }
+        await SeekIndexStore.delete(fingerprint);
+      }
+
+      // Building reads the entire file — free for a local File, a full
+      // download for HTTP — so remote sources only build when asked to.
+      const isLocal = source instanceof FileSource;
+      if (!(this.config.seekIndex ?? isLocal)) return;
+      const indexSource = this.createAuxiliarySource(false);
+      if (!indexSource) return;
+
+      const blob = await Demuxer.buildSeekIndex(
+        indexSource,
+        track.id,
+        this.config.wasmBinary,
+        () => this._destroyed || this.demuxer !== demuxer,
+      );
+      if (indexSource !== this.source) indexSource.close();
+      if (!blob || this._destroyed || this.demuxer !== demuxer) return;
+
+      await SeekIndexStore.put(fingerprint, blob);
+      if (demuxer.importSeekIndex(blob)) {
+        this.seekIndexBlob = blob;
+        this.thumbnailBindings?.importSeekIndex(blob);
+      }
+    } catch (e) {
+      Logger.warn(TAG, "Seek index setup failed (non-critical)", e);
+    }
+  }
+
+  /**
+   * Look up a stream descriptor stored by an earlier load of this source
+   * and hand it to the demuxer before it opens. Returns the descriptor's
+   * SeekIndexStore key (`<fingerprint>:probe`), or null when the source can't
+   * be fingerprinted (unknown size). Also caches fileSize.
+   */
+  private async loadProbeDescriptor(demuxer: Demuxer, source: SourceAdapter): Promise<string | null> {
+    try {
+      this.fileSize = await source.getSize();
+      if (this.fileSize <= 0) return null;
+      const key = `${await this.getSourceFingerprint(source)}:probe`;
+      const cached = await SeekIndexStore.get(key);
+      if (cached) demuxer.setProbeDescriptor(cached);
+      return key;
+    } catch (e) {
+      Logger.warn(TAG, "Stream descriptor lookup failed (non-critical)", e);
+      return null;
+    }
+  }
+
+  /**
+   * SeekIndexStore key for the open file. Keyed on the source identity plus
+   * the first 4KB, so a different file behind the same URL doesn't match.
+   * The head is already in the source's cache from open().
+   */
+  private async getSourceFingerprint(source: SourceAdapter): Promise<string> {
+    const head = new Uint8Array(await source.read(0, Math.min(4096, this.fileSize)));
+    return generateSourceFingerprint(source.getKey(), this.fileSize, head);
+  }
+
+  /**
+   * A separate reader for background passes (seek index, storyboard), so
+   * their reads don't evict the playback source's cache or move its
+   * read-ahead. Custom adapters can't be duplicated and are shared. Encrypted
+   * sources are shared when `shareEncrypted` (as the preview pipeline does)
+   * and otherwise skipped: a second session looks like concurrent playback.
+   */
+  private createAuxiliarySource(shareEncrypted: boolean): SourceAdapter | null {
+    const sourceConfig = this.config.source;
+    if (this.config.sourceAdapter) return this.source;
+    if (this.source instanceof LiveSource) return null;
+    if (!sourceConfig) return null;
+    if (sourceConfig.type === "encrypted") return shareEncrypted ? this.source : null;
+    if (sourceConfig.type === "file" && sourceConfig.file) {
+      return new FileSource(sourceConfig.file, new LRUCache(8));
+    }
+    if (sourceConfig.type === "url" && sourceConfig.url) {
+      return new ThumbnailHttpSource(sourceConfig.url, sourceConfig.headers || {});
+    }
+    return null;
+  }
+
   private async extractCoverArt(): Promise<void> {
     // Opt-in via the `thumb` attribute (maps to config.enablePreviews).
     // Without it the audio source just shows the bare strip — no artwork,
@@ -6875,6 +7445,7 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     }
     this.stopBackgroundTimer();
     this.stopPauseBuffering();
+    this.stopLiveLatencyControl();
     if (this._prefetchThrottleTimer) {
       clearTimeout(this._prefetchThrottleTimer);
       this._prefetchThrottleTimer = null;
@@ -6914,6 +7485,9 @@ export class MoviPlayer extends EventEmitter<PlayerEventMap> {
     if (this.demuxer) {
       this.demuxer.close();
       this.demuxer = null;
+      this.seekIndexBlob = null;
+      this.probeDescriptor = null;
+      this.storyboards.clear();
     }
 
     // Cleanup native audio element (separate audio source)
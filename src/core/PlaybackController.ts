@@ -93,6 +93,7 @@ export class PlaybackController {
         this.audioDecoder.setOnPCM((frame) => {
           this.audioRenderer.renderPCM(frame);
         });
+        this.audioDecoder.setStretchProvider(() => this.audioRenderer.getFusedStretch());
         
         Logger.info(TAG, `Audio decoder initialized: ${audioTrack.codec}`);
       } else {
@@ -1,6 +1,6 @@
 import type { AudioTrack } from "../types";
 import { Logger } from "../utils/Logger";
-import { SoftwareAudioDecoder, type PCMFrame } from "./SoftwareAudioDecoder";
+import { SoftwareAudioDecoder, type FusedStretch, type PCMFrame } from "./SoftwareAudioDecoder";
 import { WasmBindings } from "../wasm/bindings";
 
 const TAG = "AudioDecoder";
@@ -34,6 +34,7 @@ export class MoviAudioDecoder {
   // either passes it through (if destination.channelCount matches)
   // or lets Web Audio do its own downmix.
   private _downmix = true;
+  private stretchProvider: (() => FusedStretch | null) | null = null;
 
   constructor() {
     Logger.debug(TAG, "Created");
@@ -44,6 +45,15 @@ export class MoviAudioDecoder {
     if (this.swDecoder) this.swDecoder.setDownmix(downmix);
   }
 
+  /**
+   * Let software batches stretch in WASM through the renderer's stretcher
+   * (see SoftwareAudioDecoder.setStretchProvider). Survives reconfigure.
+   */
+  setStretchProvider(provider: (() => FusedStretch | null) | null): void {
+    this.stretchProvider = provider;
+    if (this.swDecoder) this.swDecoder.setStretchProvider(provider);
+  }
+
   setBindings(bindings: WasmBindings) {
     this.bindings = bindings;
   }
@@ -236,6 +246,7 @@ export class MoviAudioDecoder {
     // (e.g. an audio-track switch) doesn't snap back to stereo while
     // the renderer is still wired for multi-channel output.
     this.swDecoder.setDownmix(this._downmix);
+    this.swDecoder.setStretchProvider(this.stretchProvider);
     this.swDecoder.setOnData((frame) => {
       if (this.onPCM) this.onPCM(frame);
       else this.pendingPCM.push(frame);
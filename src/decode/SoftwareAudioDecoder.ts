@@ -14,6 +14,23 @@ export interface PCMFrame {
   numberOfChannels: number;
   sampleRate: number;
   timestamp: number; // micro-seconds, matches AudioData semantics
+  /** Set when the PCM was already time-stretched in WASM for this rate */
+  stretchedRate?: number;
+  /** Source frames a stretched block covers (numberOfFrames is the output) */
+  mediaFrames?: number;
+}
+
+/**
+ * A renderer-owned Signalsmith stretcher the batch decoder may feed directly
+ * (movi_decode_audio_batch_stretch). Only used when it lives in the same WASM
+ * module as the decoder and matches the stream's sample rate.
+ */
+export interface FusedStretch {
+  module: unknown;
+  handle: number;
+  tempo: number;
+  sampleRate: number;
+  channels: number;
 }
 
 export class SoftwareAudioDecoder {
@@ -52,10 +69,20 @@ export class SoftwareAudioDecoder {
   private pending: PCMFrame[] = [];
   private pendingSamples = 0;
 
+  // Source of the fused decode→stretch target; null/absent → plain batches
+  private stretchProvider: (() => FusedStretch | null) | null = null;
+  // Format of the last batch, to match a stretcher before decoding
+  private lastBatchSampleRate = 0;
+  private lastBatchChannels = 0;
+
   constructor(bindings: WasmBindings) {
     this.bindings = bindings;
   }
 
+  setStretchProvider(provider: (() => FusedStretch | null) | null): void {
+    this.stretchProvider = provider;
+  }
+
   setDownmix(downmix: boolean): void {
     this._downmix = downmix;
     if (this.isConfigured) {
@@ -183,7 +210,22 @@ export class SoftwareAudioDecoder {
   decodeBatch(packets: { data: Uint8Array; pts: number }[]): number {
     if (!this.isConfigured || this.isBroken || packets.length === 0) return 0;
 
-    const consumed = this.bindings.decodeAudioBatch(this.trackIndex, packets);
+    // At non-1x rates, stretch inside the same WASM call: the batch planes go
+    // straight into the renderer's Signalsmith instance instead of out to JS,
+    // through an interleave, back into the heap and out again.
+    const fused = this.stretchProvider?.() ?? null;
+    const useFused =
+      !!fused &&
+      fused.module === (this.bindings as any).module &&
+      fused.sampleRate === this.lastBatchSampleRate &&
+      // A channel-grouped stretcher only takes the layout it was built for;
+      // mono into a stereo one is duplicated, as before
+      (fused.channels === this.lastBatchChannels || (fused.channels === 2 && this.lastBatchChannels === 1)) &&
+      this.bindings.supportsAudioBatchStretch();
+
+    const consumed = useFused
+      ? this.bindings.decodeAudioBatchStretched(this.trackIndex, packets, fused!.handle, fused!.tempo)
+      : this.bindings.decodeAudioBatch(this.trackIndex, packets);
 
     if (consumed < 0) {
       this.consecutiveFailures++;
@@ -211,11 +253,36 @@ export class SoftwareAudioDecoder {
     const numberOfChannels = this.bindings.audioBatchChannels();
     const sampleRate = this.bindings.audioBatchSampleRate();
     const pts = this.bindings.audioBatchPts();
+    this.lastBatchSampleRate = sampleRate;
+    this.lastBatchChannels = numberOfChannels;
 
     try {
       // Read HEAPU8 only AFTER the decode call — the batch can grow the heap
       // (ALLOW_MEMORY_GROWTH), which detaches any buffer captured before it.
       const heap = (this.bindings as any).module.HEAPU8 as Uint8Array;
+
+      const stretchedFrames = useFused ? this.bindings.audioBatchStretchedFrames() : 0;
+      if (stretchedFrames > 0) {
+        const module = (this.bindings as any).module;
+        const stretchChannels: number = module._movi_stretch_channels(fused!.handle);
+        const planes: Float32Array[] = new Array(stretchChannels);
+        for (let i = 0; i < stretchChannels; i++) {
+          const ptr = module._movi_stretch_output_plane(fused!.handle, i);
+          if (!ptr) return consumed;
+          planes[i] = new Float32Array(new Float32Array(heap.buffer, ptr, stretchedFrames));
+        }
+        this.enqueueFrame({
+          planes,
+          numberOfFrames: stretchedFrames,
+          numberOfChannels: stretchChannels,
+          sampleRate,
+          timestamp: pts * 1_000_000,
+          stretchedRate: fused!.tempo,
+          mediaFrames: numberOfFrames,
+        });
+        return consumed;
+      }
+
       const planes: Float32Array[] = new Array(numberOfChannels);
       for (let i = 0; i < numberOfChannels; i++) {
         const ptr = this.bindings.audioBatchPlanePointer(i);
@@ -300,13 +367,14 @@ export class SoftwareAudioDecoder {
       return;
     }
 
-    // A channel-count / sample-rate change can't be merged into the current
-    // run — emit what we have first so the two formats stay separate.
+    // A channel-count / sample-rate / stretch change can't be merged into the
+    // current run — emit what we have first so the two formats stay separate.
     const head = this.pending[0];
     if (
       head &&
       (head.numberOfChannels !== frame.numberOfChannels ||
-        head.sampleRate !== frame.sampleRate)
+        head.sampleRate !== frame.sampleRate ||
+        head.stretchedRate !== frame.stretchedRate)
     ) {
       this.flushPending();
     }
@@ -339,13 +407,18 @@ export class SoftwareAudioDecoder {
       }
       planes[c] = out;
     }
-    return {
+    const merged: PCMFrame = {
       planes,
       numberOfFrames: total,
       numberOfChannels: channels,
       sampleRate: first.sampleRate,
       timestamp: first.timestamp, // start of the first accumulated frame
     };
+    if (first.stretchedRate !== undefined) {
+      merged.stretchedRate = first.stretchedRate;
+      merged.mediaFrames = this.pending.reduce((n, f) => n + (f.mediaFrames ?? f.numberOfFrames), 0);
+    }
+    return merged;
   }
 
   get configured(): boolean {
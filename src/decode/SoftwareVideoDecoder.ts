@@ -4,6 +4,24 @@ import { Logger } from "../utils/Logger";
 
 const TAG = "SoftwareVideoDecoder";
 
+// Frame-thread ceiling for the pthreads build. Each frame thread adds a frame
+// of decode latency and a full set of reference surfaces, and gains flatten
+// past ~4 for 1080p-4K HEVC. Must stay within the build's PTHREAD_POOL_SIZE.
+const MAX_DECODER_THREADS = 4;
+
+// Decode run-ahead (movi_pipeline.c): worth its two extra threads only for
+// frames big enough that decode/convert time rivals the frame interval, and
+// only with cores to put them on.
+const PIPELINE_MIN_PIXELS = 1920 * 1080;
+const PIPELINE_MIN_CORES = 4;
+const PIPELINE_DEPTH = 8;
+// How often pipelined frames are collected while packets are in flight, and
+// how long after the last send collection keeps going
+const PIPELINE_POLL_MS = 4;
+const PIPELINE_IDLE_MS = 500;
+// AVERROR(EAGAIN) in Emscripten (EAGAIN = 6)
+const AVERROR_EAGAIN = -6;
+
 export class SoftwareVideoDecoder {
   private bindings: WasmBindings;
   private onFrame: ((frame: VideoFrame) => void) | null = null;
@@ -13,6 +31,16 @@ export class SoftwareVideoDecoder {
 
   private targetFps: number = 0;
   private lastProcessedTimestamp: number = -1;
+  // Set when the browser rejects a planar VideoFrame (e.g. no I420P10
+  // support); every later frame goes through the RGBA conversion instead.
+  private planarExportDisabled = false;
+  // Decode and conversion run on pipeline threads; packets go in through
+  // pipelineSend and frames are collected by collectPipelined
+  private pipelined = false;
+  private pipelineRgba = false;
+  private pipelineTimer: ReturnType<typeof setTimeout> | null = null;
+  private lastSendTime = 0;
+  private lastSentPts = 0;
 
   constructor(bindings: WasmBindings) {
     this.bindings = bindings;
@@ -33,6 +61,19 @@ export class SoftwareVideoDecoder {
     // Reset timestamp tracking on re-configure
     this.lastProcessedTimestamp = -1;
 
+    // Threads must be set before the decoder is opened. Leave one core for the
+    // main thread / renderer, and stay single-threaded for low-FPS consumers
+    // (ambient mode), where latency and CPU matter more than throughput.
+    if (this.bindings.supportsDecoderThreads()) {
+      const cores = navigator.hardwareConcurrency || 1;
+      const threads =
+        this.targetFps > 0 && this.targetFps < 10
+          ? 1
+          : Math.max(1, Math.min(MAX_DECODER_THREADS, cores - 1));
+      const used = this.bindings.setDecoderThreads(threads);
+      Logger.info(TAG, `Software decoder threads: ${used}`);
+    }
+
     // Enable decoder in WASM
     const ret = this.bindings.enableDecoder(this.trackIndex);
     if (ret < 0) {
@@ -43,9 +84,8 @@ export class SoftwareVideoDecoder {
       return false;
     }
 
-    this.isConfigured = true;
-
     // Optimize CPU usage for low frame rates (e.g. ambient mode / thumbnails)
+    // Set before the pipeline takes the decoder over, while it's still idle
     if (this.targetFps > 0 && this.targetFps < 10) {
       // Skip non-reference frames (B-frames) to reduce decoding load
       // This is safe and preserves video flow but drops unnecessary frames
@@ -58,6 +98,9 @@ export class SoftwareVideoDecoder {
       this.bindings.setSkipFrame(this.trackIndex, 0); // 0 = AVDISCARD_NONE
     }
 
+    this.isConfigured = true;
+    this.startPipeline(track);
+
     Logger.info(
       TAG,
       `Configured software decoder for stream ${this.trackIndex} (TargetFPS: ${targetFps})`,
@@ -81,6 +124,41 @@ export class SoftwareVideoDecoder {
     );
   }
 
+  /**
+   * Hand the decoder to pipeline threads for large frames on multi-core
+   * machines, so demux, decode and conversion overlap instead of taking
+   * turns on this thread
+   */
+  private startPipeline(track: VideoTrack): void {
+    this.stopPipeline();
+    if (!this.bindings.supportsDecodePipeline()) return;
+    const cores = navigator.hardwareConcurrency || 1;
+    if (cores < PIPELINE_MIN_CORES) return;
+    if (track.width * track.height < PIPELINE_MIN_PIXELS) return;
+    if (this.targetFps > 0 && this.targetFps < 10) return;
+    if (!this.bindings.startDecodePipeline(this.trackIndex, PIPELINE_DEPTH)) return;
+    this.pipelined = true;
+    Logger.info(TAG, `Decode pipeline started for stream ${this.trackIndex} (depth ${PIPELINE_DEPTH})`);
+  }
+
+  private stopPipeline(): void {
+    if (this.pipelineTimer !== null) {
+      clearTimeout(this.pipelineTimer);
+      this.pipelineTimer = null;
+    }
+    if (!this.pipelined) return;
+    this.bindings.stopDecodePipeline();
+    this.pipelined = false;
+    this.pipelineRgba = false;
+  }
+
+  /**
+   * Stage occupancy of the decode pipeline, or null when decoding inline
+   */
+  getPipelineStats() {
+    return this.pipelined ? this.bindings.getDecodePipelineStats() : null;
+  }
+
   async flush(): Promise<void> {
     this.packetQueue = [];
     if (this.isConfigured && this.trackIndex >= 0) {
@@ -97,6 +175,7 @@ export class SoftwareVideoDecoder {
   }
 
   close(): void {
+    this.stopPipeline();
     this.isConfigured = false;
   }
 
@@ -142,6 +221,21 @@ export class SoftwareVideoDecoder {
           lastYieldTime = performance.now();
         }
 
+        if (this.pipelined) {
+          // Backpressure: a full packet ring keeps the packet queued here
+          // until the decode thread has made room
+          const next = this.packetQueue[0];
+          if (!next) break; // flushed during the yield
+          if (!this.sendPipelined(next)) {
+            this.collectPipelined();
+            await new Promise((resolve) => setTimeout(resolve, PIPELINE_POLL_MS));
+            continue;
+          }
+          this.packetQueue.shift();
+          this.collectPipelined();
+          continue;
+        }
+
         const packet = this.packetQueue.shift();
         if (packet) {
           this.decodeInternal(packet);
@@ -154,6 +248,56 @@ export class SoftwareVideoDecoder {
     }
   }
 
+  /**
+   * Queue a packet on the pipeline; false when its ring is full
+   */
+  private sendPipelined(packet: {
+    data: Uint8Array;
+    pts: number;
+    dts: number;
+    keyframe: boolean;
+  }): boolean {
+    const ret = this.bindings.pipelineSend(
+      packet.data,
+      packet.pts,
+      packet.dts,
+      packet.keyframe,
+    );
+    if (ret === AVERROR_EAGAIN) return false;
+    if (ret < 0) Logger.warn(TAG, `pipelineSend failed: ${ret}`);
+    this.lastSendTime = performance.now();
+    this.lastSentPts = packet.pts;
+    this.schedulePipelinePump();
+    return true;
+  }
+
+  /**
+   * Hand on every frame the pipeline has finished
+   */
+  private collectPipelined(): void {
+    while (this.pipelined && this.bindings.pipelineReceive() === 0) {
+      const framePts = this.bindings.getFramePts(this.trackIndex);
+      const timestamp =
+        framePts >= 0 ? framePts * 1_000_000 : this.lastSentPts * 1_000_000;
+      this.processDecodedFrame(timestamp);
+    }
+  }
+
+  // Frames finish on other threads, so they are collected on a timer for as
+  // long as packets were sent recently (a decoder holding frames back for
+  // reordering releases them with the next packets, which re-arm it)
+  private schedulePipelinePump(): void {
+    if (this.pipelineTimer !== null) return;
+    this.pipelineTimer = setTimeout(() => {
+      this.pipelineTimer = null;
+      if (!this.pipelined || !this.isConfigured) return;
+      this.collectPipelined();
+      if (performance.now() - this.lastSendTime < PIPELINE_IDLE_MS) {
+        this.schedulePipelinePump();
+      }
+    }, PIPELINE_POLL_MS);
+  }
+
   private decodeInternal(packet: {
     data: Uint8Array;
     pts: number;
@@ -206,6 +350,18 @@ export class SoftwareVideoDecoder {
       }
     }
 
+    // Zero-copy path: build the VideoFrame straight from the decoder's pooled
+    // planes in the WASM heap — no sws_scale to RGBA, no JS-side copy, and
+    // high-bit-depth frames keep their precision and HDR color space.
+    if (!this.planarExportDisabled && this.bindings.supportsFrameHandles()) {
+      const frame = this.exportPlanarFrame(timestamp);
+      if (frame) {
+        this.onFrame(frame);
+        this.lastProcessedTimestamp = timestamp;
+        return;
+      }
+    }
+
     let width = this.bindings.getFrameWidth();
     let height = this.bindings.getFrameHeight();
 
@@ -218,10 +374,18 @@ export class SoftwareVideoDecoder {
       height = Math.floor(height * scale);
     }
 
+    // Later frames get converted on the pipeline's convert thread and retain
+    // as RGBA; this one (and any already queued) still converts here
+    if (this.pipelined && !this.pipelineRgba) {
+      this.bindings.setDecodePipelineRgba(width, height);
+      this.pipelineRgba = true;
+    }
+
     try {
       // Use RGBA conversion for proper handling of all formats including 10-bit HDR
-      // WASM's sws_scale converts any pixel format (YUV420P10LE, etc.) to RGBA
-      // We pass the potentially downscaled dimensions here
+      // WASM converts any pixel format to RGBA: 10/12-bit YUV at native or
+      // half size in movi_tonemap.c (threaded in the mt build), the rest with
+      // sws_scale. We pass the potentially downscaled dimensions here
       const rgbaData = this.bindings.getFrameRGBA(width, height);
 
       if (!rgbaData) {
@@ -252,6 +416,32 @@ export class SoftwareVideoDecoder {
     }
   }
 
+  /**
+   * VideoFrame over the retained decoder output, or null to use RGBA
+   */
+  private exportPlanarFrame(timestamp: number): VideoFrame | null {
+    const retained = this.bindings.retainFrame();
+    if (!retained) return null;
+    try {
+      if (!retained.format) return null;
+      // The constructor copies the planes, so the handle can go right after
+      return new VideoFrame(retained.data, {
+        format: retained.format,
+        codedWidth: retained.width,
+        codedHeight: retained.height,
+        timestamp,
+        layout: retained.layout,
+        colorSpace: retained.colorSpace,
+      });
+    } catch (e) {
+      this.planarExportDisabled = true;
+      Logger.warn(TAG, `Planar VideoFrame (${retained.format}) rejected, using RGBA conversion`, e);
+      return null;
+    } finally {
+      retained.release();
+    }
+  }
+
   get configured(): boolean {
     return this.isConfigured;
   }
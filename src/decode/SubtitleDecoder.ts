@@ -4,7 +4,7 @@
 
 import type { SubtitleTrack, SubtitleCue } from '../types';
 import { Logger } from '../utils/Logger';
-import { WasmBindings } from '../wasm/bindings';
+import { WasmBindings, type BatchSubtitleCue } from '../wasm/bindings';
 
 const TAG = 'SubtitleDecoder';
 
@@ -14,6 +14,9 @@ export class SubtitleDecoder {
   private currentTrack: SubtitleTrack | null = null;
   private onCue: ((cue: SubtitleCue) => void) | null = null;
   private onError: ((error: Error) => void) | null = null;
+  // Index planes of the last palettized bitmap cue, in rect order: a rect the
+  // C side reports as unchanged (`ref`) reuses the array at that position
+  private lastBitmapIndices: (Uint8Array | undefined)[] = [];
   
   constructor() {
     Logger.debug(TAG, 'Created');
@@ -59,6 +62,11 @@ export class SubtitleDecoder {
       return false;
     }
 
+    // Batched bitmap cues come out palettized; the renderer expands them on
+    // the GPU. This also resets the C side's diff state to match ours.
+    this.lastBitmapIndices = [];
+    this.bindings.setSubtitlePalettized(true);
+
     this.isConfigured = true;
     Logger.info(TAG, `Subtitle decoder configured for track ${track.id}: ${track.codec}`);
     return true;
@@ -173,6 +181,125 @@ export class SubtitleDecoder {
     }
   }
   
+  /**
+   * Whether decodeBatch() can be used: the module exports the batched
+   * subtitle decoder and a track is configured
+   */
+  canBatch(): boolean {
+    return this.isConfigured && !!this.bindings?.supportsSubtitleBatch();
+  }
+
+  /**
+   * Decode a demux tick's subtitle packets in one WASM call (see
+   * WasmBindings.decodeSubtitleBatch) and emit their cues in order
+   */
+  async decodeBatch(packets: { data: Uint8Array; timestamp: number; duration?: number }[]): Promise<void> {
+    if (!this.isConfigured || !this.bindings || !this.currentTrack || packets.length === 0) return;
+
+    let pending = packets.map((p) => ({
+      data: p.data,
+      pts: p.timestamp,
+      duration: p.duration && p.duration > 0 ? p.duration : 0,
+    }));
+    try {
+      while (pending.length > 0) {
+        // Everything is read out of the heap before the first await, so a
+        // second batch starting meanwhile can't overwrite it.
+        const result = this.bindings.decodeSubtitleBatch(this.currentTrack.id, pending);
+        if (!result) {
+          Logger.warn(TAG, `Subtitle batch decode failed (${pending.length} packets)`);
+          return;
+        }
+        Logger.debug(TAG, `Subtitle batch: ${result.consumed}/${pending.length} packets, ${result.cues.length} cues`);
+        pending = pending.slice(result.consumed);
+        for (const cue of result.cues) {
+          await this.emitBatchCue(cue);
+        }
+      }
+    } catch (error) {
+      Logger.error(TAG, 'Subtitle batch decode error', error);
+      if (this.onError) {
+        this.onError(error as Error);
+      }
+    }
+  }
+
+  private async emitBatchCue(cue: BatchSubtitleCue): Promise<void> {
+    if (cue.images[0]?.palette) {
+      this.emitBitmapCue(cue);
+      return;
+    }
+    // One bitmap per cue, as the per-packet path shows
+    const image = cue.images[0];
+    if (image?.rgba) {
+      let bitmap: ImageBitmap;
+      try {
+        bitmap = await createImageBitmap(
+          new ImageData(new Uint8ClampedArray(image.rgba.buffer), image.width, image.height)
+        );
+      } catch (error) {
+        Logger.error(TAG, 'Failed to create ImageBitmap from subtitle', error);
+        return;
+      }
+      if (!this.onCue) {
+        bitmap.close();
+        return;
+      }
+      this.onCue({
+        start: cue.start,
+        end: cue.end,
+        image: bitmap,
+        position: { x: image.x, y: image.y },
+      });
+    } else if (cue.text && this.onCue) {
+      this.onCue({ start: cue.start, end: cue.end, text: cue.text, style: cue.style });
+    }
+  }
+
+  /**
+   * Emit a palettized cue with every rect, placed inside their bounding box
+   */
+  private emitBitmapCue(cue: BatchSubtitleCue): void {
+    const indices = cue.images.map((image) => image.indices ?? this.lastBitmapIndices[image.ref]);
+    // Whatever happens below, this is the cue the C side diffs the next against
+    this.lastBitmapIndices = indices;
+
+    let left = Infinity;
+    let top = Infinity;
+    let right = -Infinity;
+    let bottom = -Infinity;
+    for (const image of cue.images) {
+      left = Math.min(left, image.x);
+      top = Math.min(top, image.y);
+      right = Math.max(right, image.x + image.width);
+      bottom = Math.max(bottom, image.y + image.height);
+    }
+    const rects: NonNullable<SubtitleCue['bitmap']>['rects'] = [];
+    cue.images.forEach((image, i) => {
+      const plane = indices[i];
+      if (!plane || !image.palette) {
+        Logger.warn(TAG, `Bitmap subtitle rect ${i} has no index plane (ref=${image.ref})`);
+        return;
+      }
+      rects.push({
+        x: image.x - left,
+        y: image.y - top,
+        width: image.width,
+        height: image.height,
+        indices: plane,
+        palette: image.palette,
+      });
+    });
+    if (rects.length === 0 || !this.onCue) return;
+
+    this.onCue({
+      start: cue.start,
+      end: cue.end,
+      bitmap: { width: right - left, height: bottom - top, rects },
+      position: { x: left, y: top },
+    });
+  }
+
   /**
    * Set callback for decoded subtitle cues
    */
@@ -5,7 +5,7 @@
 import type { VideoTrack, VideoDecoderConfig } from "../types";
 import { Logger } from "../utils/Logger";
 import { SoftwareVideoDecoder } from "./SoftwareVideoDecoder";
-import { WasmBindings } from "../wasm/bindings";
+import { WasmBindings, type DecodePipelineStats } from "../wasm/bindings";
 
 import { CodecParser } from "./CodecParser";
 
@@ -1508,11 +1508,17 @@ export class MoviVideoDecoder {
   /**
    * Get decoder stats for nerd stats overlay
    */
-  getStats(): { decoderType: string; queueSize: number; errorCount: number } {
+  getStats(): {
+    decoderType: string;
+    queueSize: number;
+    errorCount: number;
+    pipeline: DecodePipelineStats | null;
+  } {
     return {
       decoderType: this.useSoftware ? "Software (FFmpeg)" : "Hardware (WebCodecs)",
       queueSize: this.queueSize,
       errorCount: this.errorCount,
+      pipeline: this.useSoftware ? (this.swDecoder?.getPipelineStats() ?? null) : null,
     };
   }
 
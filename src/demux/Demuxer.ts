@@ -7,6 +7,8 @@
 //hvc1.4.10.H153.8.9d
 
 import type { SourceAdapter } from "../source/SourceAdapter";
+import { LiveSource } from "../source/LiveSource";
+import { EncryptedHttpSource } from "../source/EncryptedHttpSource";
 import type {
   Track,
   VideoTrack,
@@ -23,6 +25,7 @@ import {
   type MoviWasmModule,
   type StreamInfo,
   type DataSource,
+  type CipherRead,
 } from "../wasm";
 import { CodecParser } from "../decode/CodecParser";
 import { Logger } from "../utils/Logger";
@@ -36,8 +39,16 @@ class SourceDataAdapter implements DataSource {
   private source: SourceAdapter;
   private fileSize: number = 0;
 
+  readCiphertext?: (offset: number, size: number) => Promise<CipherRead>;
+
   constructor(source: SourceAdapter) {
     this.source = source;
+    // Encrypted sources with a CTR session hand ciphertext to the context,
+    // which decrypts it in place (movi_crypt.c)
+    if (source instanceof EncryptedHttpSource && source.isCtrEnabled()) {
+      this.readCiphertext = (offset, size) =>
+        source.readCiphertext(offset, size);
+    }
   }
 
   async getSize(): Promise<number> {
@@ -62,6 +73,20 @@ export class Demuxer {
   private isOpened: boolean = false;
   private wasmBinary?: Uint8Array;
   private useNewWasmInstance: boolean = false;
+  // Packets already demuxed by a batched read but not yet handed out.
+  // Cleared on seek/close so nothing from the old position leaks through.
+  private readQueue: Packet[] = [];
+  // Stream descriptor from an earlier open of the same file, handed to the
+  // context in open() so probing can be skipped
+  private probeDescriptor: Uint8Array | null = null;
+  // Live feed: the newest packet timestamp demuxed so far (seconds), which
+  // the player measures its latency against
+  private liveEdge: number = 0;
+
+  // Packets per movi_read_frames round-trip. Large enough to amortise the
+  // Asyncify + PacketInfo overhead on ~1000 packets/s audio (TrueHD), small
+  // enough that one batch never holds more than a few frames of video.
+  private static readonly READ_BATCH_SIZE = 16;
 
   /**
    * @param source - Data source adapter
@@ -102,9 +127,30 @@ export class Demuxer {
     const dataSource = new SourceDataAdapter(this.source);
     this.bindings.setDataSource(dataSource);
 
+    if (this.probeDescriptor) {
+      this.bindings.setProbeDescriptor(this.probeDescriptor);
+      this.probeDescriptor = null;
+    }
+
+    // Live feed: switch the context to pushed input before open, then start
+    // the feed so the probe reads below have bytes to wait on
+    if (this.source instanceof LiveSource) {
+      if (!this.bindings.setLive(true)) {
+        throw new Error("Live input is not supported by this WASM build");
+      }
+      const bindings = this.bindings;
+      await this.source.start({
+        push: (chunk) => bindings.pushBytes(chunk),
+        end: () => bindings.endLive(),
+      });
+    }
+
     // Open media (async - uses Asyncify for I/O)
     const streamCount = await this.bindings.open();
-    Logger.info(TAG, `Opened with ${streamCount} streams`);
+    Logger.info(
+      TAG,
+      `Opened with ${streamCount} streams${this.bindings.isProbeDescriptorApplied() ? " (cached descriptor)" : ""}`,
+    );
 
     this.isOpened = true;
 
@@ -453,6 +499,7 @@ export class Demuxer {
       throw new Error("Demuxer not opened");
     }
 
+    this.readQueue = [];
     await this.bindings.seek(timestamp, -1, flags);
   }
 
@@ -464,10 +511,28 @@ export class Demuxer {
       throw new Error("Demuxer not opened");
     }
 
-    const result = await this.bindings.readFrame();
-    if (!result) return null;
+    if (this.readQueue.length === 0) {
+      this.readQueue = await this.readPackets(Demuxer.READ_BATCH_SIZE);
+    }
+    return this.readQueue.shift() ?? null;
+  }
+
+  /**
+   * Read up to `max` packets in one WASM round-trip. Returns an empty array
+   * at EOF. Bypasses (and must not be mixed with) readPacket's internal queue.
+   */
+  async readPackets(max: number): Promise<Packet[]> {
+    if (!this.bindings || !this.isOpened) {
+      throw new Error("Demuxer not opened");
+    }
 
-    return {
+    const results = await this.bindings.readFrames(max);
+    if (this.bindings.isLive()) {
+      for (const result of results) {
+        if (result.info.pts > this.liveEdge) this.liveEdge = result.info.pts;
+      }
+    }
+    return results.map((result) => ({
       streamIndex: result.info.streamIndex,
       keyframe: result.info.keyframe,
       timestamp: result.info.pts,
@@ -477,7 +542,8 @@ export class Demuxer {
       isIdr: result.info.isIdr,
       isRasl: result.info.isRasl,
       disposable: result.info.disposable,
-    };
+      temporalId: result.info.temporalId,
+    }));
   }
 
   /**
@@ -487,10 +553,29 @@ export class Demuxer {
     return this.duration;
   }
 
+  /**
+   * Whether this demuxer reads a pushed live feed
+   */
+  isLive(): boolean {
+    return this.bindings?.isLive() ?? false;
+  }
+
+  /**
+   * Newest timestamp demuxed from a live feed (seconds), 0 before the first
+   * packet or for non-live input
+   */
+  getLiveEdge(): number {
+    return this.liveEdge;
+  }
+
   /**
    * Close and cleanup
    */
   close(): void {
+    // Stop the feed first so no chunk is pushed into a destroyed context
+    if (this.source instanceof LiveSource) {
+      this.source.close();
+    }
     if (this.bindings) {
       this.bindings.destroy();
       this.bindings = null;
@@ -498,6 +583,8 @@ export class Demuxer {
 
     this.isOpened = false;
     this.tracks = [];
+    this.readQueue = [];
+    this.liveEdge = 0;
 
     Logger.info(TAG, "Demuxer closed");
   }
@@ -546,6 +633,172 @@ export class Demuxer {
     }
   }
 
+  /**
+   * Use a descriptor from exportProbeDescriptor for the next open(). It is
+   * only trusted if the container header matches it; otherwise open() probes
+   * as usual.
+   */
+  setProbeDescriptor(blob: Uint8Array | null): void {
+    this.probeDescriptor = blob;
+  }
+
+  /**
+   * The opened file's probed stream parameters, serialised for a later
+   * open() (or an isolated context) to skip probing. Null before open and on
+   * modules without the export.
+   */
+  exportProbeDescriptor(): Uint8Array | null {
+    if (!this.bindings || !this.isOpened) return null;
+    return this.bindings.exportProbeDescriptor();
+  }
+
+  /**
+   * Whether open() used the descriptor given to setProbeDescriptor
+   */
+  isProbeDescriptorApplied(): boolean {
+    if (!this.bindings || !this.isOpened) return false;
+    return this.bindings.isProbeDescriptorApplied();
+  }
+
+  /**
+   * Whether a persistent seek index would speed up seeking on this track
+   * (the container has no usable index of its own). False on modules
+   * without the seek-index exports.
+   */
+  isSeekIndexNeeded(trackId: number): boolean {
+    if (!this.bindings || !this.isOpened) return false;
+    if (!this.bindings.supportsSeekIndex()) return false;
+    return this.bindings.isSeekIndexNeeded(trackId);
+  }
+
+  /**
+   * Load an index produced by buildSeekIndex. Returns false when the blob
+   * was rejected (different file, corrupt, or unsupported module).
+   */
+  importSeekIndex(blob: Uint8Array): boolean {
+    if (!this.bindings || !this.isOpened) return false;
+    const count = this.bindings.importSeekIndex(blob);
+    if (count < 0) {
+      Logger.warn(TAG, `Seek index rejected: error ${count}`);
+      return false;
+    }
+    Logger.info(TAG, `Imported seek index: ${count} entries`);
+    return true;
+  }
+
+  /**
+   * Read the whole file once and return a serialised keyframe index for one
+   * track, or null if it couldn't be built (or `isCancelled` returned true).
+   *
+   * Like extractAttachedPicture this runs on a short-lived isolated WASM
+   * context: the pass discards every other stream and reads to EOF, which
+   * would wreck the playback demuxer's position. Steps are small and yield to
+   * the event loop in between, so the pass can run behind playback and be
+   * abandoned at any point (source switch, destroy).
+   */
+  static async buildSeekIndex(
+    source: SourceAdapter,
+    trackId: number,
+    wasmBinary?: Uint8Array,
+    isCancelled: () => boolean = () => false,
+  ): Promise<Uint8Array | null> {
+    let bindings: WasmBindings | null = null;
+    try {
+      const module = await loadWasmModuleNew({ wasmBinary });
+      bindings = new WasmBindings(module);
+      if (!bindings.supportsSeekIndex() || !bindings.create()) return null;
+      bindings.setDataSource(new SourceDataAdapter(source));
+      await bindings.open();
+      if (!bindings.beginSeekIndex(trackId)) return null;
+
+      const started = performance.now();
+      while (await bindings.stepSeekIndex(256)) {
+        if (isCancelled()) return null;
+        await new Promise((resolve) => setTimeout(resolve, 0));
+      }
+
+      const blob = bindings.exportSeekIndex();
+      Logger.info(
+        TAG,
+        `Built seek index in ${Math.round(performance.now() - started)}ms (${blob?.length ?? 0} bytes)`,
+      );
+      return blob;
+    } catch (e) {
+      Logger.warn(TAG, "Seek index build failed", e);
+      return null;
+    } finally {
+      bindings?.destroy();
+    }
+  }
+
+  /**
+   * Load a cue index produced by buildCueIndex, after which getCuesInRange
+   * answers from it. Returns false when the blob was rejected.
+   */
+  importCueIndex(blob: Uint8Array): boolean {
+    if (!this.bindings || !this.isOpened) return false;
+    const count = this.bindings.importCueIndex(blob);
+    if (count < 0) {
+      Logger.warn(TAG, `Cue index rejected: error ${count}`);
+      return false;
+    }
+    Logger.info(TAG, `Imported cue index: ${count} cues`);
+    return true;
+  }
+
+  /**
+   * Text cues overlapping [start, end) seconds from the imported cue index,
+   * or null without one
+   */
+  getCuesInRange(start: number, end: number): { start: number; end: number; text: string }[] | null {
+    if (!this.bindings || !this.isOpened) return null;
+    return this.bindings.getCuesInRange(start, end);
+  }
+
+  /**
+   * Decode every cue of one text subtitle track and return the serialised
+   * cue index, or null if it couldn't be built (or `isCancelled` returned
+   * true). Same shape as buildSeekIndex: an isolated context, small steps
+   * with a yield between them. Steps are also capped in bytes, which is what
+   * bounds them on MPEG-TS, where the subtitle stream can't be read without
+   * reading everything around it.
+   */
+  static async buildCueIndex(
+    source: SourceAdapter,
+    trackId: number,
+    wasmBinary?: Uint8Array,
+    isCancelled: () => boolean = () => false,
+  ): Promise<Uint8Array | null> {
+    let bindings: WasmBindings | null = null;
+    try {
+      const module = await loadWasmModuleNew({ wasmBinary });
+      bindings = new WasmBindings(module);
+      if (!bindings.supportsCueIndex() || !bindings.create()) return null;
+      bindings.setDataSource(new SourceDataAdapter(source));
+      await bindings.open();
+      if (bindings.enableDecoder(trackId) < 0) return null;
+      if (!(await bindings.beginCueIndex(trackId))) return null;
+
+      const started = performance.now();
+      while (await bindings.stepCueIndex(256, 4 * 1024 * 1024)) {
+        if (isCancelled()) return null;
+        await new Promise((resolve) => setTimeout(resolve, 0));
+      }
+
+      const blob = bindings.exportCueIndex();
+      Logger.info(
+        TAG,
+        `Built cue index in ${Math.round(performance.now() - started)}ms (${blob?.length ?? 0} bytes)`,
+      );
+      return blob;
+    } catch (e) {
+      Logger.warn(TAG, "Cue index build failed", e);
+      return null;
+    } finally {
+      bindings?.destroy();
+    }
+  }
+
   getBindings(): WasmBindings | null {
     return this.bindings;
   }
@@ -42,6 +42,7 @@ export type {
 // Utilities
 export { Logger, LogLevel } from './utils/Logger';
 export { Time, TIME_BASE } from './utils/Time';
+export { findStoryboardCue, type Storyboard, type StoryboardCue, type StoryboardOptions } from './utils/Storyboard';
 
 // Events
 export { EventEmitter } from './events/EventEmitter';
@@ -58,6 +59,8 @@ export { FileSource, createFileSource } from './source/FileSource';
 export { ThumbnailHttpSource, createThumbnailHttpSource } from './source/ThumbnailHttpSource';
 export { EncryptedHttpSource } from './source/EncryptedHttpSource';
 export type { EncryptedSourceConfig } from './source/EncryptedHttpSource';
+export { LiveSource } from './source/LiveSource';
+export type { LiveSink } from './source/LiveSource';
 export { generateFingerprint } from './utils/Fingerprint';
 
 // Cache
@@ -94,7 +97,7 @@ export {
   beaconSink,
   QOE_SCHEMA_VERSION,
 } from './utils/QoE';
-export type { QoEEvent, QoESink, QoESession } from './utils/QoE';
+export type { QoEEvent, QoESink, QoESession, QoEStageSample } from './utils/QoE';
 
 /**
  * The documented `<movi-player>` attribute surface. Kept as a flat string/
@@ -43,6 +43,7 @@ export type {
 // Utilities
 export { Logger, LogLevel } from './utils/Logger';
 export { Time, TIME_BASE } from './utils/Time';
+export { findStoryboardCue, type Storyboard, type StoryboardCue, type StoryboardOptions } from './utils/Storyboard';
 
 // Events
 export { EventEmitter } from './events/EventEmitter';
@@ -9,7 +9,15 @@ import {
   loadSignalsmith,
   type SignalsmithStretcher,
 } from "../utils/signalsmith";
-import type { PCMFrame } from "../decode/SoftwareAudioDecoder";
+import type { FusedStretch, PCMFrame } from "../decode/SoftwareAudioDecoder";
+import { loadStretchWasm } from "../wasm/FFmpegLoader";
+import {
+  PCM_RING_PROCESSOR,
+  PCMRingWriter,
+  isPCMRingSupported,
+  loadPCMRingProcessor,
+  type PCMRingStats,
+} from "./PCMRing";
 
 const TAG = "AudioRenderer";
 
@@ -92,6 +100,28 @@ export class AudioRenderer {
   private signalsmith: SignalsmithStretcher | null = null;
   private signalsmithLoading: boolean = false;
   private signalsmithSampleRate: number = 0;
+  // Channel count the stretcher was requested for (it may have fallen back
+  // to stereo on a module without the grouped export)
+  private signalsmithChannels: number = 0;
+
+  // Optional AudioWorklet output (setWorkletOutput): software PCM goes into a
+  // SharedArrayBuffer ring the audio thread drains, instead of one
+  // AudioBufferSourceNode per chunk scheduled from the main thread.
+  private workletOutput: boolean = false;
+  private ring: PCMRingWriter | null = null;
+  private ringNode: AudioWorkletNode | null = null;
+  private ringLoading: boolean = false;
+  private ringChannels: number = 2;
+  // Latched on a stream's first buffer until reset(): the ring owns it
+  private ringActive: boolean = false;
+  // Latched with ringActive: the worklet stretches (ring holds media-rate PCM)
+  private ringStretch: boolean = false;
+  // Frames written this stream, and where each written run sits in media time
+  private ringWritten: number = 0;
+  private ringTimeline: { frame: number; media: number; step: number }[] = [];
+  private ringNextMedia: number = 0;
+  private ringUnderrunsSeen: number = 0;
+  private static readonly RING_SECONDS = 16; // > the player's ~10s audio lead
   // Sample rate of the most recently decoded audio buffer. The stretcher is
   // fixed-rate per instance and MUST be built at this rate — not the
   // AudioContext's, which can differ (e.g. 48kHz media in a 44.1kHz context).
@@ -99,6 +129,9 @@ export class AudioRenderer {
   // instead of building at the context rate and then throwing it away + lazily
   // rebuilding on the first chunk (the ~1-2s opening-silence gap).
   private _decodedSampleRate: number = 0;
+  // Likewise the channel count: a 5.1/7.1 stream (downmix off) gets a
+  // channel-grouped stretcher of its own width
+  private _decodedChannels: number = 0;
 
   // Stable audio: master toggle (off by default, opt-in via element attribute)
   private _stableAudio: boolean = false;
@@ -293,6 +326,7 @@ export class AudioRenderer {
       // the first audio chunk so we use the decoded sample rate (not
       // AudioContext's, which often differs for Opus).
       loadSignalsmith();
+      this.maybeInitRing();
       return true;
     } catch (error) {
       Logger.error(TAG, "Failed to initialize", error);
@@ -347,6 +381,7 @@ export class AudioRenderer {
    */
   configure(sampleRate: number, channels: number): void {
     Logger.info(TAG, `Configured: ${sampleRate}Hz, ${channels}ch`);
+    this.ringChannels = Math.max(1, Math.min(8, channels || 2));
   }
 
   /**
@@ -462,6 +497,11 @@ export class AudioRenderer {
     if (this._muted && this.audioContext.state === "suspended") return;
 
     try {
+      if (this.ringOwns(frame)) {
+        this.writeRing(frame);
+        return;
+      }
+
       const audioTime = frame.timestamp / 1_000_000;
       const audioBuffer = this.audioContext.createBuffer(
         frame.numberOfChannels,
@@ -476,7 +516,13 @@ export class AudioRenderer {
         );
       }
 
-      this.scheduleAudioBuffer(audioBuffer, audioTime);
+      // Already stretched in WASM (fused batch decode): schedule as-is, but
+      // keep the media span it covers for the sync bookkeeping.
+      const mediaDuration =
+        frame.stretchedRate !== undefined && frame.mediaFrames !== undefined
+          ? frame.mediaFrames / frame.sampleRate
+          : undefined;
+      this.scheduleAudioBuffer(audioBuffer, audioTime, mediaDuration);
     } catch (error) {
       Logger.error(TAG, "RenderPCM error", error);
     }
@@ -484,9 +530,14 @@ export class AudioRenderer {
 
   /**
    * Schedule a populated AudioBuffer through the stretcher + A/V sync
-   * pipeline. Shared by render() and renderPCM().
+   * pipeline. Shared by render() and renderPCM(). `preStretchedDuration` is
+   * the media duration of a buffer that was already time-stretched upstream.
    */
-  private scheduleAudioBuffer(audioBuffer: AudioBuffer, audioTime: number): void {
+  private scheduleAudioBuffer(
+    audioBuffer: AudioBuffer,
+    audioTime: number,
+    preStretchedDuration?: number,
+  ): void {
     if (!this.audioContext || !this.gainNode) return;
 
     // Track when we receive decoded audio
@@ -502,6 +553,7 @@ export class AudioRenderer {
     const numberOfChannels = audioBuffer.numberOfChannels;
     const sampleRate = audioBuffer.sampleRate;
     this._decodedSampleRate = sampleRate;
+    this._decodedChannels = numberOfChannels;
 
     // Clear rebuffering flag as soon as audio data arrives (decoder is producing).
     // Don't wait for successful scheduling — the stretcher may swallow a few
@@ -518,8 +570,12 @@ export class AudioRenderer {
     // the ~1s of startup before the WASM stretcher kicks in. A brief silent
     // gap at the start is preferable to an audible pitch-shifted blip.
     let processedBuffer = audioBuffer;
-    let usedStretcher = false;
-    if (this.preservePitch && Math.abs(this._playbackRate - 1.0) > 0.01) {
+    let usedStretcher = preStretchedDuration !== undefined;
+    if (
+      !usedStretcher &&
+      this.preservePitch &&
+      Math.abs(this._playbackRate - 1.0) > 0.01
+    ) {
       const stOutput = this.processStretch(audioBuffer, this._playbackRate);
       if (stOutput && stOutput.length > 1) {
         processedBuffer = stOutput;
@@ -629,7 +685,7 @@ export class AudioRenderer {
     this.currentMediaTime = audioTime;
     this.scheduledCount++;
 
-    const endMediaTime = audioTime + audioBuffer.duration;
+    const endMediaTime = audioTime + (preStretchedDuration ?? audioBuffer.duration);
     if (endMediaTime > this.maxScheduledMediaTime) {
       this.maxScheduledMediaTime = endMediaTime;
     }
@@ -726,6 +782,7 @@ export class AudioRenderer {
     ) {
       this.maybeInitSignalsmith(
         this._decodedSampleRate || this.audioContext.sampleRate,
+        this._decodedChannels || 2,
       );
     }
 
@@ -794,20 +851,22 @@ export class AudioRenderer {
   /**
    * Kick off Signalsmith stretcher construction. Single-flight; idempotent.
    * The movi WASM module is shared with FFmpeg, so this is fast once the
-   * player has loaded — just an instance allocation.
+   * player has loaded — just an instance allocation. More than two channels
+   * get a channel-grouped instance (defaultChannelGroups).
    */
-  private maybeInitSignalsmith(sampleRate: number): void {
+  private maybeInitSignalsmith(sampleRate: number, channels: number): void {
     if (this.signalsmith || this.signalsmithLoading) return;
     this.signalsmithLoading = true;
     this.signalsmithSampleRate = sampleRate;
-    createSignalsmithStretcher(sampleRate, 2)
+    this.signalsmithChannels = Math.max(2, channels);
+    createSignalsmithStretcher(sampleRate, this.signalsmithChannels)
       .then((s) => {
         this.signalsmithLoading = false;
         if (!s) return;
         s.tempo = this._playbackRate;
         s.pitch = 1.0;
         this.signalsmith = s;
-        Logger.info(TAG, `Signalsmith ready @ ${sampleRate}Hz`);
+        Logger.info(TAG, `Signalsmith ready @ ${sampleRate}Hz, ${s.channelCount}ch`);
       })
       .catch((err) => {
         this.signalsmithLoading = false;
@@ -815,6 +874,55 @@ export class AudioRenderer {
       });
   }
 
+  /**
+   * The stretcher the software decoder may feed directly from its batch
+   * decode (see SoftwareAudioDecoder.setStretchProvider), or null when
+   * stretching isn't needed or the stretcher isn't ready. Each returned
+   * handle is used for exactly the blocks renderPCM will be handed next, so
+   * the stretcher's stream state stays continuous across both paths.
+   */
+  getFusedStretch(): FusedStretch | null {
+    if (!this.preservePitch || Math.abs(this._playbackRate - 1.0) <= 0.01) return null;
+    // The worklet stretches ring-owned streams itself
+    if (this.ringActive ? this.ringStretch : this.workletOutput && !!this.ring?.stretchReady()) {
+      return null;
+    }
+    const stretcher = this.signalsmith;
+    if (!stretcher || !stretcher.supportsPlanar()) return null;
+    stretcher.tempo = this._playbackRate;
+    stretcher.pitch = 1.0;
+    return {
+      module: stretcher.module,
+      handle: stretcher.stretchHandle,
+      tempo: this._playbackRate,
+      sampleRate: this.signalsmithSampleRate,
+      channels: stretcher.channelCount,
+    };
+  }
+
+  /**
+   * The Signalsmith instance for `sampleRate` and `channels`, set to the
+   * current tempo, or null while it's (re)loading.
+   */
+  private stretcherFor(sampleRate: number, channels: number): SignalsmithStretcher | null {
+    // Drop + rebuild the stretcher if the decoded sample rate or layout
+    // changed — Signalsmith is fixed-rate and fixed-width per instance.
+    if (
+      this.signalsmith &&
+      (this.signalsmithSampleRate !== sampleRate || this.signalsmithChannels !== Math.max(2, channels))
+    ) {
+      this.signalsmith.destroy();
+      this.signalsmith = null;
+    }
+    this.maybeInitSignalsmith(sampleRate, channels);
+
+    const stretcher = this.signalsmith;
+    if (!stretcher) return null;
+    stretcher.tempo = this._playbackRate;
+    stretcher.pitch = 1.0;
+    return stretcher;
+  }
+
   /**
    * Pitch-preserving time stretch through Signalsmith. Returns the stretched
    * AudioBuffer, or null if the stretcher isn't ready yet (caller falls back
@@ -830,19 +938,25 @@ export class AudioRenderer {
     const sampleRate = inputBuffer.sampleRate;
     const inputFrames = inputBuffer.length;
 
-    // Drop + rebuild the stretcher if the decoded sample rate changed —
-    // Signalsmith is fixed-rate per instance.
-    if (this.signalsmith && this.signalsmithSampleRate !== sampleRate) {
-      this.signalsmith.destroy();
-      this.signalsmith = null;
-    }
-    this.maybeInitSignalsmith(sampleRate);
-
-    if (!this.signalsmith) return null; // still loading — caller falls back
+    const stretcher = this.stretcherFor(sampleRate, numChannels);
+    if (!stretcher) return null; // still loading — caller falls back
 
-    const stretcher = this.signalsmith;
-    stretcher.tempo = this._playbackRate;
-    stretcher.pitch = 1.0;
+    const expectedFrames = Math.ceil(inputFrames / playbackRate);
+    if (stretcher.supportsPlanar()) {
+      // Planar in, planar out: no interleave passes on either side
+      const planes: Float32Array[] = [];
+      for (let c = 0; c < Math.min(numChannels, stretcher.channelCount); c++) {
+        planes.push(inputBuffer.getChannelData(c));
+      }
+      const stretched = stretcher.processPlanar(planes, expectedFrames);
+      if (stretched) {
+        const outputBuffer = this.audioContext.createBuffer(numChannels, expectedFrames, sampleRate);
+        for (let c = 0; c < Math.min(numChannels, stretched.length); c++) {
+          outputBuffer.copyToChannel(stretched[c] as Float32Array<ArrayBuffer>, c);
+        }
+        return outputBuffer;
+      }
+    }
 
     // Convert planar AudioBuffer → interleaved stereo for the WASM API.
     const interleavedInput = new Float32Array(inputFrames * 2);
@@ -856,7 +970,6 @@ export class AudioRenderer {
     stretcher.inputBuffer.putSamples(interleavedInput, 0, inputFrames);
     stretcher.process();
 
-    const expectedFrames = Math.ceil(inputFrames / playbackRate);
     const availableFrames = stretcher.outputBuffer.frameCount;
     const framesToExtract = Math.min(expectedFrames, availableFrames);
 
@@ -883,6 +996,260 @@ export class AudioRenderer {
     return outputBuffer;
   }
 
+  // ─── AudioWorklet Ring Output ────────────────────────────────────────
+
+  /**
+   * Route software-decoded PCM through the SharedArrayBuffer ring and the
+   * movi-pcm-ring AudioWorklet instead of per-chunk buffer sources. Needs a
+   * cross-origin-isolated page; silently stays on buffer sources otherwise.
+   * Takes effect from the next stream start (load, seek, track switch).
+   */
+  setWorkletOutput(enabled: boolean): void {
+    this.workletOutput = enabled;
+    Logger.info(TAG, `Worklet output: ${enabled ? "enabled" : "disabled"}`);
+    if (enabled) this.maybeInitRing();
+    else if (!this.ringActive) this.releaseRing();
+  }
+
+  getWorkletOutput(): boolean {
+    return this.workletOutput;
+  }
+
+  /**
+   * Fill level and underrun counters of the worklet ring, or null when the
+   * ring isn't in use.
+   */
+  getRingStats(): PCMRingStats | null {
+    return this.ring ? this.ring.stats() : null;
+  }
+
+  private maybeInitRing(): void {
+    if (!this.workletOutput || this.ring || this.ringLoading) return;
+    const context = this.audioContext;
+    if (!context || !isPCMRingSupported(context)) return;
+
+    this.ringLoading = true;
+    Promise.all([loadPCMRingProcessor(context), loadStretchWasm()])
+      .then(([ok, stretchModule]) => {
+        this.ringLoading = false;
+        if (!ok) {
+          Logger.warn(TAG, "PCM ring worklet failed to load; using buffer sources");
+          return;
+        }
+        if (this.audioContext !== context || !this.workletOutput || this.ring) return;
+        const channels = this.ringChannels;
+        const ring = new PCMRingWriter(
+          channels,
+          context.sampleRate * AudioRenderer.RING_SECONDS,
+        );
+        const nodeOptions = (module: WebAssembly.Module | null): AudioWorkletNodeOptions => ({
+          numberOfInputs: 0,
+          numberOfOutputs: 1,
+          outputChannelCount: [channels],
+          processorOptions: { buffer: ring.buffer, stretchModule: module },
+        });
+        let node: AudioWorkletNode;
+        try {
+          node = new AudioWorkletNode(context, PCM_RING_PROCESSOR, nodeOptions(stretchModule));
+        } catch (err) {
+          // An engine that won't clone a WebAssembly.Module into the worklet:
+          // run the ring without it, stretching stays on the main thread
+          if (!stretchModule) throw err;
+          node = new AudioWorkletNode(context, PCM_RING_PROCESSOR, nodeOptions(null));
+        }
+        node.connect(this.inputNode ?? this.gainNode!);
+        this.ring = ring;
+        this.ringNode = node;
+        Logger.info(
+          TAG,
+          `PCM ring ready: ${channels}ch, ${ring.capacity} frames @ ${context.sampleRate}Hz` +
+            (stretchModule ? ", worklet stretch" : ""),
+        );
+      })
+      .catch((err) => {
+        this.ringLoading = false;
+        Logger.warn(TAG, "PCM ring init failed", err);
+      });
+  }
+
+  private releaseRing(): void {
+    if (this.ringNode) {
+      try {
+        this.ringNode.port.postMessage("stop");
+        this.ringNode.disconnect();
+      } catch {
+        /* already disconnected */
+      }
+    }
+    this.ringNode = null;
+    this.ring = null;
+    this.ringActive = false;
+    this.ringStretch = false;
+    this.ringTimeline = [];
+  }
+
+  /**
+   * Whether `frame` goes to the ring. Decided on a stream's first buffer and
+   * held until reset(), so the two paths never overlap within a stream. The
+   * worklet plays at the context rate, so only rate-matched streams qualify.
+   */
+  private ringOwns(frame: PCMFrame): boolean {
+    if (this.ringActive) return true;
+    const ring = this.ring;
+    return (
+      !!ring &&
+      this.workletOutput &&
+      !this.hasFirstBuffer &&
+      frame.sampleRate === this.audioContext?.sampleRate &&
+      frame.numberOfChannels <= ring.channels
+    );
+  }
+
+  /**
+   * The renderPCM path for a ring-owned stream: stretch when needed (always
+   * pitch-preserving — the ring can't vary its read speed), then append the
+   * planes with their media timestamps. With the worklet stretching, the PCM
+   * goes in at media rate and the tempo is only published.
+   */
+  private writeRing(frame: PCMFrame): void {
+    const ring = this.ring;
+    const context = this.audioContext;
+    if (!ring || !context) return;
+
+    this.lastDecodeTime = performance.now();
+    if (this._stableAudio && this.isStarved) {
+      this.isStarved = false;
+      this.starvationStartTime = 0;
+      Logger.debug(TAG, "Recovered from audio starvation");
+    }
+    this.isRebufferingForRateChange = false;
+    this._decodedSampleRate = frame.sampleRate;
+    this._decodedChannels = frame.numberOfChannels;
+
+    const audioTime = frame.timestamp / 1_000_000;
+    const rate = this._playbackRate;
+    const preStretched = frame.stretchedRate !== undefined && frame.mediaFrames !== undefined;
+    const mediaDuration = (preStretched ? frame.mediaFrames! : frame.numberOfFrames) / frame.sampleRate;
+
+    if (!this.ringActive) {
+      this.ringStretch = ring.stretchReady();
+      ring.setTempo(this.ringStretch ? rate : 1.0);
+    }
+    // Output frames per media second when the ring is played as-is
+    const outRate = this.ringStretch ? 1.0 : rate;
+
+    let planes: (Float32Array | null)[] = frame.planes;
+    let frames = frame.numberOfFrames;
+    if (
+      frame.sampleRate !== context.sampleRate ||
+      frame.numberOfChannels > ring.channels ||
+      (preStretched && this.ringStretch)
+    ) {
+      // Format changed mid-stream: hold the timeline with silence until the
+      // next reset() hands the stream back to the buffer-source path.
+      planes = [];
+      frames = Math.ceil((mediaDuration / outRate) * context.sampleRate);
+    } else if (!this.ringStretch && !preStretched && Math.abs(rate - 1.0) > 0.01) {
+      frames = Math.ceil(frame.numberOfFrames / rate);
+      const stretcher = this.stretcherFor(frame.sampleRate, frame.numberOfChannels);
+      const stretched =
+        stretcher && stretcher.supportsPlanar()
+          ? stretcher.processPlanar(frame.planes.slice(0, stretcher.channelCount), frames)
+          : null;
+      // Not ready yet: expected-duration silence, as scheduleAudioBuffer does.
+      // Channels past a stereo-only stretcher stay silent, as there.
+      planes = stretched
+        ? [...stretched, ...new Array<null>(Math.max(0, frame.numberOfChannels - stretched.length)).fill(null)]
+        : [];
+    }
+
+    if (!this.ringActive) {
+      this.ringActive = true;
+      this.hasFirstBuffer = true;
+      this.firstBufferMediaTime = audioTime;
+      this.ringWritten = 0;
+      this.ringTimeline = [];
+      this.ringNextMedia = audioTime;
+      this.ringUnderrunsSeen = ring.stats().underruns;
+      Logger.debug(TAG, `First ring buffer, mediaTime=${audioTime.toFixed(3)}s`);
+    }
+
+    // A chunk that starts past where the last one ended (the rate-change
+    // flush, a decoder skip) gets the hole padded, so ring position keeps
+    // mapping onto media time.
+    const gap = audioTime - this.ringNextMedia;
+    if (gap > 0.02 && gap < 10) {
+      this.appendRing([], Math.round((gap / outRate) * context.sampleRate), this.ringNextMedia, gap);
+    }
+    this.appendRing(planes, frames, audioTime, mediaDuration);
+
+    this.currentMediaTime = audioTime;
+    this.scheduledCount++;
+    const endMediaTime = audioTime + mediaDuration;
+    if (endMediaTime > this.maxScheduledMediaTime) {
+      this.maxScheduledMediaTime = endMediaTime;
+    }
+  }
+
+  private appendRing(
+    planes: (Float32Array | null)[],
+    frames: number,
+    media: number,
+    mediaDuration: number,
+  ): void {
+    const ring = this.ring;
+    if (!ring || frames <= 0) return;
+    const written = ring.write(planes, frames);
+    if (written < frames) {
+      Logger.debug(TAG, `PCM ring full, dropped ${frames - written} frames`);
+    }
+    if (written <= 0) return;
+    this.ringTimeline.push({ frame: this.ringWritten, media, step: mediaDuration / frames });
+    this.ringWritten += written;
+    this.ringNextMedia = media + (mediaDuration * written) / frames;
+  }
+
+  /**
+   * Media time of the frame the worklet is about to play, from the shared
+   * read counter — advances only as the audio thread actually consumes.
+   */
+  private ringMediaTime(): number {
+    const ring = this.ring;
+    if (!ring || this.ringTimeline.length === 0) return this.firstBufferMediaTime;
+    let played = this.ringWritten - ring.fillFrames();
+    // The worklet's stretcher holds a little input that hasn't been heard yet
+    if (this.ringStretch) played = Math.max(0, played - ring.stretchLatencyFrames());
+
+    // Runs wholly before the read position can go
+    const timeline = this.ringTimeline;
+    let drop = 0;
+    while (drop + 1 < timeline.length && timeline[drop + 1].frame <= played) drop++;
+    if (drop > 0) timeline.splice(0, drop);
+
+    const run = timeline[0];
+    return run.media + Math.max(0, played - run.frame) * run.step;
+  }
+
+  private ringBufferedSeconds(): number {
+    if (!this.ring || !this.audioContext) return 0;
+    const seconds = this.ring.fillFrames() / this.audioContext.sampleRate;
+    // Media-rate PCM drains at the playback rate
+    return this.ringStretch ? seconds / this._playbackRate : seconds;
+  }
+
+  /** Fold new worklet underruns into the shared underrun bookkeeping */
+  private pollRingUnderruns(): void {
+    if (!this.ring || !this.ringActive) return;
+    const underruns = this.ring.stats().underruns;
+    if (underruns === this.ringUnderrunsSeen) return;
+    this.ringUnderrunsSeen = underruns;
+    // Draining dry after the decoder went quiet is end of stream, not an
+    // underrun — only a ring starving while PCM is still arriving counts.
+    if (performance.now() - this.lastDecodeTime < 1000) {
+      this._lastUnderrunAt = performance.now();
+    }
+  }
+
   /**
    * Warmup AudioContext (Safari fix)
    */
@@ -1064,6 +1431,7 @@ export class AudioRenderer {
       // audio has decoded.
       this.maybeInitSignalsmith(
         this._decodedSampleRate || this.audioContext.sampleRate,
+        this._decodedChannels || 2,
       );
     }
 
@@ -1084,7 +1452,19 @@ export class AudioRenderer {
     // playhead — so the audio clock does NOT leap to the demuxer's read-ahead
     // mediaTime, and the video does not hard-snap forward. That leap was the
     // "jumps 1–3s ahead on rate change" regression.
-    if (
+    if (this.ringActive && this.ringStretch && this.ring) {
+      // Stretching on the audio thread: the ring holds media-rate PCM, so the
+      // new tempo applies from the next quantum — nothing to drop or re-anchor
+      this.ring.setTempo(newRate);
+    } else if (this.ringActive && this.ring) {
+      // Same idea on the ring: drop the old-rate tail and keep the clock at
+      // the current play position. The next chunk's lead over it is padded
+      // with silence in writeRing, like the expectedTime gap above.
+      const currentMediaTime = this.ringMediaTime();
+      this.ring.flush();
+      this.ringTimeline = [{ frame: this.ringWritten, media: currentMediaTime, step: 0 }];
+      this.ringNextMedia = currentMediaTime;
+    } else if (
       this.audioContext &&
       this.audioContext.state === "running" &&
       this.hasFirstBuffer
@@ -1267,6 +1647,19 @@ export class AudioRenderer {
       }
     }
 
+    // Drop the ring's queued audio; the next stream picks its path afresh
+    // (rebuilding the ring if the channel layout or the setting changed).
+    if (this.ring) {
+      this.ring.flush();
+      this.ringActive = false;
+      this.ringStretch = false;
+      this.ringTimeline = [];
+      if (!this.workletOutput || this.ring.channels !== this.ringChannels) {
+        this.releaseRing();
+        this.maybeInitRing();
+      }
+    }
+
     // Reset clock tracking
     this.hasFirstBuffer = false;
     this.firstBufferScheduledAt = 0;
@@ -1307,10 +1700,15 @@ export class AudioRenderer {
       this.audioContext.state === "running" &&
       this.hasFirstBuffer
     ) {
-      const elapsed =
-        this.audioContext.currentTime - this.firstBufferScheduledAt;
-      let computedTime =
-        this.firstBufferMediaTime + Math.max(0, elapsed * this._playbackRate);
+      // Ring output: the worklet's read counter is the clock
+      let computedTime = this.ringActive
+        ? this.ringMediaTime()
+        : this.firstBufferMediaTime +
+          Math.max(
+            0,
+            (this.audioContext.currentTime - this.firstBufferScheduledAt) *
+              this._playbackRate,
+          );
 
       const latency =
         (this.audioContext as any).outputLatency ||
@@ -1339,10 +1737,15 @@ export class AudioRenderer {
       this.audioContext.state === "running" &&
       this.hasFirstBuffer
     ) {
-      const elapsed =
-        this.audioContext.currentTime - this.firstBufferScheduledAt;
-      let computedTime =
-        this.firstBufferMediaTime + Math.max(0, elapsed * this._playbackRate);
+      // Ring output: the worklet's read counter is the clock
+      let computedTime = this.ringActive
+        ? this.ringMediaTime()
+        : this.firstBufferMediaTime +
+          Math.max(
+            0,
+            (this.audioContext.currentTime - this.firstBufferScheduledAt) *
+              this._playbackRate,
+          );
 
       // Adjust for output latency if available (Critical for Android/Bluetooth sync)
       // outputLatency represents the delay between the audio hardware and the speakers
@@ -1417,7 +1820,9 @@ export class AudioRenderer {
     if (this.lastDecodeTime > 0 && timeSinceLastDecode > 500) return false;
 
     // Compute buffer ahead time
-    const realBufferAhead = this.scheduledTime - this.audioContext.currentTime;
+    const realBufferAhead = this.ringActive
+      ? this.ringBufferedSeconds()
+      : this.scheduledTime - this.audioContext.currentTime;
     const hasScheduledAudio =
       this.activeSources.length > 0 || realBufferAhead > 0;
 
@@ -1444,6 +1849,7 @@ export class AudioRenderer {
    */
   getBufferedDuration(): number {
     if (!this.audioContext) return 0;
+    if (this.ringActive) return this.ringBufferedSeconds();
     return Math.max(0, this.scheduledTime - this.audioContext.currentTime);
   }
 
@@ -1457,6 +1863,7 @@ export class AudioRenderer {
    * file and stutters over HTTP.
    */
   isUnderrunning(withinMs: number = 500): boolean {
+    this.pollRingUnderruns();
     return (
       this._lastUnderrunAt > 0 &&
       performance.now() - this._lastUnderrunAt < withinMs
@@ -1793,6 +2200,7 @@ export class AudioRenderer {
         /* already disconnected */
       }
     }
+    this.releaseRing();
     this.audioContext = null;
 
     this.inputNode = null;
@@ -5,6 +5,7 @@
 
 import { Logger } from "../utils/Logger";
 import type { SubtitleCue } from "../types";
+import { SubtitleBitmapCanvas } from "./SubtitleBitmap";
 
 const TAG = "CanvasRenderer";
 
@@ -98,6 +99,27 @@ export class CanvasRenderer {
   private _perfWindowBaseCount: number = 0; // framesPresented at window start
   private _perfDeficitWindows: number = 0; // consecutive struggling windows
   private _onPerformanceDegrade: ((targetFps: number) => void) | null = null;
+  // Decode-budget signal for closed-loop load shedding: per PERF_WINDOW_MS,
+  // the share of queued frames that arrived less than a frame interval ahead
+  // of the presented PTS. Unlike the achieved present rate it stays meaningful
+  // while frames are being dropped on purpose, so it can also say when
+  // there's headroom again.
+  private _onDecodeBudget: ((missRatio: number) => void) | null = null;
+  private _budgetWindowStart: number = 0; // 0 = not started
+  private _budgetArrived: number = 0;
+  private _budgetLate: number = 0;
+  // Display refresh rate, from the rAF callback rate over PERF_WINDOW_MS
+  // windows. rAF only ever runs slower than the panel (a busy main thread),
+  // so the estimate rises at once but only falls after DISPLAY_RATE_WINDOWS
+  // consistent windows — moving the window to a slower monitor, not a hitch.
+  // The player uses it to pick how many temporal sub-layers to decode.
+  private _displayHz: number = 0; // 0 = not measured yet
+  private _displayWindowStart: number = 0;
+  private _displayCallbacks: number = 0;
+  private _displayLowWindows: number = 0;
+  private _onDisplayRate: ((hz: number) => void) | null = null;
+  private static readonly DISPLAY_RATE_WINDOWS = 3;
+  private static readonly DISPLAY_RATE_TOLERANCE = 0.1;
   private static readonly PERF_WINDOW_MS = 1000;
   private static readonly PERF_DEFICIT_RATIO = 0.7; // achieved < 70% of source rate = struggling
   private static readonly PERF_DEFICIT_WINDOWS = 2; // consecutive bad windows before engaging
@@ -218,6 +240,10 @@ export class CanvasRenderer {
   // even when the cue text hasn't changed, restarting the fade-in animation
   // each time and leaving the subtitle perpetually invisible during playback.
   private _lastRenderedSubtitleKey: string = "";
+  // Palettized bitmap cues are drawn here (GPU palette lookup); RGBA image
+  // cues keep their PNG data URL, encoded once per image rather than per call
+  private subtitleBitmapCanvas: SubtitleBitmapCanvas | null = null;
+  private _imageSubtitleSrc: { image: ImageBitmap; url: string } | null = null;
   // Plain text of what's currently on screen — used to find the suffix
   // delta of the next karaoke cue so only the new word fades in, instead
   // of the whole line re-animating each tick.
@@ -1051,6 +1077,124 @@ export class CanvasRenderer {
     this._onPerformanceDegrade = cb;
   }
 
+  /** Wire the per-window decode-budget miss ratio (see _onDecodeBudget). Only
+   *  reported at normal speed with audio flowing, past the startup/seek ramp,
+   *  and for windows in which frames arrived at all. */
+  setOnDecodeBudget(cb: ((missRatio: number) => void) | null): void {
+    this._onDecodeBudget = cb;
+    this._budgetWindowStart = 0;
+  }
+
+  /** Wire a callback fired when the measured display refresh rate changes
+   *  (first measurement included). */
+  setOnDisplayRate(cb: ((hz: number) => void) | null): void {
+    this._onDisplayRate = cb;
+  }
+
+  /** Measured display refresh rate in Hz, 0 until the first window closes */
+  getDisplayRefreshRate(): number {
+    return this._displayHz;
+  }
+
+  /** The rate the source is actually delivered at changed (temporal
+   *  sub-layers dropped or restored): re-time presentation to it and re-arm
+   *  the adaptive-FPS detector, as configure does for a new source. */
+  setSourceFrameRate(frameRate: number): void {
+    if (!(frameRate > 0) || frameRate === this.videoFrameRate) return;
+    this.videoFrameRate = frameRate;
+    this._presentFpsCap = 0;
+    this._perfDegradeChecked = false;
+    this._perfWindowStart = 0;
+    this._perfDeficitWindows = 0;
+    this._budgetWindowStart = 0;
+  }
+
+  /** Roll the display-rate window (see _displayHz). Called every rAF. */
+  private sampleDisplayRate(): void {
+    // Background tabs throttle rAF to nothing; no measurement there
+    if (typeof document !== "undefined" && document.hidden) {
+      this._displayWindowStart = 0;
+      return;
+    }
+    const now = performance.now();
+    if (this._displayWindowStart === 0) {
+      this._displayWindowStart = now;
+      this._displayCallbacks = 0;
+      return;
+    }
+    this._displayCallbacks++;
+    const elapsed = now - this._displayWindowStart;
+    if (elapsed < CanvasRenderer.PERF_WINDOW_MS) return;
+    const hz = Math.round((this._displayCallbacks * 1000) / elapsed);
+    this._displayWindowStart = now;
+    this._displayCallbacks = 0;
+    const tolerance = CanvasRenderer.DISPLAY_RATE_TOLERANCE;
+    let changed = false;
+    if (hz > this._displayHz * (1 + tolerance)) {
+      changed = true;
+    } else if (hz < this._displayHz * (1 - tolerance)) {
+      changed =
+        ++this._displayLowWindows >= CanvasRenderer.DISPLAY_RATE_WINDOWS;
+    } else {
+      this._displayLowWindows = 0;
+    }
+    if (!changed) return;
+    this._displayHz = hz;
+    this._displayLowWindows = 0;
+    Logger.debug(TAG, `Display refresh rate: ~${hz}Hz`);
+    try {
+      this._onDisplayRate?.(hz);
+    } catch {
+      /* ignore */
+    }
+  }
+
+  /** Count one queued frame against the current decode-budget window */
+  private noteFrameArrival(frameTime: number): void {
+    if (!this._onDecodeBudget || this._budgetWindowStart === 0) return;
+    if (this.lastPresentedPts < 0) return;
+    this._budgetArrived++;
+    if (frameTime - this.lastPresentedPts < 1.0 / this.videoFrameRate) {
+      this._budgetLate++;
+    }
+  }
+
+  /** Roll the decode-budget window; same gating as samplePerformance, but
+   *  not one-way — it keeps reporting for the whole session. */
+  private sampleDecodeBudget(): void {
+    if (!this._onDecodeBudget) return;
+    const audioHealthy = this._isAudioHealthy ? this._isAudioHealthy() : true;
+    if (
+      !this.isPlaying ||
+      !audioHealthy ||
+      Math.abs(this.playbackRate - 1.0) > 0.05 ||
+      this.framesPresented <= CanvasRenderer.PERF_WARMUP_FRAMES
+    ) {
+      this._budgetWindowStart = 0;
+      return;
+    }
+    const now = performance.now();
+    if (this._budgetWindowStart === 0) {
+      this._budgetWindowStart = now;
+      this._budgetArrived = 0;
+      this._budgetLate = 0;
+      return;
+    }
+    if (now - this._budgetWindowStart < CanvasRenderer.PERF_WINDOW_MS) return;
+    // No arrivals at all = stuck or starved upstream, not slow (see
+    // PERF_MIN_ACHIEVED_FPS) — nothing to report
+    if (this._budgetArrived > 0) {
+      try {
+        this._onDecodeBudget(this._budgetLate / this._budgetArrived);
+      } catch {
+        /* ignore */
+      }
+    }
+    this._budgetWindowStart = now;
+    this._budgetArrived = 0;
+    this._budgetLate = 0;
+  }
+
   /** Roll the achieved-present-rate window and engage the adaptive FPS cap on a
    *  sustained deficit. Called once per presentation cycle, before the
    *  empty-queue bail, so a starving (decode-bound) pipeline still advances the
@@ -1828,6 +1972,8 @@ export class CanvasRenderer {
       return;
     }
 
+    this.noteFrameArrival(frame.timestamp / 1_000_000);
+
     // For large queues, use binary search insertion for better performance
     const frameTime = frame.timestamp;
     if (this.frameQueue.length > 0) {
@@ -1944,6 +2090,8 @@ export class CanvasRenderer {
     // Roll the adaptive-FPS window every cycle (before the empty-queue bail, so
     // a starving pipeline still registers its low present rate).
     this.samplePerformance();
+    this.sampleDecodeBudget();
+    this.sampleDisplayRate();
 
     // Get current playback time with high precision
     let currentPlaybackTime = this.getCurrentPlaybackTime();
@@ -2790,33 +2938,58 @@ export class CanvasRenderer {
   }
 
   /**
-   * Render image subtitle in HTML overlay
+   * PNG data URL for an image cue, encoded once per ImageBitmap
+   */
+  private imageSubtitleSrc(image: ImageBitmap): string | null {
+    if (this._imageSubtitleSrc?.image === image) return this._imageSubtitleSrc.url;
+
+    // Create a temporary canvas to convert ImageBitmap to data URL
+    const tempCanvas = document.createElement("canvas");
+    tempCanvas.width = image.width;
+    tempCanvas.height = image.height;
+    const tempCtx = tempCanvas.getContext("2d");
+
+    if (!tempCtx) {
+      Logger.warn(
+        TAG,
+        "Failed to create temporary canvas context for image subtitle",
+      );
+      return null;
+    }
+
+    // Draw ImageBitmap to temporary canvas
+    tempCtx.drawImage(image, 0, 0);
+
+    // Convert to data URL
+    const url = tempCanvas.toDataURL("image/png");
+    this._imageSubtitleSrc = { image, url };
+    return url;
+  }
+
+  /**
+   * Render image subtitle in HTML overlay: an <img> for RGBA cues, the
+   * SubtitleBitmapCanvas for palettized ones
    */
   private renderImageSubtitleInOverlay(cue: SubtitleCue): void {
-    if (!this.subtitleOverlay || !cue.image) {
+    const source = cue.image ?? cue.bitmap;
+    if (!this.subtitleOverlay || !source) {
       return;
     }
 
     try {
-      // Create a temporary canvas to convert ImageBitmap to data URL
-      const tempCanvas = document.createElement("canvas");
-      tempCanvas.width = cue.image.width;
-      tempCanvas.height = cue.image.height;
-      const tempCtx = tempCanvas.getContext("2d");
-
-      if (!tempCtx) {
-        Logger.warn(
-          TAG,
-          "Failed to create temporary canvas context for image subtitle",
-        );
-        return;
+      let dataUrl: string | null = null;
+      if (cue.bitmap) {
+        if (!this.subtitleBitmapCanvas) {
+          this.subtitleBitmapCanvas = new SubtitleBitmapCanvas();
+          this.subtitleBitmapCanvas.canvas.className = "movi-subtitle-image";
+        }
+        this.subtitleBitmapCanvas.draw(cue.bitmap);
+      } else if (cue.image) {
+        dataUrl = this.imageSubtitleSrc(cue.image);
+        if (!dataUrl) return;
       }
-
-      // Draw ImageBitmap to temporary canvas
-      tempCtx.drawImage(cue.image, 0, 0);
-
-      // Convert to data URL
-      const dataUrl = tempCanvas.toDataURL("image/png");
+      const imageWidth = source.width;
+      const imageHeight = source.height;
 
       // Use CSS-pixel dimensions of the visible canvas, not the dpr-scaled
       // backbuffer. this.width/height live in buffer space (target × dpr) and
@@ -2872,8 +3045,8 @@ export class CanvasRenderer {
       const uniformScale = baseScale * userSizeMult * IMAGE_SUB_DISPLAY_SHRINK;
 
       // Calculate scaled dimensions preserving aspect ratio
-      const scaledWidth = cue.image.width * uniformScale;
-      const scaledHeight = cue.image.height * uniformScale;
+      const scaledWidth = imageWidth * uniformScale;
+      const scaledHeight = imageHeight * uniformScale;
 
       // The video content is rendered "contain"-fit inside the canvas, so on
       // an ultrawide window with a 16:9 source the video sits in a centred
@@ -2898,7 +3071,7 @@ export class CanvasRenderer {
       let x: number;
       if (cue.position?.x !== undefined) {
         const sourceCentreX =
-          (cue.position.x + cue.image.width / 2) * baseScale;
+          (cue.position.x + imageWidth / 2) * baseScale;
         x = videoOffsetX + sourceCentreX - scaledWidth / 2;
       } else {
         x = (canvasWidth - scaledWidth) / 2;
@@ -2909,7 +3082,7 @@ export class CanvasRenderer {
         // Use explicit Y position (anchored on source centre, see x above)
         // but ensure it doesn't go above top.
         const sourceCentreY =
-          (cue.position.y + cue.image.height / 2) * baseScale;
+          (cue.position.y + imageHeight / 2) * baseScale;
         y = videoOffsetY + sourceCentreY - scaledHeight / 2;
         y = Math.max(0, Math.min(y, canvasHeight - scaledHeight));
       } else {
@@ -2969,18 +3142,20 @@ export class CanvasRenderer {
       this.subtitleOverlay.style.boxSizing = "border-box";
       this.subtitleOverlay.style.margin = "0";
 
-      // Create or update image element (single image element - replace on each update)
-      let imgElement = this.subtitleOverlay.querySelector(
-        "img.movi-subtitle-image",
-      ) as HTMLImageElement;
+      // Create or update image element (single image element - replace on each update).
+      // Palettized cues use the bitmap canvas in its place.
+      let imgElement: HTMLElement | null = cue.bitmap
+        ? this.subtitleBitmapCanvas!.canvas
+        : this.subtitleOverlay.querySelector("img.movi-subtitle-image");
+      const attached = !!imgElement && imgElement.parentElement === this.subtitleOverlay;
 
       Logger.debug(
         TAG,
-        `Rendering image subtitle in overlay: ${imgElement ? "img exists" : "creating img"}, x=${x.toFixed(0)}, y=${y.toFixed(0)}, width=${(cue.image.width * scaleX).toFixed(0)}, height=${(cue.image.height * scaleY).toFixed(0)}`,
+        `Rendering image subtitle in overlay: ${attached ? "element exists" : "attaching element"}, x=${x.toFixed(0)}, y=${y.toFixed(0)}, width=${(imageWidth * scaleX).toFixed(0)}, height=${(imageHeight * scaleY).toFixed(0)}`,
       );
 
-      if (!imgElement) {
-        imgElement = document.createElement("img");
+      if (!imgElement || !attached) {
+        imgElement ??= document.createElement("img");
         imgElement.className = "movi-subtitle-image";
         imgElement.style.display = "block";
         imgElement.style.position = "relative"; // Use relative to respect flexbox
@@ -3008,7 +3183,7 @@ export class CanvasRenderer {
 
       // Always update src, dimensions and position
       // Preserve aspect ratio to prevent stretching
-      imgElement.src = dataUrl;
+      if (dataUrl && imgElement instanceof HTMLImageElement) imgElement.src = dataUrl;
       imgElement.style.width = `${scaledWidth}px`;
       imgElement.style.height = `${scaledHeight}px`;
       imgElement.style.maxWidth = `${ovW}px`; // Ensure image doesn't exceed the (rotated) video frame width
@@ -3020,7 +3195,7 @@ export class CanvasRenderer {
 
       Logger.debug(
         TAG,
-        `Image subtitle rendered: src set, dimensions=${(cue.image.width * scaleX).toFixed(0)}x${(cue.image.height * scaleY).toFixed(0)}, position=(${x.toFixed(0)}, ${y.toFixed(0)})`,
+        `Image subtitle rendered: src set, dimensions=${(imageWidth * scaleX).toFixed(0)}x${(imageHeight * scaleY).toFixed(0)}, position=(${x.toFixed(0)}, ${y.toFixed(0)})`,
       );
     } catch (error) {
       Logger.error(TAG, "Failed to render image subtitle in overlay", error);
@@ -3196,7 +3371,7 @@ export class CanvasRenderer {
     const cue = this.activeSubtitleCue;
 
     // Image subtitles: Try HTML overlay first, fallback to canvas
-    if (cue.image) {
+    if (cue.image || cue.bitmap) {
       if (this.subtitleOverlay) {
         // Render image subtitle in HTML overlay using DISPLAY dimensions
         this.renderImageSubtitleInOverlay(cue);
@@ -3800,6 +3975,9 @@ export class CanvasRenderer {
       // WebGL2 contexts are garbage collected but good to delete resources
     }
     this.gl = null;
+    this.subtitleBitmapCanvas?.dispose();
+    this.subtitleBitmapCanvas = null;
+    this._imageSubtitleSrc = null;
     Logger.debug(TAG, "Destroyed");
   }
 }
@@ -16925,6 +16925,14 @@ export class MoviElement extends HTMLElement {
       this.player?.off("filerevoked", fileRevokedHandler),
     );
 
+    const dropTierHandler = (info: { tier: number; dropped: number }) => {
+      this._qoe.dropTier(info.tier, info.dropped);
+    };
+    this.player.on("dropTier", dropTierHandler);
+    this.eventHandlers.set("dropTier", () =>
+      this.player?.off("dropTier", dropTierHandler),
+    );
+
     const errorHandler = (error: unknown) => {
       this._qoe.error(
         error instanceof Error ? error.message : String(error),
@@ -17770,9 +17778,12 @@ export class MoviElement extends HTMLElement {
         | Record<string, unknown>
         | undefined;
       const decoder = String(stats?.["Video Decoder"] ?? "unknown");
-      // No dropped-frame counter is exposed yet; rebufferRatio carries the
-      // stall cost. Report 0 so the schema stays stable for consumers.
-      this._qoe.heartbeat(this.currentTime, 0, decoder);
+      // Packets the demuxer dropped under load shedding; 0 on modules without
+      // it (rebufferRatio still carries the stall cost).
+      const dropped = Number(stats?.["Dropped Packets"] ?? 0);
+      this._qoe.heartbeat(this.currentTime, dropped, decoder);
+      const wasm = this.player?.getWasmStats?.();
+      if (wasm) this._qoe.wasmStats(wasm);
     }, 10000);
   }
 
@@ -19095,6 +19106,7 @@ export class MoviElement extends HTMLElement {
     sessionToken: string;
     tokenRefreshInterval?: number;
     onAuthFailed?: (reason: string) => void;
+    wasmDecrypt?: boolean; // AES-CTR session decrypted inside WASM (see EncryptedHttpSource)
   }): Promise<void> {
     // Reset existing player
     this.resetTimeline();
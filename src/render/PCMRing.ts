@@ -0,0 +1,367 @@
+/**
+ * PCMRing - Lock-free single-producer / single-consumer float ring in shared memory
+ *
+ * The buffer-source path schedules one AudioBufferSourceNode per decoded chunk
+ * from the main thread, so every chunk costs an AudioBuffer allocation and a
+ * GC or layout stall on the main thread lands as an audible hole. Here the
+ * decoded planes are written into a SharedArrayBuffer ring and an
+ * AudioWorkletProcessor (movi-pcm-ring) pulls 128-frame quanta out of it on
+ * the audio thread — once PCM is in the ring, delivery no longer waits on the
+ * main thread at all.
+ *
+ * Layout: a 64-byte Int32 header followed by `channels` contiguous planes of
+ * `capacity` frames (capacity is a power of two). WRITE and READ are
+ * free-running uint32 frame counters; only the producer stores WRITE and only
+ * the consumer stores READ, so Atomics load/store is the whole protocol. A
+ * flush is a request (FLUSH_TO + FLUSH_GEN) the consumer applies on its next
+ * quantum, keeping READ single-writer. The writer never touches the audio
+ * graph, so the SAB can equally be handed to a worker-side decoder.
+ *
+ * Given the standalone stretch module (movi-stretch.wasm), the processor also
+ * time-stretches on the audio thread: the ring then holds media-rate PCM, the
+ * producer publishes the tempo, and each quantum consumes ~tempo×128 frames
+ * through a low-latency Signalsmith instance to produce 128.
+ */
+
+const HDR_WRITE = 0; // frames written (producer)
+const HDR_READ = 1; // frames consumed (consumer)
+const HDR_UNDERRUNS = 2; // quanta the consumer had to pad with silence
+const HDR_UNDERRUN_FRAMES = 3; // total silent frames padded
+const HDR_FLUSH_GEN = 4; // bumped by flush(); consumer jumps READ to FLUSH_TO
+const HDR_FLUSH_TO = 5;
+const HDR_PRIMED = 6; // 1 while a stream is feeding — underruns only count then
+const HDR_CHANNELS = 7;
+const HDR_CAPACITY = 8;
+const HDR_TEMPO = 9; // producer: playback rate × TEMPO_SCALE (worklet stretch)
+const HDR_STRETCH = 10; // consumer: 1 once its stretch instance is running
+const HDR_LATENCY = 11; // consumer: media frames between READ and what's heard
+const TEMPO_SCALE = 10000;
+const STRETCH_PRESET_LOW_LATENCY = 2; // movi_stretch.cpp
+const STRETCH_MAX_IN = 1024; // input frames per quantum: 128 × 4x max rate, ×2
+const HEADER_INTS = 16;
+const HEADER_BYTES = HEADER_INTS * 4;
+
+export const PCM_RING_PROCESSOR = "movi-pcm-ring";
+
+export interface PCMRingStats {
+  /** Frames written but not yet played */
+  fillFrames: number;
+  capacityFrames: number;
+  /** Render quanta padded with silence because the ring ran dry */
+  underruns: number;
+  underrunFrames: number;
+}
+
+/**
+ * True when the ring can be used at all: SharedArrayBuffer needs a
+ * cross-origin-isolated page, and the context needs AudioWorklet.
+ */
+export function isPCMRingSupported(context: BaseAudioContext | null): boolean {
+  return (
+    !!context &&
+    typeof SharedArrayBuffer !== "undefined" &&
+    (globalThis as any).crossOriginIsolated === true &&
+    typeof AudioWorkletNode !== "undefined" &&
+    !!(context as any).audioWorklet
+  );
+}
+
+/**
+ * Producer side. Owns the SharedArrayBuffer; pass `buffer` to the worklet
+ * node (processorOptions.buffer) or to a worker that decodes into it.
+ */
+export class PCMRingWriter {
+  readonly buffer: SharedArrayBuffer;
+  readonly channels: number;
+  readonly capacity: number;
+  private header: Int32Array;
+  private data: Float32Array;
+
+  constructor(channels: number, minFrames: number) {
+    let capacity = 1024;
+    while (capacity < minFrames) capacity *= 2;
+    this.channels = channels;
+    this.capacity = capacity;
+    this.buffer = new SharedArrayBuffer(HEADER_BYTES + channels * capacity * 4);
+    this.header = new Int32Array(this.buffer, 0, HEADER_INTS);
+    this.data = new Float32Array(this.buffer, HEADER_BYTES, channels * capacity);
+    this.header[HDR_CHANNELS] = channels;
+    this.header[HDR_CAPACITY] = capacity;
+    this.header[HDR_TEMPO] = TEMPO_SCALE;
+  }
+
+  /**
+   * Playback rate for the worklet's stretcher. 1 plays the ring as-is — what
+   * a producer that stretches (or doesn't) on its own side must leave set.
+   */
+  setTempo(rate: number): void {
+    Atomics.store(this.header, HDR_TEMPO, Math.round(rate * TEMPO_SCALE));
+  }
+
+  /** Whether the worklet instantiated its stretch module */
+  stretchReady(): boolean {
+    return Atomics.load(this.header, HDR_STRETCH) === 1;
+  }
+
+  /** Media frames the worklet's stretcher holds between READ and the output */
+  stretchLatencyFrames(): number {
+    return Atomics.load(this.header, HDR_LATENCY);
+  }
+
+  /** Frames written and not yet consumed */
+  fillFrames(): number {
+    return (Atomics.load(this.header, HDR_WRITE) - Atomics.load(this.header, HDR_READ)) >>> 0;
+  }
+
+  /** Frames that can be written without overwriting unplayed audio */
+  freeFrames(): number {
+    return this.capacity - this.fillFrames();
+  }
+
+  /** The consumer's free-running read counter (uint32) */
+  readCounter(): number {
+    return Atomics.load(this.header, HDR_READ) >>> 0;
+  }
+
+  /** The producer's free-running write counter (uint32) */
+  writeCounter(): number {
+    return Atomics.load(this.header, HDR_WRITE) >>> 0;
+  }
+
+  /**
+   * Append `frames` frames starting at `offset` of each plane (null planes
+   * write silence; missing channels repeat the last plane). Returns the
+   * frames actually written — fewer than asked when the ring is full.
+   */
+  write(planes: (Float32Array | null)[], frames: number, offset = 0): number {
+    const n = Math.min(frames, this.freeFrames());
+    if (n <= 0) return 0;
+    const write = Atomics.load(this.header, HDR_WRITE);
+    const start = write & (this.capacity - 1);
+    const first = Math.min(n, this.capacity - start);
+
+    for (let c = 0; c < this.channels; c++) {
+      const base = c * this.capacity;
+      const plane = planes.length > 0 ? planes[Math.min(c, planes.length - 1)] : null;
+      if (!plane) {
+        this.data.fill(0, base + start, base + start + first);
+        if (n > first) this.data.fill(0, base, base + n - first);
+        continue;
+      }
+      this.data.set(plane.subarray(offset, offset + first), base + start);
+      if (n > first) this.data.set(plane.subarray(offset + first, offset + n), base);
+    }
+
+    // Publish after the samples: the consumer's Atomics.load of WRITE orders
+    // its reads of the data behind this store.
+    Atomics.store(this.header, HDR_WRITE, (write + n) | 0);
+    Atomics.store(this.header, HDR_PRIMED, 1);
+    return n;
+  }
+
+  /** Drop everything written so far (applied by the consumer next quantum) */
+  flush(): void {
+    Atomics.store(this.header, HDR_FLUSH_TO, Atomics.load(this.header, HDR_WRITE));
+    Atomics.add(this.header, HDR_FLUSH_GEN, 1);
+    Atomics.store(this.header, HDR_PRIMED, 0);
+  }
+
+  /** Stop counting underruns until the next write (end of stream, pause) */
+  unprime(): void {
+    Atomics.store(this.header, HDR_PRIMED, 0);
+  }
+
+  stats(): PCMRingStats {
+    return {
+      fillFrames: this.fillFrames(),
+      capacityFrames: this.capacity,
+      underruns: Atomics.load(this.header, HDR_UNDERRUNS),
+      underrunFrames: Atomics.load(this.header, HDR_UNDERRUN_FRAMES),
+    };
+  }
+}
+
+/**
+ * Consumer side, evaluated in the AudioWorkletGlobalScope. Kept as source
+ * text (loaded through a Blob URL) so the library stays a single bundle with
+ * no separate worklet asset to host.
+ */
+const PROCESSOR_SOURCE = `
+class MoviPCMRingProcessor extends AudioWorkletProcessor {
+  constructor(options) {
+    super();
+    const sab = options.processorOptions.buffer;
+    this.header = new Int32Array(sab, 0, ${HEADER_INTS});
+    this.channels = this.header[${HDR_CHANNELS}];
+    this.capacity = this.header[${HDR_CAPACITY}];
+    this.data = new Float32Array(sab, ${HEADER_BYTES}, this.channels * this.capacity);
+    this.flushGen = Atomics.load(this.header, ${HDR_FLUSH_GEN});
+    this.alive = true;
+    this.port.onmessage = (e) => { if (e.data === "stop") this.alive = false; };
+    this.stretch = null;
+    this.stretching = false;
+    this.carry = 0;
+    this.latencyTempo = 0;
+    const mod = options.processorOptions.stretchModule;
+    if (mod) {
+      try {
+        this.stretch = this.createStretch(mod);
+        Atomics.store(this.header, ${HDR_STRETCH}, 1);
+      } catch (e) {
+        this.stretch = null;
+      }
+    }
+  }
+
+  createStretch(mod) {
+    // Reactor module: WASI/env imports are never reached on this path
+    const imports = {};
+    for (const imp of WebAssembly.Module.imports(mod)) {
+      if (imp.kind !== "function") continue;
+      (imports[imp.module] = imports[imp.module] || {})[imp.name] = () => 0;
+    }
+    const e = new WebAssembly.Instance(mod, imports).exports;
+    if (e._initialize) e._initialize();
+    const handle = e.movi_stretch_new_preset(this.channels, sampleRate, ${STRETCH_PRESET_LOW_LATENCY});
+    if (!handle) throw new Error("movi_stretch_new_preset failed");
+    const planes = e.malloc(this.channels * (${STRETCH_MAX_IN} + 1) * 4);
+    const ptrs = planes + this.channels * ${STRETCH_MAX_IN} * 4;
+    const s = { e, handle, planes, ptrs, f32: null, u32: null, buffer: null };
+    this.views(s);
+    for (let c = 0; c < this.channels; c++) s.u32[(ptrs >> 2) + c] = planes + c * ${STRETCH_MAX_IN} * 4;
+    return s;
+  }
+
+  views(s) {
+    // Refresh after memory growth detaches the old buffer
+    if (s.buffer !== s.e.memory.buffer) {
+      s.buffer = s.e.memory.buffer;
+      s.f32 = new Float32Array(s.buffer);
+      s.u32 = new Uint32Array(s.buffer);
+    }
+  }
+
+  processStretched(out, frames, tempo, write, read) {
+    const h = this.header;
+    const s = this.stretch;
+    if (!this.stretching) {
+      s.e.movi_stretch_reset(s.handle);
+      this.stretching = true;
+      this.carry = 0;
+    }
+    const want = frames * tempo + this.carry;
+    const n = Math.min(Math.floor(want), ${STRETCH_MAX_IN});
+    if (((write - read) >>> 0) < n) return false;
+    this.carry = want - n;
+
+    this.views(s);
+    const start = read & (this.capacity - 1);
+    const first = Math.min(n, this.capacity - start);
+    for (let c = 0; c < this.channels; c++) {
+      const base = c * this.capacity;
+      const dst = (s.planes >> 2) + c * ${STRETCH_MAX_IN};
+      s.f32.set(this.data.subarray(base + start, base + start + first), dst);
+      if (n > first) s.f32.set(this.data.subarray(base, base + n - first), dst + first);
+    }
+    s.e.movi_stretch_process_planar(s.handle, s.ptrs, this.channels, n, frames);
+    this.views(s);
+    for (let c = 0; c < out.length; c++) {
+      const src = s.e.movi_stretch_output_plane(s.handle, Math.min(c, this.channels - 1)) >> 2;
+      const dst = out[c];
+      for (let i = 0; i < frames; i++) dst[i] = s.f32[src + i];
+    }
+    Atomics.store(h, ${HDR_READ}, (read + n) | 0);
+
+    if (tempo !== this.latencyTempo) {
+      this.latencyTempo = tempo;
+      const latency = s.e.movi_stretch_input_latency(s.handle) +
+        Math.round(s.e.movi_stretch_output_latency(s.handle) * tempo);
+      Atomics.store(h, ${HDR_LATENCY}, latency);
+    }
+    return true;
+  }
+
+  process(inputs, outputs) {
+    const h = this.header;
+    const out = outputs[0];
+    const frames = out.length > 0 ? out[0].length : 128;
+    const write = Atomics.load(h, ${HDR_WRITE});
+    let read = Atomics.load(h, ${HDR_READ});
+
+    const gen = Atomics.load(h, ${HDR_FLUSH_GEN});
+    if (gen !== this.flushGen) {
+      this.flushGen = gen;
+      const to = Atomics.load(h, ${HDR_FLUSH_TO});
+      // Only ever move forward: a stale FLUSH_TO behind READ is ignored
+      if (((to - read) >>> 0) <= ((write - read) >>> 0)) {
+        read = to;
+        // Publish now: a stretched quantum that underruns returns without
+        // storing READ, and the generation is already consumed
+        Atomics.store(h, ${HDR_READ}, read);
+        // The stretcher's history is from before the jump: reset it on the
+        // next stretched quantum, which also republishes its latency
+        this.stretching = false;
+        this.latencyTempo = 0;
+        Atomics.store(h, ${HDR_LATENCY}, 0);
+      }
+    }
+
+    const tempo = Atomics.load(h, ${HDR_TEMPO}) / ${TEMPO_SCALE};
+    if (this.stretch && tempo > 0 && Math.abs(tempo - 1) > 0.01) {
+      if (this.processStretched(out, frames, tempo, write, read)) return this.alive;
+      for (let c = 0; c < out.length; c++) out[c].fill(0);
+      if (Atomics.load(h, ${HDR_PRIMED}) === 1) {
+        Atomics.add(h, ${HDR_UNDERRUNS}, 1);
+        Atomics.add(h, ${HDR_UNDERRUN_FRAMES}, frames);
+      }
+      return this.alive;
+    }
+    if (this.stretching) {
+      this.stretching = false;
+      this.latencyTempo = 0;
+      Atomics.store(h, ${HDR_LATENCY}, 0);
+    }
+
+    const n = Math.min(frames, (write - read) >>> 0);
+    const start = read & (this.capacity - 1);
+    const first = Math.min(n, this.capacity - start);
+    for (let c = 0; c < out.length; c++) {
+      const dst = out[c];
+      const base = Math.min(c, this.channels - 1) * this.capacity;
+      if (first > 0) dst.set(this.data.subarray(base + start, base + start + first), 0);
+      if (n > first) dst.set(this.data.subarray(base, base + n - first), first);
+      if (n < frames) dst.fill(0, n);
+    }
+    Atomics.store(h, ${HDR_READ}, (read + n) | 0);
+
+    if (n < frames && Atomics.load(h, ${HDR_PRIMED}) === 1) {
+      Atomics.add(h, ${HDR_UNDERRUNS}, 1);
+      Atomics.add(h, ${HDR_UNDERRUN_FRAMES}, frames - n);
+    }
+    return this.alive;
+  }
+}
+registerProcessor("${PCM_RING_PROCESSOR}", MoviPCMRingProcessor);
+`;
+
+const processorModules = new WeakMap<BaseAudioContext, Promise<boolean>>();
+
+/**
+ * Register the ring processor on `context` (once per context). Resolves
+ * false when AudioWorklet is unavailable or the module failed to load.
+ */
+export function loadPCMRingProcessor(context: BaseAudioContext): Promise<boolean> {
+  let loading = processorModules.get(context);
+  if (!loading) {
+    const url = URL.createObjectURL(
+      new Blob([PROCESSOR_SOURCE], { type: "application/javascript" }),
+    );
+    loading = context.audioWorklet
+      .addModule(url)
+      .then(() => true)
+      .catch(() => false)
+      .finally(() => URL.revokeObjectURL(url));
+    processorModules.set(context, loading);
+  }
+  return loading;
+}
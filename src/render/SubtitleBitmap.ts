@@ -0,0 +1,234 @@
+/**
+ * SubtitleBitmap - GPU palette expansion for PGS/DVB/DVD subtitle rects
+ *
+ * Bitmap subtitles are 8-bit indices into a 256-entry palette. Expanding them
+ * to RGBA on the CPU and then PNG-encoding the result for the overlay <img>
+ * costs a 33MB copy plus an encode per full-screen 4K object. Here each rect's
+ * index plane is an R8 texture and its palette a 256x1 RGBA texture, and a
+ * fragment shader does the lookup while drawing into a small WebGL2 canvas
+ * that sits in the subtitle overlay.
+ *
+ * Unchanged rects of consecutive display sets share one `indices` array (see
+ * SubtitleDecoder), and textures are keyed on that array, so a palette fade
+ * re-uploads 1KB per rect instead of the whole object. Without WebGL2 the same
+ * canvas falls back to a 2D context and expands on the CPU.
+ */
+
+import type { SubtitleCue } from "../types";
+import { Logger } from "../utils/Logger";
+
+const TAG = "SubtitleBitmap";
+
+type SubtitleBitmap = NonNullable<SubtitleCue["bitmap"]>;
+
+const VS_SOURCE = `#version 300 es
+  in vec2 a_position;
+  out vec2 v_texCoord;
+  void main() {
+    // Row 0 of the index plane at the top of the rect
+    v_texCoord = vec2(a_position.x * 0.5 + 0.5, 0.5 - a_position.y * 0.5);
+    gl_Position = vec4(a_position, 0.0, 1.0);
+  }`;
+
+const FS_SOURCE = `#version 300 es
+  precision highp float;
+  uniform sampler2D u_indices;
+  uniform sampler2D u_palette;
+  in vec2 v_texCoord;
+  out vec4 outColor;
+  void main() {
+    float index = texture(u_indices, v_texCoord).r * 255.0;
+    vec4 color = texture(u_palette, vec2((index + 0.5) / 256.0, 0.5));
+    // The canvas is premultiplied-alpha
+    outColor = vec4(color.rgb * color.a, color.a);
+  }`;
+
+export class SubtitleBitmapCanvas {
+  readonly canvas: HTMLCanvasElement;
+  private gl: WebGL2RenderingContext | null = null;
+  private ctx2d: CanvasRenderingContext2D | null = null;
+  private program: WebGLProgram | null = null;
+  private vao: WebGLVertexArrayObject | null = null;
+  private paletteTexture: WebGLTexture | null = null;
+  // Index textures of the last draw, keyed on the rect's indices array
+  private indexTextures: Map<Uint8Array, WebGLTexture> = new Map();
+  private drawn: SubtitleBitmap | null = null;
+  private initialized: boolean = false;
+
+  constructor() {
+    this.canvas = document.createElement("canvas");
+  }
+
+  /**
+   * Draw a cue's bitmap at its native size. No-op when it is already on
+   * the canvas.
+   */
+  draw(bitmap: SubtitleBitmap): void {
+    if (bitmap === this.drawn) return;
+    this.drawn = bitmap;
+    if (!this.initialized) this.init();
+
+    // Resizing clears the drawing buffer, which every draw repaints anyway
+    if (this.canvas.width !== bitmap.width) this.canvas.width = bitmap.width;
+    if (this.canvas.height !== bitmap.height) this.canvas.height = bitmap.height;
+
+    if (this.gl) {
+      this.drawGL(this.gl, bitmap);
+    } else if (this.ctx2d) {
+      this.draw2D(this.ctx2d, bitmap);
+    }
+  }
+
+  dispose(): void {
+    const gl = this.gl;
+    if (gl) {
+      for (const texture of this.indexTextures.values()) gl.deleteTexture(texture);
+      if (this.paletteTexture) gl.deleteTexture(this.paletteTexture);
+      if (this.program) gl.deleteProgram(this.program);
+      if (this.vao) gl.deleteVertexArray(this.vao);
+      gl.getExtension("WEBGL_lose_context")?.loseContext();
+    }
+    this.indexTextures.clear();
+    this.gl = null;
+    this.ctx2d = null;
+    this.drawn = null;
+  }
+
+  private init(): void {
+    this.initialized = true;
+    const gl = this.canvas.getContext("webgl2", {
+      alpha: true,
+      premultipliedAlpha: true,
+      antialias: false,
+      depth: false,
+    });
+    if (gl && this.initProgram(gl)) {
+      this.gl = gl;
+      return;
+    }
+    Logger.warn(TAG, "WebGL2 unavailable, expanding subtitle bitmaps on the CPU");
+    // A canvas with a (failed) webgl2 context can't switch to 2D
+    if (!gl) this.ctx2d = this.canvas.getContext("2d");
+  }
+
+  private initProgram(gl: WebGL2RenderingContext): boolean {
+    const createShader = (type: number, source: string) => {
+      const shader = gl.createShader(type);
+      if (!shader) return null;
+      gl.shaderSource(shader, source);
+      gl.compileShader(shader);
+      if (!gl.getShaderParameter(shader, gl.COMPILE_STATUS)) {
+        Logger.error(TAG, "Shader compile error:", gl.getShaderInfoLog(shader));
+        gl.deleteShader(shader);
+        return null;
+      }
+      return shader;
+    };
+
+    const vert = createShader(gl.VERTEX_SHADER, VS_SOURCE);
+    const frag = createShader(gl.FRAGMENT_SHADER, FS_SOURCE);
+    if (!vert || !frag) return false;
+
+    const program = gl.createProgram();
+    if (!program) return false;
+    gl.attachShader(program, vert);
+    gl.attachShader(program, frag);
+    gl.linkProgram(program);
+    gl.deleteShader(vert);
+    gl.deleteShader(frag);
+    if (!gl.getProgramParameter(program, gl.LINK_STATUS)) {
+      Logger.error(TAG, "Program link error:", gl.getProgramInfoLog(program));
+      gl.deleteProgram(program);
+      return false;
+    }
+    this.program = program;
+
+    this.vao = gl.createVertexArray();
+    gl.bindVertexArray(this.vao);
+    const vbo = gl.createBuffer();
+    gl.bindBuffer(gl.ARRAY_BUFFER, vbo);
+    gl.bufferData(
+      gl.ARRAY_BUFFER,
+      new Float32Array([-1.0, 1.0, -1.0, -1.0, 1.0, 1.0, 1.0, -1.0]),
+      gl.STATIC_DRAW,
+    );
+    const position = gl.getAttribLocation(program, "a_position");
+    gl.enableVertexAttribArray(position);
+    gl.vertexAttribPointer(position, 2, gl.FLOAT, false, 0, 0);
+    gl.bindVertexArray(null);
+
+    gl.useProgram(program);
+    gl.uniform1i(gl.getUniformLocation(program, "u_indices"), 0);
+    gl.uniform1i(gl.getUniformLocation(program, "u_palette"), 1);
+    this.paletteTexture = this.createTexture(gl);
+    return true;
+  }
+
+  private createTexture(gl: WebGL2RenderingContext): WebGLTexture | null {
+    const texture = gl.createTexture();
+    gl.bindTexture(gl.TEXTURE_2D, texture);
+    // Indices must not be filtered: a blend of two indices is a third colour
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.NEAREST);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MAG_FILTER, gl.NEAREST);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_S, gl.CLAMP_TO_EDGE);
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_T, gl.CLAMP_TO_EDGE);
+    return texture;
+  }
+
+  private drawGL(gl: WebGL2RenderingContext, bitmap: SubtitleBitmap): void {
+    gl.viewport(0, 0, bitmap.width, bitmap.height);
+    gl.clearColor(0, 0, 0, 0);
+    gl.clear(gl.COLOR_BUFFER_BIT);
+    gl.useProgram(this.program);
+    gl.bindVertexArray(this.vao);
+    gl.pixelStorei(gl.UNPACK_ALIGNMENT, 1);
+
+    const live = new Map<Uint8Array, WebGLTexture>();
+    for (const rect of bitmap.rects) {
+      let texture = this.indexTextures.get(rect.indices) ?? live.get(rect.indices);
+      gl.activeTexture(gl.TEXTURE0);
+      if (texture) {
+        gl.bindTexture(gl.TEXTURE_2D, texture);
+      } else {
+        texture = this.createTexture(gl) ?? undefined;
+        if (!texture) continue;
+        gl.texImage2D(
+          gl.TEXTURE_2D, 0, gl.R8, rect.width, rect.height, 0,
+          gl.RED, gl.UNSIGNED_BYTE, rect.indices,
+        );
+      }
+      live.set(rect.indices, texture);
+
+      gl.activeTexture(gl.TEXTURE1);
+      gl.bindTexture(gl.TEXTURE_2D, this.paletteTexture);
+      gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA8, 256, 1, 0, gl.RGBA, gl.UNSIGNED_BYTE, rect.palette);
+
+      // GL's origin is bottom-left, the rect's top-left
+      gl.viewport(rect.x, bitmap.height - rect.y - rect.height, rect.width, rect.height);
+      gl.drawArrays(gl.TRIANGLE_STRIP, 0, 4);
+    }
+    gl.bindVertexArray(null);
+
+    for (const [indices, texture] of this.indexTextures) {
+      if (!live.has(indices)) gl.deleteTexture(texture);
+    }
+    this.indexTextures = live;
+  }
+
+  private draw2D(ctx: CanvasRenderingContext2D, bitmap: SubtitleBitmap): void {
+    const image = ctx.createImageData(bitmap.width, bitmap.height);
+    // Palette entries are RGBA bytes, so whole pixels copy as one uint32
+    const out = new Uint32Array(image.data.buffer);
+    for (const rect of bitmap.rects) {
+      const palette = new Uint32Array(rect.palette.buffer, rect.palette.byteOffset, 256);
+      for (let y = 0; y < rect.height; y++) {
+        const src = y * rect.width;
+        const dst = (rect.y + y) * bitmap.width + rect.x;
+        for (let x = 0; x < rect.width; x++) {
+          out[dst + x] = palette[rect.indices[src + x]];
+        }
+      }
+    }
+    ctx.putImageData(image, 0, 0);
+  }
+}
@@ -1,2 +1,4 @@
 export { CanvasRenderer } from "./CanvasRenderer";
 export { AudioRenderer } from "./AudioRenderer";
+export { PCMRingWriter, isPCMRingSupported } from "./PCMRing";
+export type { PCMRingStats } from "./PCMRing";
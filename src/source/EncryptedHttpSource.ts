@@ -21,6 +21,17 @@
  *      IV, decrypts with the same non-extractable masterKey, and hands
  *      plaintext to the demuxer.
  *
+ * CTR mode (`wasmDecrypt`): the client asks for an AES-256-CTR session in
+ * the token request. A server that supports it derives the key
+ * ("enc:master-ctr") and counter nonce ("enc:ctr-nonce") with the same HKDF
+ * and frames raw ciphertext, [4-byte BE length][ciphertext], with the counter
+ * block = nonce || 64-bit BE index of the 16-byte block at the file offset.
+ * The demuxer reads that ciphertext through readCiphertext() and decrypts it
+ * in place inside WASM (movi_crypt.c) instead of one WebCrypto promise per
+ * frame here. The trade-off: the CTR key is raw bytes (it has to reach WASM),
+ * not a non-extractable CryptoKey, and CTR carries no per-frame auth tag.
+ * A server without CTR support ignores the request and the GCM path runs.
+ *
  * Why inherit from HttpSource? Purely for a shared SourceAdapter shape
  * + the convenience of resolveSize() and getKey() defaults. The
  * streaming machinery HttpSource provides is NOT used here — encrypted
@@ -31,6 +42,7 @@
 
 import { HttpSource } from "./HttpSource";
 import { Logger } from "../utils/Logger";
+import type { CipherRead, CtrCipher } from "../wasm/bindings";
 
 const TAG = "EncryptedSource";
 
@@ -43,6 +55,12 @@ export interface EncryptedSourceConfig {
   sessionToken: string;
   headers?: Record<string, string>;
   onAuthFailed?: (reason: string) => void;
+  /**
+   * Ask the server for an AES-256-CTR session so the demuxer decrypts in
+   * WASM (see the CTR note above). Off by default: the session key is then
+   * held as raw bytes rather than a non-extractable CryptoKey.
+   */
+  wasmDecrypt?: boolean;
 }
 
 interface TokenResponse {
@@ -67,6 +85,8 @@ interface TokenResponse {
    * Older tokens without this field fall back to a zero salt.
    */
   hkdfSalt?: string;
+  /** "aes-ctr" when the server agreed to a CTR session (wasmDecrypt) */
+  cipher?: string;
 }
 
 function b64Encode(bytes: Uint8Array): string {
@@ -102,6 +122,10 @@ export class EncryptedHttpSource extends HttpSource {
   // Per-session state derived from ECDH shared secret.
   private _masterKey: CryptoKey | null = null;
   private _hmacKey: CryptoKey | null = null;
+  // CTR session of the current token (null = AES-GCM frames), and a counter
+  // so every token's session gets its own generation
+  private _ctr: CtrCipher | null = null;
+  private _ctrGeneration: number = 0;
   private _token: string = "";
   private _expiresAt: number = 0;
   private _knownFileSize: number = -1;
@@ -165,6 +189,11 @@ export class EncryptedHttpSource extends HttpSource {
   private _prefetchHighWater: number = EncryptedHttpSource.PREFETCH_HIGH_WATER;
   private _lastReadEnd: number = 0;
   private readonly _blockCache = new Map<number, Uint8Array>();
+  // CTR mode: the session each cached block's ciphertext is under. Blocks
+  // without an entry hold plaintext (AES-GCM frames, decrypted on arrival).
+  private readonly _blockCipher = new Map<number, CtrCipher>();
+  // CryptoKeys for decrypting CTR blocks in JS (plaintext read()s)
+  private readonly _ctrCryptoKeys = new WeakMap<CtrCipher, Promise<CryptoKey>>();
   // Each block fetch is async — dedupe in-flight requests so parallel
   // reads for the same block share one HTTP round-trip.
   private readonly _blockInflight = new Map<number, Promise<Uint8Array>>();
@@ -235,9 +264,147 @@ export class EncryptedHttpSource extends HttpSource {
   // fetch in aligned plaintext blocks, decrypt once per block, and
   // satisfy the demuxer's many small reads out of the resulting cache.
   async read(offset: number, length: number): Promise<ArrayBuffer> {
+    const span = await this.fetchSpan(offset, length);
+    if (!span) return new ArrayBuffer(0);
+
+    // Assemble the requested slice across the returned blocks, decrypting
+    // the pieces of any CTR blocks (plaintext readers: thumbnails,
+    // fingerprinting — the demuxer itself uses readCiphertext).
+    const out = new Uint8Array(span.length);
+    let written = 0;
+    for (const piece of this.spanPieces(span)) {
+      const cipher = this._blockCipher.get(piece.block);
+      out.set(
+        cipher ? await this.ctrDecrypt(cipher, piece.offset, piece.bytes) : piece.bytes,
+        written,
+      );
+      written += piece.bytes.length;
+    }
+
+    // Top up the prefetch window if it's run low. Fire-and-forget —
+    // the stream just fills the cache in the background. Use actual
+    // bytes written (may be short at EOF) so prefetch doesn't aim
+    // past the end of the file. The cursor itself was already snapped
+    // to the requested range in fetchSpan, before the await.
+    this.maybePrefetch(span.offset + written);
+
+    // If the tail fell off the end of file, shrink the output buffer
+    // down to the bytes we actually produced.
+    return written === span.length
+      ? out.buffer
+      : out.slice(0, written).buffer;
+  }
+
+  /**
+   * CTR mode (wasmDecrypt) is on for this source. Whether the server agreed
+   * shows per read: readCiphertext returns a null cipher for plaintext.
+   */
+  isCtrEnabled(): boolean {
+    return !!this._encConfig.wasmDecrypt;
+  }
+
+  /**
+   * Like read(), but CTR blocks come back as ciphertext with the session
+   * they're under, for the demuxer to decrypt in place. Stops short at a
+   * block under a different session (a token refresh landed mid-range), so
+   * a result is always under one key; the caller reads on from there.
+   */
+  async readCiphertext(offset: number, length: number): Promise<CipherRead> {
+    const span = await this.fetchSpan(offset, length);
+    if (!span) return { data: new Uint8Array(0), cipher: null };
+
+    const pieces = this.spanPieces(span);
+    const cipher = pieces.length
+      ? (this._blockCipher.get(pieces[0].block) ?? null)
+      : null;
+    const out = new Uint8Array(span.length);
+    let written = 0;
+    for (const piece of pieces) {
+      if ((this._blockCipher.get(piece.block) ?? null) !== cipher) break;
+      out.set(piece.bytes, written);
+      written += piece.bytes.length;
+    }
+    this.maybePrefetch(span.offset + written);
+    return {
+      data: written === span.length ? out : out.subarray(0, written),
+      cipher,
+    };
+  }
+
+  // Byte range [offset, offset + length) of each block in `span`
+  private spanPieces(span: {
+    offset: number;
+    length: number;
+    firstBlock: number;
+    blocks: Uint8Array[];
+  }): { block: number; offset: number; bytes: Uint8Array }[] {
+    const BLOCK = EncryptedHttpSource.BLOCK_SIZE;
+    const pieces: { block: number; offset: number; bytes: Uint8Array }[] = [];
+    for (let i = 0; i < span.blocks.length; i++) {
+      const block = span.blocks[i];
+      const blockStart = (span.firstBlock + i) * BLOCK;
+      // Requested byte range intersected with this block's byte range.
+      const sliceStart = Math.max(0, span.offset - blockStart);
+      const sliceEnd = Math.min(
+        block.length,
+        span.offset + span.length - blockStart,
+      );
+      if (sliceEnd <= sliceStart) continue;
+      pieces.push({
+        block: span.firstBlock + i,
+        offset: blockStart + sliceStart,
+        bytes: block.subarray(sliceStart, sliceEnd),
+      });
+    }
+    return pieces;
+  }
+
+  // Decrypt CTR ciphertext that starts at file offset `offset` with
+  // WebCrypto, starting the counter at its 16-byte block
+  private async ctrDecrypt(
+    cipher: CtrCipher,
+    offset: number,
+    bytes: Uint8Array,
+  ): Promise<Uint8Array> {
+    let key = this._ctrCryptoKeys.get(cipher);
+    if (!key) {
+      key = crypto.subtle.importKey(
+        "raw",
+        new Uint8Array(cipher.key),
+        { name: "AES-CTR" },
+        false,
+        ["decrypt"],
+      );
+      this._ctrCryptoKeys.set(cipher, key);
+    }
+    const skip = offset % 16;
+    const counter = new Uint8Array(new ArrayBuffer(16));
+    counter.set(cipher.nonce.subarray(0, 8));
+    new DataView(counter.buffer).setBigUint64(8, BigInt(Math.floor(offset / 16)), false);
+    const padded = new Uint8Array(new ArrayBuffer(skip + bytes.length));
+    padded.set(bytes, skip);
+    const plain = await crypto.subtle.decrypt(
+      { name: "AES-CTR", counter, length: 64 },
+      await key,
+      padded,
+    );
+    return new Uint8Array(plain, skip);
+  }
+
+  // Fetch (or find cached) every block overlapping [offset, offset + length),
+  // clamped to the file. Null when nothing is left to read.
+  private async fetchSpan(
+    offset: number,
+    length: number,
+  ): Promise<{
+    offset: number;
+    length: number;
+    firstBlock: number;
+    blocks: Uint8Array[];
+  } | null> {
     const clampedOffset = Math.max(0, offset);
     let clampedLength = Math.max(0, length);
-    if (clampedLength === 0) return new ArrayBuffer(0);
+    if (clampedLength === 0) return null;
 
     // Clamp to file size so we never ask for bytes past EOF. Without
     // this, a read at offset=fileSize-64KB + length=512KB computes a
@@ -245,12 +412,12 @@ export class EncryptedHttpSource extends HttpSource {
     // starts a stream with firstBlock > lastBlock (negative range) and
     // the worker returns 400. Trim the request to what actually exists.
     if (this._knownFileSize > 0) {
-      if (clampedOffset >= this._knownFileSize) return new ArrayBuffer(0);
+      if (clampedOffset >= this._knownFileSize) return null;
       clampedLength = Math.min(
         clampedLength,
         this._knownFileSize - clampedOffset,
       );
-      if (clampedLength <= 0) return new ArrayBuffer(0);
+      if (clampedLength <= 0) return null;
     }
 
     const BLOCK = EncryptedHttpSource.BLOCK_SIZE;
@@ -317,37 +484,12 @@ export class EncryptedHttpSource extends HttpSource {
       );
     }
 
-    // Assemble the requested slice across the returned blocks.
-    const out = new Uint8Array(clampedLength);
-    let written = 0;
-    for (let b = firstBlock; b <= lastBlock; b++) {
-      const block = blocks[b - firstBlock];
-      const blockStart = b * BLOCK;
-      // Requested byte range intersected with this block's byte range.
-      const sliceStart = Math.max(0, clampedOffset - blockStart);
-      const sliceEnd = Math.min(
-        block.length,
-        clampedOffset + clampedLength - blockStart,
-      );
-      if (sliceEnd <= sliceStart) continue;
-      const piece = block.subarray(sliceStart, sliceEnd);
-      out.set(piece, written);
-      written += piece.length;
-    }
-
-    // Top up the prefetch window if it's run low. Fire-and-forget —
-    // the stream just fills the cache in the background. Use actual
-    // bytes written (may be short at EOF) so prefetch doesn't aim
-    // past the end of the file. The cursor itself was already snapped
-    // to the requested range above, before the await.
-    const readEnd = clampedOffset + written;
-    this.maybePrefetch(readEnd);
-
-    // If the tail fell off the end of file, shrink the output buffer
-    // down to the bytes we actually produced.
-    return written === clampedLength
-      ? out.buffer
-      : out.slice(0, written).buffer;
+    return {
+      offset: clampedOffset,
+      length: clampedLength,
+      firstBlock,
+      blocks,
+    };
   }
 
   /**
@@ -663,6 +805,7 @@ export class EncryptedHttpSource extends HttpSource {
     const streamMasterKey = this._masterKey;
     const streamToken = this._token;
     const streamHmacKey = this._hmacKey;
+    const streamCtr = this._ctr;
 
     const BLOCK = EncryptedHttpSource.BLOCK_SIZE;
     const start = firstBlock * BLOCK;
@@ -724,9 +867,14 @@ export class EncryptedHttpSource extends HttpSource {
     const commitBlock = (plain: Uint8Array) => {
       const tCommit = performance.now();
       this._blockCache.set(currentBlock, plain);
+      if (streamCtr) this._blockCipher.set(currentBlock, streamCtr);
+      else this._blockCipher.delete(currentBlock);
       if (this._blockCache.size > this._maxCachedBlocks) {
         const oldest = this._blockCache.keys().next().value;
-        if (oldest !== undefined) this._blockCache.delete(oldest);
+        if (oldest !== undefined) {
+          this._blockCache.delete(oldest);
+          this._blockCipher.delete(oldest);
+        }
       }
       const r = resolvers.get(currentBlock);
       const hadResolver = !!r;
@@ -790,6 +938,15 @@ export class EncryptedHttpSource extends HttpSource {
             4,
           ).getUint32(0, false);
           if (buf.length < 4 + frameLen) break;
+
+          // CTR frames are bare ciphertext, cached as-is: nothing to
+          // decrypt here (the demuxer does it in WASM)
+          if (streamCtr) {
+            const ct = buf.slice(4, 4 + frameLen);
+            buf = buf.slice(4 + frameLen);
+            commitChain = commitChain.then(() => commitBlock(ct));
+            continue;
+          }
           // Copy IV/CT out of `buf` — the chained decrypt may outlive
           // the next buf = buf.slice(...) reassignment, so we want
           // owned memory rather than views into the rolling buffer.
@@ -861,6 +1018,11 @@ export class EncryptedHttpSource extends HttpSource {
     this._hmacKey = null;
     this._clientPrivKey = null;
     this._usedNonces.clear();
+    // CTR session keys are plain bytes — zero them before letting go
+    this._ctr?.key.fill(0);
+    this._ctr = null;
+    for (const cipher of this._blockCipher.values()) cipher.key.fill(0);
+    this._blockCipher.clear();
     this._blockCache.clear();
     this._blockInflight.clear();
     // Let HttpSource release its (unused) stream/buffer state.
@@ -900,6 +1062,7 @@ export class EncryptedHttpSource extends HttpSource {
         videoId: this._encConfig.videoId,
         fingerprint: this._encConfig.fingerprint,
         clientPubKey: this._clientPubB64,
+        ...(this._encConfig.wasmDecrypt ? { cipher: "aes-ctr" } : {}),
       }),
       credentials: "include",
       signal: this._abortCtrl.signal,
@@ -1001,6 +1164,38 @@ export class EncryptedHttpSource extends HttpSource {
       ["sign"],
     );
 
+    // CTR session for this token, if we asked for one and the server
+    // agreed. Raw bytes by necessity — they're handed to WASM. Earlier
+    // sessions stay referenced by the blocks cached under them.
+    this._ctr = null;
+    if (this._encConfig.wasmDecrypt && data.cipher === "aes-ctr") {
+      const ctrKeyBits = await crypto.subtle.deriveBits(
+        {
+          name: "HKDF",
+          hash: "SHA-256",
+          salt: hkdfSalt,
+          info: new TextEncoder().encode("enc:master-ctr"),
+        },
+        sharedKey,
+        256,
+      );
+      const ctrNonceBits = await crypto.subtle.deriveBits(
+        {
+          name: "HKDF",
+          hash: "SHA-256",
+          salt: hkdfSalt,
+          info: new TextEncoder().encode("enc:ctr-nonce"),
+        },
+        sharedKey,
+        64,
+      );
+      this._ctr = {
+        key: new Uint8Array(ctrKeyBits),
+        nonce: new Uint8Array(ctrNonceBits),
+        generation: ++this._ctrGeneration,
+      };
+    }
+
     // Fresh session = nonces from prior token are no longer replayable
     // by definition (the HMAC key itself changed), but keeping the set
     // bounded is still cheap insurance.
@@ -41,6 +41,17 @@ const METADATA_CACHE_MAX_CHUNK = 128 * 1024; // Reads larger than this skip the
 const METADATA_CACHE_MAX_BYTES = 8 * 1024 * 1024; // 8MB total cap
 const METADATA_CACHE_MAX_ENTRIES = 128;
 
+// Out-of-window range read-ahead. A read that misses the stream window is
+// served by a one-off range fetch; FFmpeg follows it with more small reads
+// right behind it (Cues/SeekHead/index walks, moov-at-end probing, the next
+// AVIO refill), each of which used to be its own round trip. One-off fetches
+// are rounded up to a span sized from measured range throughput (~RANGE_AHEAD_TARGET_MS
+// of transfer, clamped), the surplus is kept, and once the reader is halfway
+// through it the next span is fetched speculatively. Seeks cancel it.
+const RANGE_AHEAD_MIN = 512 * 1024;
+const RANGE_AHEAD_MAX = 8 * 1024 * 1024;
+const RANGE_AHEAD_TARGET_MS = 250;
+
 export class HttpSource implements SourceAdapter {
   private url: string;
   private headers: Record<string, string>;
@@ -138,6 +149,19 @@ export class HttpSource implements SourceAdapter {
   // Consumed by the next read either way (an in-window seek needs no restart).
   private seekHinted: boolean = false;
 
+  // Range read-ahead state (see RANGE_AHEAD_*). `rangeAhead` holds the bytes
+  // of the last one-off fetch beyond what the read asked for; the in-flight
+  // entry is the speculative follow-up. rangeThroughput is a smoothed
+  // bytes/s over range fetches, round trip included — what sizes the span.
+  private rangeAhead: { offset: number; data: Uint8Array } | null = null;
+  private rangeAheadInflight: {
+    offset: number;
+    length: number;
+    controller: AbortController;
+    promise: Promise<Uint8Array | null>;
+  } | null = null;
+  private rangeThroughput: number = 0;
+
   // Dynamic buffer size (3% of file size, clamped)
   // Start with minimum size, will be resized when file size is known
   private bufferSize: number = MIN_BUFFER_SIZE;
@@ -389,6 +413,140 @@ export class HttpSource implements SourceAdapter {
    */
   hintSeek(): void {
     this.seekHinted = true;
+    this.cancelRangeAhead();
+  }
+
+  /**
+   * Drop read-ahead bytes and abort the speculative range fetch, if any.
+   */
+  private cancelRangeAhead(): void {
+    if (this.rangeAheadInflight) {
+      this.rangeAheadInflight.controller.abort();
+      this.rangeAheadInflight = null;
+    }
+    this.rangeAhead = null;
+  }
+
+  /**
+   * Span to fetch for an out-of-window read of `length` bytes
+   */
+  private rangeAheadSpan(length: number): number {
+    const target =
+      this.rangeThroughput > 0
+        ? (this.rangeThroughput * RANGE_AHEAD_TARGET_MS) / 1000
+        : RANGE_AHEAD_MIN;
+    const span = Math.min(RANGE_AHEAD_MAX, Math.max(RANGE_AHEAD_MIN, Math.round(target)));
+    return Math.max(length, span);
+  }
+
+  /**
+   * Fetch [offset, offset + length) with a Range request, clamped to EOF.
+   * Throws if the server ignores the Range header.
+   */
+  private async fetchRange(
+    offset: number,
+    length: number,
+    signal?: AbortSignal,
+  ): Promise<Uint8Array> {
+    const rangeEnd =
+      this.size > 0
+        ? Math.min(offset + length - 1, this.size - 1)
+        : offset + length - 1;
+    const rangeLen = rangeEnd - offset + 1;
+    const started = performance.now();
+    const response = await fetch(this.url, {
+      headers: await this.buildRequestHeaders({ offset, length: rangeLen }),
+      signal,
+    });
+    if (response.status !== 206 && !response.ok) {
+      throw new Error(`Range fetch failed: HTTP ${response.status}`);
+    }
+    // Guard against a server that ignores the Range header and streams
+    // the whole file back: that huge body would be wrong to slot into a
+    // small window. Bail (→ stream restart) rather than mis-writing it.
+    const contentLength = response.headers.get("content-length");
+    if (contentLength && parseInt(contentLength, 10) > rangeLen * 1.5) {
+      throw new Error(
+        `Server ignored Range (Content-Length ${contentLength} for a ${rangeLen}-byte request)`,
+      );
+    }
+    const arrayBuffer = await response.arrayBuffer();
+    if (
+      response.status !== 206 &&
+      arrayBuffer.byteLength > rangeLen * 1.5
+    ) {
+      throw new Error(
+        `Server ignored Range (returned ${arrayBuffer.byteLength} bytes for a ${rangeLen}-byte request)`,
+      );
+    }
+
+    const elapsed = (performance.now() - started) / 1000;
+    if (elapsed > 0 && arrayBuffer.byteLength > 0) {
+      const sample = arrayBuffer.byteLength / elapsed;
+      this.rangeThroughput =
+        this.rangeThroughput > 0 ? this.rangeThroughput * 0.7 + sample * 0.3 : sample;
+    }
+    this.totalBytesDownloaded += arrayBuffer.byteLength;
+    return new Uint8Array(arrayBuffer);
+  }
+
+  /**
+   * Serve a read from the range read-ahead, awaiting the speculative fetch
+   * if it covers the offset. Returns null on a miss.
+   */
+  private async readFromRangeAhead(offset: number, length: number): Promise<ArrayBuffer | null> {
+    const inflight = this.rangeAheadInflight;
+    if (
+      inflight &&
+      (!this.rangeAhead ||
+        offset >= this.rangeAhead.offset + this.rangeAhead.data.length) &&
+      offset >= inflight.offset &&
+      offset < inflight.offset + inflight.length
+    ) {
+      const data = await inflight.promise;
+      if (this.rangeAheadInflight === inflight) {
+        this.rangeAheadInflight = null;
+        if (data) this.rangeAhead = { offset: inflight.offset, data };
+      }
+    }
+
+    const ahead = this.rangeAhead;
+    if (
+      !ahead ||
+      offset < ahead.offset ||
+      offset + length > ahead.offset + ahead.data.length
+    ) {
+      return null;
+    }
+
+    const local = offset - ahead.offset;
+    const result = new Uint8Array(length);
+    result.set(ahead.data.subarray(local, local + length));
+    this.position = offset + length;
+
+    // Halfway through the held span: fetch the next one behind the reader.
+    const aheadEnd = ahead.offset + ahead.data.length;
+    if (
+      !this.rangeAheadInflight &&
+      local + length > ahead.data.length / 2 &&
+      (this.size <= 0 || aheadEnd < this.size)
+    ) {
+      this.startRangeAhead(aheadEnd, this.rangeAheadSpan(length));
+    }
+    return result.buffer;
+  }
+
+  private startRangeAhead(offset: number, length: number): void {
+    const controller = new AbortController();
+    const promise = this.fetchRange(offset, length, controller.signal).catch(
+      (e) => {
+        if (!controller.signal.aborted) {
+          Logger.debug(TAG, `Speculative range fetch at ${offset} failed`, e);
+        }
+        return null;
+      },
+    );
+    this.rangeAheadInflight = { offset, length, controller, promise };
   }
 
   private async awaitPrefetchGate(): Promise<void> {
@@ -844,6 +1002,11 @@ export class HttpSource implements SourceAdapter {
     }
 
     await this.stopStream();
+    // The new stream gets the bandwidth; held read-ahead bytes stay valid.
+    if (this.rangeAheadInflight) {
+      this.rangeAheadInflight.controller.abort();
+      this.rangeAheadInflight = null;
+    }
 
     Logger.info(TAG, `Starting stream from ${fromOffset}`);
 
@@ -1722,6 +1885,17 @@ export class HttpSource implements SourceAdapter {
       return this.readFromBuffer(offset, length);
     }
 
+    // Held or in-flight range read-ahead from an earlier out-of-window read.
+    // Not a network fetch on this read, so it doesn't count toward the
+    // one-off streak that would restart the main stream.
+    if (!this.rangeUnsupported) {
+      const ahead = await this.readFromRangeAhead(offset, length);
+      if (ahead) {
+        Logger.debug(TAG, `Read: served from range read-ahead`);
+        return ahead;
+      }
+    }
+
     // Non-range source: there is exactly one stream (the full file from 0),
     // so we can never restart at a different offset. Forward reads wait for the
     // single sequential stream to reach them; reads behind the sliding window
@@ -1847,55 +2021,36 @@ export class HttpSource implements SourceAdapter {
     ) {
       Logger.info(TAG, `Read: one-off range fetch for offset=${offset}, length=${length} (outside stream window, main stream continues)`);
       try {
-        const rangeEnd =
-          this.size > 0
-            ? Math.min(offset + length - 1, this.size - 1)
-            : offset + length - 1;
-        const rangeLen = rangeEnd - offset + 1;
-        const response = await fetch(this.url, {
-          headers: await this.buildRequestHeaders({ offset, length: rangeLen }),
-        });
-        if (response.status === 206 || response.ok) {
-          // Guard against a server that ignores the Range header and streams
-          // the whole file back: that huge body would be wrong to slot into a
-          // small window. Bail (→ stream restart) rather than mis-writing it.
-          const contentLength = response.headers.get("content-length");
-          if (contentLength && parseInt(contentLength, 10) > rangeLen * 1.5) {
-            throw new Error(
-              `Server ignored Range (Content-Length ${contentLength} for a ${rangeLen}-byte request)`,
-            );
-          }
-          const arrayBuffer = await response.arrayBuffer();
-          if (
-            response.status !== 206 &&
-            arrayBuffer.byteLength > rangeLen * 1.5
-          ) {
-            throw new Error(
-              `Server ignored Range (returned ${arrayBuffer.byteLength} bytes for a ${rangeLen}-byte request)`,
-            );
-          }
-          const data = new Uint8Array(arrayBuffer);
-
-          // Cache into the buffer only when the offset maps inside the current
-          // window (small / buffer-fitting files). For large streamed files the
-          // offset falls outside the window, so we just serve the data directly.
-          const buffer = this.getBuffer();
-          const bufStart = this.atomicGetBufferStart();
-          const localOffset = offset - bufStart;
-          if (localOffset >= 0 && localOffset + data.length <= buffer.length) {
-            buffer.set(data, localOffset);
-          }
+        // Round the fetch up so the reads FFmpeg issues right behind this
+        // one are coalesced into the same request (see RANGE_AHEAD_*).
+        const span = Math.min(ONEOFF_RANGE_MAX_BYTES, this.rangeAheadSpan(length));
+        if (this.rangeAheadInflight) {
+          this.rangeAheadInflight.controller.abort();
+          this.rangeAheadInflight = null;
+        }
+        const data = await this.fetchRange(offset, span);
 
-          // Serve the fetched data directly
-          const result = new Uint8Array(data.length);
-          result.set(data);
-          this.position = offset + data.length;
-          this.consecutiveForceRestarts = 0;
-          // Count this one-off; a run of them (a real seek) trips the gate above
-          // on the next read and restarts the stream at the new position.
-          this.consecutiveOneOffFetches++;
-          return result.buffer;
+        // Cache into the buffer only when the offset maps inside the current
+        // window (small / buffer-fitting files). For large streamed files the
+        // offset falls outside the window, so we just serve the data directly.
+        const buffer = this.getBuffer();
+        const bufStart = this.atomicGetBufferStart();
+        const localOffset = offset - bufStart;
+        if (localOffset >= 0 && localOffset + data.length <= buffer.length) {
+          buffer.set(data, localOffset);
         }
+
+        // Serve the requested part; keep the surplus for the next reads
+        const served = Math.min(length, data.length);
+        const result = new Uint8Array(served);
+        result.set(data.subarray(0, served));
+        this.rangeAhead = data.length > served ? { offset, data } : null;
+        this.position = offset + served;
+        this.consecutiveForceRestarts = 0;
+        // Count this one-off; a run of them (a real seek) trips the gate above
+        // on the next read and restarts the stream at the new position.
+        this.consecutiveOneOffFetches++;
+        return result.buffer;
       } catch (e) {
         Logger.warn(TAG, `One-off range fetch failed, falling back to stream restart`, e);
       }
@@ -1957,6 +2112,7 @@ export class HttpSource implements SourceAdapter {
 
   close(): void {
     this.stopStream();
+    this.cancelRangeAhead();
     Logger.debug(TAG, "Source closed");
   }
 
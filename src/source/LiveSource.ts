@@ -0,0 +1,146 @@
+/**
+ * LiveSource - Push-based HTTP source for live MPEG-TS / fragmented MP4 feeds.
+ *
+ * A live feed is one endless response with no size and no Range support, so
+ * the pull model (the demuxer asks for offset/length, HttpSource fetches it)
+ * doesn't fit. LiveSource streams the response body and pushes each chunk to
+ * a sink as it arrives — the demuxer's live FIFO (movi_live.c) — holding back
+ * while the sink is full. The SourceAdapter methods exist so the player can
+ * treat it like any other source; there is nothing to read at an offset.
+ */
+
+import type { SourceAdapter } from "./SourceAdapter";
+import { Logger } from "../utils/Logger";
+
+const TAG = "LiveSource";
+
+// Wait before re-offering bytes the sink refused (its queue was full)
+const BACKPRESSURE_RETRY_MS = 20;
+
+/**
+ * Where pushed bytes go. Returns how many bytes were taken (fewer than
+ * given = full, retry the rest later; < 0 = gone, stop).
+ */
+export interface LiveSink {
+  push(chunk: Uint8Array): number;
+  end(): void;
+}
+
+export class LiveSource implements SourceAdapter {
+  private url: string;
+  private headers: Record<string, string>;
+  private abortController: AbortController | null = null;
+  private bytesReceived: number = 0;
+  private ended: boolean = false;
+  private onError: ((error: Error) => void) | null = null;
+
+  constructor(url: string, headers: Record<string, string> = {}) {
+    this.url = url;
+    this.headers = headers;
+  }
+
+  /**
+   * Start streaming the feed into `sink`. Resolves once the response headers
+   * are in (rejects on an HTTP error); chunks keep flowing after that until
+   * the feed ends or close() is called.
+   */
+  async start(sink: LiveSink): Promise<void> {
+    this.close();
+    this.ended = false;
+    const controller = new AbortController();
+    this.abortController = controller;
+    const response = await fetch(this.url, {
+      headers: this.headers,
+      signal: controller.signal,
+    });
+    if (!response.ok || !response.body) {
+      throw new Error(`Live feed request failed: HTTP ${response.status}`);
+    }
+    Logger.info(TAG, `Live feed connected: ${this.url}`);
+    void this.pump(response.body.getReader(), sink, controller.signal);
+  }
+
+  private async pump(
+    reader: ReadableStreamDefaultReader<Uint8Array>,
+    sink: LiveSink,
+    signal: AbortSignal,
+  ): Promise<void> {
+    try {
+      for (;;) {
+        const { done, value } = await reader.read();
+        if (done || signal.aborted) break;
+        let chunk = value;
+        while (chunk.byteLength > 0 && !signal.aborted) {
+          const taken = sink.push(chunk);
+          if (taken < 0) return;
+          this.bytesReceived += taken;
+          chunk = chunk.subarray(taken);
+          if (chunk.byteLength > 0) {
+            await new Promise((r) => setTimeout(r, BACKPRESSURE_RETRY_MS));
+          }
+        }
+      }
+      if (!signal.aborted) {
+        Logger.info(TAG, `Live feed ended after ${this.bytesReceived} bytes`);
+        this.ended = true;
+        sink.end();
+      }
+    } catch (error) {
+      if (signal.aborted) return;
+      Logger.error(TAG, "Live feed failed", error);
+      this.ended = true;
+      sink.end();
+      this.onError?.(error as Error);
+    } finally {
+      reader.releaseLock();
+    }
+  }
+
+  /** Called when the feed breaks off mid-stream (not on close()) */
+  setOnError(cb: ((error: Error) => void) | null): void {
+    this.onError = cb;
+  }
+
+  /** Bytes handed to the sink so far */
+  getBytesReceived(): number {
+    return this.bytesReceived;
+  }
+
+  isEnded(): boolean {
+    return this.ended;
+  }
+
+  /** A live feed is always forward-only: no seeking, no timeline */
+  isLinearMode(): boolean {
+    return true;
+  }
+
+  // SourceAdapter: a live feed has no size and nothing to read at an offset
+
+  async getSize(): Promise<number> {
+    return 0;
+  }
+
+  async read(_offset: number, _length: number): Promise<ArrayBuffer> {
+    return new ArrayBuffer(0);
+  }
+
+  seek(_offset: number): number {
+    return this.bytesReceived;
+  }
+
+  getPosition(): number {
+    return this.bytesReceived;
+  }
+
+  close(): void {
+    if (this.abortController) {
+      this.abortController.abort();
+      this.abortController = null;
+    }
+  }
+
+  getKey(): string {
+    return `live:${this.url}`;
+  }
+}
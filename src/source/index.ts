@@ -4,6 +4,8 @@ export { FileSource, createFileSource } from './FileSource';
 export { ThumbnailHttpSource, createThumbnailHttpSource } from './ThumbnailHttpSource';
 export { EncryptedHttpSource } from './EncryptedHttpSource';
 export type { EncryptedSourceConfig } from './EncryptedHttpSource';
+export { LiveSource } from './LiveSource';
+export type { LiveSink } from './LiveSource';
 export { analyzeDashFallback } from './DashFallback';
 export type { DashFallbackPlan } from './DashFallback';
 export { generateFingerprint } from '../utils/Fingerprint';
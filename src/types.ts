@@ -79,7 +79,27 @@ export interface SubtitleCue {
   start: number;
   end: number;
   text?: string;
+  /** ASS style name of the event, when the batched decoder reports one */
+  style?: string;
   image?: ImageBitmap;
+  /**
+   * Palettized bitmap (PGS/DVB/DVD) the renderer expands on the GPU, in place
+   * of `image`. `width`/`height` bound every rect; rect positions are relative
+   * to `position`. Unchanged rects share their `indices` array with the
+   * previous cue, so the renderer can skip re-uploading them.
+   */
+  bitmap?: {
+    width: number;
+    height: number;
+    rects: {
+      x: number;
+      y: number;
+      width: number;
+      height: number;
+      indices: Uint8Array;
+      palette: Uint8Array;
+    }[];
+  };
   position?: { x: number; y: number };
 }
 
@@ -153,6 +173,7 @@ export interface PlayerConfig {
   canvas?: HTMLCanvasElement | OffscreenCanvas;
   wasmBinary?: Uint8Array; // Embedded WASM binary data
   enablePreviews?: boolean; // Enable thumbnail preview pipeline (default: false)
+  seekIndex?: boolean; // Scan files without a container index (MKV without Cues, TS, raw ES) once and cache the keyframe table in IndexedDB for fast seeks. Cached indexes are always used; default builds only for local files, since the scan reads the whole file
   frameRate?: number; // Override frame rate (fps) - 0 = auto
   headers?: Record<string, string>; // Custom HTTP headers for media network requests — adaptive manifest + segments (HLS/DASH) and progressive downloads alike (e.g. auth tokens, signed cookies)
   audioOnly?: boolean; // Audio-only mode: skip video decode (CPU) and, for adaptive streams, fetch only audio renditions (bandwidth). UI shows album art / strip.
@@ -161,6 +182,8 @@ export interface PlayerConfig {
   licenseHeaders?: Record<string, string>; // Custom headers for license requests (e.g., auth tokens)
   lcevc?: boolean; // Enable MPEG-5 Part 2 LCEVC decoding (needs the lcevc_dec.js library)
   lcevcUrl?: string; // Optional URL to lazy-load the lcevc_dec.js decoder library (else expect a global LCEVCdec)
+  live?: boolean | { latency?: number }; // Treat a url source as a live MPEG-TS / fragmented MP4 feed: bytes are pushed into the demuxer as they arrive, probing is cut short, and playback speeds up slightly to hold `latency` seconds (default 1) behind the newest demuxed packet. No seeking, previews or seek index
+  memoryBudget?: number | null; // Cap (bytes) on WASM allocations across all players sharing the module; idle players are trimmed to stay under it. Default 1 GB, null = no limit
 }
 
 // ============================================================================
@@ -234,6 +257,9 @@ export interface Packet {
   // renderer's adaptive detector reports the device can't keep up. Always false
   // for keyframes. See VideoDecoder.decode.
   disposable: boolean;
+  // Temporal sub-layer the picture belongs to (0 = base layer, and for streams
+  // without temporal scalability).
+  temporalId: number;
 }
 
 // ============================================================================
@@ -314,4 +340,10 @@ export interface PlayerEventMap {
    * to cache whole. The UI hides the timeline and disables seeking/thumbnails.
    */
   linearmode: void;
+  /**
+   * The load-shedding tier changed (0 = full decode, 1 = non-reference frames
+   * dropped, 2 = + no loop filter, 3 = B-frames dropped, 4 = keyframes only).
+   * `dropped` counts video packets the demuxer has dropped for this source.
+   */
+  dropTier: { tier: number; dropped: number };
 }
@@ -67,3 +67,25 @@ export async function generateFingerprint(): Promise<string> {
   const hashArray = Array.from(new Uint8Array(hashBuffer));
   return hashArray.map((b) => b.toString(16).padStart(2, "0")).join("");
 }
+
+/**
+ * Source Fingerprint
+ * Identifies a media file across sessions (keys the persistent seek index).
+ * The source key (URL or file name/size/mtime), the size and an optional
+ * sample of the first bytes are hashed, so a file replaced in place at the
+ * same URL stops matching once its header changes.
+ */
+export async function generateSourceFingerprint(
+  sourceKey: string,
+  size: number,
+  head?: Uint8Array,
+): Promise<string> {
+  const encoder = new TextEncoder();
+  const prefix = encoder.encode(`${sourceKey}|${size}|`);
+  const data = new Uint8Array(prefix.length + (head?.length ?? 0));
+  data.set(prefix, 0);
+  if (head) data.set(head, prefix.length);
+  const hashBuffer = await crypto.subtle.digest("SHA-256", data);
+  const hashArray = Array.from(new Uint8Array(hashBuffer));
+  return hashArray.map((b) => b.toString(16).padStart(2, "0")).join("");
+}
@@ -6,10 +6,16 @@
  *
  * Wire a sink (or listen to the element's `movi-qoe` CustomEvent) and forward to
  * Mux / GA4 / Amplitude / your own endpoint. Cookieless and self-host friendly.
+ *
+ * With a MOVI_STATS build of the WASM module, heartbeats are joined by
+ * `wasm_stats` samples: per-stage decode-path timings (I/O wait, demux,
+ * decode, conversion, stretch) for the interval since the previous sample.
  */
 
+import type { WasmInstrumentation, WasmStageStats } from "../wasm/bindings";
+
 /** Bump when the event shape changes so downstream consumers can branch. */
-export const QOE_SCHEMA_VERSION = 1;
+export const QOE_SCHEMA_VERSION = 3;
 
 export type QoEEvent =
   | { type: "session_start"; ts: number; src: string }
@@ -21,6 +27,8 @@ export type QoEEvent =
   | { type: "bitrate_switch"; ts: number; height: number | null; label: string | null }
   /** Decode dropped from hardware (WebCodecs) to software (FFmpeg-WASM). */
   | { type: "decode_fallback"; ts: number; codec: string }
+  /** Load-shedding tier changed (0 = full decode … 4 = keyframes only). */
+  | { type: "drop_tier"; ts: number; tier: number; droppedFrames: number }
   | { type: "error"; ts: number; message: string; fatal: boolean }
   /** Periodic health sample while playing. */
   | {
@@ -32,8 +40,25 @@ export type QoEEvent =
       decoder: string;
       rebufferRatio: number;
     }
+  /** WASM hot-path timings since the previous sample (MOVI_STATS builds). */
+  | {
+      type: "wasm_stats";
+      ts: number;
+      stages: Record<string, QoEStageSample>;
+      suspensions: number;
+      bytesRead: number;
+      bytesDiscarded: number;
+    }
   | { type: "ended"; ts: number; watchedMs: number };
 
+/** One WASM stage over a sample interval. Percentiles are histogram bucket
+ *  upper bounds, so they round up to the next power of two. */
+export interface QoEStageSample {
+  count: number;
+  meanMs: number;
+  p95Ms: number;
+}
+
 export type QoESink = (event: QoEEvent) => void;
 
 /** A rolled-up snapshot of the whole session. */
@@ -49,6 +74,31 @@ export interface QoESession {
   bitrateSwitches: number;
   errors: number;
   decoder: string;
+  /** Highest load-shedding tier reached this session. */
+  maxDropTier: number;
+  /** Whole-session WASM stage timings; null without a MOVI_STATS build. */
+  wasmStages: Record<string, QoEStageSample & { maxMs: number }> | null;
+}
+
+// Upper bound (ms) of the bucket holding quantile q of a latency histogram:
+// bucket b covers calls under baseUs << b, the last bucket is open-ended
+function histogramQuantile(buckets: number[], baseUs: number, q: number): number {
+  const total = buckets.reduce((a, b) => a + b, 0);
+  if (total <= 0) return 0;
+  let seen = 0;
+  for (let b = 0; b < buckets.length; b++) {
+    seen += buckets[b];
+    if (seen >= total * q) return (baseUs * 2 ** b) / 1000;
+  }
+  return (baseUs * 2 ** (buckets.length - 1)) / 1000;
+}
+
+function stageSample(s: WasmStageStats, baseUs: number): QoEStageSample {
+  return {
+    count: s.count,
+    meanMs: s.count > 0 ? +(s.totalMs / s.count).toFixed(3) : 0,
+    p95Ms: histogramQuantile(s.buckets, baseUs, 0.95),
+  };
 }
 
 /**
@@ -70,7 +120,9 @@ export class QoECollector {
   private bitrateSwitches = 0;
   private errors = 0;
   private droppedFrames = 0;
+  private maxDropTier = 0;
   private decoder = "unknown";
+  private wasmLast: WasmInstrumentation | null = null;
   private src = "";
   private nowFn: () => number;
 
@@ -113,6 +165,8 @@ export class QoECollector {
     this.bitrateSwitches = 0;
     this.errors = 0;
     this.droppedFrames = 0;
+    this.maxDropTier = 0;
+    this.wasmLast = null;
     this.src = src;
     this.emit({ type: "session_start", ts: this.stamp(), src });
   }
@@ -170,6 +224,12 @@ export class QoECollector {
     this.emit({ type: "decode_fallback", ts: this.stamp(), codec });
   }
 
+  dropTier(tier: number, droppedFrames: number): void {
+    this.droppedFrames = droppedFrames;
+    this.maxDropTier = Math.max(this.maxDropTier, tier);
+    this.emit({ type: "drop_tier", ts: this.stamp(), tier, droppedFrames });
+  }
+
   error(message: string, fatal: boolean): void {
     this.errors++;
     this.emit({ type: "error", ts: this.stamp(), message, fatal });
@@ -191,6 +251,36 @@ export class QoECollector {
     });
   }
 
+  /** WASM instrumentation snapshot (cumulative, from the player); emits the
+   *  difference from the previous snapshot. A counter that went backwards
+   *  means the context was reset or replaced, so the snapshot counts whole. */
+  wasmStats(stats: WasmInstrumentation): void {
+    const prev = this.wasmLast;
+    this.wasmLast = stats;
+    const stages: Record<string, QoEStageSample> = {};
+    for (const [name, cur] of Object.entries(stats.stages)) {
+      if (!cur) continue;
+      const old = prev?.stages[name as keyof typeof stats.stages];
+      const base = old && old.count <= cur.count ? old : null;
+      const delta: WasmStageStats = {
+        count: cur.count - (base?.count ?? 0),
+        totalMs: cur.totalMs - (base?.totalMs ?? 0),
+        maxMs: cur.maxMs,
+        buckets: cur.buckets.map((n, i) => n - (base?.buckets[i] ?? 0)),
+      };
+      if (delta.count > 0) stages[name] = stageSample(delta, stats.bucketBaseUs);
+    }
+    const since = prev && prev.bytesRead <= stats.bytesRead ? prev : null;
+    this.emit({
+      type: "wasm_stats",
+      ts: this.stamp(),
+      stages,
+      suspensions: stats.suspensions - (since?.suspensions ?? 0),
+      bytesRead: stats.bytesRead - (since?.bytesRead ?? 0),
+      bytesDiscarded: stats.bytesDiscarded - (since?.bytesDiscarded ?? 0),
+    });
+  }
+
   ended(): void {
     this.paused();
     this.emit({ type: "ended", ts: this.stamp(), watchedMs: this.watchedMs() });
@@ -223,8 +313,21 @@ export class QoECollector {
       bitrateSwitches: this.bitrateSwitches,
       errors: this.errors,
       decoder: this.decoder,
+      maxDropTier: this.maxDropTier,
+      wasmStages: this.wasmSession(),
     };
   }
+
+  private wasmSession(): QoESession["wasmStages"] {
+    const last = this.wasmLast;
+    if (!last) return null;
+    const out: NonNullable<QoESession["wasmStages"]> = {};
+    for (const [name, s] of Object.entries(last.stages)) {
+      if (s && s.count > 0)
+        out[name] = { ...stageSample(s, last.bucketBaseUs), maxMs: s.maxMs };
+    }
+    return out;
+  }
 }
 
 /** Built-in sink: POST each event to `url` via sendBeacon (falls back to fetch
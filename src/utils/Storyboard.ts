@@ -0,0 +1,225 @@
+/**
+ * Storyboard - Sprite-sheet thumbnail extraction on a pool of thumbnail contexts
+ *
+ * getPreviewFrame serves one hover at a time (seek, decode, encode per tile),
+ * so a full seekbar strip for a long file trickles in tile by tile. Here the
+ * timestamps are known up front: they're sorted (timestamp order is file
+ * order), split into contiguous slices, and each slice is swept once by its
+ * own MoviThumbnailContext in an isolated WASM instance
+ * (movi_thumbnail_storyboard_*: keyframe-only demux + decode, forward reads
+ * between nearby targets, tiles scaled to size in C). The slices download in
+ * parallel; the tiles are composited into one sprite sheet with a timestamp
+ * map that can be cached and served without touching WASM again.
+ */
+
+import type { SourceAdapter } from "../source/SourceAdapter";
+import { ThumbnailBindings } from "../wasm/bindings";
+import { loadWasmModuleNew } from "../wasm/FFmpegLoader";
+import { Logger } from "./Logger";
+
+const TAG = "Storyboard";
+
+export interface StoryboardOptions {
+  /** Number of tiles (default 100) */
+  count?: number;
+  /** Tile width in pixels; height follows the video aspect ratio (default 160) */
+  tileWidth?: number;
+  /** Tiles per sprite-sheet row (default 10) */
+  columns?: number;
+  /** Parallel thumbnail contexts, each its own WASM instance (default 2, max 4) */
+  workers?: number;
+  /** JPEG quality of the sprite sheet (default 0.7) */
+  quality?: number;
+}
+
+export interface StoryboardCue {
+  /** Requested time (seconds) */
+  time: number;
+  /** Presentation time of the keyframe actually shown (seconds) */
+  pts: number;
+  /** Tile origin in the sprite sheet */
+  x: number;
+  y: number;
+}
+
+export interface Storyboard {
+  image: Blob;
+  tileWidth: number;
+  tileHeight: number;
+  columns: number;
+  rows: number;
+  /** Sorted by time; a missing tile (decode failure) has no cue */
+  cues: StoryboardCue[];
+}
+
+export interface StoryboardSource {
+  /** A reader for one worker; may return the same adapter each time */
+  createSource: () => SourceAdapter | null;
+  /** Called with each created source once its worker is done */
+  releaseSource?: (source: SourceAdapter) => void;
+  fileSize: number;
+  videoWidth: number;
+  videoHeight: number;
+  wasmBinary?: Uint8Array;
+  /** Serialised seek index to load into each context (see Demuxer.buildSeekIndex) */
+  seekIndex?: Uint8Array | null;
+  /** Probed stream descriptor that lets each context open without probing */
+  probeDescriptor?: Uint8Array | null;
+}
+
+const MAX_WORKERS = 4;
+
+/**
+ * Look up the cue to show for time t (the last cue at or before it)
+ */
+export function findStoryboardCue(board: Storyboard, t: number): StoryboardCue | null {
+  const cues = board.cues;
+  if (cues.length === 0) return null;
+  let lo = 0;
+  let hi = cues.length - 1;
+  let best = 0;
+  while (lo <= hi) {
+    const mid = (lo + hi) >> 1;
+    if (cues[mid].time <= t) {
+      best = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return cues[best];
+}
+
+export class StoryboardGenerator {
+  private input: StoryboardSource;
+
+  constructor(input: StoryboardSource) {
+    this.input = input;
+  }
+
+  /**
+   * Build a storyboard for `times` (seconds). Resolves to null when nothing
+   * could be decoded or `isCancelled` returned true.
+   */
+  async generate(
+    times: number[],
+    options: StoryboardOptions = {},
+    isCancelled: () => boolean = () => false,
+  ): Promise<Storyboard | null> {
+    const { videoWidth, videoHeight } = this.input;
+    if (times.length === 0 || videoWidth <= 0 || videoHeight <= 0) return null;
+
+    const tileWidth = Math.max(16, Math.round(options.tileWidth ?? 160) & ~1);
+    const tileHeight = Math.max(16, Math.round((tileWidth * videoHeight) / videoWidth) & ~1);
+    const columns = Math.max(1, Math.min(options.columns ?? 10, times.length));
+    const rows = Math.ceil(times.length / columns);
+    const workers = Math.max(1, Math.min(options.workers ?? 2, MAX_WORKERS, times.length));
+
+    const sorted = [...times].sort((a, b) => a - b);
+    const sliceSize = Math.ceil(sorted.length / workers);
+    const slices: { start: number; times: number[] }[] = [];
+    for (let i = 0; i < sorted.length; i += sliceSize) {
+      slices.push({ start: i, times: sorted.slice(i, i + sliceSize) });
+    }
+
+    const started = performance.now();
+    const tiles: ({ pts: number; rgba: Uint8ClampedArray } | null)[] = new Array(sorted.length).fill(null);
+    await Promise.all(
+      slices.map((slice) =>
+        this.sweep(slice.times, tileWidth, tileHeight, isCancelled).then((result) => {
+          result.forEach((tile, i) => {
+            tiles[slice.start + i] = tile;
+          });
+        }),
+      ),
+    );
+    if (isCancelled()) return null;
+
+    const width = columns * tileWidth;
+    const height = rows * tileHeight;
+    const canvas: OffscreenCanvas | HTMLCanvasElement =
+      typeof OffscreenCanvas !== "undefined"
+        ? new OffscreenCanvas(width, height)
+        : Object.assign(document.createElement("canvas"), { width, height });
+    const ctx2d = canvas.getContext("2d") as
+      | OffscreenCanvasRenderingContext2D
+      | CanvasRenderingContext2D
+      | null;
+    if (!ctx2d) return null;
+
+    const cues: StoryboardCue[] = [];
+    tiles.forEach((tile, i) => {
+      if (!tile) return;
+      const x = (i % columns) * tileWidth;
+      const y = Math.floor(i / columns) * tileHeight;
+      ctx2d.putImageData(new ImageData(tile.rgba, tileWidth, tileHeight), x, y);
+      cues.push({ time: sorted[i], pts: tile.pts, x, y });
+    });
+    if (cues.length === 0) return null;
+
+    const quality = options.quality ?? 0.7;
+    const image =
+      "convertToBlob" in canvas
+        ? await canvas.convertToBlob({ type: "image/jpeg", quality })
+        : await new Promise<Blob | null>((resolve) =>
+            (canvas as HTMLCanvasElement).toBlob(resolve, "image/jpeg", quality),
+          );
+    if (!image) return null;
+
+    Logger.info(
+      TAG,
+      `Storyboard: ${cues.length}/${sorted.length} tiles, ${workers} workers, ${Math.round(performance.now() - started)}ms`,
+    );
+    return { image, tileWidth, tileHeight, columns, rows, cues };
+  }
+
+  /**
+   * One worker: an isolated WASM instance sweeping an ascending slice
+   */
+  private async sweep(
+    times: number[],
+    tileWidth: number,
+    tileHeight: number,
+    isCancelled: () => boolean,
+  ): Promise<({ pts: number; rgba: Uint8ClampedArray } | null)[]> {
+    const out: ({ pts: number; rgba: Uint8ClampedArray } | null)[] = new Array(times.length).fill(null);
+    const source = this.input.createSource();
+    if (!source) return out;
+
+    let bindings: ThumbnailBindings | null = null;
+    try {
+      const module = await loadWasmModuleNew({ wasmBinary: this.input.wasmBinary });
+      bindings = new ThumbnailBindings(module);
+      if (!bindings.supportsStoryboard()) {
+        Logger.warn(TAG, "WASM module has no storyboard exports");
+        return out;
+      }
+      bindings.setDataSource({
+        read: async (offset: number, size: number): Promise<Uint8Array> =>
+          new Uint8Array(await source.read(offset, size)),
+        getSize: async (): Promise<number> => this.input.fileSize,
+      });
+      if (!(await bindings.create(this.input.fileSize))) return out;
+      bindings.setFastDecode(tileWidth);
+      if (this.input.probeDescriptor) bindings.setProbeDescriptor(this.input.probeDescriptor);
+      if (!(await bindings.open())) return out;
+      if (this.input.seekIndex) bindings.importSeekIndex(this.input.seekIndex);
+      if (!bindings.beginStoryboard(tileWidth, tileHeight, times.length)) return out;
+
+      for (let i = 0; i < times.length; i++) {
+        if (isCancelled()) break;
+        const pts = await bindings.addStoryboardTile(i, times[i]);
+        if (pts === null) continue;
+        const rgba = bindings.getStoryboardTile(i, tileWidth, tileHeight);
+        if (rgba) out[i] = { pts, rgba };
+      }
+      bindings.endStoryboard();
+    } catch (e) {
+      Logger.warn(TAG, "Storyboard worker failed", e);
+    } finally {
+      bindings?.destroy();
+      this.input.releaseSource?.(source);
+    }
+    return out;
+  }
+}
@@ -67,6 +67,10 @@ export class ThumbnailRenderer {
   // event (a different packet, or this one once it's no longer being retried)
   // is then free to recreate again.
   private decoderRevivedUnproven: boolean = false;
+  // setHoldLastFrame: the last decoded frame at full size, kept (instead of
+  // closed) so a seek to its GOP can show it on the main canvas right away
+  private holdLastFrame: boolean = false;
+  private heldFrame: VideoFrame | null = null;
 
   private hasNativeHDRSupport: boolean = false;
   private isHDRSource: boolean = false;
@@ -545,7 +549,12 @@ export class ThumbnailRenderer {
           output: (frame) => {
             // Render the frame immediately when decoded
             this.renderVideoFrame(frame);
-            frame.close(); // Important: release frame
+            if (this.holdLastFrame) {
+              this.heldFrame?.close();
+              this.heldFrame = frame;
+            } else {
+              frame.close(); // Important: release frame
+            }
             if (this.pendingDecodeResolve) {
               this.pendingDecodeResolve(true);
               this.pendingDecodeResolve = null;
@@ -810,6 +819,28 @@ export class ThumbnailRenderer {
     );
   }
 
+  /**
+   * Keep the last WebCodecs-decoded frame instead of closing it (one frame;
+   * the previous one is closed when the next decode lands)
+   */
+  setHoldLastFrame(enabled: boolean): void {
+    this.holdLastFrame = enabled;
+    if (!enabled && this.heldFrame) {
+      this.heldFrame.close();
+      this.heldFrame = null;
+    }
+  }
+
+  /**
+   * The held frame when it is the decode of the packet at `pts` (seconds),
+   * else null. Still owned by the renderer: clone it to keep it.
+   */
+  getHeldFrame(pts: number): VideoFrame | null {
+    const frame = this.heldFrame;
+    if (!frame || Math.abs(frame.timestamp / 1_000_000 - pts) > 0.001) return null;
+    return frame;
+  }
+
   /**
    * Render RGBA data to canvas
    */
@@ -1145,5 +1176,6 @@ export class ThumbnailRenderer {
       }
       this.decoder = null;
     }
+    this.setHoldLastFrame(false);
   }
 }
@@ -1,3 +1,10 @@
 export { Logger, LogLevel } from './Logger';
 export { Time, TIME_BASE } from './Time';
 export { ThumbnailRenderer, type ThumbnailRenderOptions } from './ThumbnailRenderer';
+export {
+  StoryboardGenerator,
+  findStoryboardCue,
+  type Storyboard,
+  type StoryboardCue,
+  type StoryboardOptions,
+} from './Storyboard';
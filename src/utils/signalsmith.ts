@@ -18,6 +18,54 @@ const TAG = "Signalsmith";
 
 let modulePromise: Promise<MoviWasmModule | null> | null = null;
 
+/** movi_stretch_new_preset configurations (see movi_stretch.cpp) */
+export const SignalsmithPreset = {
+  /** 120ms blocks — best quality, the renderer's chunked path */
+  Default: 0,
+  /** 100ms blocks at 2.5x overlap — less CPU */
+  Cheaper: 1,
+  /** 60ms blocks, work split across calls — for small real-time blocks */
+  LowLatency: 2,
+} as const;
+
+/** movi_stretch_new_grouped quality tiers (see movi_stretch.cpp) */
+export const SignalsmithTier = {
+  /** 4x overlap, as the default preset */
+  Full: 0,
+  /** 2.5x overlap */
+  Cheap: 1,
+  /** 2x overlap — LFE and other channels that barely need phase coherence */
+  Minimal: 2,
+} as const;
+
+/** Channels (bit c = channel c) stretched together at one quality tier */
+export interface SignalsmithChannelGroup {
+  mask: number;
+  tier: number;
+}
+
+/**
+ * Quality groups for a decoded layout in FFmpeg channel order, or null for
+ * mono/stereo (one full-quality group). 5.1 and 7.1 (FL FR FC LFE, then the
+ * surrounds): fronts full, LFE minimal, surrounds cheap. Anything else: the
+ * front pair full, the rest cheap. With the decoder's stereo downmix on, the
+ * stretcher only ever sees two channels and this never applies.
+ */
+export function defaultChannelGroups(channels: number): SignalsmithChannelGroup[] | null {
+  if (channels <= 2) return null;
+  if (channels === 6 || channels === 8) {
+    return [
+      { mask: 0b0111, tier: SignalsmithTier.Full },
+      { mask: 0b1000, tier: SignalsmithTier.Minimal },
+      { mask: 0xff & ~0b1111, tier: SignalsmithTier.Cheap },
+    ];
+  }
+  return [
+    { mask: 0b11, tier: SignalsmithTier.Full },
+    { mask: ~0b11 >>> 0, tier: SignalsmithTier.Cheap },
+  ];
+}
+
 /**
  * Ensure the movi WASM module is loaded. Single-flight, shared with the
  * FFmpeg pipeline. Returns null if loading fails so the caller can fall back
@@ -41,8 +89,10 @@ export function loadSignalsmith(): Promise<MoviWasmModule | null> {
 
 /**
  * SoundTouch-shaped facade around movi's Signalsmith Stretch API.
- * Stereo only — AudioRenderer always upmixes to interleaved 2-channel before
- * calling, matching the SoundTouch / Rubberband paths.
+ * The interleaved path is stereo only — AudioRenderer upmixes to interleaved
+ * 2-channel before calling, matching the SoundTouch / Rubberband paths.
+ * processPlanar takes any channel count the instance was built with
+ * (multichannel instances use channel groups, see defaultChannelGroups).
  */
 export class SignalsmithStretcher {
   private mod: MoviWasmModule;
@@ -69,10 +119,23 @@ export class SignalsmithStretcher {
     receiveSamples: (output: Float32Array, numFrames: number) => void;
   };
 
-  constructor(mod: MoviWasmModule, sampleRate: number, channels: number = 2) {
+  constructor(
+    mod: MoviWasmModule,
+    sampleRate: number,
+    channels: number = 2,
+    preset: number = SignalsmithPreset.Default,
+    groups: SignalsmithChannelGroup[] | null = null,
+  ) {
     this.mod = mod;
     this.channels = channels;
-    this.handle = mod._movi_stretch_new(channels, sampleRate);
+    if (groups && groups.length > 0 && typeof mod._movi_stretch_new_grouped === "function") {
+      this.handle = this.createGrouped(sampleRate, groups);
+    } else {
+      this.handle =
+        preset !== SignalsmithPreset.Default && typeof mod._movi_stretch_new_preset === "function"
+          ? mod._movi_stretch_new_preset(channels, sampleRate, preset)
+          : mod._movi_stretch_new(channels, sampleRate);
+    }
     if (!this.handle) {
       throw new Error("movi_stretch_new returned 0");
     }
@@ -132,6 +195,75 @@ export class SignalsmithStretcher {
     this.mod._movi_stretch_reset(this.handle);
   }
 
+  /** Channels the instance stretches */
+  get channelCount(): number {
+    return this.channels;
+  }
+
+  /** The movi_stretch_new handle (for movi_decode_audio_batch_stretch) */
+  get stretchHandle(): number {
+    return this.handle;
+  }
+
+  /** The WASM module the stretcher lives in */
+  get module(): MoviWasmModule {
+    return this.mod;
+  }
+
+  /** Whether this module has the planar (no interleave) entry point */
+  supportsPlanar(): boolean {
+    return (
+      typeof this.mod._movi_stretch_process_planar === "function" &&
+      typeof this.mod._movi_stretch_output_plane === "function"
+    );
+  }
+
+  /**
+   * Stretch planar input straight to planar output: `input[c]` holds the
+   * frames of channel c (mono is duplicated); outFrames per channel come back
+   * as views into the stretcher's output in the WASM heap — copy them out
+   * (e.g. AudioBuffer.copyToChannel) before the next call into the module.
+   * Null when the module has no planar export.
+   */
+  processPlanar(input: Float32Array[], outFrames: number): Float32Array[] | null {
+    if (!this.handle || !this.supportsPlanar() || input.length === 0) return null;
+    const inFrames = input[0].length;
+    const inChannels = Math.min(input.length, this.channels);
+
+    // Channel planes back to back, then the pointer array after them (the
+    // extra frame per channel leaves room for it)
+    const planeBytes = inFrames * 4;
+    const inPtr = this.ensureBuffer("in", inFrames + 1);
+    const ptrsPtr = inPtr + inChannels * planeBytes;
+    const heapF32 = new Float32Array(this.mod.HEAPU8.buffer);
+    const ptrs = new Uint32Array(this.mod.HEAPU8.buffer, ptrsPtr, inChannels);
+    for (let c = 0; c < inChannels; c++) {
+      const planePtr = inPtr + c * planeBytes;
+      heapF32.set(input[c].subarray(0, inFrames), planePtr >> 2);
+      ptrs[c] = planePtr;
+    }
+
+    this.mod._movi_stretch_process_planar!(this.handle, ptrsPtr, inChannels, inFrames, outFrames);
+    return this.outputPlanes(outFrames);
+  }
+
+  /**
+   * Views of the last planar output (processPlanar or the fused batch decode).
+   * On a shared-memory heap (threaded build) these are copies instead: Web
+   * Audio won't take SharedArrayBuffer-backed arrays.
+   */
+  outputPlanes(frames: number): Float32Array[] {
+    const heap = this.mod.HEAPU8.buffer;
+    const shared = typeof SharedArrayBuffer !== "undefined" && heap instanceof SharedArrayBuffer;
+    const planes: Float32Array[] = [];
+    for (let c = 0; c < this.channels; c++) {
+      const ptr = this.mod._movi_stretch_output_plane!(this.handle, c);
+      const view = new Float32Array(heap, ptr, frames);
+      planes.push(shared ? view.slice() : view);
+    }
+    return planes;
+  }
+
   destroy(): void {
     if (!this.handle) return;
     if (this.inPtr) this.mod._free(this.inPtr);
@@ -142,6 +274,26 @@ export class SignalsmithStretcher {
     this.outPtr = 0;
   }
 
+  private createGrouped(sampleRate: number, groups: SignalsmithChannelGroup[]): number {
+    const ptr = this.mod._malloc(groups.length * 8);
+    if (!ptr) return 0;
+    const masks = new Uint32Array(this.mod.HEAPU8.buffer, ptr, groups.length);
+    const tiers = new Int32Array(this.mod.HEAPU8.buffer, ptr + groups.length * 4, groups.length);
+    groups.forEach((group, i) => {
+      masks[i] = group.mask >>> 0;
+      tiers[i] = group.tier;
+    });
+    const handle = this.mod._movi_stretch_new_grouped!(
+      this.channels,
+      sampleRate,
+      ptr,
+      ptr + groups.length * 4,
+      groups.length,
+    );
+    this.mod._free(ptr);
+    return handle;
+  }
+
   private stashInput(samples: Float32Array, position: number, numFrames: number): void {
     if (!numFrames || numFrames <= 0) {
       numFrames = (samples.length - position * this.channels) / this.channels;
@@ -205,12 +357,24 @@ export class SignalsmithStretcher {
 
 /**
  * Convenience: load the WASM module + construct a stretcher in one call.
+ * More than two channels need the planar and grouped exports; without them
+ * the stretcher falls back to stereo.
  */
 export async function createSignalsmithStretcher(
   sampleRate: number,
   channels: number = 2,
+  preset: number = SignalsmithPreset.Default,
+  groups: SignalsmithChannelGroup[] | null = defaultChannelGroups(channels),
 ): Promise<SignalsmithStretcher | null> {
   const mod = await loadSignalsmith();
   if (!mod) return null;
-  return new SignalsmithStretcher(mod, sampleRate, channels);
+  if (
+    channels > 2 &&
+    (typeof mod._movi_stretch_new_grouped !== "function" ||
+      typeof mod._movi_stretch_process_planar !== "function")
+  ) {
+    channels = 2;
+    groups = null;
+  }
+  return new SignalsmithStretcher(mod, sampleRate, channels, preset, groups);
 }
@@ -0,0 +1,267 @@
+/**
+ * ContextManager - Coordinates the MoviContexts that share one WASM module
+ *
+ * loadWasmModule() hands every player the same module. Asyncify allows one
+ * suspended call per module and the JS glue keeps a single pending read/seek
+ * slot, so async calls from different contexts are serialised here and each
+ * AVIO callback is routed to the context whose call is running. The manager
+ * also sizes per-context AVIO buffers from the context count and keeps the
+ * module's allocations under a budget by trimming idle contexts.
+ */
+
+import type { MoviWasmModule } from "./types";
+import { Logger } from "../utils/Logger";
+
+const TAG = "ContextManager";
+
+// Default cap on bytes allocated across the module (malloc's view). The heap
+// itself never shrinks, so the budget is what keeps it from growing further:
+// trimmed memory is reused before the heap has to grow again.
+const DEFAULT_MEMORY_BUDGET = 1024 * 1024 * 1024;
+// How long a context must have gone without a call before it may be trimmed
+const IDLE_TRIM_MS = 10000;
+// Minimum gap between two budget checks
+const ENFORCE_INTERVAL_MS = 2000;
+
+export interface ManagedContext {
+  /** MoviContext pointer (0 until created) */
+  ptr: number;
+  onRead: (offset: number | bigint, size: number) => void | Promise<void>;
+  onSeek: (offset: number | bigint, whence: number) => void | Promise<void>;
+  /** performance.now() of the last call made for this context */
+  lastActive: number;
+  /** Highest movi_trim level applied since the context was last used */
+  trimLevel: number;
+}
+
+export interface ContextMemoryUsage {
+  ptr: number;
+  /** Bytes the context holds on its own (movi_context_memory) */
+  bytes: number;
+  idleMs: number;
+  trimLevel: number;
+}
+
+export interface ModuleMemoryUsage {
+  /** Current WebAssembly.Memory size */
+  heapSize: number;
+  /** Bytes allocated by malloc across all contexts and FFmpeg state */
+  allocated: number;
+  /** Shared RGBA / audio scratch */
+  shared: number;
+  budget: number | null;
+  contexts: ContextMemoryUsage[];
+}
+
+export class WasmContextManager {
+  private static managers = new WeakMap<MoviWasmModule, WasmContextManager>();
+
+  private module: MoviWasmModule;
+  private contexts = new Set<ManagedContext>();
+  private active: ManagedContext | null = null;
+  private queue: Promise<void> = Promise.resolve();
+  private budget: number | null = DEFAULT_MEMORY_BUDGET;
+  private lastEnforce = 0;
+  private usageScratch = 0;
+
+  /** The manager for a module, created on first use */
+  static for(module: MoviWasmModule): WasmContextManager {
+    let manager = WasmContextManager.managers.get(module);
+    if (!manager) {
+      manager = new WasmContextManager(module);
+      WasmContextManager.managers.set(module, manager);
+    }
+    return manager;
+  }
+
+  private constructor(module: MoviWasmModule) {
+    this.module = module;
+    this.installHandlers();
+  }
+
+  /**
+   * Point the module's AVIO callbacks at the active context. Re-installed
+   * before every call in case something else (ThumbnailBindings) replaced
+   * them on this module.
+   */
+  private installHandlers(): void {
+    const self = this;
+    (this.module as any).onReadRequest = (
+      offset: number | bigint,
+      size: number,
+    ) => {
+      const target = self.active ?? self.latest();
+      if (!target) {
+        Logger.error(TAG, "Read request with no context to serve it");
+        return;
+      }
+      return target.onRead(offset, size);
+    };
+    (this.module as any).onSeekRequest = (
+      offset: number | bigint,
+      whence: number,
+    ) => {
+      const target = self.active ?? self.latest();
+      if (!target) {
+        Logger.error(TAG, "Seek request with no context to serve it");
+        return;
+      }
+      return target.onSeek(offset, whence);
+    };
+  }
+
+  // Most recently registered context: where an unscheduled callback went
+  // before contexts were managed
+  private latest(): ManagedContext | null {
+    let last: ManagedContext | null = null;
+    for (const entry of this.contexts) last = entry;
+    return last;
+  }
+
+  register(entry: ManagedContext): void {
+    this.contexts.add(entry);
+  }
+
+  unregister(entry: ManagedContext): void {
+    this.contexts.delete(entry);
+    if (this.active === entry) this.active = null;
+  }
+
+  get contextCount(): number {
+    return this.contexts.size;
+  }
+
+  /**
+   * Run an async module call for `entry`. Calls are chained so only one is
+   * suspended in the module at a time; a failed call doesn't block the next.
+   */
+  run<T>(entry: ManagedContext, fn: () => T | Promise<T>): Promise<T> {
+    const task = this.queue.then(async () => {
+      this.active = entry;
+      entry.trimLevel = 0;
+      this.installHandlers();
+      try {
+        return await fn();
+      } finally {
+        this.active = null;
+        entry.lastActive = performance.now();
+      }
+    });
+    this.queue = task.then(
+      () => this.enforce(),
+      () => this.enforce(),
+    );
+    return task;
+  }
+
+  /**
+   * AVIO buffer for a context about to open. Read-ahead is worth the most to
+   * a lone player; with many contexts the buffers themselves add up.
+   */
+  avioBufferSize(): number {
+    const n = this.contexts.size;
+    if (n <= 2) return 512 * 1024;
+    if (n <= 4) return 256 * 1024;
+    if (n <= 8) return 128 * 1024;
+    return 64 * 1024;
+  }
+
+  /** Cap on module allocations in bytes; null disables trimming */
+  setMemoryBudget(bytes: number | null): void {
+    this.budget = bytes !== null && bytes > 0 ? bytes : null;
+    this.lastEnforce = 0;
+    this.enforce();
+  }
+
+  getMemoryBudget(): number | null {
+    return this.budget;
+  }
+
+  getUsage(): ModuleMemoryUsage | null {
+    const m = this.module;
+    if (typeof m._movi_module_memory !== "function") return null;
+    if (!this.usageScratch) this.usageScratch = m._malloc(32);
+    m._movi_module_memory(this.usageScratch);
+    const base = this.usageScratch >> 3;
+    const now = performance.now();
+    const contexts: ContextMemoryUsage[] = [];
+    for (const entry of this.contexts) {
+      if (!entry.ptr) continue;
+      contexts.push({
+        ptr: entry.ptr,
+        bytes: m._movi_context_memory?.(entry.ptr) ?? 0,
+        idleMs: entry === this.active ? 0 : now - entry.lastActive,
+        trimLevel: entry.trimLevel,
+      });
+    }
+    return {
+      heapSize: m.HEAPF64[base],
+      allocated: m.HEAPF64[base + 1],
+      shared: m.HEAPF64[base + 2],
+      budget: this.budget,
+      contexts,
+    };
+  }
+
+  /**
+   * Trim idle contexts, oldest first, until allocations are back under the
+   * budget: every idle context at level 1 before any decoder is evicted, and
+   * decoders only while some other context shares the module. The shared
+   * scratch goes last, and only with no call in flight.
+   */
+  private enforce(): void {
+    const m = this.module;
+    if (this.budget === null || typeof m._movi_trim !== "function") return;
+    const now = performance.now();
+    if (now - this.lastEnforce < ENFORCE_INTERVAL_MS) return;
+    this.lastEnforce = now;
+
+    let usage = this.getUsage();
+    if (!usage || usage.allocated <= this.budget) return;
+
+    const idle = [...this.contexts]
+      .filter(
+        (e) =>
+          e.ptr && e !== this.active && now - e.lastActive >= IDLE_TRIM_MS,
+      )
+      .sort((a, b) => a.lastActive - b.lastActive);
+    const maxLevel = this.contexts.size > 1 ? 2 : 1;
+    let released = 0;
+    let trimmed = 0;
+
+    for (let level = 1; level <= maxLevel; level++) {
+      for (const entry of idle) {
+        if (entry.trimLevel >= level) continue;
+        released += m._movi_trim(entry.ptr, level);
+        entry.trimLevel = level;
+        trimmed++;
+        usage = this.getUsage()!;
+        if (usage.allocated <= this.budget) break;
+      }
+      if (usage.allocated <= this.budget) break;
+    }
+
+    if (
+      usage.allocated > this.budget &&
+      !this.active &&
+      typeof m._movi_scratch_release === "function"
+    ) {
+      released += usage.shared;
+      m._movi_scratch_release();
+      usage = this.getUsage()!;
+    }
+
+    if (trimmed > 0 || released > 0) {
+      Logger.info(
+        TAG,
+        `Over budget: trimmed ${trimmed} context(s), released ~${(released / 1048576).toFixed(1)}MB; ` +
+          `allocated ${(usage.allocated / 1048576).toFixed(1)}MB of ${(this.budget / 1048576).toFixed(0)}MB`,
+      );
+    } else {
+      Logger.debug(
+        TAG,
+        `Over budget (${(usage.allocated / 1048576).toFixed(1)}MB) with nothing idle to trim`,
+      );
+    }
+  }
+}
@@ -20,6 +20,110 @@ let embeddedWasmBinary: Uint8Array | null = null;
 export interface LoaderOptions {
   wasmBinary?: Uint8Array; // Embedded WASM binary data (required if embeddedWasmBinary not set)
   workerPath?: string;
+  /**
+   * Use the pthreads build (movi-mt.js) when the page can run it.
+   * Defaults to true for the main playback module and false for isolated
+   * instances (thumbnails/previews), which would each spawn their own pool.
+   */
+  threads?: boolean;
+  /** Use the SIMD128 build (movi-simd.js) when the engine supports it. Defaults to true. */
+  simd?: boolean;
+  /** Override where movi-mt.js is served from (default: ./wasm/movi-mt.js next to the bundle) */
+  threadedModuleUrl?: string;
+  /** Override where movi-simd.js is served from (default: ./wasm/movi-simd.js next to the bundle) */
+  simdModuleUrl?: string;
+}
+
+/** Which build a module instance came from (see resolveModuleFactory) */
+export type WasmFlavor = 'st' | 'simd' | 'mt';
+
+// The optional builds aren't inlined into the bundles like movi.js: the
+// pthreads glue must be re-importable by URL from its workers, and inlining the
+// SIMD build would double bundle size for everyone. Both ship under dist/wasm/
+// and are loaded with a dynamic import. Kept in variables so the bundler leaves
+// the import alone instead of trying to resolve it at build time.
+const DEFAULT_THREADED_MODULE_URL = './wasm/movi-mt.js';
+const DEFAULT_SIMD_MODULE_URL = './wasm/movi-simd.js';
+// Standalone Signalsmith build for the audio worklet (no JS glue, see
+// build-ffmpeg.sh). Fetched as raw bytes and compiled here, because an
+// AudioWorkletGlobalScope can't fetch or import anything itself.
+// The -simd variant carries the SIMD128 FFT backend (fft-simd128.h).
+const DEFAULT_STRETCH_WASM_URL = './wasm/movi-stretch.wasm';
+const DEFAULT_STRETCH_SIMD_WASM_URL = './wasm/movi-stretch-simd.wasm';
+
+// Smallest module using a v128 instruction (i8x16.splat / i32x4.extract_lane);
+// validate() rejects it on engines without SIMD128 (Safari < 16.4).
+const SIMD_PROBE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+let simdSupported: boolean | null = null;
+
+/**
+ * Whether the engine can run the SIMD128 builds (movi-simd / movi-mt)
+ */
+export function canUseSimdWasm(): boolean {
+  if (simdSupported === null) {
+    try {
+      simdSupported = typeof WebAssembly !== 'undefined' && WebAssembly.validate(SIMD_PROBE);
+    } catch {
+      simdSupported = false;
+    }
+  }
+  return simdSupported;
+}
+
+/**
+ * Whether this context can instantiate the pthreads build: it needs
+ * SharedArrayBuffer, which browsers only expose on cross-origin-isolated
+ * pages (COOP: same-origin + COEP: require-corp/credentialless). The mt build
+ * is also compiled with SIMD128.
+ */
+export function canUseThreadedWasm(): boolean {
+  return (
+    typeof SharedArrayBuffer !== 'undefined' &&
+    typeof globalThis !== 'undefined' &&
+    (globalThis as any).crossOriginIsolated === true &&
+    canUseSimdWasm()
+  );
+}
+
+async function importFactory(url: string): Promise<any> {
+  const mod = await import(/* @vite-ignore */ new URL(url, import.meta.url).href);
+  return mod.default;
+}
+
+/**
+ * Pick the module factory, fastest first: threaded (mt) when requested and the
+ * page is cross-origin isolated, then SIMD, then the statically bundled
+ * single-threaded movi.js. Any failure to fetch an optional build (not
+ * deployed, CSP, 404) falls through to the next one.
+ */
+async function resolveModuleFactory(
+  options: LoaderOptions,
+  threadsByDefault: boolean,
+): Promise<{ factory: any; flavor: WasmFlavor }> {
+  // An explicit wasmBinary is the single-threaded binary; never pair it with other glue
+  if (options.wasmBinary || embeddedWasmBinary) {
+    return { factory: createMoviModule, flavor: 'st' };
+  }
+  const wantThreads = options.threads ?? threadsByDefault;
+  const wantSimd = options.simd ?? true;
+  if (wantThreads && wantSimd && canUseThreadedWasm()) {
+    try {
+      return { factory: await importFactory(options.threadedModuleUrl || DEFAULT_THREADED_MODULE_URL), flavor: 'mt' };
+    } catch (error) {
+      Logger.warn(TAG, 'Threaded WASM build unavailable', error);
+    }
+  }
+  if (wantSimd && canUseSimdWasm()) {
+    try {
+      return { factory: await importFactory(options.simdModuleUrl || DEFAULT_SIMD_MODULE_URL), flavor: 'simd' };
+    } catch (error) {
+      Logger.warn(TAG, 'SIMD WASM build unavailable', error);
+    }
+  }
+  return { factory: createMoviModule, flavor: 'st' };
 }
 
 /**
@@ -41,8 +145,9 @@ export async function loadWasmModule(options: LoaderOptions = {}): Promise<MoviW
     const wasmBinary = options.wasmBinary || embeddedWasmBinary;
     
     try {
-      // Static import - movi.js is bundled into index.js
-      const createModule = createMoviModule;
+      // Static import - movi.js is bundled into index.js (movi-mt.js is loaded
+      // on demand when the page is cross-origin isolated)
+      const { factory: createModule, flavor } = await resolveModuleFactory(options, true);
       
       // Create module - with SINGLE_FILE, WASM is embedded, so wasmBinary is optional
       const moduleOptions: any = {
@@ -62,9 +167,19 @@ export async function loadWasmModule(options: LoaderOptions = {}): Promise<MoviW
       if (wasmBinary) {
         moduleOptions.wasmBinary = wasmBinary;
       }
-      const module: MoviWasmModule = await createModule(moduleOptions);
+      let module: MoviWasmModule;
+      try {
+        module = await createModule(moduleOptions);
+        module.moviFlavor = flavor;
+      } catch (error) {
+        if (createModule === createMoviModule) throw error;
+        // e.g. the pthread pool failed to start (worker-src CSP) — retry single-threaded
+        Logger.warn(TAG, `WASM module (${flavor}) failed to start, retrying single-threaded`, error);
+        module = await createMoviModule(moduleOptions);
+        module.moviFlavor = 'st';
+      }
       
-      Logger.info(TAG, 'WASM module loaded successfully');
+      Logger.info(TAG, `WASM module loaded successfully (${module.moviFlavor})`);
       
       if ((module as any).FS) {
         Logger.debug(TAG, 'FS is present on module');
@@ -95,7 +210,7 @@ export async function loadWasmModuleNew(options: LoaderOptions = {}): Promise<Mo
   const wasmBinary = options.wasmBinary || embeddedWasmBinary;
   
   try {
-    const createModule = createMoviModule;
+    const { factory: createModule, flavor } = await resolveModuleFactory(options, false);
     
     const moduleOptions: any = {
       print: (text: string) => {
@@ -115,8 +230,9 @@ export async function loadWasmModuleNew(options: LoaderOptions = {}): Promise<Mo
     
     // Always create fresh instance - no caching
     const module: MoviWasmModule = await createModule(moduleOptions);
+    module.moviFlavor = flavor;
     
-    Logger.info(TAG, 'NEW WASM module instance loaded');
+    Logger.info(TAG, `NEW WASM module instance loaded (${flavor})`);
     return module;
   } catch (error) {
     Logger.error(TAG, 'Failed to load new WASM module', error);
@@ -124,6 +240,41 @@ export async function loadWasmModuleNew(options: LoaderOptions = {}): Promise<Mo
   }
 }
 
+let stretchModulePromise: Promise<WebAssembly.Module | null> | null = null;
+
+/**
+ * Compile the standalone stretch module (movi-stretch.wasm) for the audio
+ * worklet. Cached; resolves null when it isn't deployed or fails to compile,
+ * in which case stretching stays on the main thread.
+ */
+export function loadStretchWasm(url?: string): Promise<WebAssembly.Module | null> {
+  if (!stretchModulePromise) {
+    const compile = async (from: string): Promise<WebAssembly.Module> => {
+      const response = await fetch(new URL(from, import.meta.url).href);
+      if (!response.ok) throw new Error(`HTTP ${response.status}`);
+      return WebAssembly.compile(await response.arrayBuffer());
+    };
+    stretchModulePromise = (async () => {
+      // Without an explicit URL, prefer the SIMD build and fall back to the
+      // scalar one (older engines, or a deployment that only ships one)
+      if (!url && canUseSimdWasm()) {
+        try {
+          return await compile(DEFAULT_STRETCH_SIMD_WASM_URL);
+        } catch (error) {
+          Logger.debug(TAG, 'SIMD stretch WASM unavailable, trying scalar build', error);
+        }
+      }
+      try {
+        return await compile(url || DEFAULT_STRETCH_WASM_URL);
+      } catch (error) {
+        Logger.warn(TAG, 'Stretch WASM unavailable, stretching on the main thread', error);
+        return null;
+      }
+    })();
+  }
+  return stretchModulePromise;
+}
+
 /**
  * Get the loaded module (throws if not loaded)
  */
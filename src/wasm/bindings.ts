@@ -10,8 +10,15 @@ import {
   STREAM_INFO_OFFSETS,
   PACKET_INFO_SIZE,
   PACKET_INFO_OFFSETS,
+  CUE_REF_SIZE,
+  CUE_REF_OFFSETS,
+  SUB_CUE_SIZE,
+  SUB_CUE_OFFSETS,
+  SUB_RECT_SIZE,
+  SUB_RECT_OFFSETS,
 } from "./types";
 import { Logger, LogLevel } from "../utils/Logger";
+import { WasmContextManager, type ManagedContext } from "./ContextManager";
 
 const TAG = "Bindings";
 
@@ -26,6 +33,166 @@ const AV_LOG_INFO = 32;
 const AV_LOG_DEBUG = 48;
 const AV_LOG_TRACE = 56;
 
+/** AV_INPUT_BUFFER_PADDING_SIZE from libavcodec/packet.h */
+const INPUT_PADDING_SIZE = 64;
+/** Packets at least this large go through movi_send_packet_owned (no copy) */
+const OWNED_PACKET_MIN = 1024 * 1024;
+
+/** VideoFrame formats movi_frame_handle_info reports (MOVI_VF_* in movi_frame.c) */
+const RETAINED_FRAME_FORMATS: (VideoPixelFormat | null)[] = [
+  null,
+  "I420",
+  "I420P10",
+  "I422",
+  "I422P10",
+  "I444",
+  "I444P10",
+  "NV12",
+  "I420A",
+  "RGBA",
+] as (VideoPixelFormat | null)[];
+
+// AVCOL_* values (libavutil/pixfmt.h) → WebCodecs color space members
+const AVCOL_MATRIX: Record<number, VideoMatrixCoefficients> = {
+  0: "rgb",
+  1: "bt709",
+  5: "bt470bg",
+  6: "smpte170m",
+  9: "bt2020-ncl",
+};
+const AVCOL_PRIMARIES: Record<number, VideoColorPrimaries> = {
+  1: "bt709",
+  5: "bt470bg",
+  6: "smpte170m",
+  9: "bt2020",
+  12: "smpte432",
+} as Record<number, VideoColorPrimaries>;
+const AVCOL_TRANSFER: Record<number, VideoTransferCharacteristics> = {
+  1: "bt709",
+  6: "smpte170m",
+  8: "linear",
+  13: "iec61966-2-1",
+  16: "pq",
+  18: "hlg",
+} as Record<number, VideoTransferCharacteristics>;
+
+/**
+ * A decoded frame kept alive in the WASM heap (see WasmBindings.retainFrame)
+ */
+export interface RetainedFrame {
+  /** VideoFrame pixel format, or null when the format has no equivalent */
+  format: VideoPixelFormat | null;
+  width: number;
+  height: number;
+  /** HEAPU8 view spanning every plane; `layout` offsets are relative to it */
+  data: Uint8Array;
+  layout: PlaneLayout[];
+  colorSpace: VideoColorSpaceInit;
+  /** Return the frame's buffers to the decoder pool. Idempotent. */
+  release: () => void;
+}
+
+/**
+ * Stage occupancy and load of a software decode pipeline
+ * (WasmBindings.getDecodePipelineStats, movi_pipeline_stats)
+ */
+export interface DecodePipelineStats {
+  /** Slots per ring */
+  capacity: number;
+  packetsQueued: number;
+  packetsPeak: number;
+  /** Sends refused because the packet ring was full (demux backpressure) */
+  sendsRefused: number;
+  decodedQueued: number;
+  decodedPeak: number;
+  /** Frames the decode stage held back because the convert stage was full */
+  decodeStalls: number;
+  outputQueued: number;
+  outputPeak: number;
+  /** Frames the convert stage held back because JS hadn't received them */
+  convertStalls: number;
+  decodeBusyMs: number;
+  convertBusyMs: number;
+  framesDecoded: number;
+  framesConverted: number;
+}
+
+/** Timed stages of an instrumented module, in movi_stats.c (MoviStage) order */
+export const WASM_STAT_STAGES = [
+  "read",
+  "demux",
+  "classify",
+  "send",
+  "receive",
+  "resample",
+  "rgba",
+  "stretch",
+  "decrypt",
+] as const;
+export type WasmStatStage = (typeof WASM_STAT_STAGES)[number];
+
+export interface WasmStageStats {
+  count: number;
+  totalMs: number;
+  maxMs: number;
+  /**
+   * Latency histogram: bucket 0 counts calls under bucketBaseUs, bucket b
+   * calls under bucketBaseUs << b, the last one everything slower
+   */
+  buckets: number[];
+}
+
+/**
+ * Per-context counters of a module built with MOVI_STATS
+ * (WasmBindings.getWasmStats, movi_get_stats)
+ */
+export interface WasmInstrumentation {
+  bucketBaseUs: number;
+  /** Asyncify suspensions: one per js_read_async (the read stage's count) */
+  suspensions: number;
+  /** Bytes the AVIO read callback received from the data source */
+  bytesRead: number;
+  /** Bytes av_read_frame consumed to produce the returned packets */
+  bytesDemuxed: number;
+  /**
+   * Of bytesDemuxed, those no returned packet carried: AVDISCARD_ALL
+   * streams, shed packets and container overhead
+   */
+  bytesDiscarded: number;
+  packets: number;
+  stages: Partial<Record<WasmStatStage, WasmStageStats>>;
+}
+
+/**
+ * One bitmap rect of a BatchSubtitleCue. Expanded rects carry `rgba`;
+ * palettized ones (setSubtitlePalettized) carry a 256-entry RGBA `palette`
+ * and either their `indices` or, when unchanged, `ref`: the rect of the
+ * previous bitmap cue whose indices they share.
+ */
+export interface BatchSubtitleRect {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  rgba?: Uint8Array;
+  indices?: Uint8Array;
+  palette?: Uint8Array;
+  ref: number;
+}
+
+/**
+ * One event from WasmBindings.decodeSubtitleBatch. `text` is the cleaned text
+ * (empty for a bitmap-only cue).
+ */
+export interface BatchSubtitleCue {
+  start: number;
+  end: number;
+  text: string;
+  /** ASS style name, when the event has one */
+  style?: string;
+  images: BatchSubtitleRect[];
+}
+
 /**
  * Convert MoviPlayer LogLevel to FFmpeg log level
  */
@@ -62,6 +229,31 @@ export interface DataSource {
 
   /** Read data at offset */
   read(offset: number, size: number): Promise<Uint8Array>;
+
+  /**
+   * Read data at offset as it came off the wire, for the context to decrypt
+   * in place (movi_crypt.c). Used instead of read() when present and the
+   * module supports it. May return fewer bytes than asked so one result
+   * never spans two keys.
+   */
+  readCiphertext?(offset: number, size: number): Promise<CipherRead>;
+}
+
+/**
+ * Bytes from DataSource.readCiphertext: AES-256-CTR ciphertext under `cipher`
+ * (counter = nonce || 64-bit big-endian block index of the file offset), or
+ * plaintext when `cipher` is null
+ */
+export interface CipherRead {
+  data: Uint8Array;
+  cipher: CtrCipher | null;
+}
+
+export interface CtrCipher {
+  key: Uint8Array; // 32 bytes
+  nonce: Uint8Array; // 8 bytes
+  /** Changes whenever key/nonce do, so the context is only re-keyed then */
+  generation: number;
 }
 
 /**
@@ -173,6 +365,7 @@ function parsePacketInfo(module: MoviWasmModule, ptr: number): PacketInfo {
     isIdr: view.getInt32(PACKET_INFO_OFFSETS.isIdr, true) !== 0,
     isRasl: view.getInt32(PACKET_INFO_OFFSETS.isRasl, true) !== 0,
     disposable: view.getInt32(PACKET_INFO_OFFSETS.disposable, true) !== 0,
+    temporalId: view.getInt32(PACKET_INFO_OFFSETS.temporalId, true),
   };
 }
 
@@ -184,14 +377,49 @@ export class WasmBindings {
   private contextPtr: number = 0;
   private packetBuffer: number = 0;
   private packetBufferSize: number = 0;
+  // PacketInfo + out-pointer scratch for readFrame, allocated once per context
+  // instead of a malloc/free pair per packet.
+  private readScratch: number = 0;
+  // movi_frame_handle_info output, allocated on first retainFrame()
+  private frameInfoScratch: number = 0;
+  // Reusable input buffer for sendPacket / decodeAudioBatch payloads; grows
+  // geometrically so steady-state decode does no malloc per packet.
+  private inputScratch: number = 0;
+  private inputScratchSize: number = 0;
+  // movi_read_frames arena + PacketInfo array, allocated on first readFrames()
+  private batchArena: number = 0;
+  private batchArenaSize: number = 0;
+  private batchInfos: number = 0;
+  private batchInfosCount: number = 0;
+  // movi_subtitle_style_name results; ids are stable for the context's
+  // lifetime, so each name crosses once
+  private subtitleStyles: string[] = [];
 
   private dataSource: DataSource | null = null;
   private fileSize: number = 0;
+  // Live ingest (movi_live.c): bytes are pushed in instead of read on demand
+  private live: boolean = false;
+  private liveScratch: number = 0;
+  private liveScratchSize: number = 0;
+  // CTR session the context is keyed with (CtrCipher.generation), -1 = none
+  private cipherGeneration: number = -1;
   private lastError: string | null = null; // Store last I/O error for better error messages
 
+  // Other players may share this module; the manager serialises async calls
+  // and routes AVIO callbacks to whichever context's call is running
+  private manager: WasmContextManager;
+  private managed: ManagedContext;
+
   constructor(module: MoviWasmModule) {
     this.module = module;
-    this.setupAsyncHandlers();
+    this.manager = WasmContextManager.for(module);
+    this.managed = {
+      ptr: 0,
+      onRead: (offset, size) => this.handleReadRequest(offset, size),
+      onSeek: (offset, whence) => this.handleSeekRequest(offset, whence),
+      lastActive: performance.now(),
+      trimLevel: 0,
+    };
 
     // Register this instance for log level updates
     activeBindings.add(this);
@@ -246,77 +474,104 @@ export class WasmBindings {
   }
 
   /**
-   * Setup async I/O handlers for Asyncify callbacks
+   * Run an async (Asyncify) export for this context through the module's
+   * context manager
    */
-  private setupAsyncHandlers(): void {
-    const self = this;
-
-    // Handle read requests from WASM
-    // IMPORTANT: offset may be a BigInt for files >= 2GB, convert to number safely
-    (this.module as any).onReadRequest = async (
-      offset: number | bigint,
-      size: number,
-    ) => {
-      try {
-        if (!self.dataSource) {
-          Logger.error(TAG, "No data source set for read request");
-          self.fulfillRead(new Uint8Array(0), -1);
-          return;
-        }
-
-        // Convert BigInt to number for offset (safe up to 2^53, but BigInt handles larger values)
-        // For files >= 2GB, we need to ensure proper conversion
-        const offsetNum = typeof offset === "bigint" ? Number(offset) : offset;
-        if (offsetNum > Number.MAX_SAFE_INTEGER) {
-          Logger.warn(
-            TAG,
-            `Read offset ${offset} exceeds MAX_SAFE_INTEGER, precision may be lost`,
-          );
-        }
+  private callAsync(
+    name: string,
+    returnType: string,
+    argTypes: string[],
+    args: unknown[],
+  ): Promise<number> {
+    return this.manager.run(
+      this.managed,
+      () =>
+        this.module.ccall(name, returnType, argTypes, args, {
+          async: true,
+        }) as Promise<number>,
+    );
+  }
 
-        const data = await self.dataSource.read(offsetNum, size);
-        self.fulfillRead(new Uint8Array(data), data.byteLength);
-      } catch (error) {
-        // Store error message for better error reporting
-        self.lastError = (error as any).message || String(error);
-        Logger.error(TAG, "Read request failed", error);
-        self.fulfillRead(new Uint8Array(0), -1);
+  /**
+   * Handle a read request from WASM (routed here by the context manager)
+   * IMPORTANT: offset may be a BigInt for files >= 2GB, convert to number safely
+   */
+  private async handleReadRequest(
+    offset: number | bigint,
+    size: number,
+  ): Promise<void> {
+    try {
+      if (!this.dataSource) {
+        Logger.error(TAG, "No data source set for read request");
+        this.fulfillRead(new Uint8Array(0), -1);
+        return;
       }
-    };
 
-    // Handle seek requests from WASM
-    // IMPORTANT: offset may be a BigInt for files >= 2GB
-    // This is especially important for large files (>= 2GB) where position tracking
-    // needs to be accurate to avoid sequential reads
-    (this.module as any).onSeekRequest = async (
-      offset: number | bigint,
-      _whence: number,
-    ) => {
       // Convert BigInt to number for offset (safe up to 2^53, but BigInt handles larger values)
+      // For files >= 2GB, we need to ensure proper conversion
       const offsetNum = typeof offset === "bigint" ? Number(offset) : offset;
       if (offsetNum > Number.MAX_SAFE_INTEGER) {
         Logger.warn(
           TAG,
-          `Seek offset ${offset} exceeds MAX_SAFE_INTEGER, precision may be lost`,
+          `Read offset ${offset} exceeds MAX_SAFE_INTEGER, precision may be lost`,
         );
       }
 
-      // Update source position when seeking to ensure it's in sync
-      if (
-        self.dataSource &&
-        typeof (self.dataSource as any).seek === "function"
-      ) {
-        try {
-          (self.dataSource as any).seek(offsetNum);
-        } catch (e) {
-          Logger.warn(TAG, "Source seek failed, continuing anyway", e);
+      if (this.dataSource.readCiphertext && this.supportsDecrypt()) {
+        const { data, cipher } = await this.dataSource.readCiphertext(
+          offsetNum,
+          size,
+        );
+        // Keyed right before the read resumes, so the bytes are decrypted
+        // with the key they were encrypted under
+        if (!this.setCipher(cipher)) {
+          throw new Error("Failed to key the context for decryption");
         }
+        this.fulfillRead(data, data.byteLength);
+        return;
       }
-      // Return as BigInt to maintain precision for large offsets
-      const resultOffset =
-        typeof offset === "bigint" ? offset : BigInt(Math.floor(offsetNum));
-      self.fulfillSeek(resultOffset);
-    };
+
+      const data = await this.dataSource.read(offsetNum, size);
+      this.fulfillRead(new Uint8Array(data), data.byteLength);
+    } catch (error) {
+      // Store error message for better error reporting
+      this.lastError = (error as any).message || String(error);
+      Logger.error(TAG, "Read request failed", error);
+      this.fulfillRead(new Uint8Array(0), -1);
+    }
+  }
+
+  /**
+   * Handle a seek request from WASM
+   * IMPORTANT: offset may be a BigInt for files >= 2GB
+   * This is especially important for large files (>= 2GB) where position tracking
+   * needs to be accurate to avoid sequential reads
+   */
+  private handleSeekRequest(offset: number | bigint, _whence: number): void {
+    // Convert BigInt to number for offset (safe up to 2^53, but BigInt handles larger values)
+    const offsetNum = typeof offset === "bigint" ? Number(offset) : offset;
+    if (offsetNum > Number.MAX_SAFE_INTEGER) {
+      Logger.warn(
+        TAG,
+        `Seek offset ${offset} exceeds MAX_SAFE_INTEGER, precision may be lost`,
+      );
+    }
+
+    // Update source position when seeking to ensure it's in sync
+    if (
+      this.dataSource &&
+      typeof (this.dataSource as any).seek === "function"
+    ) {
+      try {
+        (this.dataSource as any).seek(offsetNum);
+      } catch (e) {
+        Logger.warn(TAG, "Source seek failed, continuing anyway", e);
+      }
+    }
+    // Return as BigInt to maintain precision for large offsets
+    const resultOffset =
+      typeof offset === "bigint" ? offset : BigInt(Math.floor(offsetNum));
+    this.fulfillSeek(resultOffset);
   }
 
   /**
@@ -397,10 +652,11 @@ export class WasmBindings {
       Logger.error(TAG, "Failed to create movi context");
       return false;
     }
+    this.managed.ptr = this.contextPtr;
+    this.manager.register(this.managed);
 
-    // Allocate packet buffer (10MB for 4K support)
-    this.packetBufferSize = 10 * 1024 * 1024;
-    this.packetBuffer = this.module._malloc(this.packetBufferSize);
+    // PacketInfo + one pointer for movi_read_frame_ref's data_out
+    this.readScratch = this.module._malloc(PACKET_INFO_SIZE + 8);
 
     Logger.debug(TAG, "Context created");
     return true;
@@ -412,15 +668,58 @@ export class WasmBindings {
   destroy(): void {
     // Unregister this instance
     activeBindings.delete(this);
+    this.manager.unregister(this.managed);
 
     if (this.packetBuffer) {
       this.module._free(this.packetBuffer);
       this.packetBuffer = 0;
+      this.packetBufferSize = 0;
+    }
+    if (this.readScratch) {
+      this.module._free(this.readScratch);
+      this.readScratch = 0;
+    }
+    if (this.batchArena) {
+      this.module._free(this.batchArena);
+      this.batchArena = 0;
+      this.batchArenaSize = 0;
+    }
+    if (this.batchInfos) {
+      this.module._free(this.batchInfos);
+      this.batchInfos = 0;
+      this.batchInfosCount = 0;
     }
+    if (this.frameInfoScratch) {
+      this.module._free(this.frameInfoScratch);
+      this.frameInfoScratch = 0;
+    }
+    if (this.inputScratch) {
+      this.module._free(this.inputScratch);
+      this.inputScratch = 0;
+      this.inputScratchSize = 0;
+    }
+    if (this.liveScratch) {
+      this.module._free(this.liveScratch);
+      this.liveScratch = 0;
+      this.liveScratchSize = 0;
+    }
+    // A read suspended on an empty live FIFO is failed rather than left
+    // hanging; it resumes (and unwinds) on the next microtask, so the context
+    // is freed a task later instead of under it
+    const liveReadPending = this.wakeLiveRead(-1);
+    this.live = false;
+    this.cipherGeneration = -1;
+    this.subtitleStyles = [];
 
     if (this.contextPtr) {
-      this.module._movi_destroy(this.contextPtr);
+      const ctx = this.contextPtr;
+      if (liveReadPending) {
+        setTimeout(() => this.module._movi_destroy(ctx), 0);
+      } else {
+        this.module._movi_destroy(ctx);
+      }
       this.contextPtr = 0;
+      this.managed.ptr = 0;
     }
 
     this.dataSource = null;
@@ -442,8 +741,8 @@ export class WasmBindings {
       throw new Error("Data source not set");
     }
 
-    // Get file size (may be > 2GB)
-    this.fileSize = await this.dataSource.getSize();
+    // Get file size (may be > 2GB); a live feed has none
+    this.fileSize = this.live ? 0 : await this.dataSource.getSize();
     // Store as BigInt to maintain precision for large files
     (this.module as any)._fileSize = BigInt(Math.floor(this.fileSize));
 
@@ -453,19 +752,23 @@ export class WasmBindings {
     const sizeLow = Number(fileSizeBigInt & 0xffffffffn);
     const sizeHigh = Number(fileSizeBigInt >> 32n);
     this.module._movi_set_file_size(this.contextPtr, sizeLow, sizeHigh);
+    // Smaller read-ahead once several contexts share the module
+    this.module._movi_set_avio_buffer_size?.(
+      this.contextPtr,
+      this.manager.avioBufferSize(),
+    );
 
     // Open (this will trigger async reads via AVIO callbacks)
     // IMPORTANT: Use ccall with async:true for Asyncify to work correctly
     // Clear any previous error
     this.lastError = null;
 
-    const ret = (await this.module.ccall(
+    const ret = (await this.callAsync(
       "movi_open",
       "number",
       ["number"],
       [this.contextPtr],
-      { async: true },
-    )) as number;
+    ));
 
     if (ret < 0) {
       // Include last I/O error if available (e.g., CORS, network errors)
@@ -713,13 +1016,12 @@ export class WasmBindings {
     }
 
     // Use ccall with async:true for Asyncify
-    const ret = (await this.module.ccall(
+    const ret = (await this.callAsync(
       "movi_seek_to",
       "number",
       ["number", "number", "number", "number"],
       [this.contextPtr, timestamp, streamIndex, flags],
-      { async: true },
-    )) as number;
+    ));
 
     if (ret < 0) {
       throw new Error(`Seek failed: error ${ret}`);
@@ -730,64 +1032,503 @@ export class WasmBindings {
 
   /**
    * Read next frame/packet (async due to Asyncify)
+   * Returns a JS-owned copy of the payload, safe to queue.
    */
   async readFrame(): Promise<{ info: PacketInfo; data: Uint8Array } | null> {
+    const pkt = await this.readFrameBorrowed();
+    if (!pkt) return null;
+    try {
+      return { info: pkt.info, data: pkt.data.slice() };
+    } finally {
+      pkt.release();
+    }
+  }
+
+  /**
+   * Read next frame/packet without copying it out of the WASM heap.
+   *
+   * `data` is a HEAPU8 view straight into the demuxer's packet (movi_read_frame_ref
+   * ring slot). It is only valid until `release()` and must be consumed before
+   * the next call into the module: a heap growth detaches it. Callers that queue
+   * packets should use readFrame() instead. Always call `release()` — the ring
+   * has a fixed number of slots.
+   */
+  async readFrameBorrowed(): Promise<{ info: PacketInfo; data: Uint8Array; release: () => void } | null> {
+    if (!this.contextPtr || !this.readScratch) return null;
+
+    const release = this.module._movi_packet_release;
+    if (typeof this.module._movi_read_frame_ref !== "function" || typeof release !== "function") {
+      // Older WASM without the packet ring: copy through the packet buffer
+      const legacy = await this.readFrameCopy();
+      return legacy ? { ...legacy, release: () => {} } : null;
+    }
+
+    const infoPtr = this.readScratch;
+    const dataOutPtr = this.readScratch + PACKET_INFO_SIZE;
+    const ret = (await this.callAsync(
+      "movi_read_frame_ref",
+      "number",
+      ["number", "number", "number"],
+      [this.contextPtr, infoPtr, dataOutPtr],
+    ));
+
+    if (ret === 0) {
+      // EOF
+      return null;
+    }
+    if (ret < 0) {
+      Logger.error(TAG, `Read frame failed: error ${ret}`);
+      throw new Error(`Read frame failed: error ${ret}`);
+    }
+
+    const ctx = this.contextPtr;
+    const slot = ret;
+    let released = false;
+    const releaseSlot = () => {
+      if (released) return;
+      released = true;
+      release(ctx, slot);
+    };
+
+    const info = parsePacketInfo(this.module, infoPtr);
+    if (info.size < 0) {
+      releaseSlot();
+      Logger.warn(TAG, `Invalid packet size: ${info.size}, treating as EOF`);
+      return null;
+    }
+    const dataPtr = new DataView(this.module.HEAPU8.buffer, dataOutPtr, 4).getUint32(0, true);
+    return {
+      info,
+      data: this.module.HEAPU8.subarray(dataPtr, dataPtr + info.size),
+      release: releaseSlot,
+    };
+  }
+
+  /**
+   * Whether this module can demux several packets per call (readFrames)
+   */
+  supportsBatchRead(): boolean {
+    return typeof this.module._movi_read_frames === "function";
+  }
+
+  /**
+   * Read up to `max` packets in one Asyncify round-trip (movi_read_frames).
+   * Each returned payload is a JS-owned copy. Stops early when the next packet
+   * wouldn't fit in the arena (it's kept for the next read) or at the stream
+   * limit set by setReadFramesLimit. Returns an empty array at EOF.
+   * Falls back to a single readFrame() on modules without the export, or when
+   * one packet is larger than the whole arena.
+   */
+  async readFrames(
+    max: number,
+    arenaSize: number = 4 * 1024 * 1024,
+  ): Promise<{ info: PacketInfo; data: Uint8Array }[]> {
+    if (!this.contextPtr) return [];
+    if (!this.supportsBatchRead() || max <= 1) {
+      const one = await this.readFrame();
+      return one ? [one] : [];
+    }
+
+    if (this.batchInfosCount < max) {
+      if (this.batchInfos) this.module._free(this.batchInfos);
+      this.batchInfos = this.module._malloc(max * PACKET_INFO_SIZE);
+      this.batchInfosCount = this.batchInfos ? max : 0;
+    }
+    if (this.batchArenaSize < arenaSize) {
+      if (this.batchArena) this.module._free(this.batchArena);
+      this.batchArena = this.module._malloc(arenaSize);
+      this.batchArenaSize = this.batchArena ? arenaSize : 0;
+    }
+    if (!this.batchInfos || !this.batchArena) {
+      throw new Error("Failed to allocate demux batch buffers");
+    }
+
+    const count = (await this.callAsync(
+      "movi_read_frames",
+      "number",
+      ["number", "number", "number", "number", "number"],
+      [this.contextPtr, this.batchInfos, max, this.batchArena, this.batchArenaSize],
+    ));
+
+    if (count === 0) return [];
+    if (count < 0) {
+      // ENOBUFS: the held-back packet is bigger than the arena; the single-packet
+      // path has no size limit and takes it. Any other error resurfaces there too.
+      const one = await this.readFrame();
+      return one ? [one] : [];
+    }
+
+    // One copy of the whole used arena, then per-packet views into it
+    const infos: PacketInfo[] = [];
+    let used = 0;
+    for (let i = 0; i < count; i++) {
+      const info = parsePacketInfo(this.module, this.batchInfos + i * PACKET_INFO_SIZE);
+      infos.push(info);
+      used += info.size;
+    }
+    const block = this.module.HEAPU8.slice(this.batchArena, this.batchArena + used);
+    const packets: { info: PacketInfo; data: Uint8Array }[] = [];
+    let offset = 0;
+    for (const info of infos) {
+      packets.push({ info, data: block.subarray(offset, offset + info.size) });
+      offset += info.size;
+    }
+    return packets;
+  }
+
+  /**
+   * Cap how many packets of one stream a single readFrames() batch returns.
+   * Pass streamIndex < 0 to remove the cap.
+   */
+  setReadFramesLimit(streamIndex: number, maxPackets: number): void {
+    if (!this.contextPtr) return;
+    const fn = this.module._movi_set_read_frames_limit;
+    if (typeof fn !== "function") return; // older WASM without the export
+    fn(this.contextPtr, streamIndex, maxPackets);
+  }
+
+  /**
+   * Hand the context a stream descriptor exported by an earlier open of the
+   * same file (exportProbeDescriptor). Call before open(): when the container
+   * header agrees with it, open() skips stream probing. Returns false on
+   * modules without the export.
+   */
+  setProbeDescriptor(blob: Uint8Array): boolean {
+    if (!this.contextPtr) return false;
+    const fn = this.module._movi_probe_import;
+    if (typeof fn !== "function") return false;
+
+    const bufferPtr = this.module._malloc(blob.length);
+    if (!bufferPtr) return false;
+    try {
+      this.module.HEAPU8.set(blob, bufferPtr);
+      return fn(this.contextPtr, bufferPtr, blob.length) === 0;
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Serialise the opened streams' probed parameters into a JS-owned blob
+   * (see SeekIndexStore), or null on modules without the export
+   */
+  exportProbeDescriptor(): Uint8Array | null {
     if (!this.contextPtr) return null;
+    const fn = this.module._movi_probe_export;
+    if (typeof fn !== "function") return null;
 
-    const infoPtr = this.module._malloc(PACKET_INFO_SIZE);
+    const size = fn(this.contextPtr, 0, 0);
+    if (size <= 0) return null;
+    const bufferPtr = this.module._malloc(size);
     try {
-      // Use ccall with async:true for Asyncify
-      let ret = (await this.module.ccall(
-        "movi_read_frame",
-        "number",
-        ["number", "number", "number", "number"],
-        [this.contextPtr, infoPtr, this.packetBuffer, this.packetBufferSize],
-        { async: true },
-      )) as number;
-
-      // Handle buffer too small (ENOBUFS is defined as -105 in many systems,
-      // but FFmpeg's AVERROR(ENOBUFS) is platform dependent.
-      // For now, check if ret is a large negative indicating truncation.
-      // In movi_streams.c we specifically returned AVERROR(ENOBUFS).
-      if (ret < 0 && ret !== -1 /* EOF check is handled by 0 above */) {
-        // Log detail and try to handle or propagate
-        Logger.error(
-          TAG,
-          `Read frame failed: error ${ret}. This might be due to a packet larger than ${this.packetBufferSize} bytes.`,
-        );
-        throw new Error(`Read frame failed: error ${ret}`);
-      }
+      if (fn(this.contextPtr, bufferPtr, size) !== size) return null;
+      return this.module.HEAPU8.slice(bufferPtr, bufferPtr + size);
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
 
-      if (ret === 0) {
-        // EOF
-        return null;
+  /**
+   * Whether open() took its stream parameters from the descriptor instead
+   * of probing
+   */
+  isProbeDescriptorApplied(): boolean {
+    if (!this.contextPtr) return false;
+    const fn = this.module._movi_probe_applied;
+    return typeof fn === "function" && fn(this.contextPtr) === 1;
+  }
+
+  /**
+   * Whether this module can build and import persistent seek indexes
+   */
+  supportsSeekIndex(): boolean {
+    return (
+      typeof this.module._movi_index_begin === "function" &&
+      typeof this.module._movi_index_import === "function"
+    );
+  }
+
+  /**
+   * Whether building a seek index for this stream is worthwhile: false for
+   * MP4/MOV (sample tables already index every frame) and for files whose
+   * demuxer found a real index at open (e.g. Matroska Cues).
+   */
+  isSeekIndexNeeded(streamIndex: number): boolean {
+    if (!this.contextPtr) return false;
+    const fn = this.module._movi_index_needed;
+    if (typeof fn !== "function") return false;
+    return fn(this.contextPtr, streamIndex) === 1;
+  }
+
+  /**
+   * Turn this context into an index pass over one stream. Every other stream
+   * is discarded, so only call this on a dedicated (non-playback) context.
+   */
+  beginSeekIndex(streamIndex: number): boolean {
+    if (!this.contextPtr || !this.supportsSeekIndex()) return false;
+    return this.module._movi_index_begin!(this.contextPtr, streamIndex) === 0;
+  }
+
+  /**
+   * Read up to maxPackets packets of the index pass. Returns true while
+   * there's more to read, false once the whole file has been indexed.
+   */
+  async stepSeekIndex(maxPackets: number): Promise<boolean> {
+    if (!this.contextPtr) return false;
+    const ret = (await this.callAsync(
+      "movi_index_step",
+      "number",
+      ["number", "number"],
+      [this.contextPtr, maxPackets],
+    ));
+    if (ret < 0) {
+      throw new Error(`Seek index step failed: error ${ret}`);
+    }
+    return ret === 1;
+  }
+
+  /**
+   * Fraction of the file the index pass has covered (0..1)
+   */
+  getSeekIndexProgress(): number {
+    if (!this.contextPtr) return 0;
+    const fn = this.module._movi_index_progress;
+    return typeof fn === "function" ? fn(this.contextPtr) : 0;
+  }
+
+  /**
+   * Serialise the index built by begin/step into a JS-owned blob
+   */
+  exportSeekIndex(): Uint8Array | null {
+    if (!this.contextPtr) return null;
+    const fn = this.module._movi_index_export;
+    if (typeof fn !== "function") return null;
+
+    const size = fn(this.contextPtr, 0, 0);
+    if (size <= 0) return null;
+    const bufferPtr = this.module._malloc(size);
+    try {
+      if (fn(this.contextPtr, bufferPtr, size) !== size) return null;
+      return this.module.HEAPU8.slice(bufferPtr, bufferPtr + size);
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Load a previously exported seek index. Returns the number of entries
+   * added, or a negative value if the blob doesn't belong to this file.
+   */
+  importSeekIndex(blob: Uint8Array): number {
+    if (!this.contextPtr) return -1;
+    const fn = this.module._movi_index_import;
+    if (typeof fn !== "function") return -1;
+
+    const bufferPtr = this.module._malloc(blob.length);
+    if (!bufferPtr) return -1;
+    try {
+      this.module.HEAPU8.set(blob, bufferPtr);
+      return fn(this.contextPtr, bufferPtr, blob.length);
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Whether this module has the incremental subtitle cue index
+   */
+  supportsCueIndex(): boolean {
+    return (
+      typeof this.module._movi_cues_begin === "function" &&
+      typeof this.module._movi_get_cues_in_range === "function" &&
+      typeof this.module._movi_cues_import === "function"
+    );
+  }
+
+  /**
+   * Turn this context into a cue pass over one subtitle stream (its decoder
+   * must be enabled). Like beginSeekIndex, only on a dedicated context.
+   */
+  async beginCueIndex(streamIndex: number): Promise<boolean> {
+    if (!this.contextPtr || !this.supportsCueIndex()) return false;
+    const ret = (await this.callAsync(
+      "movi_cues_begin",
+      "number",
+      ["number", "number"],
+      [this.contextPtr, streamIndex],
+    ));
+    if (ret < 0) Logger.warn(TAG, `beginCueIndex: failed (${ret})`);
+    return ret === 0;
+  }
+
+  /**
+   * Decode the next slice of the cue pass: up to maxPackets packets and (when
+   * maxBytes > 0) about maxBytes of file. True while there's more to read.
+   */
+  async stepCueIndex(maxPackets: number, maxBytes: number = 0): Promise<boolean> {
+    if (!this.contextPtr) return false;
+    const ret = (await this.callAsync(
+      "movi_cues_step",
+      "number",
+      ["number", "number", "number"],
+      [this.contextPtr, maxPackets, maxBytes],
+    ));
+    if (ret < 0) {
+      throw new Error(`Cue index step failed: error ${ret}`);
+    }
+    return ret === 1;
+  }
+
+  /**
+   * Fraction of the file the cue pass has covered (0..1)
+   */
+  getCueIndexProgress(): number {
+    if (!this.contextPtr) return 0;
+    const fn = this.module._movi_cues_progress;
+    return typeof fn === "function" ? fn(this.contextPtr) : 0;
+  }
+
+  /**
+   * Cues overlapping [start, end) seconds from the built or imported index,
+   * in start order. Null when this context has no cue index.
+   */
+  getCuesInRange(start: number, end: number): { start: number; end: number; text: string }[] | null {
+    if (!this.contextPtr) return null;
+    const fn = this.module._movi_get_cues_in_range;
+    if (typeof fn !== "function") return null;
+
+    const total = fn(this.contextPtr, start, end, 0, 0);
+    if (total < 0) return null;
+    if (total === 0) return [];
+    const outPtr = this.module._malloc(total * CUE_REF_SIZE);
+    if (!outPtr) return null;
+    try {
+      const count = Math.min(fn(this.contextPtr, start, end, outPtr, total), total);
+      const heap = this.module.HEAPU8;
+      const view = new DataView(heap.buffer);
+      const decoder = new TextDecoder();
+      const cues: { start: number; end: number; text: string }[] = [];
+      for (let i = 0; i < count; i++) {
+        const ref = outPtr + i * CUE_REF_SIZE;
+        const textPtr = view.getUint32(ref + CUE_REF_OFFSETS.text, true);
+        const textLength = view.getInt32(ref + CUE_REF_OFFSETS.textLength, true);
+        const text = decoder.decode(heap.slice(textPtr, textPtr + textLength)).trim();
+        if (!text) continue;
+        cues.push({
+          start: view.getFloat64(ref + CUE_REF_OFFSETS.start, true),
+          end: view.getFloat64(ref + CUE_REF_OFFSETS.end, true),
+          text,
+        });
       }
+      return cues;
+    } finally {
+      this.module._free(outPtr);
+    }
+  }
 
-      const info = parsePacketInfo(this.module, infoPtr);
+  /**
+   * Serialise the cue index into a JS-owned blob (see SeekIndexStore)
+   */
+  exportCueIndex(): Uint8Array | null {
+    if (!this.contextPtr) return null;
+    const fn = this.module._movi_cues_export;
+    if (typeof fn !== "function") return null;
 
-      // Validate packet size to prevent corrupted state from creating invalid arrays
-      // Near EOF, FFmpeg's demuxer may produce corrupted packets from stale internal buffer data — treat as EOF
-      if (info.size < 0 || info.size > this.packetBufferSize) {
-        Logger.warn(
-          TAG,
-          `Invalid packet size: ${info.size} (buffer size: ${this.packetBufferSize}), treating as EOF`,
-        );
-        return null;
+    const size = fn(this.contextPtr, 0, 0);
+    if (size <= 0) return null;
+    const bufferPtr = this.module._malloc(size);
+    try {
+      if (fn(this.contextPtr, bufferPtr, size) !== size) return null;
+      return this.module.HEAPU8.slice(bufferPtr, bufferPtr + size);
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Load an exported cue index into this context. Returns the cue count, or
+   * a negative value if the blob doesn't belong to this file.
+   */
+  importCueIndex(blob: Uint8Array): number {
+    if (!this.contextPtr) return -1;
+    const fn = this.module._movi_cues_import;
+    if (typeof fn !== "function") return -1;
+
+    const bufferPtr = this.module._malloc(blob.length);
+    if (!bufferPtr) return -1;
+    try {
+      this.module.HEAPU8.set(blob, bufferPtr);
+      return fn(this.contextPtr, bufferPtr, blob.length);
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Copying read path for modules without movi_read_frame_ref: movi_read_frame
+   * memcpy's the packet into a 10MB heap buffer (allocated on first use), which
+   * is then copied into a JS-owned array.
+   */
+  private async readFrameCopy(): Promise<{ info: PacketInfo; data: Uint8Array } | null> {
+    if (!this.packetBuffer) {
+      // 10MB for 4K support
+      this.packetBufferSize = 10 * 1024 * 1024;
+      this.packetBuffer = this.module._malloc(this.packetBufferSize);
+      if (!this.packetBuffer) {
+        this.packetBufferSize = 0;
+        throw new Error("Failed to allocate packet buffer");
       }
+    }
 
-      // Copy packet data
-      const data = new Uint8Array(info.size);
-      data.set(
-        this.module.HEAPU8.subarray(
-          this.packetBuffer,
-          this.packetBuffer + info.size,
-        ),
+    const infoPtr = this.readScratch;
+    // Use ccall with async:true for Asyncify
+    let ret = (await this.callAsync(
+      "movi_read_frame",
+      "number",
+      ["number", "number", "number", "number"],
+      [this.contextPtr, infoPtr, this.packetBuffer, this.packetBufferSize],
+    ));
+
+    // Handle buffer too small (ENOBUFS is defined as -105 in many systems,
+    // but FFmpeg's AVERROR(ENOBUFS) is platform dependent.
+    // For now, check if ret is a large negative indicating truncation.
+    // In movi_streams.c we specifically returned AVERROR(ENOBUFS).
+    if (ret < 0 && ret !== -1 /* EOF check is handled by 0 above */) {
+      // Log detail and try to handle or propagate
+      Logger.error(
+        TAG,
+        `Read frame failed: error ${ret}. This might be due to a packet larger than ${this.packetBufferSize} bytes.`,
       );
+      throw new Error(`Read frame failed: error ${ret}`);
+    }
 
-      return { info, data };
-    } finally {
-      this.module._free(infoPtr);
+    if (ret === 0) {
+      // EOF
+      return null;
+    }
+
+    const info = parsePacketInfo(this.module, infoPtr);
+
+    // Validate packet size to prevent corrupted state from creating invalid arrays
+    // Near EOF, FFmpeg's demuxer may produce corrupted packets from stale internal buffer data — treat as EOF
+    if (info.size < 0 || info.size > this.packetBufferSize) {
+      Logger.warn(
+        TAG,
+        `Invalid packet size: ${info.size} (buffer size: ${this.packetBufferSize}), treating as EOF`,
+      );
+      return null;
     }
+
+    // Copy packet data
+    const data = new Uint8Array(info.size);
+    data.set(
+      this.module.HEAPU8.subarray(
+        this.packetBuffer,
+        this.packetBuffer + info.size,
+      ),
+    );
+
+    return { info, data };
   }
 
   /**
@@ -821,6 +1562,189 @@ export class WasmBindings {
     }
   }
 
+  /**
+   * Whether this module is the pthreads build and can decode video on
+   * multiple threads (see FFmpegLoader's threaded module selection).
+   */
+  supportsDecoderThreads(): boolean {
+    const fn = this.module._movi_threads_supported;
+    return typeof fn === "function" && fn() === 1;
+  }
+
+  /**
+   * Thread count for software video decoders enabled after this call.
+   * threadType is an FF_THREAD_* bitmask (1 = frame, 2 = slice, 0 = both).
+   * Returns the count that will be used (always 1 on the single-threaded build).
+   */
+  setDecoderThreads(count: number, threadType: number = 0): number {
+    if (!this.contextPtr) return 1;
+    const fn = this.module._movi_set_decoder_threads;
+    if (typeof fn !== "function") return 1; // older WASM without the export
+    return fn(this.contextPtr, count, threadType);
+  }
+
+  /**
+   * Whether software video decode can run ahead on its own decode and convert
+   * threads (movi_pipeline.c, pthreads build only)
+   */
+  supportsDecodePipeline(): boolean {
+    return (
+      this.supportsDecoderThreads() &&
+      typeof this.module._movi_pipeline_start === "function"
+    );
+  }
+
+  /**
+   * Move an enabled software video decoder onto pipeline threads, with
+   * `depth` packets / frames per stage ring. Afterwards feed it with
+   * pipelineSend and collect frames with pipelineReceive; flushDecoder and
+   * the frame getters keep working. Returns false to keep decoding inline.
+   */
+  startDecodePipeline(streamIndex: number, depth: number = 8): boolean {
+    const fn = this.module._movi_pipeline_start;
+    if (!this.contextPtr || typeof fn !== "function") return false;
+    const ret = fn(this.contextPtr, streamIndex, depth);
+    if (ret < 0) {
+      Logger.debug(TAG, `Decode pipeline not started: ${ret}`);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Queue a packet for the pipelined decoder. Returns 0, -6 (EAGAIN) when the
+   * packet ring is full — keep the packet, receive, and send it again — or
+   * another negative code on error.
+   */
+  pipelineSend(
+    data: Uint8Array,
+    pts: number,
+    dts: number,
+    keyframe: boolean,
+  ): number {
+    const fn = this.module._movi_pipeline_send;
+    if (!this.contextPtr || typeof fn !== "function") return -1;
+    // Copied into a packet of its own before the call returns
+    const ptr = this.ensureInputScratch(data.byteLength);
+    if (!ptr) return -3;
+    this.module.HEAPU8.set(data, ptr);
+    return fn(this.contextPtr, ptr, data.byteLength, pts, dts, keyframe ? 1 : 0);
+  }
+
+  /**
+   * Make the next pipelined frame current (as receiveFrame does). Returns 0,
+   * or -6 (EAGAIN) when none is ready yet.
+   */
+  pipelineReceive(): number {
+    const fn = this.module._movi_pipeline_receive;
+    if (!this.contextPtr || typeof fn !== "function") return -1;
+    return fn(this.contextPtr);
+  }
+
+  /**
+   * Have the pipeline's convert thread turn frames into width x height RGBA
+   * (they then retain as "RGBA"); 0 x 0 passes decoder output through
+   */
+  setDecodePipelineRgba(width: number, height: number): void {
+    if (!this.contextPtr) return;
+    this.module._movi_pipeline_set_rgba?.(this.contextPtr, width, height);
+  }
+
+  getDecodePipelineStats(): DecodePipelineStats | null {
+    const fn = this.module._movi_pipeline_stats;
+    if (!this.contextPtr || typeof fn !== "function") return null;
+    const ptr = this.module._malloc(14 * 8);
+    if (!ptr) return null;
+    try {
+      if (fn(this.contextPtr, ptr) < 0) return null;
+      const v = this.module.HEAPF64.subarray(ptr >> 3, (ptr >> 3) + 14);
+      return {
+        capacity: v[0],
+        packetsQueued: v[1],
+        packetsPeak: v[2],
+        sendsRefused: v[3],
+        decodedQueued: v[4],
+        decodedPeak: v[5],
+        decodeStalls: v[6],
+        outputQueued: v[7],
+        outputPeak: v[8],
+        convertStalls: v[9],
+        decodeBusyMs: v[10],
+        convertBusyMs: v[11],
+        framesDecoded: v[12],
+        framesConverted: v[13],
+      };
+    } finally {
+      this.module._free(ptr);
+    }
+  }
+
+  /**
+   * Stage timings and byte counters for this context, or null when the module
+   * wasn't built with MOVI_STATS
+   */
+  getWasmStats(): WasmInstrumentation | null {
+    const m = this.module;
+    if (
+      !this.contextPtr ||
+      typeof m._movi_get_stats !== "function" ||
+      typeof m._movi_stats_size !== "function"
+    )
+      return null;
+    const size = m._movi_stats_size();
+    const ptr = m._malloc(size);
+    if (!ptr) return null;
+    try {
+      if (m._movi_get_stats(this.contextPtr, ptr) !== 1) return null;
+      const v = m.HEAPF64.subarray(ptr >> 3, (ptr + size) >> 3);
+      // Header: version, enabled, counter/stage/bucket counts, bucket base
+      const counterCount = v[2];
+      const stageCount = v[3];
+      const bucketCount = v[4];
+      const counters = 6;
+      const stats: WasmInstrumentation = {
+        bucketBaseUs: v[5],
+        suspensions: 0,
+        bytesRead: v[counters],
+        bytesDemuxed: v[counters + 1],
+        bytesDiscarded: v[counters + 2],
+        packets: v[counters + 3],
+        stages: {},
+      };
+      const stride = 3 + bucketCount;
+      const n = Math.min(stageCount, WASM_STAT_STAGES.length);
+      for (let i = 0; i < n; i++) {
+        const at = counters + counterCount + i * stride;
+        stats.stages[WASM_STAT_STAGES[i]] = {
+          count: v[at],
+          totalMs: v[at + 1],
+          maxMs: v[at + 2],
+          buckets: Array.from(v.subarray(at + 3, at + stride)),
+        };
+      }
+      stats.suspensions = stats.stages.read?.count ?? 0;
+      return stats;
+    } finally {
+      m._free(ptr);
+    }
+  }
+
+  /**
+   * Zero this context's instrumentation counters
+   */
+  resetWasmStats(): void {
+    if (!this.contextPtr) return;
+    this.module._movi_reset_stats?.(this.contextPtr);
+  }
+
+  /**
+   * Stop the pipeline and return its decoder to inline decoding (flushed)
+   */
+  stopDecodePipeline(): void {
+    if (!this.contextPtr) return;
+    this.module._movi_pipeline_stop?.(this.contextPtr);
+  }
+
   /**
    * Persistently discard (or re-enable) a stream at the demuxer level. With
    * discard=true, av_read_frame skips that stream's packets internally and never
@@ -844,29 +1768,51 @@ export class WasmBindings {
   ): number {
     if (!this.contextPtr) return -1;
 
-    // Alloc temp buffer for data. _malloc returns 0 on OOM — without the
-    // guard, HEAPU8.set(data, 0) would silently write packet bytes over
+    // Large payloads (4K/8K keyframes) are handed over instead of copied a
+    // second time: movi_send_packet_owned frees the buffer when the decoder
+    // is done with it, so it is not freed here.
+    const owned = this.module._movi_send_packet_owned;
+    if (data.byteLength >= OWNED_PACKET_MIN && typeof owned === "function") {
+      const ptr = this.module._malloc(data.byteLength + INPUT_PADDING_SIZE);
+      if (!ptr) return -6;
+      this.module.HEAPU8.set(data, ptr);
+      this.module.HEAPU8.fill(0, ptr + data.byteLength, ptr + data.byteLength + INPUT_PADDING_SIZE);
+      return owned(this.contextPtr, streamIndex, ptr, data.byteLength, pts, dts, keyframe ? 1 : 0);
+    }
+
+    // Stage the payload in the reusable input buffer; movi_send_packet copies
+    // it into a pooled packet. ensureInputScratch returns 0 on OOM — without
+    // the guard, HEAPU8.set(data, 0) would silently write packet bytes over
     // the start of the WASM heap (allocator state, stack, etc.) and the
     // corruption surfaces hundreds of packets later as a demuxer
     // "memory access out of bounds" in av_read_frame. Bail out as -6
     // (ENOMEM) so the caller drops the packet instead of corrupting.
-    const ptr = this.module._malloc(data.byteLength);
+    const ptr = this.ensureInputScratch(data.byteLength);
     if (!ptr) return -6;
     this.module.HEAPU8.set(data, ptr);
 
-    try {
-      return this.module._movi_send_packet(
-        this.contextPtr,
-        streamIndex,
-        ptr,
-        data.byteLength,
-        pts,
-        dts,
-        keyframe ? 1 : 0,
-      );
-    } finally {
-      this.module._free(ptr);
-    }
+    return this.module._movi_send_packet(
+      this.contextPtr,
+      streamIndex,
+      ptr,
+      data.byteLength,
+      pts,
+      dts,
+      keyframe ? 1 : 0,
+    );
+  }
+
+  /**
+   * The reusable input buffer, at least `bytes` long (0 on OOM)
+   */
+  private ensureInputScratch(bytes: number): number {
+    if (this.inputScratch && this.inputScratchSize >= bytes) return this.inputScratch;
+    let size = Math.max(this.inputScratchSize, 64 * 1024);
+    while (size < bytes) size *= 2;
+    if (this.inputScratch) this.module._free(this.inputScratch);
+    this.inputScratch = this.module._malloc(size);
+    this.inputScratchSize = this.inputScratch ? size : 0;
+    return this.inputScratch;
   }
 
   receiveFrame(streamIndex: number): number {
@@ -908,45 +1854,89 @@ export class WasmBindings {
     const fn = this.module._movi_decode_audio_batch;
     if (!fn) return -1;
 
+    const staged = this.stageAudioBatch(packets);
+    if (!staged) return -6; // ENOMEM — caller drops the batch rather than corrupt the heap
+    return fn(
+      this.contextPtr,
+      streamIndex,
+      staged.blobPtr,
+      staged.sizesPtr,
+      staged.ptssPtr,
+      packets.length,
+    );
+  }
+
+  /**
+   * Whether decodeAudioBatchStretched is available
+   */
+  supportsAudioBatchStretch(): boolean {
+    return typeof this.module._movi_decode_audio_batch_stretch === "function";
+  }
+
+  /**
+   * decodeAudioBatch plus Signalsmith time-stretch in the same call. `stretch`
+   * is a movi_stretch_new handle created on THIS module. When
+   * audioBatchStretchedFrames() > 0 afterwards, the stretched PCM is at
+   * movi_stretch_output_plane(stretch, ch); otherwise the block was left
+   * unstretched in the usual batch planes.
+   */
+  decodeAudioBatchStretched(
+    streamIndex: number,
+    packets: { data: Uint8Array; pts: number }[],
+    stretch: number,
+    tempo: number,
+  ): number {
+    if (!this.contextPtr || packets.length === 0) return -1;
+    const fn = this.module._movi_decode_audio_batch_stretch;
+    if (!fn) return -1;
+
+    const staged = this.stageAudioBatch(packets);
+    if (!staged) return -6;
+    return fn(
+      this.contextPtr,
+      streamIndex,
+      staged.blobPtr,
+      staged.sizesPtr,
+      staged.ptssPtr,
+      packets.length,
+      stretch,
+      tempo,
+    );
+  }
+
+  audioBatchStretchedFrames(): number {
+    if (!this.contextPtr) return 0;
+    return this.module._movi_audio_batch_stretched_frames?.(this.contextPtr) ?? 0;
+  }
+
+  /**
+   * Lay a packet batch out for movi_decode_audio_batch*: pts descriptors, size
+   * descriptors and the payloads back to back in the reusable input buffer
+   * (pts first keeps the Float64Array 8-byte aligned), so a batch costs no
+   * allocation once the buffer has grown to fit. Null on OOM.
+   */
+  private stageAudioBatch(
+    packets: { data: Uint8Array; pts: number }[],
+  ): { blobPtr: number; sizesPtr: number; ptssPtr: number } | null {
     let totalBytes = 0;
     for (const p of packets) totalBytes += p.data.byteLength;
 
-    // One blob for the payloads + parallel size/pts descriptors, so the whole
-    // batch crosses the boundary as three allocations instead of 3N.
-    const blobPtr = this.module._malloc(totalBytes);
-    const sizesPtr = this.module._malloc(packets.length * 4);
-    const ptssPtr = this.module._malloc(packets.length * 8);
-    if (!blobPtr || !sizesPtr || !ptssPtr) {
-      if (blobPtr) this.module._free(blobPtr);
-      if (sizesPtr) this.module._free(sizesPtr);
-      if (ptssPtr) this.module._free(ptssPtr);
-      return -6; // ENOMEM — caller drops the batch rather than corrupt the heap
-    }
-
-    try {
-      let offset = 0;
-      const sizes = new Int32Array(this.module.HEAPU8.buffer, sizesPtr, packets.length);
-      const ptss = new Float64Array(this.module.HEAPU8.buffer, ptssPtr, packets.length);
-      for (let i = 0; i < packets.length; i++) {
-        const p = packets[i];
-        this.module.HEAPU8.set(p.data, blobPtr + offset);
-        offset += p.data.byteLength;
-        sizes[i] = p.data.byteLength;
-        ptss[i] = p.pts;
-      }
-      return fn(
-        this.contextPtr,
-        streamIndex,
-        blobPtr,
-        sizesPtr,
-        ptssPtr,
-        packets.length,
-      );
-    } finally {
-      this.module._free(blobPtr);
-      this.module._free(sizesPtr);
-      this.module._free(ptssPtr);
+    const ptssPtr = this.ensureInputScratch(packets.length * 12 + totalBytes);
+    if (!ptssPtr) return null;
+    const sizesPtr = ptssPtr + packets.length * 8;
+    const blobPtr = sizesPtr + packets.length * 4;
+
+    let offset = 0;
+    const sizes = new Int32Array(this.module.HEAPU8.buffer, sizesPtr, packets.length);
+    const ptss = new Float64Array(this.module.HEAPU8.buffer, ptssPtr, packets.length);
+    for (let i = 0; i < packets.length; i++) {
+      const p = packets[i];
+      this.module.HEAPU8.set(p.data, blobPtr + offset);
+      offset += p.data.byteLength;
+      sizes[i] = p.data.byteLength;
+      ptss[i] = p.pts;
     }
+    return { blobPtr, sizesPtr, ptssPtr };
   }
 
   audioBatchSamples(): number {
@@ -970,6 +1960,140 @@ export class WasmBindings {
     return this.module._movi_audio_batch_plane?.(this.contextPtr, channel) ?? 0;
   }
 
+  /**
+   * Whether decodeSubtitleBatch is available
+   */
+  supportsSubtitleBatch(): boolean {
+    return (
+      typeof this.module._movi_decode_subtitle_batch === "function" &&
+      typeof this.module._movi_subtitle_batch_info === "function"
+    );
+  }
+
+  /**
+   * Decode many subtitle packets in ONE call and read the cue table back
+   * (movi_subs.c). The per-packet path is four crossings and a buffer
+   * allocation per cue; here it's two per batch, and every cue's text comes
+   * out of a single TextDecoder pass over the arena.
+   *
+   * Returns the packets CONSUMED alongside the cues: fewer than
+   * packets.length when the batch's bitmap budget filled up, in which case
+   * the caller submits the remainder again. Null on a hard error.
+   */
+  decodeSubtitleBatch(
+    streamIndex: number,
+    packets: { data: Uint8Array; pts: number; duration: number }[],
+  ): { consumed: number; cues: BatchSubtitleCue[] } | null {
+    if (!this.contextPtr || packets.length === 0) return null;
+    const fn = this.module._movi_decode_subtitle_batch;
+    const infoFn = this.module._movi_subtitle_batch_info;
+    if (!fn || !infoFn) return null;
+
+    // Same layout as stageAudioBatch, with a durations array after the pts
+    let totalBytes = 0;
+    for (const p of packets) totalBytes += p.data.byteLength;
+    const ptssPtr = this.ensureInputScratch(packets.length * 20 + totalBytes);
+    if (!ptssPtr) return null;
+    const durationsPtr = ptssPtr + packets.length * 8;
+    const sizesPtr = durationsPtr + packets.length * 8;
+    const blobPtr = sizesPtr + packets.length * 4;
+    const ptss = new Float64Array(this.module.HEAPU8.buffer, ptssPtr, packets.length);
+    const durations = new Float64Array(this.module.HEAPU8.buffer, durationsPtr, packets.length);
+    const sizes = new Int32Array(this.module.HEAPU8.buffer, sizesPtr, packets.length);
+    let offset = 0;
+    for (let i = 0; i < packets.length; i++) {
+      const p = packets[i];
+      this.module.HEAPU8.set(p.data, blobPtr + offset);
+      offset += p.data.byteLength;
+      sizes[i] = p.data.byteLength;
+      ptss[i] = p.pts;
+      durations[i] = p.duration;
+    }
+
+    const consumed = fn(
+      this.contextPtr,
+      streamIndex,
+      blobPtr,
+      sizesPtr,
+      ptssPtr,
+      durationsPtr,
+      packets.length,
+    );
+    if (consumed < 0) return null;
+
+    const infoPtr = infoFn(this.contextPtr);
+    if (!infoPtr) return { consumed, cues: [] };
+    // Views are taken after the call: decoding may have grown the heap
+    const heap = this.module.HEAPU8;
+    const view = new DataView(heap.buffer);
+    const info = new Uint32Array(heap.buffer, infoPtr, 8);
+    const [cuesPtr, count, textPtr, textSize, rectsPtr, , pixelsPtr] = info;
+    if (count === 0) return { consumed, cues: [] };
+
+    const texts = new TextDecoder().decode(heap.subarray(textPtr, textPtr + textSize)).split("\0");
+    const cues: BatchSubtitleCue[] = [];
+    for (let i = 0; i < count; i++) {
+      const cue = cuesPtr + i * SUB_CUE_SIZE;
+      const styleId = view.getInt32(cue + SUB_CUE_OFFSETS.style, true);
+      const rectFirst = view.getInt32(cue + SUB_CUE_OFFSETS.rectFirst, true);
+      const rectCount = view.getInt32(cue + SUB_CUE_OFFSETS.rectCount, true);
+      const images: BatchSubtitleCue["images"] = [];
+      for (let r = 0; r < rectCount && rectFirst >= 0; r++) {
+        const rect = rectsPtr + (rectFirst + r) * SUB_RECT_SIZE;
+        const width = view.getInt32(rect + SUB_RECT_OFFSETS.width, true);
+        const height = view.getInt32(rect + SUB_RECT_OFFSETS.height, true);
+        const dataOffset = view.getInt32(rect + SUB_RECT_OFFSETS.dataOffset, true);
+        const paletteOffset = view.getInt32(rect + SUB_RECT_OFFSETS.paletteOffset, true);
+        const image: BatchSubtitleRect = {
+          x: view.getInt32(rect + SUB_RECT_OFFSETS.x, true),
+          y: view.getInt32(rect + SUB_RECT_OFFSETS.y, true),
+          width,
+          height,
+          ref: view.getInt32(rect + SUB_RECT_OFFSETS.ref, true),
+        };
+        const data = pixelsPtr + dataOffset;
+        if (paletteOffset < 0) {
+          image.rgba = heap.slice(data, data + width * height * 4);
+        } else {
+          const palette = pixelsPtr + paletteOffset;
+          image.palette = heap.slice(palette, palette + 1024);
+          if (dataOffset >= 0) image.indices = heap.slice(data, data + width * height);
+        }
+        images.push(image);
+      }
+      cues.push({
+        start: view.getFloat64(cue + SUB_CUE_OFFSETS.start, true),
+        end: view.getFloat64(cue + SUB_CUE_OFFSETS.end, true),
+        text: (texts[i] ?? "").trim(),
+        style: styleId >= 0 ? this.subtitleStyleName(styleId) : undefined,
+        images,
+      });
+    }
+    return { consumed, cues };
+  }
+
+  /**
+   * Switch batched bitmap subtitles between expanded RGBA and index plane +
+   * palette. Also drops the previous cue's rects on the C side, so call it
+   * whenever the caller forgets its own copies. False when unsupported.
+   */
+  setSubtitlePalettized(enable: boolean): boolean {
+    if (!this.contextPtr) return false;
+    const fn = this.module._movi_subtitle_batch_set_palettized;
+    if (typeof fn !== "function") return false;
+    return fn(this.contextPtr, enable ? 1 : 0) === 0;
+  }
+
+  private subtitleStyleName(id: number): string | undefined {
+    const cached = this.subtitleStyles[id];
+    if (cached !== undefined) return cached;
+    const ptr = this.module._movi_subtitle_style_name?.(this.contextPtr, id) ?? 0;
+    if (!ptr) return undefined;
+    const name = this.module.UTF8ToString(ptr);
+    this.subtitleStyles[id] = name;
+    return name;
+  }
+
   /**
    * Decode a subtitle packet
    */
@@ -998,7 +2122,7 @@ export class WasmBindings {
       const packetDuration = duration ?? 0;
 
       // Decode subtitle using ccall with async
-      const result = (await this.module.ccall(
+      const result = (await this.callAsync(
         "movi_decode_subtitle",
         "number",
         ["number", "number", "number", "number", "number", "number"],
@@ -1010,8 +2134,7 @@ export class WasmBindings {
           timestamp,
           packetDuration,
         ],
-        { async: true },
-      )) as number;
+      ));
 
       return result;
     } finally {
@@ -1143,13 +2266,12 @@ export class WasmBindings {
   ): Promise<{ start: number; end: number; text: string }[] | null> {
     if (!this.contextPtr) return null;
 
-    const count = (await this.module.ccall(
+    const count = (await this.callAsync(
       "movi_prefetch_subtitle_cues",
       "number",
       ["number", "number"],
       [this.contextPtr, streamIndex],
-      { async: true },
-    )) as number;
+    ));
 
     if (count < 0) {
       Logger.warn(TAG, `prefetchSubtitleCues: failed (${count})`);
@@ -1361,6 +2483,95 @@ export class WasmBindings {
     this.module._movi_flush_decoder(this.contextPtr, streamIndex);
   }
 
+  /**
+   * Whether this module exports retained frame handles
+   */
+  supportsFrameHandles(): boolean {
+    return typeof this.module._movi_frame_retain === "function";
+  }
+
+  /**
+   * Keep the current decoded video frame alive past the next receiveFrame and
+   * describe its planes in place, so a VideoFrame or texture upload can read
+   * them straight from the heap. `data` is a HEAPU8 view: consume it before
+   * the heap can grow (any call that allocates) — the buffers themselves stay
+   * put until release(). Returns null without a frame or when every handle is
+   * taken; always release() what you get.
+   */
+  retainFrame(): RetainedFrame | null {
+    const retain = this.module._movi_frame_retain;
+    const infoFn = this.module._movi_frame_handle_info;
+    const releaseFn = this.module._movi_frame_release;
+    if (!this.contextPtr || !this.readScratch) return null;
+    if (typeof retain !== "function" || typeof infoFn !== "function" || typeof releaseFn !== "function") {
+      return null;
+    }
+
+    const handle = retain(this.contextPtr);
+    if (handle <= 0) return null;
+    const ctx = this.contextPtr;
+    let released = false;
+    const release = () => {
+      if (released) return;
+      released = true;
+      releaseFn(ctx, handle);
+    };
+
+    // movi_frame_handle_info writes 16 uint32
+    if (!this.frameInfoScratch) this.frameInfoScratch = this.module._malloc(64);
+    const infoPtr = this.frameInfoScratch;
+    if (!infoPtr) {
+      release();
+      return null;
+    }
+    if (infoFn(ctx, handle, infoPtr) < 0) {
+      release();
+      return null;
+    }
+    const info = new Uint32Array(this.module.HEAPU8.buffer, infoPtr, 16).slice();
+    const planes = info[3];
+    let start = Infinity;
+    let end = 0;
+    const height = info[2];
+    const ptrs: number[] = [];
+    const strides: number[] = [];
+    for (let i = 0; i < planes; i++) {
+      ptrs.push(info[4 + 2 * i]);
+      strides.push(info[5 + 2 * i]);
+    }
+    // Chroma rows: half height for 4:2:0 / NV12, full for 4:2:2 / 4:4:4
+    const format = RETAINED_FRAME_FORMATS[info[0]] ?? null;
+    const chromaRows =
+      format === "I420" || format === "I420P10" || format === "NV12" || format === "I420A"
+        ? (height + 1) >> 1
+        : height;
+    for (let i = 0; i < planes; i++) {
+      const rows = i === 0 || (format === "I420A" && i === 3) ? height : chromaRows;
+      start = Math.min(start, ptrs[i]);
+      end = Math.max(end, ptrs[i] + strides[i] * rows);
+    }
+    if (planes === 0 || !Number.isFinite(start)) {
+      release();
+      return null;
+    }
+
+    const colorSpace: VideoColorSpaceInit = {
+      matrix: AVCOL_MATRIX[info[12]] ?? null,
+      primaries: AVCOL_PRIMARIES[info[13]] ?? null,
+      transfer: AVCOL_TRANSFER[info[14]] ?? null,
+      fullRange: info[15] === 2, // AVCOL_RANGE_JPEG
+    };
+    return {
+      format,
+      width: info[1],
+      height,
+      data: this.module.HEAPU8.subarray(start, end),
+      layout: ptrs.map((ptr, i) => ({ offset: ptr - start, stride: strides[i] })),
+      colorSpace,
+      release,
+    };
+  }
+
   /**
    * Get decoded frame as RGBA data (converts any format including 10-bit HDR)
    * This is useful for software decoding where YUV output is in non-standard formats
@@ -1386,6 +2597,19 @@ export class WasmBindings {
     return this.module.HEAPU8.subarray(rgbaPtr, rgbaPtr + size);
   }
 
+  /**
+   * Tone-map PQ/HLG frames to SDR BT.709 in getFrameRGBA instead of keeping
+   * their transfer for the renderer's HDR path. Returns false when the
+   * module predates movi_tonemap.c.
+   */
+  setHdrToneMap(enabled: boolean): boolean {
+    if (!this.contextPtr) return false;
+    const fn = this.module._movi_set_hdr_tonemap;
+    if (typeof fn !== "function") return false;
+    fn(this.contextPtr, enabled ? 1 : 0);
+    return true;
+  }
+
   /**
    * Set frames to skip during decoding
    * 0: None, 1: NonRef, 2: Bidir, 3: NonKey, 4: All
@@ -1394,6 +2618,235 @@ export class WasmBindings {
     if (!this.contextPtr) return;
     this.module._movi_set_skip_frame(this.contextPtr, trackIndex, skip);
   }
+
+  /**
+   * Whether this module picks the frame-drop tier itself (movi_shed.c)
+   */
+  supportsLoadShedding(): boolean {
+    return (
+      typeof this.module._movi_shed_enable === "function" &&
+      typeof this.module._movi_shed_report === "function"
+    );
+  }
+
+  /**
+   * Put one stream under closed-loop load shedding, or stop with
+   * streamIndex < 0. Resets the tier to 0 (full decode).
+   */
+  enableLoadShedding(streamIndex: number): void {
+    if (!this.contextPtr) return;
+    this.module._movi_shed_enable?.(this.contextPtr, streamIndex);
+  }
+
+  /**
+   * Report one renderer window's decode-budget miss ratio (0..1) and get the
+   * tier now in effect: 0 off, 1 non-reference, 2 + no loop filter, 3 B-frames,
+   * 4 keyframes only.
+   */
+  reportDecodeBudget(missRatio: number): number {
+    if (!this.contextPtr) return 0;
+    return this.module._movi_shed_report?.(this.contextPtr, missRatio) ?? 0;
+  }
+
+  /**
+   * Packets dropped in the demuxer since enableLoadShedding
+   */
+  getLoadShedDropped(): number {
+    if (!this.contextPtr) return 0;
+    return this.module._movi_shed_dropped?.(this.contextPtr) ?? 0;
+  }
+
+  /**
+   * Whether this module has the push-based live ingest (movi_live.c)
+   */
+  supportsLive(): boolean {
+    return (
+      typeof this.module._movi_set_live === "function" &&
+      typeof this.module._movi_push_bytes === "function"
+    );
+  }
+
+  /**
+   * Switch the context to live ingest before open(): non-seekable AVIO over
+   * pushed bytes, minimal probing, no read-ahead buffering. No DataSource
+   * reads happen after this; feed the stream with pushBytes.
+   */
+  setLive(enable: boolean): boolean {
+    if (!this.contextPtr || !this.supportsLive()) return false;
+    if (this.module._movi_set_live!(this.contextPtr, enable ? 1 : 0) < 0) {
+      return false;
+    }
+    this.live = enable;
+    return true;
+  }
+
+  isLive(): boolean {
+    return this.live;
+  }
+
+  /**
+   * Append live-feed bytes. Returns how many were taken — fewer than given
+   * when the context's queue is full (push the rest once the demuxer has
+   * read some), -1 once the stream has ended.
+   */
+  pushBytes(chunk: Uint8Array): number {
+    if (!this.contextPtr || !this.live) return -1;
+    if (chunk.byteLength === 0) return 0;
+    if (this.liveScratchSize < chunk.byteLength) {
+      if (this.liveScratch) this.module._free(this.liveScratch);
+      this.liveScratchSize = Math.max(chunk.byteLength, 64 * 1024);
+      this.liveScratch = this.module._malloc(this.liveScratchSize);
+      if (!this.liveScratch) {
+        this.liveScratchSize = 0;
+        return 0;
+      }
+    }
+    this.module.HEAPU8.set(chunk, this.liveScratch);
+    const taken = this.module._movi_push_bytes!(
+      this.contextPtr,
+      this.liveScratch,
+      chunk.byteLength,
+    );
+    if (taken > 0) this.wakeLiveRead(0);
+    return taken;
+  }
+
+  /**
+   * End the live stream: the demuxer drains what's queued, then sees EOF
+   */
+  endLive(): void {
+    if (!this.contextPtr || !this.live) return;
+    this.module._movi_push_eof?.(this.contextPtr);
+    this.wakeLiveRead(0);
+  }
+
+  /**
+   * Live bytes pushed but not yet read by the demuxer
+   */
+  getLiveBuffered(): number {
+    if (!this.contextPtr || !this.live) return 0;
+    return this.module._movi_live_buffered?.(this.contextPtr) ?? 0;
+  }
+
+  // Resume this context's read if it's suspended on an empty live FIFO;
+  // returns whether one was
+  private wakeLiveRead(result: number): boolean {
+    const pending = (this.module as any)._pendingLiveWait;
+    if (!pending || !this.contextPtr || pending.ctx !== this.contextPtr) {
+      return false;
+    }
+    (this.module as any)._pendingLiveWait = null;
+    pending.resolve(result);
+    return true;
+  }
+
+  /**
+   * Whether this module decrypts AES-CTR encrypted reads itself
+   * (movi_crypt.c)
+   */
+  supportsDecrypt(): boolean {
+    return typeof this.module._movi_set_ctr_key === "function";
+  }
+
+  // Key the context for the CTR session `cipher` (null = plaintext reads).
+  // The key passes through a scratch buffer that is wiped straight after.
+  private setCipher(cipher: CtrCipher | null): boolean {
+    const generation = cipher ? cipher.generation : -1;
+    if (!this.contextPtr || generation === this.cipherGeneration) return true;
+    if (!cipher) {
+      this.module._movi_set_ctr_key!(this.contextPtr, 0, 0);
+      this.cipherGeneration = -1;
+      return true;
+    }
+    const scratch = this.module._malloc(40);
+    if (!scratch) return false;
+    this.module.HEAPU8.set(cipher.key.subarray(0, 32), scratch);
+    this.module.HEAPU8.set(cipher.nonce.subarray(0, 8), scratch + 32);
+    const ret = this.module._movi_set_ctr_key!(
+      this.contextPtr,
+      scratch,
+      scratch + 32,
+    );
+    this.module.HEAPU8.fill(0, scratch, scratch + 40);
+    this.module._free(scratch);
+    if (ret < 0) return false;
+    this.cipherGeneration = generation;
+    return true;
+  }
+
+  /**
+   * Whether this module can drop temporal sub-layers in the demuxer
+   * (movi_nal.c)
+   */
+  supportsTemporalLayers(): boolean {
+    return (
+      typeof this.module._movi_set_max_temporal_layer === "function" &&
+      typeof this.module._movi_temporal_layers === "function"
+    );
+  }
+
+  /**
+   * Temporal sub-layers of a stream, as signalled or seen so far; 1 when it
+   * has no temporal scalability (or the module can't tell)
+   */
+  getTemporalLayers(streamIndex: number): number {
+    if (!this.contextPtr) return 1;
+    const layers =
+      this.module._movi_temporal_layers?.(this.contextPtr, streamIndex) ?? 1;
+    return layers > 0 ? layers : 1;
+  }
+
+  /**
+   * Keep sub-layers 0..maxTid of a stream and drop the rest before they're
+   * copied out; maxTid < 0 keeps every layer. Keyframes are never dropped.
+   */
+  setMaxTemporalLayer(streamIndex: number, maxTid: number): void {
+    if (!this.contextPtr) return;
+    this.module._movi_set_max_temporal_layer?.(
+      this.contextPtr,
+      streamIndex,
+      maxTid,
+    );
+  }
+
+  /**
+   * Packets dropped above the stream's temporal-layer limit since it was set
+   */
+  getTemporalDropped(streamIndex: number): number {
+    if (!this.contextPtr) return 0;
+    return (
+      this.module._movi_temporal_dropped?.(this.contextPtr, streamIndex) ?? 0
+    );
+  }
+
+  /**
+   * Release memory this context can rebuild on demand: 1 = scaler, HDR
+   * tables, pooled packets and idle frame buffers; 2 = also close the
+   * audio/video decoders (they reopen at the next keyframe). Returns the
+   * bytes released. Normally driven by the module's memory budget.
+   */
+  trim(level: number): number {
+    if (!this.contextPtr) return 0;
+    const released = this.module._movi_trim?.(this.contextPtr, level) ?? 0;
+    this.managed.trimLevel = Math.max(this.managed.trimLevel, level);
+    return released;
+  }
+
+  /**
+   * Heap bytes this context holds on its own (a floor: codec-internal state
+   * isn't counted)
+   */
+  getMemoryUsage(): number {
+    if (!this.contextPtr) return 0;
+    return this.module._movi_context_memory?.(this.contextPtr) ?? 0;
+  }
+
+  /**
+   * The manager shared by every context in this module
+   */
+  getContextManager(): WasmContextManager {
+    return this.manager;
+  }
 }
 
 /**
@@ -1540,11 +2993,50 @@ export class ThumbnailBindings {
    * Uses callback pattern - C calls JS when packet is ready
    */
   async readKeyframe(timestamp: number): Promise<number> {
+    return this.callKeyframeExport("movi_thumbnail_read_keyframe", timestamp);
+  }
+
+  /**
+   * Whether this module has the scrub cursor exports
+   */
+  supportsScrub(): boolean {
+    return typeof this.module._movi_thumbnail_scrub_keyframe === "function";
+  }
+
+  /**
+   * readKeyframe through the scrub cursor: a time in the GOP of the last
+   * keyframe returns it again without I/O, a time shortly after it reads
+   * forward instead of seeking. Same return value as readKeyframe.
+   */
+  async scrubKeyframe(timestamp: number): Promise<number> {
+    if (!this.supportsScrub()) return this.readKeyframe(timestamp);
+    return this.callKeyframeExport("movi_thumbnail_scrub_keyframe", timestamp);
+  }
+
+  /**
+   * End (media time, seconds) of the GOP of the keyframe scrubKeyframe last
+   * returned: Infinity after the last keyframe, -1 when not known
+   */
+  getScrubGopEnd(): number {
+    const fn = this.module._movi_thumbnail_scrub_next_pts;
+    if (!this.contextPtr || typeof fn !== "function") return -1;
+    return fn(this.contextPtr);
+  }
+
+  /**
+   * Leave scrub mode and demux every stream again
+   */
+  endScrub(): void {
+    if (!this.contextPtr) return;
+    this.module._movi_thumbnail_scrub_end?.(this.contextPtr);
+  }
+
+  private async callKeyframeExport(name: string, timestamp: number): Promise<number> {
     if (!this.contextPtr || !this.isOpened) return -1;
 
     Logger.debug(
       TAG,
-      `JS calling _movi_thumbnail_read_keyframe(${this.contextPtr}, ${timestamp.toFixed(2)})`,
+      `JS calling _${name}(${this.contextPtr}, ${timestamp.toFixed(2)})`,
     );
 
     // We use a shared result object to capture callback data
@@ -1567,7 +3059,7 @@ export class ThumbnailBindings {
       // Call C function using ccall with async:true
       // This ensures we wait for the entire async operation to complete
       await this.module.ccall(
-        "movi_thumbnail_read_keyframe",
+        name,
         "void",
         ["number", "number"],
         [this.contextPtr, timestamp],
@@ -1580,7 +3072,7 @@ export class ThumbnailBindings {
       }
       return packetSize;
     } catch (e) {
-      Logger.error(TAG, "readKeyframe error", e);
+      Logger.error(TAG, `${name} error`, e);
       return -1;
     } finally {
       (this.module as any)._pendingThumbnail = null;
@@ -1665,6 +3157,126 @@ export class ThumbnailBindings {
     }
   }
 
+  /**
+   * Load a seek index exported by WasmBindings.exportSeekIndex so keyframe
+   * lookups jump to indexed offsets. Returns the entry count, < 0 on mismatch.
+   */
+  importSeekIndex(blob: Uint8Array): number {
+    if (!this.contextPtr) return -1;
+    const fn = this.module._movi_thumbnail_import_index;
+    if (typeof fn !== "function") return -1;
+
+    const bufferPtr = this.module._malloc(blob.length);
+    if (!bufferPtr) return -1;
+    try {
+      this.module.HEAPU8.set(blob, bufferPtr);
+      return fn(this.contextPtr, bufferPtr, blob.length);
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Trade decode quality for speed when output is downscaled to about
+   * targetWidth (lowres where supported, no loop filter, no film grain).
+   * Call before open(); 0 restores full-quality decode.
+   */
+  setFastDecode(targetWidth: number): void {
+    const fn = this.module._movi_thumbnail_set_fast_decode;
+    if (!this.contextPtr || typeof fn !== "function") return;
+    fn(this.contextPtr, targetWidth);
+  }
+
+  /**
+   * Open from the container header alone (no stream probing) when it fully
+   * describes the video stream. For contexts whose WebCodecs decoder is
+   * configured from an already-probed track. Call before open().
+   */
+  setHeaderOnlyOpen(enabled: boolean): void {
+    const fn = this.module._movi_thumbnail_set_header_only;
+    if (!this.contextPtr || typeof fn !== "function") return;
+    fn(this.contextPtr, enabled ? 1 : 0);
+  }
+
+  /**
+   * Hand the context the playback context's stream descriptor
+   * (WasmBindings.exportProbeDescriptor) so open() can skip probing for any
+   * container whose header matches it. Call before open().
+   */
+  setProbeDescriptor(blob: Uint8Array): boolean {
+    if (!this.contextPtr) return false;
+    const fn = this.module._movi_thumbnail_import_probe;
+    if (typeof fn !== "function") return false;
+
+    const bufferPtr = this.module._malloc(blob.length);
+    if (!bufferPtr) return false;
+    try {
+      this.module.HEAPU8.set(blob, bufferPtr);
+      return fn(this.contextPtr, bufferPtr, blob.length) === 0;
+    } finally {
+      this.module._free(bufferPtr);
+    }
+  }
+
+  /**
+   * Whether this module has the storyboard sweep exports
+   */
+  supportsStoryboard(): boolean {
+    return typeof this.module._movi_thumbnail_storyboard_begin === "function";
+  }
+
+  /**
+   * Switch this context to storyboard mode with room for maxTiles tiles
+   */
+  beginStoryboard(tileWidth: number, tileHeight: number, maxTiles: number): boolean {
+    if (!this.contextPtr || !this.supportsStoryboard()) return false;
+    return (
+      this.module._movi_thumbnail_storyboard_begin!(
+        this.contextPtr,
+        tileWidth,
+        tileHeight,
+        maxTiles,
+      ) === 0
+    );
+  }
+
+  /**
+   * Decode the keyframe for `time` into tile `slot`. Feed ascending times.
+   * Returns the keyframe pts in seconds, or null on failure.
+   */
+  async addStoryboardTile(slot: number, time: number): Promise<number | null> {
+    if (!this.contextPtr) return null;
+    const ret = (await this.module.ccall(
+      "movi_thumbnail_storyboard_add",
+      "number",
+      ["number", "number", "number"],
+      [this.contextPtr, slot, time],
+      { async: true },
+    )) as number;
+    if (ret !== 0) return null;
+    return this.module._movi_thumbnail_storyboard_pts!(this.contextPtr, slot);
+  }
+
+  /**
+   * Copy of tile `slot` (RGBA) out of WASM memory
+   */
+  getStoryboardTile(slot: number, tileWidth: number, tileHeight: number): Uint8ClampedArray | null {
+    if (!this.contextPtr) return null;
+    const base = this.module._movi_thumbnail_storyboard_tiles!(this.contextPtr);
+    if (!base) return null;
+    const size = tileWidth * tileHeight * 4;
+    const start = base + slot * size;
+    return new Uint8ClampedArray(this.module.HEAPU8.slice(start, start + size).buffer);
+  }
+
+  /**
+   * Free the tile buffer and return to normal (readKeyframe) operation
+   */
+  endStoryboard(): void {
+    if (!this.contextPtr) return;
+    this.module._movi_thumbnail_storyboard_end?.(this.contextPtr);
+  }
+
   /**
    * Decode current packet to YUV (preserves HDR)
    */
@@ -1,3 +1,4 @@
 export type { MoviWasmModule, StreamInfo, PacketInfo } from './types';
-export { loadWasmModule, loadWasmModuleNew, getWasmModule, isWasmModuleLoaded, type LoaderOptions } from './FFmpegLoader';
-export { WasmBindings, ThumbnailBindings, type DataSource } from './bindings';
+export { loadWasmModule, loadWasmModuleNew, getWasmModule, isWasmModuleLoaded, canUseSimdWasm, canUseThreadedWasm, type LoaderOptions, type WasmFlavor } from './FFmpegLoader';
+export { WasmBindings, ThumbnailBindings, type DataSource, type CipherRead, type CtrCipher, type DecodePipelineStats, WASM_STAT_STAGES, type WasmStatStage, type WasmStageStats, type WasmInstrumentation } from './bindings';
+export { WasmContextManager, type ManagedContext, type ModuleMemoryUsage, type ContextMemoryUsage } from './ContextManager';
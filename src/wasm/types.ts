@@ -34,6 +34,9 @@ export interface MoviWasmModule {
   // Filesystem
   FS: EmscriptenFS;
 
+  // Build the instance came from, stamped by FFmpegLoader
+  moviFlavor?: "st" | "simd" | "mt";
+
   // Core API - async functions due to Asyncify
   _movi_create: () => number;
   _movi_destroy: (ctx: number) => void;
@@ -75,6 +78,37 @@ export interface MoviWasmModule {
     buffer: number,
     bufferSize: number,
   ) => Promise<number>; // Now async
+  // Zero-copy packet ring: returns a slot id (>= 1) and writes the payload
+  // pointer to dataOutPtr; the slot must be given back with _movi_packet_release.
+  // Optional so a newer bundle falls back to _movi_read_frame on an older .wasm.
+  _movi_read_frame_ref?: (ctx: number, infoPtr: number, dataOutPtr: number) => Promise<number>;
+  _movi_packet_release?: (ctx: number, slot: number) => void;
+  // Batched demux: up to `max` PacketInfo records, payloads packed back-to-back
+  // into `arena` (packet i starts at the sum of the previous sizes).
+  _movi_read_frames?: (ctx: number, infos: number, max: number, arena: number, arenaSize: number) => Promise<number>;
+  _movi_set_read_frames_limit?: (ctx: number, streamIndex: number, maxPackets: number) => void;
+  // Persistent seek index (movi_index.c). Build with begin + repeated step on a
+  // dedicated context, export the blob, import it into later contexts.
+  _movi_index_needed?: (ctx: number, streamIndex: number) => number;
+  _movi_index_begin?: (ctx: number, streamIndex: number) => number;
+  _movi_index_step?: (ctx: number, maxPackets: number) => Promise<number>;
+  _movi_index_progress?: (ctx: number) => number;
+  _movi_index_export?: (ctx: number, buffer: number, bufferSize: number) => number;
+  _movi_index_import?: (ctx: number, blob: number, size: number) => number;
+  // Cached stream descriptors (movi_probe.c): export after a probed open,
+  // import before movi_open to skip avformat_find_stream_info.
+  _movi_probe_export?: (ctx: number, buffer: number, bufferSize: number) => number;
+  _movi_probe_import?: (ctx: number, blob: number, size: number) => number;
+  _movi_probe_applied?: (ctx: number) => number;
+  // Subtitle cue index (movi_cues.c). Built like the seek index on a dedicated
+  // context; query with movi_get_cues_in_range (CUE_REF_SIZE-byte records).
+  _movi_cues_begin?: (ctx: number, streamIndex: number) => Promise<number>;
+  _movi_cues_step?: (ctx: number, maxPackets: number, maxBytes: number) => Promise<number>;
+  _movi_cues_progress?: (ctx: number) => number;
+  _movi_cues_count?: (ctx: number) => number;
+  _movi_get_cues_in_range?: (ctx: number, start: number, end: number, out: number, max: number) => number;
+  _movi_cues_export?: (ctx: number, buffer: number, bufferSize: number) => number;
+  _movi_cues_import?: (ctx: number, blob: number, size: number) => number;
   _movi_set_log_level: (level: number) => void;
   _movi_get_format_name: (ctx: number, buffer: number, size: number) => number;
   _movi_get_metadata_title: (
@@ -94,7 +128,21 @@ export interface MoviWasmModule {
     dts: number,
     keyframe: number,
   ) => number;
+  // Zero-copy variant: takes ownership of a malloc'd, zero-padded payload
+  _movi_send_packet_owned?: (
+    ctx: number,
+    stream_index: number,
+    data: number,
+    size: number,
+    pts: number,
+    dts: number,
+    keyframe: number,
+  ) => number;
   _movi_receive_frame: (ctx: number, stream_index: number) => number;
+  // Decoder threading — only effective in the pthreads build (movi-mt.wasm).
+  // Optional for the same reason as the batch exports below.
+  _movi_threads_supported?: () => number;
+  _movi_set_decoder_threads?: (ctx: number, count: number, threadType: number) => number;
   // Batched audio decode — many packets per round-trip, PCM accumulated into
   // one contiguous planar block. See WasmBindings.decodeAudioBatch.
   // Optional: the element bundle and the .wasm ship separately, so a bundle
@@ -113,6 +161,33 @@ export interface MoviWasmModule {
   _movi_audio_batch_sample_rate?: (ctx: number) => number;
   _movi_audio_batch_pts?: (ctx: number) => number;
   _movi_audio_batch_plane?: (ctx: number, channel: number) => number;
+  // Batch decode fused with Signalsmith stretch (same module's stretch handle)
+  _movi_decode_audio_batch_stretch?: (
+    ctx: number,
+    stream_index: number,
+    blob: number,
+    sizes: number,
+    ptss: number,
+    count: number,
+    stretch: number,
+    tempo: number,
+  ) => number;
+  _movi_audio_batch_stretched_frames?: (ctx: number) => number;
+  // Batched subtitle decode (movi_subs.c) — one call per demux tick instead of
+  // four per cue. movi_subtitle_batch_info points at 8 int32s: cues, count,
+  // text arena, text bytes, rects, rect count, pixel arena, pixel bytes.
+  _movi_decode_subtitle_batch?: (
+    ctx: number,
+    stream_index: number,
+    blob: number,
+    sizes: number,
+    ptss: number,
+    durations: number,
+    count: number,
+  ) => number;
+  _movi_subtitle_batch_info?: (ctx: number) => number;
+  _movi_subtitle_batch_set_palettized?: (ctx: number, enable: number) => number;
+  _movi_subtitle_style_name?: (ctx: number, id: number) => number;
   _movi_get_frame_width: (ctx: number) => number;
   _movi_get_frame_height: (ctx: number) => number;
   _movi_get_frame_format(ctx: number): number;
@@ -133,7 +208,57 @@ export interface MoviWasmModule {
   ): number;
   _movi_get_frame_rgba_size(ctx: number): number;
   _movi_get_frame_rgba_linesize(ctx: number): number;
+  _movi_set_hdr_tonemap?: (ctx: number, enable: number) => void;
   _movi_set_skip_frame(ctx: number, streamIndex: number, skip: number): void;
+  // Closed-loop load shedding (movi_shed.c)
+  _movi_shed_enable?: (ctx: number, streamIndex: number) => void;
+  _movi_shed_report?: (ctx: number, missRatio: number) => number;
+  _movi_shed_tier?: (ctx: number) => number;
+  _movi_shed_dropped?: (ctx: number) => number;
+  // Live ingest (movi_live.c)
+  _movi_set_live?: (ctx: number, enable: number) => number;
+  _movi_push_bytes?: (ctx: number, data: number, size: number) => number;
+  _movi_push_eof?: (ctx: number) => void;
+  _movi_live_buffered?: (ctx: number) => number;
+  // Encrypted-source CTR decryption (movi_crypt.c)
+  _movi_set_ctr_key?: (ctx: number, key: number, nonce: number) => number;
+  // Temporal sub-layer dropping (movi_nal.c)
+  _movi_set_max_temporal_layer?: (
+    ctx: number,
+    streamIndex: number,
+    maxTid: number,
+  ) => number;
+  _movi_temporal_layers?: (ctx: number, streamIndex: number) => number;
+  _movi_temporal_dropped?: (ctx: number, streamIndex: number) => number;
+  // Shared scratch and memory budget (movi_budget.c)
+  _movi_set_avio_buffer_size?: (ctx: number, size: number) => void;
+  _movi_context_memory?: (ctx: number) => number;
+  _movi_module_memory?: (outPtr: number) => void;
+  _movi_trim?: (ctx: number, level: number) => number;
+  _movi_scratch_release?: () => void;
+  // Software decode run-ahead threads (movi_pipeline.c, mt build)
+  _movi_pipeline_start?: (ctx: number, streamIndex: number, depth: number) => number;
+  _movi_pipeline_send?: (
+    ctx: number,
+    data: number,
+    size: number,
+    pts: number,
+    dts: number,
+    keyframe: number,
+  ) => number;
+  _movi_pipeline_receive?: (ctx: number) => number;
+  _movi_pipeline_flush?: (ctx: number) => void;
+  _movi_pipeline_set_rgba?: (ctx: number, width: number, height: number) => void;
+  _movi_pipeline_stats?: (ctx: number, out: number) => number;
+  _movi_pipeline_stop?: (ctx: number) => void;
+  // Hot-path instrumentation (movi_get_stats returns 0 unless built with MOVI_STATS)
+  _movi_stats_size?: () => number;
+  _movi_get_stats?: (ctx: number, out: number) => number;
+  _movi_reset_stats?: (ctx: number) => void;
+  // Retained frame handles (pooled decoder output, zero-copy export)
+  _movi_frame_retain?: (ctx: number) => number;
+  _movi_frame_handle_info?: (ctx: number, handle: number, out: number) => number;
+  _movi_frame_release?: (ctx: number, handle: number) => void;
 
   // Thumbnail API (demux only)
   _movi_thumbnail_create: (fileSizeLow: number, fileSizeHigh: number) => number;
@@ -142,6 +267,22 @@ export interface MoviWasmModule {
   _movi_thumbnail_get_packet_data: (ctx: number) => number;
   _movi_thumbnail_get_packet_pts: (ctx: number) => number;
   _movi_thumbnail_get_stream_info: (ctx: number, infoPtr: number) => number;
+  _movi_thumbnail_import_index?: (ctx: number, blob: number, size: number) => number;
+  _movi_thumbnail_import_probe?: (ctx: number, blob: number, size: number) => number;
+  _movi_thumbnail_set_fast_decode?: (ctx: number, targetWidth: number) => void;
+  _movi_thumbnail_set_header_only?: (ctx: number, enable: number) => void;
+  // Scrub cursor: scrub_keyframe has read_keyframe's callback contract;
+  // scrub_next_pts is the end of the held keyframe's GOP (-1 = unknown).
+  _movi_thumbnail_scrub_keyframe?: (ctx: number, timestamp: number) => void;
+  _movi_thumbnail_scrub_next_pts?: (ctx: number) => number;
+  _movi_thumbnail_scrub_end?: (ctx: number) => void;
+  // Storyboard sweep: begin, then add(slot, t) with ascending t; tiles are
+  // RGBA tileWidth x tileHeight, stored back to back from storyboard_tiles.
+  _movi_thumbnail_storyboard_begin?: (ctx: number, tileWidth: number, tileHeight: number, maxTiles: number) => number;
+  _movi_thumbnail_storyboard_add?: (ctx: number, slot: number, timestamp: number) => Promise<number>;
+  _movi_thumbnail_storyboard_tiles?: (ctx: number) => number;
+  _movi_thumbnail_storyboard_pts?: (ctx: number, slot: number) => number;
+  _movi_thumbnail_storyboard_end?: (ctx: number) => void;
   _movi_thumbnail_get_extradata: (
     ctx: number,
     buffer: number,
@@ -156,11 +297,31 @@ export interface MoviWasmModule {
 
   // Signalsmith Stretch — pitch-preserving time-stretch (sync API).
   _movi_stretch_new: (channels: number, sampleRate: number) => number;
+  // preset: 0 default, 1 cheaper, 2 low latency (see movi_stretch.cpp)
+  _movi_stretch_new_preset?: (channels: number, sampleRate: number, preset: number) => number;
+  // Channel groups: `groups` u32 channel masks at masksPtr, i32 tiers at tiersPtr
+  _movi_stretch_new_grouped?: (
+    channels: number,
+    sampleRate: number,
+    masksPtr: number,
+    tiersPtr: number,
+    groups: number,
+  ) => number;
   _movi_stretch_delete: (handle: number) => void;
   _movi_stretch_reset: (handle: number) => void;
   _movi_stretch_set_transpose_semitones: (handle: number, semitones: number) => void;
   _movi_stretch_input_latency: (handle: number) => number;
   _movi_stretch_output_latency: (handle: number) => number;
+  // Planar stretch; output stays in the instance (movi_stretch_output_plane)
+  _movi_stretch_process_planar?: (
+    handle: number,
+    inPlanes: number,
+    inChannels: number,
+    inFrames: number,
+    outFrames: number,
+  ) => number;
+  _movi_stretch_channels?: (handle: number) => number;
+  _movi_stretch_output_plane?: (handle: number, channel: number) => number;
   _movi_stretch_process: (
     handle: number,
     inPtr: number,
@@ -241,6 +402,9 @@ export interface PacketInfo {
   // safe to drop before the decoder when the device can't sustain the source
   // rate (see VideoDecoder adaptive skip). Always false for keyframes.
   disposable: boolean;
+  // Temporal sub-layer of the picture (HEVC/VVC TemporalId, AV1 temporal_id,
+  // H.264 SVC temporal_id). 0 for streams without temporal layering.
+  temporalId: number;
 }
 
 // StreamInfo struct layout (matches C struct)
@@ -276,11 +440,51 @@ export const STREAM_INFO_OFFSETS = {
   isAttachedPic: 340, // 4 bytes (int)
 };
 
+// MoviCueRef (movi_cues.c) as written by movi_get_cues_in_range: start,
+// end (doubles), then a wasm32 pointer to the cue text in the index's arena
+// and its byte length. Not NUL-terminated.
+export const CUE_REF_SIZE = 24;
+export const CUE_REF_OFFSETS = {
+  start: 0, // double
+  end: 8, // double
+  text: 16, // const char *
+  textLength: 20, // int
+};
+
+// MoviSubCue (movi_subs.c), one per event in a subtitle batch. Text offsets
+// are bytes into the batch's UTF-8 arena, where each cue's text is
+// NUL-terminated in cue order; rectFirst indexes the rect table (-1 = text).
+export const SUB_CUE_SIZE = 40;
+export const SUB_CUE_OFFSETS = {
+  start: 0, // double
+  end: 8, // double
+  style: 16, // int, movi_subtitle_style_name id or -1
+  textOffset: 20, // int
+  textLength: 24, // int
+  rectFirst: 28, // int
+  rectCount: 32, // int
+};
+
+// MoviSubRect (movi_subs.c): placement plus offsets into the batch's pixel
+// arena — w * h RGBA, or when palettized w * h indices and a 256-entry RGBA
+// palette. A palettized rect with dataOffset -1 reuses the indices of rect
+// `ref` of the previous bitmap cue.
+export const SUB_RECT_SIZE = 28;
+export const SUB_RECT_OFFSETS = {
+  x: 0,
+  y: 4,
+  width: 8,
+  height: 12,
+  dataOffset: 16, // int, -1 = same indices as `ref`
+  paletteOffset: 20, // int, -1 = RGBA rect
+  ref: 24, // int
+};
+
 // PacketInfo struct layout. Contains doubles (8-byte alignment). The trailing
-// ints is_idr(36)+is_rasl(40)+disposable(44) fill what was padding — the struct
-// stays 48 bytes (44 data was already padded to 48). Keep in sync with
+// ints is_idr(36)+is_rasl(40)+disposable(44) fill what was padding;
+// temporal_id(48) grows it to 52, padded to 56. Keep in sync with
 // sizeof(PacketInfo) in movi.h.
-export const PACKET_INFO_SIZE = 48;
+export const PACKET_INFO_SIZE = 56;
 export const PACKET_INFO_OFFSETS = {
   streamIndex: 0,
   keyframe: 4,
@@ -290,5 +494,6 @@ export const PACKET_INFO_OFFSETS = {
   size: 32,
   isIdr: 36, // int — occupies the padding after `size`
   isRasl: 40, // int
-  disposable: 44, // int — fills the final padding slot, size stays 48
+  disposable: 44, // int — fills the final padding slot
+  temporalId: 48, // int
 };
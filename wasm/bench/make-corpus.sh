@@ -0,0 +1,42 @@
+#!/bin/bash
+# Generate the benchmark corpus (wasm/bench/corpus.json) with a native ffmpeg
+# on the host: the emsdk build image has none. Needs libx265, libsvtav1 and
+# libx264 in that ffmpeg. Clips without a recipe (PGS) are listed for copying
+# in by hand. Existing files are kept; pass --force to regenerate them.
+#
+#   wasm/bench/make-corpus.sh [corpus-dir] [--force]
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+dir="$here/corpus"
+force=0
+for arg in "$@"; do
+    case "$arg" in
+        --force) force=1 ;;
+        *) dir=$arg ;;
+    esac
+done
+mkdir -p "$dir"
+
+FFMPEG=${FFMPEG:-ffmpeg}
+command -v "$FFMPEG" >/dev/null || { echo "ffmpeg not found (set FFMPEG=)"; exit 1; }
+
+# name<TAB>file<TAB>recipe, one line per clip ("-" for no recipe)
+node -e '
+  const c = require(process.argv[1]);
+  for (const clip of c.clips)
+    console.log([clip.name, clip.file, clip.recipe ?? "-"].join("\t"));
+' "$here/corpus.json" | while IFS=$'\t' read -r name file recipe; do
+    out="$dir/$file"
+    if [ -f "$out" ] && [ "$force" = "0" ]; then
+        echo "keep    $file"
+        continue
+    fi
+    if [ "$recipe" = "-" ]; then
+        echo "missing $file ($name has no recipe: copy one in by hand)"
+        continue
+    fi
+    echo "make    $file"
+    # shellcheck disable=SC2086 # the recipe is an argument list
+    "$FFMPEG" -nostdin -hide_banner -loglevel error -y $recipe "$out"
+done
@@ -0,0 +1,577 @@
+#!/usr/bin/env node
+// Headless benchmark of the WASM core over the reference corpus
+// (corpus.json). Drives the raw exports of a node-linked movi module the way
+// WasmBindings does, serving AVIO reads from the clip held in memory so the
+// numbers are CPU cost, not disk. build-ffmpeg.sh links that module with
+// MOVI_BUILD_BENCH=1 (simd flavor, MOVI_STATS on) and runs this script.
+//
+// Per clip: open time, demux packets/s through movi_read_frame, software
+// video decode fps, movi_decode_audio_batch samples/s, subtitle decode time,
+// seek latency with the bytes and reads each seek cost, thumbnail ms/frame.
+// Once per run: stretch realtime factor for 2 and 6 channels. Decode phases
+// replay packets demuxed up front, so they time the decoder alone. With an
+// instrumented module each phase also carries its movi_get_stats stage
+// totals.
+//
+// Prints JSON (or writes it to --out). With --baseline, metrics that moved
+// the wrong way by more than --threshold percent are listed under
+// "regressions", and --fail-on-regression makes them exit 2.
+//
+//   node movi_bench.mjs --module /tmp/movi-bench.mjs [--corpus dir]
+//       [--only name,...] [--out file] [--baseline file] [--threshold 10]
+//       [--fail-on-regression] [--max-frames 300] [--verbose]
+
+import { readFileSync, writeFileSync, existsSync, statSync } from 'fs';
+import { fileURLToPath, pathToFileURL } from 'url';
+import { dirname, join, resolve } from 'path';
+import { performance } from 'perf_hooks';
+
+const __dirname = dirname(fileURLToPath(import.meta.url));
+
+const BENCH_SCHEMA = 1;
+const EAGAIN = -6; // AVERROR(EAGAIN) under Emscripten
+const PACKET_INFO_SIZE = 56; // PacketInfo, movi.h
+const STREAM_INFO_SIZE = 344; // StreamInfo, see STREAM_INFO_OFFSETS in types.ts
+const PACKET_BUFFER_SIZE = 16 * 1024 * 1024;
+const AUDIO_BATCH = 64;
+const SEEK_POINTS = [0.5, 0.1, 0.9, 0.3, 0.7, 0.2, 0.8, 0.4, 0.6];
+const THUMB_POINTS = [0.1, 0.3, 0.5, 0.7, 0.9];
+// Stage order of MoviStage (movi.h)
+const STAGES = ['read', 'demux', 'classify', 'send', 'receive', 'resample', 'rgba', 'stretch', 'decrypt'];
+
+function parseArgs(argv) {
+  const args = {
+    module: '/tmp/movi-bench.mjs',
+    corpus: join(__dirname, 'corpus'),
+    only: null,
+    out: null,
+    baseline: null,
+    threshold: 10,
+    failOnRegression: false,
+    maxFrames: 300,
+    verbose: false,
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const a = argv[i];
+    const next = () => argv[++i];
+    if (a === '--module') args.module = next();
+    else if (a === '--corpus') args.corpus = next();
+    else if (a === '--only') args.only = next().split(',');
+    else if (a === '--out') args.out = next();
+    else if (a === '--baseline') args.baseline = next();
+    else if (a === '--threshold') args.threshold = Number(next());
+    else if (a === '--fail-on-regression') args.failOnRegression = true;
+    else if (a === '--max-frames') args.maxFrames = Number(next());
+    else if (a === '--verbose') args.verbose = true;
+    else throw new Error(`Unknown argument: ${a}`);
+  }
+  return args;
+}
+
+const round = (n, digits = 2) => (Number.isFinite(n) ? +n.toFixed(digits) : null);
+
+// ---- Module plumbing -------------------------------------------------------
+
+class Bench {
+  constructor(m) {
+    this.m = m;
+    this.data = null;
+    this.io = { reads: 0, bytes: 0 };
+    this.packetBuffer = m._malloc(PACKET_BUFFER_SIZE);
+    this.infoPtr = m._malloc(PACKET_INFO_SIZE);
+    this.statsSize = m._movi_stats_size?.() ?? 0;
+    this.statsPtr = this.statsSize ? m._malloc(this.statsSize) : 0;
+    const probe = m._movi_create();
+    this.instrumented = !!this.statsPtr && m._movi_get_stats(probe, this.statsPtr) === 1;
+    m._movi_destroy(probe);
+
+    // Same contract as WasmBindings.handleReadRequest / handleSeekRequest
+    m.onReadRequest = (offset, size) => {
+      const pending = m._pendingRead;
+      m._pendingRead = null;
+      const start = Number(offset);
+      const end = Math.min(start + size, this.data.length);
+      const n = Math.max(0, end - start);
+      if (n > 0) m.HEAPU8.set(this.data.subarray(start, end), pending.buffer);
+      this.io.reads++;
+      this.io.bytes += n;
+      pending.resolve(n);
+    };
+    m.onSeekRequest = (offset) => {
+      const pending = m._pendingSeek;
+      m._pendingSeek = null;
+      pending.resolve(typeof offset === 'bigint' ? offset : BigInt(offset));
+    };
+  }
+
+  load(data) {
+    this.data = data;
+    this.m._fileSize = BigInt(data.length);
+  }
+
+  view() {
+    // Re-created per use: memory growth detaches older views
+    return new DataView(this.m.HEAPU8.buffer);
+  }
+
+  call(name, ret, types, args) {
+    return this.m.ccall(name, ret, types, args, { async: true });
+  }
+
+  async openContext() {
+    const m = this.m;
+    const ctx = m._movi_create();
+    if (!ctx) throw new Error('movi_create failed');
+    const size = BigInt(this.data.length);
+    m._movi_set_file_size(ctx, Number(size & 0xffffffffn), Number(size >> 32n));
+    const t0 = performance.now();
+    const ret = await this.call('movi_open', 'number', ['number'], [ctx]);
+    const openMs = performance.now() - t0;
+    if (ret < 0) {
+      m._movi_destroy(ctx);
+      throw new Error(`movi_open failed: ${ret}`);
+    }
+    return { ctx, openMs };
+  }
+
+  streams(ctx) {
+    const m = this.m;
+    const ptr = m._malloc(STREAM_INFO_SIZE);
+    const out = [];
+    try {
+      const count = m._movi_get_stream_count(ctx);
+      for (let i = 0; i < count; i++) {
+        m.HEAPU8.fill(0, ptr, ptr + STREAM_INFO_SIZE);
+        if (m._movi_get_stream_info(ctx, i, ptr) < 0) continue;
+        const v = this.view();
+        const name = m.HEAPU8.slice(ptr + 12, ptr + 44);
+        out.push({
+          index: i,
+          type: ['video', 'audio', 'subtitle', 'unknown'][v.getInt32(ptr + 4, true)] ?? 'unknown',
+          codec: new TextDecoder().decode(name.slice(0, name.indexOf(0))),
+          width: v.getInt32(ptr + 44, true),
+          height: v.getInt32(ptr + 48, true),
+          channels: v.getInt32(ptr + 64, true),
+          sampleRate: v.getInt32(ptr + 68, true),
+          attachedPic: v.getInt32(ptr + 340, true) !== 0,
+        });
+      }
+    } finally {
+      m._free(ptr);
+    }
+    return out;
+  }
+
+  // One movi_read_frame: { stream, key, pts, dts, duration, data } or null
+  async readPacket(ctx, keep) {
+    const ret = await this.call(
+      'movi_read_frame', 'number',
+      ['number', 'number', 'number', 'number'],
+      [ctx, this.infoPtr, this.packetBuffer, PACKET_BUFFER_SIZE],
+    );
+    if (ret === 0) return null;
+    if (ret < 0) throw new Error(`movi_read_frame failed: ${ret}`);
+    const v = this.view();
+    const p = this.infoPtr;
+    const size = v.getInt32(p + 32, true);
+    const stream = v.getInt32(p, true);
+    return {
+      stream,
+      key: v.getInt32(p + 4, true) !== 0,
+      pts: v.getFloat64(p + 8, true),
+      dts: v.getFloat64(p + 16, true),
+      duration: v.getFloat64(p + 24, true),
+      size,
+      data: keep(stream)
+        ? this.m.HEAPU8.slice(this.packetBuffer, this.packetBuffer + size)
+        : null,
+    };
+  }
+
+  // Copy a packet payload into the shared packet buffer
+  place(data) {
+    this.m.HEAPU8.set(data, this.packetBuffer);
+    return this.packetBuffer;
+  }
+
+  resetStats(ctx) {
+    this.m._movi_reset_stats?.(ctx);
+  }
+
+  // Stage totals since the last resetStats; undefined without MOVI_STATS
+  stages(ctx) {
+    const m = this.m;
+    if (!this.instrumented || m._movi_get_stats(ctx, this.statsPtr) !== 1) return undefined;
+    const base = this.statsPtr;
+    const v = this.view();
+    const f = (i) => v.getFloat64(base + i * 8, true);
+    const counterCount = f(2);
+    const stageCount = f(3);
+    const stride = 3 + f(4);
+    const out = {};
+    for (let i = 0; i < Math.min(stageCount, STAGES.length); i++) {
+      const at = 6 + counterCount + i * stride;
+      const count = f(at);
+      if (count > 0) {
+        out[STAGES[i]] = { count, total_ms: round(f(at + 1)), max_ms: round(f(at + 2), 3) };
+      }
+    }
+    out.bytes = { read: f(6), demuxed: f(7), discarded: f(8) };
+    return out;
+  }
+}
+
+// ---- Phases ----------------------------------------------------------------
+
+async function benchDemux(b, ctx, wanted) {
+  b.resetStats(ctx);
+  const keep = (i) => wanted.has(i);
+  const packets = new Map([...wanted].map((i) => [i, []]));
+  const io0 = { ...b.io };
+  let count = 0;
+  let bytes = 0;
+  const t0 = performance.now();
+  for (;;) {
+    const pkt = await b.readPacket(ctx, keep);
+    if (!pkt) break;
+    count++;
+    bytes += pkt.size;
+    if (pkt.data) packets.get(pkt.stream).push(pkt);
+  }
+  const seconds = (performance.now() - t0) / 1000;
+  return {
+    result: {
+      packets: count,
+      packets_per_s: round(count / seconds, 0),
+      mb_per_s: round(bytes / 1048576 / seconds),
+      reads: b.io.reads - io0.reads,
+      stages: b.stages(ctx),
+    },
+    packets,
+  };
+}
+
+async function benchVideo(b, ctx, stream, packets, maxFrames) {
+  const m = b.m;
+  if (m._movi_enable_decoder(ctx, stream.index, 0, 0) < 0) return { skipped: 'decoder' };
+  b.resetStats(ctx);
+  let frames = 0;
+  const receive = () => {
+    let n = 0;
+    while (m._movi_receive_frame(ctx, stream.index) === 0) n++;
+    return n;
+  };
+  const t0 = performance.now();
+  for (const pkt of packets) {
+    if (frames >= maxFrames) break;
+    const ptr = b.place(pkt.data);
+    let ret = m._movi_send_packet(ctx, stream.index, ptr, pkt.size, pkt.pts, pkt.dts, pkt.key ? 1 : 0);
+    if (ret === EAGAIN) {
+      frames += receive();
+      ret = m._movi_send_packet(ctx, stream.index, ptr, pkt.size, pkt.pts, pkt.dts, pkt.key ? 1 : 0);
+    }
+    if (ret < 0 && ret !== EAGAIN) break;
+    frames += receive();
+  }
+  const seconds = (performance.now() - t0) / 1000;
+  return {
+    codec: stream.codec,
+    width: stream.width,
+    height: stream.height,
+    frames,
+    fps: round(frames / seconds, 1),
+    stages: b.stages(ctx),
+  };
+}
+
+async function benchAudio(b, ctx, stream, packets) {
+  const m = b.m;
+  if (m._movi_enable_decoder(ctx, stream.index, 0, 0) < 0) return { skipped: 'decoder' };
+  const maxBytes = packets.reduce((a, p) => Math.max(a, p.size), 0) * AUDIO_BATCH;
+  const blob = m._malloc(maxBytes);
+  const sizes = m._malloc(AUDIO_BATCH * 4);
+  const ptss = m._malloc(AUDIO_BATCH * 8);
+  b.resetStats(ctx);
+  let samples = 0;
+  let calls = 0;
+  const t0 = performance.now();
+  try {
+    for (let i = 0; i < packets.length; ) {
+      const batch = packets.slice(i, i + AUDIO_BATCH);
+      let offset = 0;
+      const v = b.view();
+      batch.forEach((p, j) => {
+        m.HEAPU8.set(p.data, blob + offset);
+        offset += p.size;
+        v.setInt32(sizes + j * 4, p.size, true);
+        v.setFloat64(ptss + j * 8, p.pts, true);
+      });
+      const consumed = m._movi_decode_audio_batch(ctx, stream.index, blob, sizes, ptss, batch.length);
+      calls++;
+      if (consumed <= 0) break;
+      samples += m._movi_audio_batch_samples(ctx);
+      i += consumed;
+    }
+  } finally {
+    m._free(blob);
+    m._free(sizes);
+    m._free(ptss);
+  }
+  const seconds = (performance.now() - t0) / 1000;
+  return {
+    codec: stream.codec,
+    channels: stream.channels,
+    batches: calls,
+    samples,
+    samples_per_s: round(samples / seconds, 0),
+    realtime: stream.sampleRate > 0 ? round(samples / stream.sampleRate / seconds, 1) : null,
+    stages: b.stages(ctx),
+  };
+}
+
+async function benchSubtitle(b, ctx, stream, packets) {
+  const m = b.m;
+  if (m._movi_enable_decoder(ctx, stream.index, 0, 0) < 0) return { skipped: 'decoder' };
+  let decoded = 0;
+  const t0 = performance.now();
+  for (const pkt of packets) {
+    const ptr = b.place(pkt.data);
+    const ret = await b.call(
+      'movi_decode_subtitle', 'number',
+      ['number', 'number', 'number', 'number', 'number', 'number'],
+      [ctx, stream.index, ptr, pkt.size, pkt.pts, pkt.duration],
+    );
+    if (ret === 0) decoded++;
+    m._movi_free_subtitle(ctx);
+  }
+  const ms = performance.now() - t0;
+  return {
+    codec: stream.codec,
+    packets: packets.length,
+    decoded,
+    ms_per_packet: packets.length ? round(ms / packets.length, 3) : null,
+  };
+}
+
+// Seek to each point and read up to the first packet of the target stream
+async function benchSeek(b, ctx, streamIndex) {
+  const duration = b.m._movi_get_duration(ctx);
+  if (!(duration > 0)) return { skipped: 'duration' };
+  b.resetStats(ctx);
+  const times = [];
+  const bytes = [];
+  const reads = [];
+  for (const at of SEEK_POINTS) {
+    const io0 = { ...b.io };
+    const t0 = performance.now();
+    const ret = await b.call(
+      'movi_seek_to', 'number',
+      ['number', 'number', 'number', 'number'],
+      [ctx, duration * at, -1, 1],
+    );
+    if (ret < 0) continue;
+    for (;;) {
+      const pkt = await b.readPacket(ctx, () => false);
+      if (!pkt || streamIndex < 0 || pkt.stream === streamIndex) break;
+    }
+    times.push(performance.now() - t0);
+    bytes.push(b.io.bytes - io0.bytes);
+    reads.push(b.io.reads - io0.reads);
+  }
+  if (!times.length) return { skipped: 'seek' };
+  const mean = (a) => a.reduce((s, x) => s + x, 0) / a.length;
+  return {
+    seeks: times.length,
+    mean_ms: round(mean(times)),
+    max_ms: round(Math.max(...times)),
+    mean_bytes: round(mean(bytes), 0),
+    max_bytes: Math.max(...bytes),
+    mean_reads: round(mean(reads), 1),
+    stages: b.stages(ctx),
+  };
+}
+
+async function benchThumbnail(b, duration) {
+  const m = b.m;
+  if (!(duration > 0)) return { skipped: 'duration' };
+  const size = BigInt(b.data.length);
+  const tctx = m._movi_thumbnail_create(Number(size & 0xffffffffn), Number(size >> 32n));
+  if (!tctx) return { skipped: 'create' };
+  try {
+    if ((await b.call('movi_thumbnail_open', 'number', ['number'], [tctx])) !== 0) {
+      return { skipped: 'open' };
+    }
+    let frames = 0;
+    const t0 = performance.now();
+    for (const at of THUMB_POINTS) {
+      let packetSize = -1;
+      // Same callback contract as ThumbnailBindings.callKeyframeExport
+      m._pendingThumbnail = { resolve: (r) => { packetSize = r.size; } };
+      await b.call('movi_thumbnail_read_keyframe', 'void', ['number', 'number'], [tctx, duration * at]);
+      m._pendingThumbnail = null;
+      if (packetSize > 0 && m._movi_thumbnail_decode_frame(tctx, 320, 180)) frames++;
+    }
+    const ms = performance.now() - t0;
+    return { frames, ms_per_frame: frames ? round(ms / frames) : null };
+  } finally {
+    m._movi_thumbnail_destroy(tctx);
+  }
+}
+
+// Mirrors stretch_bench.cpp through the module's exports: 30s of noise at
+// 1.25x tempo in 512-frame output chunks
+function benchStretch(m) {
+  const sampleRate = 48000;
+  const outChunk = 512;
+  const tempo = 1.25;
+  const inChunk = Math.round(outChunk * tempo);
+  const results = [];
+  for (const channels of [2, 6]) {
+    const inPtr = m._malloc(inChunk * channels * 4);
+    const outPtr = m._malloc(outChunk * channels * 4);
+    const input = new Float32Array(m.HEAPU8.buffer, inPtr, inChunk * channels);
+    let seed = 1;
+    for (let i = 0; i < input.length; i++) {
+      seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+      input[i] = (seed / 0x7fffffff) * 2 - 1;
+    }
+    const h = m._movi_stretch_new(channels, sampleRate);
+    for (let i = 0; i < 32; i++) m._movi_stretch_process(h, inPtr, inChunk, outPtr, outChunk);
+    const chunks = Math.floor((30 * sampleRate) / inChunk);
+    const t0 = performance.now();
+    for (let i = 0; i < chunks; i++) m._movi_stretch_process(h, inPtr, inChunk, outPtr, outChunk);
+    const seconds = (performance.now() - t0) / 1000;
+    m._movi_stretch_delete(h);
+    m._free(inPtr);
+    m._free(outPtr);
+    results.push({ channels, realtime: round((chunks * inChunk) / sampleRate / seconds, 1) });
+  }
+  return results;
+}
+
+async function benchClip(b, clip, data, args) {
+  b.load(data);
+  const { ctx, openMs } = await b.openContext();
+  try {
+    const streams = b.streams(ctx);
+    const video = streams.find((s) => s.type === 'video' && !s.attachedPic);
+    const audio = streams.find((s) => s.type === 'audio');
+    const subtitle = streams.find((s) => s.type === 'subtitle');
+    const wanted = new Set([video, audio, subtitle].filter(Boolean).map((s) => s.index));
+
+    const result = {
+      file: clip.file,
+      bytes: data.length,
+      streams: streams.map((s) => `${s.index}:${s.type}/${s.codec}`),
+      open_ms: round(openMs),
+    };
+    const demux = await benchDemux(b, ctx, wanted);
+    result.demux = demux.result;
+    if (video) result.video_decode = await benchVideo(b, ctx, video, demux.packets.get(video.index), args.maxFrames);
+    if (audio) result.audio_decode = await benchAudio(b, ctx, audio, demux.packets.get(audio.index));
+    if (subtitle) result.subtitle_decode = await benchSubtitle(b, ctx, subtitle, demux.packets.get(subtitle.index));
+    result.seek = await benchSeek(b, ctx, (video ?? audio)?.index ?? -1);
+    result.thumbnail = video ? await benchThumbnail(b, b.m._movi_get_duration(ctx)) : { skipped: 'no video' };
+    return result;
+  } finally {
+    b.m._movi_destroy(ctx);
+  }
+}
+
+// ---- Baseline comparison ---------------------------------------------------
+
+// Metrics compared against a baseline, and which direction is better
+const HIGHER_IS_BETTER = ['packets_per_s', 'mb_per_s', 'fps', 'samples_per_s', 'realtime'];
+const LOWER_IS_BETTER = ['open_ms', 'mean_ms', 'max_ms', 'ms_per_frame', 'ms_per_packet', 'mean_bytes', 'mean_reads'];
+
+function compare(current, baseline, threshold) {
+  const regressions = [];
+  const walk = (cur, base, path) => {
+    if (!cur || !base || typeof cur !== 'object') return;
+    for (const [key, value] of Object.entries(cur)) {
+      if (key === 'stages') continue; // breakdown, not a gate
+      const old = base[key];
+      const here = Array.isArray(cur) ? `${path}[${key}]` : path ? `${path}.${key}` : key;
+      if (typeof value === 'object') {
+        walk(value, old, here);
+        continue;
+      }
+      if (typeof value !== 'number' || typeof old !== 'number' || old === 0) continue;
+      const higher = HIGHER_IS_BETTER.includes(key);
+      if (!higher && !LOWER_IS_BETTER.includes(key)) continue;
+      const change = ((value - old) / old) * 100;
+      if ((higher && change < -threshold) || (!higher && change > threshold)) {
+        regressions.push({ metric: here, baseline: old, current: value, change_pct: round(change, 1) });
+      }
+    }
+  };
+  walk(current.clips, baseline.clips, 'clips');
+  walk(current.stretch, baseline.stretch, 'stretch');
+  return regressions;
+}
+
+// ---- Main ------------------------------------------------------------------
+
+const args = parseArgs(process.argv.slice(2));
+const log = console.log;
+// The module's own logging (library_movi.js) would corrupt the JSON on stdout
+if (!args.verbose) console.log = () => {};
+const progress = (msg) => process.stderr.write(`${msg}\n`);
+
+const modulePath = resolve(args.module);
+if (!existsSync(modulePath)) {
+  progress(`Module not found: ${modulePath} (build with MOVI_BUILD_BENCH=1)`);
+  process.exit(1);
+}
+const { default: createMoviModule } = await import(pathToFileURL(modulePath).href);
+const m = await createMoviModule();
+m._movi_set_log_level?.(-8); // AV_LOG_QUIET
+const b = new Bench(m);
+
+const corpus = JSON.parse(readFileSync(join(__dirname, 'corpus.json'), 'utf8'));
+const report = {
+  schema: BENCH_SCHEMA,
+  corpus_version: corpus.version,
+  node: process.version,
+  instrumented: b.instrumented,
+  clips: {},
+  stretch: null,
+};
+
+for (const clip of corpus.clips) {
+  if (args.only && !args.only.includes(clip.name)) continue;
+  const path = join(args.corpus, clip.file);
+  if (!existsSync(path) || !statSync(path).isFile()) {
+    report.clips[clip.name] = { file: clip.file, skipped: 'missing' };
+    progress(`skip  ${clip.name} (${clip.file} not in ${args.corpus})`);
+    continue;
+  }
+  progress(`bench ${clip.name}`);
+  try {
+    report.clips[clip.name] = await benchClip(b, clip, readFileSync(path), args);
+  } catch (e) {
+    report.clips[clip.name] = { file: clip.file, error: String(e?.message ?? e) };
+  }
+}
+if (!args.only || args.only.includes('stretch')) {
+  progress('bench stretch');
+  report.stretch = typeof m._movi_stretch_new === 'function' ? benchStretch(m) : null;
+}
+
+if (args.baseline) {
+  const baseline = JSON.parse(readFileSync(args.baseline, 'utf8'));
+  report.baseline = args.baseline;
+  report.threshold_pct = args.threshold;
+  report.regressions = compare(report, baseline, args.threshold);
+}
+
+const json = JSON.stringify(report, null, 2);
+if (args.out) writeFileSync(args.out, `${json}\n`);
+else log(json);
+
+if (report.regressions?.length) {
+  for (const r of report.regressions) {
+    progress(`regression ${r.metric}: ${r.baseline} -> ${r.current} (${r.change_pct}%)`);
+  }
+  if (args.failOnRegression) process.exit(2);
+}
@@ -0,0 +1,64 @@
+// movi_stretch_process throughput, per channel count. Links movi_stretch.cpp
+// directly (no FFmpeg), so the same source measures the scalar and SIMD128
+// FFT backends: build-ffmpeg.sh compiles it twice with MOVI_BUILD_BENCH=1 and
+// runs both under node.
+//
+// Feeds 30s of noise through a stretcher in 512-frame output chunks at 1.25x
+// tempo and prints one line per channel count: seconds of audio stretched per
+// wall-clock second, overall and per channel.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+int movi_stretch_new(int channels, float sampleRate);
+void movi_stretch_delete(int handle);
+void movi_stretch_process(int handle, const float *in, int inFrames,
+                          float *out, int outFrames);
+}
+
+namespace {
+
+const float kSampleRate = 48000.0f;
+const int kSeconds = 30;
+const int kOutChunk = 512;
+const float kTempo = 1.25f;
+
+double benchChannels(int channels) {
+    const int inChunk = static_cast<int>(kOutChunk * kTempo);
+    std::vector<float> in(static_cast<size_t>(inChunk) * channels);
+    std::vector<float> out(static_cast<size_t>(kOutChunk) * channels);
+    srand(1);
+    for (auto &s : in) s = static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f;
+
+    const int handle = movi_stretch_new(channels, kSampleRate);
+    // Warm-up: first blocks allocate and fill the analysis history
+    for (int i = 0; i < 32; ++i) {
+        movi_stretch_process(handle, in.data(), inChunk, out.data(), kOutChunk);
+    }
+
+    const int chunks = static_cast<int>(kSeconds * kSampleRate / inChunk);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < chunks; ++i) {
+        movi_stretch_process(handle, in.data(), inChunk, out.data(), kOutChunk);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    movi_stretch_delete(handle);
+
+    // Input seconds consumed per wall-clock second
+    return (static_cast<double>(chunks) * inChunk / kSampleRate) / elapsed.count();
+}
+
+} // anonymous
+
+int main() {
+    const int counts[] = {1, 2, 6, 8};
+    for (int channels : counts) {
+        const double realtime = benchChannels(channels);
+        printf("channels=%d realtime=%.1fx per_channel=%.1fx\n",
+               channels, realtime, realtime * channels);
+    }
+    return 0;
+}
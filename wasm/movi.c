@@ -90,6 +90,8 @@ EM_JS(int64_t, js_get_file_size, (void), {
 // files >= 2GB
 static int avio_read_callback(void *opaque, uint8_t *buf, int buf_size) {
   MoviContext *ctx = (MoviContext *)opaque;
+  if (ctx->live)
+    return movi_live_read(ctx, buf, buf_size);
   // Split int64_t position into two 32-bit parts for JavaScript BigInt
   // reconstruction Use unsigned casts to avoid sign extension issues with
   // values >= 2GB
@@ -101,8 +103,17 @@ static int avio_read_callback(void *opaque, uint8_t *buf, int buf_size) {
   // unsigned BigInt
   int offset_low = (int)position_low;
   int offset_high = (int)position_high;
+  MOVI_STAT_START(t0);
   int bytes_read = js_read_async(buf, offset_low, offset_high, buf_size);
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_READ, t0);
   if (bytes_read > 0) {
+    // Encrypted source: ciphertext landed straight in the AVIO buffer
+    if (ctx->crypt) {
+      MOVI_STAT_START(t1);
+      movi_crypt_apply(ctx, buf, bytes_read, ctx->position);
+      MOVI_STAT_STOP(ctx, MOVI_STAGE_DECRYPT, t1);
+    }
+    MOVI_STAT_ADD(ctx, MOVI_COUNTER_BYTES_READ, bytes_read);
     // Use int64_t arithmetic to ensure correct handling of large positions
     ctx->position += (int64_t)bytes_read;
   } else if (bytes_read == 0) {
@@ -153,6 +164,9 @@ MoviContext *movi_create(void) {
     return NULL;
   }
   ctx->avio_buffer_size = 524288; // 512KB buffer for fewer JS callbacks
+  ctx->read_limit_stream = -1;
+  ctx->shed_stream = -1;
+  movi_budget_register(ctx);
   return ctx;
 }
 
@@ -173,7 +187,17 @@ EMSCRIPTEN_KEEPALIVE
 void movi_destroy(MoviContext *ctx) {
   if (!ctx)
     return;
+  movi_budget_unregister(ctx);
+  movi_pipeline_stop(ctx);
   movi_abatch_free(ctx);
+  movi_send_pool_free(ctx);
+  movi_frame_handles_free(ctx);
+  movi_packet_ring_free(ctx);
+  movi_seek_index_free(ctx);
+  movi_probe_free(ctx);
+  movi_cue_index_free(ctx);
+  movi_sub_batch_free(ctx);
+  movi_tonemap_free(ctx);
   if (ctx->fmt_ctx)
     avformat_close_input(&ctx->fmt_ctx);
   if (ctx->avio_ctx) {
@@ -186,18 +210,19 @@ void movi_destroy(MoviContext *ctx) {
     if (ctx->fmt_ctx) {
       for (int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
         if (ctx->decoders[i])
-          avcodec_free_context(&ctx->decoders[i]);
+          movi_decoder_free(&ctx->decoders[i]);
         if (ctx->resamplers && ctx->resamplers[i])
           swr_free(&ctx->resamplers[i]);
       }
     }
     free(ctx->decoders);
+    free(ctx->decoder_evicted);
     if (ctx->resamplers)
       free(ctx->resamplers);
   }
   if (ctx->subtitle) {
     avsubtitle_free(ctx->subtitle);
-    av_freep(&ctx->subtitle);
+    ctx->subtitle = NULL;
   }
   if (ctx->prefetched_cues) {
     for (int i = 0; i < ctx->prefetched_cue_count; i++) {
@@ -217,8 +242,10 @@ void movi_destroy(MoviContext *ctx) {
     sws_freeContext(ctx->sws_ctx);
   if (ctx->rgb_frame)
     av_frame_free(&ctx->rgb_frame);
-  if (ctx->rgb_buffer)
-    av_free(ctx->rgb_buffer);
+  movi_stats_free(ctx);
+  movi_classifiers_free(ctx);
+  movi_live_free(ctx);
+  movi_crypt_free(ctx);
   free(ctx);
 }
 
@@ -230,9 +257,11 @@ int movi_open(MoviContext *ctx) {
   ctx->avio_buffer = av_malloc(ctx->avio_buffer_size);
   if (!ctx->avio_buffer)
     return -2;
+  // Live feeds can't seek: no seek callback, so FFmpeg never tries
   ctx->avio_ctx =
       avio_alloc_context(ctx->avio_buffer, ctx->avio_buffer_size, 0, ctx,
-                         avio_read_callback, NULL, avio_seek_callback);
+                         avio_read_callback, NULL,
+                         ctx->live ? NULL : avio_seek_callback);
   if (!ctx->avio_ctx) {
     av_free(ctx->avio_buffer);
     return -3;
@@ -247,23 +276,40 @@ int movi_open(MoviContext *ctx) {
   ctx->fmt_ctx->pb = ctx->avio_ctx;
   ctx->fmt_ctx->probesize = 10 * 1024 * 1024;
   ctx->fmt_ctx->max_analyze_duration = 5 * AV_TIME_BASE;
+  if (ctx->live)
+    movi_live_configure(ctx);
 
   int ret = avformat_open_input(&ctx->fmt_ctx, NULL, NULL, NULL);
   if (ret < 0)
     return ret;
   
+  // A descriptor from an earlier open of this file stands in for the probe
+  // when the header agrees with it (movi_probe.c)
+  if (ctx->probe_blob &&
+      movi_probe_apply(ctx->fmt_ctx, ctx->file_size, ctx->probe_blob,
+                       ctx->probe_size) == 0) {
+    ctx->probe_applied = 1;
+    av_log(NULL, AV_LOG_DEBUG, "Stream descriptor matched, skipping probe\n");
+  }
+  movi_probe_free(ctx);
+
   // Try to find stream info, but don't fail hard if it returns error (e.g. no PTS found)
   // This allows playing files where probing failed but streams might be usable
-  int info_ret = avformat_find_stream_info(ctx->fmt_ctx, NULL);
-  if (info_ret < 0) {
-      av_log(NULL, AV_LOG_WARNING, "avformat_find_stream_info failed: %d, continuing anyway\n", info_ret);
+  if (!ctx->probe_applied) {
+    int info_ret = avformat_find_stream_info(ctx->fmt_ctx, NULL);
+    if (info_ret < 0) {
+        av_log(NULL, AV_LOG_WARNING, "avformat_find_stream_info failed: %d, continuing anyway\n", info_ret);
+    }
   }
   ctx->decoders = (AVCodecContext **)calloc(ctx->fmt_ctx->nb_streams,
                                             sizeof(AVCodecContext *));
+  ctx->decoder_evicted = (uint8_t *)calloc(ctx->fmt_ctx->nb_streams, 1);
   ctx->resamplers =
       (SwrContext **)calloc(ctx->fmt_ctx->nb_streams, sizeof(SwrContext *));
   ctx->frame = av_frame_alloc();
   ctx->resampled_frame = av_frame_alloc();
+  // Codec and extradata are known now: pick each stream's packet classifier
+  movi_classifiers_init(ctx);
   return ctx->fmt_ctx->nb_streams;
 }
 
@@ -89,9 +89,28 @@ typedef struct {
   // JS drops these before WebCodecs on the hardware/software-in-browser path
   // when the renderer reports the device can't sustain the source rate. Fills
   // the 4 padding bytes after is_rasl, so sizeof(PacketInfo) stays 48.
+  // Also set for H.264 nal_ref_idc == 0 slices and HEVC sub-layer
+  // non-reference pictures at the highest temporal layer (movi_nal.c).
   int disposable;
+  // Temporal sub-layer of the picture (movi_nal.c): HEVC/VVC TemporalId, AV1
+  // temporal_id, H.264 SVC temporal_id; 0 for streams without layering. Bumps
+  // sizeof(PacketInfo) 48 -> 56; PACKET_INFO_SIZE in types.ts must match.
+  int temporal_id;
 } PacketInfo;
 
+// Packet ring slot (movi_read_frame_ref / movi_packet_release). Holds the
+// demuxer's AVPacket reference while JS views the payload in place; `own` is a
+// slot-owned copy used only when bytes must be prepended (AV1 TD), with
+// MOVI_PACKET_HEADROOM bytes reserved in front of the payload.
+#define MOVI_PACKET_SLOTS 64
+#define MOVI_PACKET_HEADROOM 16
+typedef struct {
+  AVPacket *pkt;
+  uint8_t *own;
+  int own_capacity;
+  int in_use;
+} MoviPacketSlot;
+
 // Prefetched subtitle cue (populated by movi_prefetch_subtitle_cues).
 // Used for negative subtitle delay where the renderer needs cues from
 // future stream positions before the demuxer would naturally deliver them.
@@ -101,6 +120,54 @@ typedef struct {
   char *text; // null-terminated, malloc-owned
 } PrefetchedSubCue;
 
+// Decoded frames JS may hold at once via movi_frame_retain
+#define MOVI_FRAME_HANDLES 8
+
+// Persistent seek index state (movi_index.c), opaque outside that file.
+typedef struct MoviSeekIndex MoviSeekIndex;
+
+// Incremental subtitle cue index (movi_cues.c), opaque outside that file.
+typedef struct MoviCueIndex MoviCueIndex;
+
+// Batched subtitle decode output (movi_subs.c), opaque outside that file.
+typedef struct MoviSubBatch MoviSubBatch;
+
+// High-bit-depth RGBA conversion tables (movi_tonemap.c), opaque outside that
+// file.
+typedef struct MoviToneMap MoviToneMap;
+
+// Software video decode run-ahead threads (movi_pipeline.c), opaque outside
+// that file.
+typedef struct MoviPipeline MoviPipeline;
+
+// Per-stage counters and latency histograms (movi_stats.c), opaque outside
+// that file. Only allocated in builds with -DMOVI_STATS.
+typedef struct MoviStats MoviStats;
+
+// Per-stream packet classifier picked at movi_open (movi_nal.c), opaque
+// outside that file.
+typedef struct MoviClassifier MoviClassifier;
+
+// Packet classification (movi_nal.c). movi_classify_packet fills every field
+// from one pass over the packet's NAL units / OBUs with the stream's
+// classifier. is_idr: a true random-access picture (IDR/BLA in HEVC, IDR in
+// H.264/VVC, a shown key frame in AV1), also 1 when the codec isn't parsed or
+// no slice was found (trust the container flag). is_rasl: HEVC RASL_N/R, VVC
+// RASL. disposable: no other picture references it.
+typedef struct {
+  int is_idr;
+  int is_rasl;
+  int disposable;
+  int temporal_id;
+} MoviPacketClass;
+
+// Pushed live-feed bytes (movi_live.c), opaque outside that file.
+typedef struct MoviLive MoviLive;
+
+// AES-256-CTR session for encrypted sources (movi_crypt.c), opaque outside
+// that file.
+typedef struct MoviCrypt MoviCrypt;
+
 // Demuxer context with custom AVIO
 typedef struct {
   AVFormatContext *fmt_ctx;
@@ -111,20 +178,72 @@ typedef struct {
   int64_t file_size; // Total file size
   int avio_buffer_size;
 
-  // Decoding support
+  // Zero-copy packet ring (movi_streams.c). Lazily allocated on the first
+  // movi_read_frame_ref; freed in movi_destroy.
+  MoviPacketSlot *pkt_slots;
+  int pkt_slot_next;
+  // 1 when ctx->pkt holds a packet movi_read_frames read but couldn't fit;
+  // the next read of any kind returns it first.
+  int pkt_pending;
+  // ctx->pkt's classification, from the one movi_classify_packet pass
+  // movi_next_packet makes per demuxed video packet; load shedding, layer
+  // dropping and PacketInfo all read it. is_idr 1, the rest 0 for other media.
+  MoviPacketClass pkt_class;
+  // movi_set_read_frames_limit: per-call packet cap for one stream (-1 = off)
+  int read_limit_stream;
+  int read_limit_packets;
+
+  // Load shedding (movi_shed.c): stream under control (-1 = off), current
+  // tier, consecutive over/under-budget windows, windows of headroom needed to
+  // step down, whether the last change was a step down, packets dropped.
+  int shed_stream;
+  int shed_tier;
+  int shed_over;
+  int shed_under;
+  int shed_backoff;
+  int shed_last_down;
+  int shed_dropped;
+
+  // Seek index being built (movi_index_begin) or imported (movi_index_import).
+  // NULL when neither; freed in movi_destroy.
+  MoviSeekIndex *seek_index;
+
+  // Stream descriptor handed over by movi_probe_import, consumed (and freed)
+  // by movi_open; probe_applied is 1 when the open used it instead of probing.
+  uint8_t *probe_blob;
+  int probe_size;
+  int probe_applied;
+
+  // Decoding support. decoder_evicted[i] is 1 while stream i's decoder is
+  // closed by movi_trim; the next keyframe sent to it reopens it.
   AVCodecContext **decoders;
+  uint8_t *decoder_evicted;
   SwrContext **resamplers;
   AVFrame *frame;
   AVFrame *resampled_frame;
-  AVSubtitle *subtitle;                 // For subtitle decoding
+  AVSubtitle *subtitle;                 // For subtitle decoding (&subtitle_store or NULL)
+  AVSubtitle subtitle_store;            // Reused across movi_decode_subtitle calls
   double last_subtitle_packet_duration; // Store packet duration for fallback
   int downmix_to_stereo;
+
+  // Software video decoder threading (movi_set_decoder_threads). Only honoured
+  // by the pthreads build (movi-mt.wasm); the single-threaded build always opens
+  // decoders with thread_count=1. <= 1 (the calloc default) = single-threaded.
+  // Clamped below the build's PTHREAD_POOL_SIZE (MOVI_DECODER_MAX_THREADS):
+  // workers can't be spawned while JS is blocked inside a decode call.
+  int decoder_threads;
+  int decoder_thread_type; // FF_THREAD_FRAME | FF_THREAD_SLICE bitmask, 0 = both
   
-  // RGB conversion support (for 10-bit HDR to 8-bit RGBA)
+  // RGB conversion support (for 10-bit HDR to 8-bit RGBA). rgb_buffer is
+  // borrowed from the module-wide scratch (movi_scratch_rgba) and only valid
+  // until the next conversion on any context; rgb_buffer_size is the current
+  // frame's byte size.
   struct SwsContext *sws_ctx;
   AVFrame *rgb_frame;
   uint8_t *rgb_buffer;
   int rgb_buffer_size;
+  MoviToneMap *tonemap; // 10/12-bit tables, freed in movi_destroy
+  int hdr_tonemap;      // movi_set_hdr_tonemap: PQ/HLG → SDR in RGBA output
 
   // Prefetched subtitle cues (lazy — populated on demand for non-zero
   // subtitle delay). Owned by the context; freed in movi_destroy.
@@ -132,6 +251,14 @@ typedef struct {
   int prefetched_cue_count;
   int prefetched_cue_capacity;
 
+  // Cue index being built (movi_cues_begin) or imported (movi_cues_import).
+  // NULL when neither; freed in movi_destroy.
+  MoviCueIndex *cue_index;
+
+  // Cue table from the last movi_decode_subtitle_batch, reused across calls
+  // and freed in movi_destroy.
+  MoviSubBatch *sub_batch;
+
   // ---- Batched audio decode accumulation --------------------------------
   // Decoding one packet per JS→WASM round-trip is fine for AAC (1024 frames a
   // packet ≈ 47 packets/s) but brutal for TrueHD/MLP, whose access unit is only
@@ -141,24 +268,265 @@ typedef struct {
   // second of audio, and it's the per-packet overhead — not the decode math —
   // that starves the renderer after a seek. movi_decode_audio_batch decodes many
   // packets in a single call and accumulates the PCM here, so JS makes one copy
-  // per channel for the whole batch. Owned by the context; freed in movi_destroy.
-  float **abatch;        // abatch_channels contiguous planes
-  int abatch_channels;   // channels the planes were allocated for
-  int abatch_capacity;   // samples each plane can hold
+  // per channel for the whole batch. The planes live in the module-wide
+  // scratch block (movi_scratch_planes) and are only valid until the next
+  // batch on any context; the pointer array is the context's, freed in
+  // movi_destroy.
+  float **abatch;        // abatch_channels planes, abatch_capacity apart
+  int abatch_channels;   // channels the planes were laid out for
+  int abatch_capacity;   // samples each plane can hold (0 = not laid out)
   int abatch_nb_samples; // samples currently accumulated
   int abatch_sample_rate;
   double abatch_pts;   // pts (seconds) of the first accumulated frame
   int abatch_has_pts;  // 0 until the first frame lands
+  // movi_decode_audio_batch_stretch: output frames the stretcher produced from
+  // this block, 0 when it wasn't stretched (JS then reads the planes above)
+  int abatch_stretched_frames;
+
+  // ---- Pooled decoder input (movi_decode.c) -----------------------------
+  // movi_send_packet / movi_decode_subtitle used to allocate an AVPacket and a
+  // fresh payload buffer per call; at TrueHD rates (~1200 packets/s) or 60 fps
+  // software video that is thousands of small dlmalloc round-trips a second,
+  // fragmenting the fixed WASM heap. One packet shell is reused and payloads
+  // come from an AVBufferPool: a buffer returns to the pool once the decoder
+  // drops its reference, so frame-threaded decoders that hold packets stay
+  // safe. The pool's buffer size only grows (powers of two, padding included);
+  // payloads over 1MB are allocated one-off instead.
+  AVPacket *send_pkt;
+  AVBufferPool *send_pool;
+  int send_pool_size;
+
+  // ---- Retained frame handles (movi_frame.c) ----------------------------
+  // ctx->frame is overwritten by the next movi_receive_frame, so JS had to copy
+  // every plane out before decoding on. movi_frame_retain takes a reference to
+  // the decoded frame instead: its pooled buffers stay alive (and HEAPU8 views
+  // of them valid) until movi_frame_release. Slot i is handle i + 1.
+  AVFrame *frame_handles[MOVI_FRAME_HANDLES];
+
+  // Decode/convert threads running one video stream's decoder
+  // (movi_pipeline_start); NULL when it decodes inline. Stopped in
+  // movi_destroy.
+  MoviPipeline *pipeline;
+
+  // Hot-path instrumentation (movi_stats.c); NULL until the first sample, and
+  // always NULL without MOVI_STATS. Freed in movi_destroy.
+  MoviStats *stats;
+
+  // One packet classifier per stream (movi_classifiers_init, at movi_open),
+  // grown for streams that appear later. Freed in movi_destroy.
+  MoviClassifier *classifiers;
+  int classifier_count;
+  // Streams with a movi_set_max_temporal_layer limit; 0 skips the check
+  int layer_limits;
+
+  // Live ingest FIFO (movi_set_live, before movi_open); NULL for file
+  // playback. Freed in movi_destroy.
+  MoviLive *live;
+
+  // Encrypted source keyed for in-place CTR decryption (movi_set_ctr_key);
+  // NULL when reads arrive as plaintext. Freed in movi_destroy.
+  MoviCrypt *crypt;
 } MoviContext;
 
 // Release the batched-audio accumulation planes (called from movi_destroy).
 void movi_abatch_free(MoviContext *ctx);
 
+// Release the pooled input packet and its buffer pool (called from movi_destroy).
+void movi_send_pool_free(MoviContext *ctx);
+
+// Point the (unreferenced) `pkt` at a copy of `size` bytes of `data` from the
+// send pool (movi_decode.c); NULL/0 leaves it empty. Returns 0, -1 on OOM.
+// The JS thread only: the pipeline's decode thread just drops references.
+int movi_packet_fill_pooled(MoviContext *ctx, AVPacket *pkt,
+                            const uint8_t *data, int size);
+
+// Signalsmith planar entry points (movi_stretch.cpp, extern "C")
+int movi_stretch_process_planar(int handle, const float *const *in,
+                                int inChannels, int inFrames, int outFrames);
+int movi_stretch_channels(int handle);
+
+// Video decoder output pool (movi_frame.c): movi_frame_pool_attach installs a
+// get_buffer2 serving 64-byte-aligned planes from an AVBufferPool, before
+// avcodec_open2; movi_decoder_free frees a decoder together with its pool.
+// movi_frame_handles_free drops every retained frame handle.
+int movi_frame_pool_attach(AVCodecContext *c);
+void movi_decoder_free(AVCodecContext **c);
+void movi_frame_handles_free(MoviContext *ctx);
+
+// Release the zero-copy packet ring and any packets it still holds.
+void movi_packet_ring_free(MoviContext *ctx);
+
+// Drop the packet movi_read_frames held back (movi_streams.c). Anything that
+// repositions fmt_ctx must call it first.
+void movi_drop_pending_packet(MoviContext *ctx);
+
+// Packet classification (movi_nal.c); MoviPacketClass is declared above
+// MoviContext.
+int movi_classifiers_init(MoviContext *ctx);
+void movi_classifiers_free(MoviContext *ctx);
+void movi_classify_packet(MoviContext *ctx, const AVPacket *pkt,
+                          MoviPacketClass *out);
+// 1 when a demuxed packet (classified as `cls`) is above its stream's
+// temporal-layer limit and must be dropped (movi_set_max_temporal_layer)
+int movi_layer_drop(MoviContext *ctx, const AVPacket *pkt,
+                    const MoviPacketClass *cls);
+
+// Live ingest (movi_live.c). movi_live_read serves avio_read_callback from the
+// pushed bytes, movi_live_configure applies the low-latency open settings,
+// movi_live_starved ends a live movi_read_frames batch, movi_live_free is
+// called from movi_destroy.
+int movi_live_read(MoviContext *ctx, uint8_t *buf, int size);
+void movi_live_configure(MoviContext *ctx);
+int movi_live_starved(MoviContext *ctx);
+void movi_live_free(MoviContext *ctx);
+double movi_live_memory(MoviContext *ctx);
+
+// Encrypted-source decryption (movi_crypt.c). movi_crypt_apply decrypts an
+// AVIO read in place at its file offset while a CTR key is set
+// (movi_set_ctr_key); movi_crypt_free wipes the key, called from movi_destroy.
+void movi_crypt_apply(MoviContext *ctx, uint8_t *buf, int size,
+                      int64_t offset);
+void movi_crypt_free(MoviContext *ctx);
+
+// Seek index (movi_index.c). movi_index_apply validates an exported index
+// against fmt_ctx and adds its entries to the stream (count, or < 0);
+// movi_index_seek_target moves an AV_TIME_BASE target back to the nearest
+// IDR entry when the imported index has CRA keyframes.
+void movi_seek_index_free(MoviContext *ctx);
+int movi_index_apply(AVFormatContext *fmt_ctx, int64_t file_size,
+                     const uint8_t *blob, int size);
+int64_t movi_index_seek_target(MoviContext *ctx, int64_t target);
+
+// Cached stream descriptors (movi_probe.c). movi_probe_apply validates an
+// exported descriptor against a header-only fmt_ctx and completes its streams
+// from it (0, or < 0 to probe as usual); movi_probe_free drops an imported
+// descriptor that no open consumed (called from movi_destroy).
+int movi_probe_apply(AVFormatContext *fmt_ctx, int64_t file_size,
+                     const uint8_t *blob, int size);
+void movi_probe_free(MoviContext *ctx);
+
+// Release the subtitle cue index (movi_cues.c, called from movi_destroy).
+void movi_cue_index_free(MoviContext *ctx);
+
+// Release the batched subtitle cue table (movi_subs.c, called from movi_destroy).
+void movi_sub_batch_free(MoviContext *ctx);
+
+// Load shedding (movi_shed.c). movi_shed_drop: 1 when the demuxed packet
+// (classified as `cls`) must be dropped before it's returned
+// (movi_next_packet); movi_shed_apply: apply the current tier to a decoder
+// just opened (movi_enable_decoder).
+int movi_shed_drop(MoviContext *ctx, const AVPacket *pkt,
+                   const MoviPacketClass *cls);
+void movi_shed_apply(MoviContext *ctx, int stream_index);
+
+// Shared module memory (movi_budget.c). Contexts register in movi_create and
+// unregister in movi_destroy. movi_scratch_rgba returns the module-wide RGBA
+// buffer grown to `size`; movi_scratch_planes lays `planes` float planes
+// `stride` samples apart in the shared audio block, carrying the first `keep`
+// samples of each over from a previous `old_stride` layout. Both return NULL
+// on allocation failure.
+void movi_budget_register(MoviContext *ctx);
+void movi_budget_unregister(MoviContext *ctx);
+uint8_t *movi_scratch_rgba(int size);
+float *movi_scratch_planes(int planes, int stride, int old_stride, int keep);
+void movi_scratch_release(void);
+
+// Decoder frame pool accounting for movi_trim (movi_frame.c): bytes the
+// decoder's pool has allocated, and dropping its idle buffers.
+size_t movi_frame_pool_bytes(const AVCodecContext *c);
+void movi_frame_pool_trim(AVCodecContext *c);
+
+// Bytes of one context's tone-mapping tables (movi_tonemap.c).
+size_t movi_tonemap_size(void);
+
+// Decode run-ahead (movi_pipeline.c). movi_pipeline_owns: 1 while a pipeline
+// thread drives stream_index's decoder, which must then not be flushed, freed
+// or trimmed directly; movi_pipeline_stop is called from movi_destroy.
+// movi_pipeline_set_discard queues skip_frame / skip_loop_filter for such a
+// decoder (MOVI_DISCARD_KEEP leaves one as it is), applied by its decode
+// thread before the next packet; 0 when no pipeline owns the stream and the
+// caller may set them itself.
+#define MOVI_DISCARD_KEEP ((enum AVDiscard)-1)
+int movi_pipeline_owns(const MoviContext *ctx, int stream_index);
+int movi_pipeline_set_discard(MoviContext *ctx, int stream_index,
+                              enum AVDiscard skip_frame,
+                              enum AVDiscard skip_loop_filter);
+void movi_pipeline_flush(MoviContext *ctx);
+void movi_pipeline_stop(MoviContext *ctx);
+
+// Instrumentation (movi_stats.c). Stages are the timed hot paths, counters
+// the byte/packet totals; both index the snapshot movi_get_stats returns, so
+// append new entries at the end. MOVI_STAT_START/STOP time a stage around a
+// call, MOVI_STAT_ADD bumps a counter; all three vanish without MOVI_STATS.
+#define MOVI_STATS_BUCKETS 16
+typedef enum {
+  MOVI_STAGE_READ,     // js_read_async: one Asyncify suspension per call
+  MOVI_STAGE_DEMUX,    // av_read_frame for movi_read_frame(s), READ, CLASSIFY in it
+  MOVI_STAGE_CLASSIFY, // movi_classify_packet on demuxed video packets
+  MOVI_STAGE_SEND,     // avcodec_send_packet
+  MOVI_STAGE_RECEIVE,  // avcodec_receive_frame
+  MOVI_STAGE_RESAMPLE, // swr_convert
+  MOVI_STAGE_RGBA,     // movi_get_frame_rgba conversion
+  MOVI_STAGE_STRETCH,  // movi_stretch_process_planar from a decoded batch
+  MOVI_STAGE_DECRYPT,  // movi_crypt_apply on an encrypted AVIO read
+  MOVI_STAGE_COUNT
+} MoviStage;
+typedef enum {
+  MOVI_COUNTER_BYTES_READ,      // bytes js_read_async delivered
+  MOVI_COUNTER_BYTES_DEMUXED,   // AVIO bytes av_read_frame consumed
+  MOVI_COUNTER_BYTES_DISCARDED, // ...of which no returned packet carried
+  MOVI_COUNTER_PACKETS,         // packets returned to movi_read_frame(s)
+  MOVI_COUNTER_COUNT
+} MoviCounter;
+void movi_stats_free(MoviContext *ctx);
+#ifdef MOVI_STATS
+void movi_stats_record(MoviContext *ctx, MoviStage stage, double ms);
+void movi_stats_add(MoviContext *ctx, MoviCounter counter, double n);
+#define MOVI_STAT_START(t) double t = emscripten_get_now()
+#define MOVI_STAT_STOP(ctx, stage, t)                                        \
+  movi_stats_record((ctx), (stage), emscripten_get_now() - (t))
+#define MOVI_STAT_ADD(ctx, counter, n) movi_stats_add((ctx), (counter), (n))
+#else
+#define MOVI_STAT_START(t) ((void)0)
+#define MOVI_STAT_STOP(ctx, stage, t) ((void)0)
+#define MOVI_STAT_ADD(ctx, counter, n) ((void)0)
+#endif
+
+// Convert a SUBTITLE_BITMAP rect's palettized pixels to w*h RGBA at `dst`
+// (movi_decode.c). Returns 0, or -1 when the rect has no pixels or palette.
+int movi_subtitle_rect_rgba(const AVSubtitleRect *rect, uint8_t *dst);
+
+// SIMD YUV420P → RGBA (movi_yuv.c). Returns 0 when it converted the frame at
+// its native size, -1 when the caller must fall back to sws_scale (non-SIMD
+// build or unsupported pixel format/range).
+int movi_yuv420p_to_rgba(const AVFrame *src, uint8_t *dst, int dst_linesize);
+
+// 10/12-bit planar YUV → RGBA (movi_tonemap.c), honouring the frame's matrix,
+// range and (with hdr_tonemap) transfer. Returns 0 when it converted the frame
+// at native or exactly half size, -1 when the caller must fall back to
+// sws_scale. movi_tonemap_convert does the same with tables of the caller's
+// own (allocated on first use, av_freep them), for a converting thread that
+// mustn't share ctx->tonemap. movi_tonemap_free is called from movi_destroy.
+int movi_tonemap_to_rgba(MoviContext *ctx, const AVFrame *src, uint8_t *dst,
+                         int dst_linesize, int width, int height);
+int movi_tonemap_convert(MoviToneMap **tables, int hdr_tonemap,
+                         const AVFrame *src, uint8_t *dst, int dst_linesize,
+                         int width, int height);
+void movi_tonemap_free(MoviContext *ctx);
+
 // Defined in movi_decode.c; movi_decode_audio_batch drives these internally.
 EMSCRIPTEN_KEEPALIVE int movi_send_packet(MoviContext *ctx, int stream_index,
                                           uint8_t *data, int size, double pts,
                                           double dts, int keyframe);
 EMSCRIPTEN_KEEPALIVE int movi_receive_frame(MoviContext *ctx, int stream_index);
+EMSCRIPTEN_KEEPALIVE int movi_get_subtitle_text(MoviContext *ctx, char *buffer,
+                                                int buffer_size);
+EMSCRIPTEN_KEEPALIVE int movi_decode_subtitle(MoviContext *ctx, int stream_index,
+                                              uint8_t *data, int size, double pts,
+                                              double duration);
+EMSCRIPTEN_KEEPALIVE int movi_get_subtitle_times(MoviContext *ctx, double *start,
+                                                 double *end);
+EMSCRIPTEN_KEEPALIVE void movi_free_subtitle(MoviContext *ctx);
 
 EMSCRIPTEN_KEEPALIVE double movi_get_start_time(MoviContext *ctx);
 EMSCRIPTEN_KEEPALIVE int movi_get_format_name(MoviContext *ctx, char *buffer, int buffer_size);
@@ -0,0 +1,206 @@
+#include "movi.h"
+#include <emscripten/heap.h>
+#include <malloc.h>
+
+// ---- Shared module memory --------------------------------------------------
+// Several players can sit in one module (loadWasmModule is a singleton), and
+// each MoviContext used to keep its own RGBA frame buffer (8MB at 1080p),
+// batched-audio planes and a 512KB AVIO buffer, grow-only, for its lifetime.
+// On a page with a grid of players that is a heap that only ever climbs.
+//
+// What can be shared is shared here. The RGBA buffer and the audio batch
+// planes are scratch: movi_get_frame_rgba and movi_decode_audio_batch fill
+// them and JS copies them out before making any other call into the module
+// (VideoFrame / AudioData construction), so one module-wide buffer of each
+// serves every context. The AVIO buffer holds a context's read-ahead and
+// can't be shared; instead JS sizes it per context (movi_set_avio_buffer_size)
+// from how many contexts the module carries.
+//
+// Under pressure JS calls movi_trim on idle contexts: level 1 drops what is
+// rebuilt on demand (scaler, conversion tables, pooled packet buffers, idle
+// decoder frame buffers), level 2 also evicts the audio/video decoders, which
+// reopen on the next keyframe sent to them (movi_decode.c). Per-context and
+// module-wide usage is reported by movi_context_memory / movi_module_memory.
+
+#define MOVI_AVIO_MIN (32 * 1024)
+#define MOVI_AVIO_MAX (1024 * 1024)
+
+static MoviContext **budget_contexts;
+static int budget_count;
+static int budget_capacity;
+
+static uint8_t *scratch_rgba;
+static unsigned int scratch_rgba_size;
+static float *scratch_planes;
+static size_t scratch_planes_count; // floats
+
+void movi_budget_register(MoviContext *ctx) {
+  if (budget_count == budget_capacity) {
+    int cap = budget_capacity ? budget_capacity * 2 : 8;
+    MoviContext **list = realloc(budget_contexts, cap * sizeof(*list));
+    if (!list)
+      return; // unlisted contexts still work, they just aren't counted
+    budget_contexts = list;
+    budget_capacity = cap;
+  }
+  budget_contexts[budget_count++] = ctx;
+}
+
+void movi_budget_unregister(MoviContext *ctx) {
+  for (int i = 0; i < budget_count; i++) {
+    if (budget_contexts[i] == ctx) {
+      budget_contexts[i] = budget_contexts[--budget_count];
+      break;
+    }
+  }
+  if (budget_count == 0) {
+    // Last context gone: nothing can be borrowing the scratch buffers
+    movi_scratch_release();
+  }
+}
+
+uint8_t *movi_scratch_rgba(int size) {
+  av_fast_malloc(&scratch_rgba, &scratch_rgba_size, size);
+  return scratch_rgba;
+}
+
+float *movi_scratch_planes(int planes, int stride, int old_stride, int keep) {
+  size_t count = (size_t)planes * stride;
+  if (count <= scratch_planes_count && (keep == 0 || stride == old_stride))
+    return scratch_planes;
+  if (count < scratch_planes_count)
+    count = scratch_planes_count;
+  float *block = malloc(count * sizeof(float));
+  if (!block)
+    return NULL;
+  // Carry the samples accumulated so far over to the new layout
+  for (int i = 0; i < planes && keep > 0; i++)
+    memcpy(block + (size_t)i * stride,
+           scratch_planes + (size_t)i * old_stride, keep * sizeof(float));
+  free(scratch_planes);
+  scratch_planes = block;
+  scratch_planes_count = count;
+  return block;
+}
+
+// Free the shared RGBA and audio scratch; they regrow on the next use. Any
+// pointer JS got from movi_get_frame_rgba / movi_audio_batch_plane is invalid
+// afterwards, as it would be after the next conversion anyway.
+EMSCRIPTEN_KEEPALIVE
+void movi_scratch_release(void) {
+  av_freep(&scratch_rgba);
+  scratch_rgba_size = 0;
+  free(scratch_planes);
+  scratch_planes = NULL;
+  scratch_planes_count = 0;
+  for (int i = 0; i < budget_count; i++) {
+    budget_contexts[i]->rgb_buffer = NULL;
+    budget_contexts[i]->rgb_buffer_size = 0;
+    budget_contexts[i]->abatch_capacity = 0;
+    budget_contexts[i]->abatch_nb_samples = 0;
+  }
+}
+
+// AVIO buffer for the next movi_open (bytes, clamped to 32KB..1MB). Smaller
+// buffers mean more js_read_async round-trips per byte, so JS only shrinks it
+// once the module carries several contexts.
+EMSCRIPTEN_KEEPALIVE
+void movi_set_avio_buffer_size(MoviContext *ctx, int size) {
+  if (!ctx || ctx->avio_ctx || ctx->live)
+    return; // live contexts keep their small buffer (movi_live.c)
+  if (size < MOVI_AVIO_MIN)
+    size = MOVI_AVIO_MIN;
+  if (size > MOVI_AVIO_MAX)
+    size = MOVI_AVIO_MAX;
+  ctx->avio_buffer_size = size;
+}
+
+// Heap bytes this context holds that it doesn't share: AVIO buffer, pooled
+// input packets, decoder frame pools, conversion tables, packets JS still
+// holds from the zero-copy ring. Decoders that bring their own picture pool
+// (libdav1d) and codec-internal state aren't visible here, so this is the
+// floor of the context's footprint rather than an exact figure.
+EMSCRIPTEN_KEEPALIVE
+double movi_context_memory(MoviContext *ctx) {
+  if (!ctx)
+    return 0;
+  double bytes = ctx->avio_buffer_size + ctx->send_pool_size;
+  bytes += movi_live_memory(ctx);
+  if (ctx->tonemap)
+    bytes += movi_tonemap_size();
+  if (ctx->fmt_ctx && ctx->decoders) {
+    for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+      if (ctx->decoders[i])
+        bytes += (double)movi_frame_pool_bytes(ctx->decoders[i]);
+    }
+  }
+  if (ctx->pkt_slots) {
+    for (int i = 0; i < MOVI_PACKET_SLOTS; i++) {
+      const MoviPacketSlot *slot = &ctx->pkt_slots[i];
+      bytes += slot->own_capacity;
+      if (slot->in_use && slot->pkt)
+        bytes += slot->pkt->size;
+    }
+  }
+  return bytes;
+}
+
+// Module-wide figures into out[4]: heap size, bytes allocated (malloc's view,
+// all contexts plus FFmpeg's own state), shared scratch bytes, live contexts.
+EMSCRIPTEN_KEEPALIVE
+void movi_module_memory(double *out) {
+  if (!out)
+    return;
+  struct mallinfo mi = mallinfo();
+  out[0] = (double)emscripten_get_heap_size();
+  out[1] = (double)(unsigned int)mi.uordblks;
+  out[2] = (double)scratch_rgba_size +
+           (double)scratch_planes_count * sizeof(float);
+  out[3] = budget_count;
+}
+
+// Release memory an idle context can live without. Level 1: scaler, RGB frame,
+// HDR tables, pooled input packets, idle decoder frame buffers, the subtitle
+// batch table. Level 2 also closes the audio and video decoders; each reopens
+// with the next keyframe sent to it, so a resumed context shows nothing new
+// until the next GOP. Subtitle decoders stay: some were opened with extradata
+// only JS has. Returns the bytes released, as movi_context_memory counts them.
+EMSCRIPTEN_KEEPALIVE
+double movi_trim(MoviContext *ctx, int level) {
+  if (!ctx || level <= 0)
+    return 0;
+  double before = movi_context_memory(ctx);
+  if (ctx->sws_ctx) {
+    sws_freeContext(ctx->sws_ctx);
+    ctx->sws_ctx = NULL;
+  }
+  if (ctx->rgb_frame)
+    av_frame_free(&ctx->rgb_frame);
+  movi_tonemap_free(ctx);
+  movi_send_pool_free(ctx);
+  movi_sub_batch_free(ctx);
+  if (ctx->fmt_ctx && ctx->decoders) {
+    for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+      AVCodecContext *dec = ctx->decoders[i];
+      if (!dec)
+        continue;
+      if (movi_pipeline_owns(ctx, i)) {
+        // Driven by a pipeline thread: only the mutex-guarded pool is safe
+        movi_frame_pool_trim(dec);
+        continue;
+      }
+      enum AVMediaType type = ctx->fmt_ctx->streams[i]->codecpar->codec_type;
+      if (level >= 2 && ctx->decoder_evicted &&
+          (type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_AUDIO)) {
+        movi_decoder_free(&ctx->decoders[i]);
+        if (ctx->resamplers && ctx->resamplers[i])
+          swr_free(&ctx->resamplers[i]);
+        ctx->decoder_evicted[i] = 1;
+      } else {
+        movi_frame_pool_trim(dec);
+      }
+    }
+  }
+  double released = before - movi_context_memory(ctx);
+  return released > 0 ? released : 0;
+}
@@ -0,0 +1,242 @@
+#include "movi.h"
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+// ---- In-place AES-256-CTR for encrypted sources --------------------------
+// EncryptedHttpSource used to decrypt every 2MB block in JS (WebCrypto
+// AES-GCM, one promise per frame) and hand plaintext to js_read_async, which
+// copied it into the AVIO buffer again. At high bitrates that promise churn
+// was the ceiling. With a CTR session (movi_set_ctr_key) the source passes
+// ciphertext straight through instead, and avio_read_callback decrypts it in
+// place in avio_buffer right after js_read_async lands it.
+//
+// The counter block is the session's 8-byte nonce followed by the 64-bit
+// big-endian index of the 16-byte block at the absolute file offset, so any
+// offset decrypts without touching what came before it: a seek is just a new
+// starting counter. The same key + nonce layout is what the server encrypts
+// with and what WebCrypto's AES-CTR (length 64) takes.
+//
+// AES itself is the classic four-table round (wasm has no AES instructions);
+// the SIMD build XORs the keystream sixteen bytes at a time. The key is only
+// ever encrypted with, so there's no decryption key schedule.
+
+// Keystream generated per pass (blocks), so the XOR runs over a warm buffer
+#define MOVI_CTR_BATCH 64
+
+struct MoviCrypt {
+  uint32_t rk[60]; // AES-256 encryption key schedule
+  uint8_t nonce[8];
+};
+
+static const uint8_t aes_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b,
+    0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+    0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26,
+    0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2,
+    0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+    0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed,
+    0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f,
+    0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+    0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec,
+    0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14,
+    0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+    0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d,
+    0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f,
+    0x4b, 0xbd, 0x8b, 0x8a, 0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+    0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+    0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f,
+    0xb0, 0x54, 0xbb, 0x16};
+
+// Round tables, built from the S-box on first use (4KB)
+static uint32_t aes_te[4][256];
+static int aes_tables_ready;
+
+static void aes_init_tables(void) {
+  for (int i = 0; i < 256; i++) {
+    uint32_t s = aes_sbox[i];
+    uint32_t s2 = ((s << 1) ^ ((s & 0x80) ? 0x1b : 0)) & 0xff;
+    uint32_t t = (s2 << 24) | (s << 16) | (s << 8) | (s2 ^ s);
+    aes_te[0][i] = t;
+    aes_te[1][i] = (t >> 8) | (t << 24);
+    aes_te[2][i] = (t >> 16) | (t << 16);
+    aes_te[3][i] = (t >> 24) | (t << 8);
+  }
+  aes_tables_ready = 1;
+}
+
+static inline uint32_t load_be32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static inline uint32_t sub_word(uint32_t w) {
+  return ((uint32_t)aes_sbox[w >> 24] << 24) |
+         ((uint32_t)aes_sbox[(w >> 16) & 0xff] << 16) |
+         ((uint32_t)aes_sbox[(w >> 8) & 0xff] << 8) | aes_sbox[w & 0xff];
+}
+
+static void aes256_expand(uint32_t rk[60], const uint8_t key[32]) {
+  static const uint8_t rcon[7] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40};
+  for (int i = 0; i < 8; i++)
+    rk[i] = load_be32(key + 4 * i);
+  for (int i = 8; i < 60; i++) {
+    uint32_t t = rk[i - 1];
+    if (i % 8 == 0)
+      t = sub_word((t << 8) | (t >> 24)) ^ ((uint32_t)rcon[i / 8 - 1] << 24);
+    else if (i % 8 == 4)
+      t = sub_word(t);
+    rk[i] = rk[i - 8] ^ t;
+  }
+}
+
+static void aes256_encrypt(const uint32_t rk[60], const uint8_t in[16],
+                           uint8_t out[16]) {
+  uint32_t s0 = load_be32(in) ^ rk[0];
+  uint32_t s1 = load_be32(in + 4) ^ rk[1];
+  uint32_t s2 = load_be32(in + 8) ^ rk[2];
+  uint32_t s3 = load_be32(in + 12) ^ rk[3];
+  for (int r = 1; r < 14; r++) {
+    const uint32_t *k = rk + 4 * r;
+    uint32_t t0 = aes_te[0][s0 >> 24] ^ aes_te[1][(s1 >> 16) & 0xff] ^
+                  aes_te[2][(s2 >> 8) & 0xff] ^ aes_te[3][s3 & 0xff] ^ k[0];
+    uint32_t t1 = aes_te[0][s1 >> 24] ^ aes_te[1][(s2 >> 16) & 0xff] ^
+                  aes_te[2][(s3 >> 8) & 0xff] ^ aes_te[3][s0 & 0xff] ^ k[1];
+    uint32_t t2 = aes_te[0][s2 >> 24] ^ aes_te[1][(s3 >> 16) & 0xff] ^
+                  aes_te[2][(s0 >> 8) & 0xff] ^ aes_te[3][s1 & 0xff] ^ k[2];
+    uint32_t t3 = aes_te[0][s3 >> 24] ^ aes_te[1][(s0 >> 16) & 0xff] ^
+                  aes_te[2][(s1 >> 8) & 0xff] ^ aes_te[3][s2 & 0xff] ^ k[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+  // Last round: SubBytes + ShiftRows, no MixColumns
+  const uint32_t *k = rk + 56;
+  store_be32(out, (((uint32_t)aes_sbox[s0 >> 24] << 24) |
+                   ((uint32_t)aes_sbox[(s1 >> 16) & 0xff] << 16) |
+                   ((uint32_t)aes_sbox[(s2 >> 8) & 0xff] << 8) |
+                   aes_sbox[s3 & 0xff]) ^
+                      k[0]);
+  store_be32(out + 4, (((uint32_t)aes_sbox[s1 >> 24] << 24) |
+                       ((uint32_t)aes_sbox[(s2 >> 16) & 0xff] << 16) |
+                       ((uint32_t)aes_sbox[(s3 >> 8) & 0xff] << 8) |
+                       aes_sbox[s0 & 0xff]) ^
+                          k[1]);
+  store_be32(out + 8, (((uint32_t)aes_sbox[s2 >> 24] << 24) |
+                       ((uint32_t)aes_sbox[(s3 >> 16) & 0xff] << 16) |
+                       ((uint32_t)aes_sbox[(s0 >> 8) & 0xff] << 8) |
+                       aes_sbox[s1 & 0xff]) ^
+                          k[2]);
+  store_be32(out + 12, (((uint32_t)aes_sbox[s3 >> 24] << 24) |
+                        ((uint32_t)aes_sbox[(s0 >> 16) & 0xff] << 16) |
+                        ((uint32_t)aes_sbox[(s1 >> 8) & 0xff] << 8) |
+                        aes_sbox[s2 & 0xff]) ^
+                           k[3]);
+}
+
+// Keystream for `count` consecutive blocks starting at block index `block`
+static void ctr_keystream(const MoviCrypt *c, uint64_t block, uint8_t *ks,
+                          int count) {
+  uint8_t ctr[16];
+  memcpy(ctr, c->nonce, 8);
+  for (int i = 0; i < count; i++, block++) {
+    store_be32(ctr + 8, (uint32_t)(block >> 32));
+    store_be32(ctr + 12, (uint32_t)block);
+    aes256_encrypt(c->rk, ctr, ks + 16 * i);
+  }
+}
+
+static void xor_bytes(uint8_t *dst, const uint8_t *ks, int n) {
+  int i = 0;
+#ifdef __wasm_simd128__
+  for (; i + 16 <= n; i += 16) {
+    v128_t d = wasm_v128_load(dst + i);
+    wasm_v128_store(dst + i, wasm_v128_xor(d, wasm_v128_load(ks + i)));
+  }
+#else
+  for (; i + 8 <= n; i += 8) {
+    uint64_t d, k;
+    memcpy(&d, dst + i, 8);
+    memcpy(&k, ks + i, 8);
+    d ^= k;
+    memcpy(dst + i, &d, 8);
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] ^= ks[i];
+}
+
+// Key the context's CTR session (32-byte key, 8-byte nonce), or end it with
+// key == NULL so reads pass through untouched. Takes effect from the next
+// AVIO read; JS copies the key in from a scratch buffer it wipes afterwards.
+EMSCRIPTEN_KEEPALIVE
+int movi_set_ctr_key(MoviContext *ctx, const uint8_t *key,
+                     const uint8_t *nonce) {
+  if (!ctx)
+    return -1;
+  if (!key) {
+    movi_crypt_free(ctx);
+    return 0;
+  }
+  if (!nonce)
+    return -1;
+  if (!ctx->crypt) {
+    ctx->crypt = (MoviCrypt *)calloc(1, sizeof(MoviCrypt));
+    if (!ctx->crypt)
+      return -1;
+  }
+  if (!aes_tables_ready)
+    aes_init_tables();
+  aes256_expand(ctx->crypt->rk, key);
+  memcpy(ctx->crypt->nonce, nonce, 8);
+  return 0;
+}
+
+// Decrypt `size` bytes read from absolute file offset `offset`, in place
+// (avio_read_callback). CTR is symmetric, so this is also the encryption.
+void movi_crypt_apply(MoviContext *ctx, uint8_t *buf, int size,
+                      int64_t offset) {
+  const MoviCrypt *c = ctx->crypt;
+  uint8_t ks[16 * MOVI_CTR_BATCH];
+  uint64_t block = (uint64_t)offset >> 4;
+  int skip = (int)(offset & 15);
+  while (size > 0) {
+    int blocks = (skip + size + 15) >> 4;
+    if (blocks > MOVI_CTR_BATCH)
+      blocks = MOVI_CTR_BATCH;
+    ctr_keystream(c, block, ks, blocks);
+    int n = blocks * 16 - skip;
+    if (n > size)
+      n = size;
+    xor_bytes(buf, ks + skip, n);
+    buf += n;
+    size -= n;
+    block += blocks;
+    skip = 0;
+  }
+}
+
+void movi_crypt_free(MoviContext *ctx) {
+  if (ctx && ctx->crypt) {
+    // Don't leave the key schedule behind in the heap
+    volatile uint8_t *p = (volatile uint8_t *)ctx->crypt;
+    for (size_t i = 0; i < sizeof(MoviCrypt); i++)
+      p[i] = 0;
+    free(ctx->crypt);
+    ctx->crypt = NULL;
+  }
+}
@@ -0,0 +1,489 @@
+#include "movi.h"
+
+// ---- Incremental subtitle cue index ---------------------------------------
+// movi_prefetch_subtitle_cues scans the whole file in one call on the playback
+// context: JS has to quiesce playback, the scan blocks until EOF, and each cue
+// is a separate strdup. This is the seek index's model instead (movi_index.c):
+// JS opens a dedicated context, movi_cues_begin discards every other stream,
+// and movi_cues_step decodes a bounded slice of the file per call, yielding
+// between calls, so the pass runs behind playback and can be abandoned.
+//
+// Cue text lives in one arena, interned: repeated lines (karaoke, signs,
+// "♪") are stored once. Cues are kept sorted by start with a running maximum
+// of end times, which makes movi_get_cues_in_range a binary search plus a scan
+// over the hits. movi_cues_export / movi_cues_import serialise the index so JS
+// can persist it next to the seek index and load it into the playback context.
+//
+// MPEG-TS can't skip a discarded stream's bytes — the demuxer still reads
+// every TS packet, and av_read_frame only returns once a kept stream completes
+// a PES, which for a sparse subtitle stream can be most of the file. There the
+// other streams stay enabled so each av_read_frame returns promptly, and the
+// step's byte budget is what bounds it.
+
+#define MOVI_CUES_MAGIC 0x5543564d // "MVCU"
+#define MOVI_CUES_VERSION 1
+
+typedef struct {
+  double start_sec;
+  double end_sec;
+  int32_t text_off; // into the arena
+  int32_t text_len;
+} MoviCue;
+
+// movi_get_cues_in_range output; text points into the arena and stays valid
+// until the next movi_cues_step / movi_cues_import / movi_destroy.
+typedef struct {
+  double start_sec;
+  double end_sec;
+  const char *text; // not NUL-terminated
+  int32_t text_len;
+} MoviCueRef;
+
+typedef struct {
+  int32_t magic;
+  int32_t version;
+  int32_t stream_index;
+  int32_t codec_id;
+  int64_t file_size;
+  int32_t count;
+  int32_t arena_size;
+} MoviCuesHeader;
+
+struct MoviCueIndex {
+  int stream_index;
+  int mpegts;
+  int done;
+  int64_t last_pos;
+
+  MoviCue *cues;
+  int count;
+  int capacity;
+  int sorted;   // cues ascending by start_sec
+  double *max_end; // max_end[i] = max end_sec of cues[0..i]
+  int max_end_count; // valid prefix of max_end
+
+  char *arena;
+  int arena_size;
+  int arena_capacity;
+
+  // Intern table: open addressing on the text hash, slots hold arena
+  // offset/length (off -1 = empty). Load factor kept under 1/2.
+  int32_t *intern_off;
+  int32_t *intern_len;
+  int intern_capacity;
+  int intern_used;
+};
+
+void movi_cue_index_free(MoviContext *ctx) {
+  if (!ctx || !ctx->cue_index)
+    return;
+  MoviCueIndex *idx = ctx->cue_index;
+  free(idx->cues);
+  free(idx->max_end);
+  free(idx->arena);
+  free(idx->intern_off);
+  free(idx->intern_len);
+  free(idx);
+  ctx->cue_index = NULL;
+}
+
+static MoviCueIndex *movi_cue_index_reset(MoviContext *ctx, int stream_index) {
+  movi_cue_index_free(ctx);
+  MoviCueIndex *idx = (MoviCueIndex *)calloc(1, sizeof(MoviCueIndex));
+  if (!idx)
+    return NULL;
+  idx->stream_index = stream_index;
+  idx->sorted = 1;
+  ctx->cue_index = idx;
+  return idx;
+}
+
+static uint32_t movi_cue_hash(const char *s, int len) {
+  uint32_t h = 2166136261u; // FNV-1a
+  for (int i = 0; i < len; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// Slot for text: the matching entry, or the empty slot to insert it at.
+static int movi_cue_intern_slot(MoviCueIndex *idx, const char *text, int len) {
+  uint32_t mask = (uint32_t)idx->intern_capacity - 1;
+  uint32_t slot = movi_cue_hash(text, len) & mask;
+  while (idx->intern_off[slot] >= 0) {
+    if (idx->intern_len[slot] == len &&
+        memcmp(idx->arena + idx->intern_off[slot], text, len) == 0)
+      break;
+    slot = (slot + 1) & mask;
+  }
+  return (int)slot;
+}
+
+static int movi_cue_intern_grow(MoviCueIndex *idx) {
+  int old_capacity = idx->intern_capacity;
+  int32_t *old_off = idx->intern_off;
+  int32_t *old_len = idx->intern_len;
+  int capacity = old_capacity ? old_capacity * 2 : 256;
+  int32_t *off = (int32_t *)malloc(capacity * sizeof(int32_t));
+  int32_t *len = (int32_t *)malloc(capacity * sizeof(int32_t));
+  if (!off || !len) {
+    free(off);
+    free(len);
+    return AVERROR(ENOMEM);
+  }
+  memset(off, 0xff, capacity * sizeof(int32_t)); // -1
+  idx->intern_off = off;
+  idx->intern_len = len;
+  idx->intern_capacity = capacity;
+  for (int i = 0; i < old_capacity; i++) {
+    if (old_off[i] < 0)
+      continue;
+    int slot = movi_cue_intern_slot(idx, idx->arena + old_off[i], old_len[i]);
+    idx->intern_off[slot] = old_off[i];
+    idx->intern_len[slot] = old_len[i];
+  }
+  free(old_off);
+  free(old_len);
+  return 0;
+}
+
+// Arena offset of text, appending it the first time it's seen (< 0 on ENOMEM)
+static int movi_cue_intern(MoviCueIndex *idx, const char *text, int len) {
+  if ((idx->intern_used + 1) * 2 > idx->intern_capacity &&
+      movi_cue_intern_grow(idx) < 0)
+    return AVERROR(ENOMEM);
+  int slot = movi_cue_intern_slot(idx, text, len);
+  if (idx->intern_off[slot] >= 0)
+    return idx->intern_off[slot];
+
+  if (idx->arena_size + len > idx->arena_capacity) {
+    int capacity = idx->arena_capacity ? idx->arena_capacity : 64 * 1024;
+    while (capacity < idx->arena_size + len)
+      capacity *= 2;
+    char *grown = (char *)realloc(idx->arena, capacity);
+    if (!grown)
+      return AVERROR(ENOMEM);
+    idx->arena = grown;
+    idx->arena_capacity = capacity;
+  }
+  int off = idx->arena_size;
+  memcpy(idx->arena + off, text, len);
+  idx->arena_size += len;
+  idx->intern_off[slot] = off;
+  idx->intern_len[slot] = len;
+  idx->intern_used++;
+  return off;
+}
+
+static int movi_cue_append(MoviCueIndex *idx, double start_sec, double end_sec,
+                           const char *text, int len) {
+  if (idx->count == idx->capacity) {
+    int capacity = idx->capacity ? idx->capacity * 2 : 256;
+    MoviCue *grown = (MoviCue *)realloc(idx->cues, capacity * sizeof(MoviCue));
+    if (!grown)
+      return AVERROR(ENOMEM);
+    idx->cues = grown;
+    idx->capacity = capacity;
+  }
+  int off = movi_cue_intern(idx, text, len);
+  if (off < 0)
+    return off;
+  if (idx->count > 0 && start_sec < idx->cues[idx->count - 1].start_sec)
+    idx->sorted = 0;
+  MoviCue *c = &idx->cues[idx->count++];
+  c->start_sec = start_sec;
+  c->end_sec = end_sec;
+  c->text_off = off;
+  c->text_len = len;
+  return 0;
+}
+
+static int cmp_cue(const void *a, const void *b) {
+  const MoviCue *x = (const MoviCue *)a, *y = (const MoviCue *)b;
+  if (x->start_sec != y->start_sec)
+    return x->start_sec < y->start_sec ? -1 : 1;
+  if (x->end_sec != y->end_sec)
+    return x->end_sec < y->end_sec ? -1 : 1;
+  return x->text_off - y->text_off;
+}
+
+// Sort (when a cue arrived out of order) and extend the running max of end
+// times to cover every cue. Cheap when nothing changed since the last call.
+static int movi_cue_index_prepare(MoviCueIndex *idx) {
+  if (!idx->sorted) {
+    qsort(idx->cues, idx->count, sizeof(MoviCue), cmp_cue);
+    idx->sorted = 1;
+    idx->max_end_count = 0;
+  }
+  if (idx->max_end_count == idx->count)
+    return 0;
+  double *grown = (double *)realloc(
+      idx->max_end, (idx->capacity ? idx->capacity : 1) * sizeof(double));
+  if (!grown)
+    return AVERROR(ENOMEM);
+  idx->max_end = grown;
+  double running =
+      idx->max_end_count > 0 ? idx->max_end[idx->max_end_count - 1] : -1e300;
+  for (int i = idx->max_end_count; i < idx->count; i++) {
+    if (idx->cues[i].end_sec > running)
+      running = idx->cues[i].end_sec;
+    idx->max_end[i] = running;
+  }
+  idx->max_end_count = idx->count;
+  return 0;
+}
+
+// Prepare this (dedicated) context for a cue pass over `stream_index`, whose
+// decoder must already be enabled. Rewinds to the start of the file.
+EMSCRIPTEN_KEEPALIVE
+int movi_cues_begin(MoviContext *ctx, int stream_index) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || stream_index < 0 ||
+      stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return -1;
+  AVCodecContext *dec = ctx->decoders[stream_index];
+  if (!dec || dec->codec_type != AVMEDIA_TYPE_SUBTITLE)
+    return -2;
+  MoviCueIndex *idx = movi_cue_index_reset(ctx, stream_index);
+  if (!idx)
+    return AVERROR(ENOMEM);
+
+  const char *name = ctx->fmt_ctx->iformat ? ctx->fmt_ctx->iformat->name : "";
+  idx->mpegts = strstr(name, "mpegts") != NULL;
+  for (unsigned i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+    ctx->fmt_ctx->streams[i]->discard =
+        ((int)i == stream_index || idx->mpegts) ? AVDISCARD_DEFAULT
+                                                : AVDISCARD_ALL;
+  }
+
+  if (ctx->avio_ctx)
+    avio_flush(ctx->avio_ctx);
+  movi_drop_pending_packet(ctx);
+  int ret = avformat_seek_file(ctx->fmt_ctx, -1, INT64_MIN, 0, INT64_MAX,
+                               AVSEEK_FLAG_BACKWARD);
+  if (ret < 0)
+    ret = av_seek_frame(ctx->fmt_ctx, -1, 0, AVSEEK_FLAG_BACKWARD);
+  if (ret < 0)
+    return -3;
+  if (ctx->fmt_ctx->pb)
+    ctx->fmt_ctx->pb->eof_reached = 0;
+  avcodec_flush_buffers(dec);
+  return 0;
+}
+
+// Decode the next slice of the cue pass: at most max_packets packets, and
+// (when max_bytes > 0) stop once the demuxer has read max_bytes further into
+// the file. Returns 1 while there is more to read, 0 at EOF, < 0 on error.
+EMSCRIPTEN_KEEPALIVE
+int movi_cues_step(MoviContext *ctx, int max_packets, int max_bytes) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || !ctx->cue_index)
+    return -1;
+  MoviCueIndex *idx = ctx->cue_index;
+  if (idx->done)
+    return 0;
+  AVCodecContext *dec = ctx->decoders[idx->stream_index];
+  if (!dec)
+    return -2;
+  AVRational tb = ctx->fmt_ctx->streams[idx->stream_index]->time_base;
+  int64_t start_pos = ctx->fmt_ctx->pb ? avio_tell(ctx->fmt_ctx->pb) : 0;
+
+  for (int n = 0; n < max_packets; n++) {
+    if (max_bytes > 0 && ctx->fmt_ctx->pb &&
+        avio_tell(ctx->fmt_ctx->pb) - start_pos >= max_bytes)
+      break;
+    av_packet_unref(ctx->pkt);
+    int ret = av_read_frame(ctx->fmt_ctx, ctx->pkt);
+    if (ret == AVERROR_EOF) {
+      idx->done = 1;
+      if (ctx->fmt_ctx->pb)
+        ctx->fmt_ctx->pb->eof_reached = 0;
+      avcodec_flush_buffers(dec);
+      return 0;
+    }
+    if (ret < 0)
+      return ret;
+    if (ctx->pkt->pos >= 0)
+      idx->last_pos = ctx->pkt->pos;
+    if (ctx->pkt->stream_index != idx->stream_index)
+      continue;
+
+    AVSubtitle sub;
+    memset(&sub, 0, sizeof(sub));
+    int got_sub = 0;
+    if (avcodec_decode_subtitle2(dec, &sub, &got_sub, ctx->pkt) < 0 || !got_sub)
+      continue;
+    if (sub.num_rects == 0) {
+      avsubtitle_free(&sub);
+      continue;
+    }
+
+    // Timing as movi_prefetch_subtitle_cues / movi_get_subtitle_times
+    double start_sec =
+        ctx->pkt->pts != AV_NOPTS_VALUE ? ctx->pkt->pts * av_q2d(tb) : 0;
+    double duration_sec =
+        ctx->pkt->duration > 0 ? ctx->pkt->duration * av_q2d(tb) : 0;
+    if (sub.end_display_time > 0 && sub.end_display_time != UINT32_MAX) {
+      double codec_dur = sub.end_display_time / 1000.0;
+      if (codec_dur > 0.1 && codec_dur < 60.0)
+        duration_sec = codec_dur;
+    }
+    if (duration_sec < 0.3)
+      duration_sec = 0.3;
+
+    // movi_get_subtitle_text reads ctx->subtitle; alias it for the call.
+    AVSubtitle *saved_sub = ctx->subtitle;
+    ctx->subtitle = &sub;
+    char text[8192];
+    text[0] = '\0';
+    int len = movi_get_subtitle_text(ctx, text, (int)sizeof(text));
+    ctx->subtitle = saved_sub;
+    avsubtitle_free(&sub);
+
+    if (len > 0 && movi_cue_append(idx, start_sec, start_sec + duration_sec,
+                                   text, len) < 0)
+      return AVERROR(ENOMEM);
+  }
+  av_packet_unref(ctx->pkt);
+  return 1;
+}
+
+// Fraction of the file the cue pass has covered (0..1), for progress UI.
+EMSCRIPTEN_KEEPALIVE
+double movi_cues_progress(MoviContext *ctx) {
+  if (!ctx || !ctx->cue_index)
+    return 0.0;
+  if (ctx->cue_index->done)
+    return 1.0;
+  if (ctx->file_size <= 0)
+    return 0.0;
+  double p = (double)ctx->cue_index->last_pos / (double)ctx->file_size;
+  return p > 1.0 ? 1.0 : p;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_cues_count(MoviContext *ctx) {
+  return ctx && ctx->cue_index ? ctx->cue_index->count : 0;
+}
+
+// Cues overlapping [start_sec, end_sec), in start order. Writes up to max
+// entries to out and returns the total number of matches, so JS can size a
+// second call; < 0 without an index.
+EMSCRIPTEN_KEEPALIVE
+int movi_get_cues_in_range(MoviContext *ctx, double start_sec, double end_sec,
+                           MoviCueRef *out, int max) {
+  if (!ctx || !ctx->cue_index)
+    return -1;
+  MoviCueIndex *idx = ctx->cue_index;
+  if (movi_cue_index_prepare(idx) < 0)
+    return AVERROR(ENOMEM);
+
+  // First cue whose running max end is past start_sec: every cue before it
+  // ended at or before start_sec.
+  int lo = 0, hi = idx->count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (idx->max_end[mid] > start_sec)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  int found = 0;
+  for (int i = lo; i < idx->count && idx->cues[i].start_sec < end_sec; i++) {
+    const MoviCue *c = &idx->cues[i];
+    if (c->end_sec <= start_sec)
+      continue;
+    if (out && found < max) {
+      out[found].start_sec = c->start_sec;
+      out[found].end_sec = c->end_sec;
+      out[found].text = idx->arena + c->text_off;
+      out[found].text_len = c->text_len;
+    }
+    found++;
+  }
+  return found;
+}
+
+// Serialise the cue index into buffer. Returns the bytes needed; writes only
+// when buffer_size is large enough (call with 0 first to size it).
+EMSCRIPTEN_KEEPALIVE
+int movi_cues_export(MoviContext *ctx, uint8_t *buffer, int buffer_size) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->cue_index)
+    return -1;
+  MoviCueIndex *idx = ctx->cue_index;
+  if (movi_cue_index_prepare(idx) < 0)
+    return AVERROR(ENOMEM);
+  int needed = (int)sizeof(MoviCuesHeader) + idx->count * (int)sizeof(MoviCue) +
+               idx->arena_size;
+  if (!buffer || buffer_size < needed)
+    return needed;
+
+  MoviCuesHeader hdr = {0};
+  hdr.magic = MOVI_CUES_MAGIC;
+  hdr.version = MOVI_CUES_VERSION;
+  hdr.stream_index = idx->stream_index;
+  hdr.codec_id = ctx->fmt_ctx->streams[idx->stream_index]->codecpar->codec_id;
+  hdr.file_size = ctx->file_size;
+  hdr.count = idx->count;
+  hdr.arena_size = idx->arena_size;
+  memcpy(buffer, &hdr, sizeof(hdr));
+  uint8_t *p = buffer + sizeof(hdr);
+  if (idx->count > 0)
+    memcpy(p, idx->cues, idx->count * sizeof(MoviCue));
+  p += idx->count * sizeof(MoviCue);
+  if (idx->arena_size > 0)
+    memcpy(p, idx->arena, idx->arena_size);
+  return needed;
+}
+
+// Load an exported cue index into this context (replacing any other), ready
+// for movi_get_cues_in_range. Returns the cue count; < 0 when the blob is
+// malformed (-2) or belongs to another file or stream layout (-3).
+EMSCRIPTEN_KEEPALIVE
+int movi_cues_import(MoviContext *ctx, const uint8_t *blob, int size) {
+  if (!ctx || !ctx->fmt_ctx || !blob || size < (int)sizeof(MoviCuesHeader))
+    return -1;
+  MoviCuesHeader hdr;
+  memcpy(&hdr, blob, sizeof(hdr));
+  if (hdr.magic != MOVI_CUES_MAGIC || hdr.version != MOVI_CUES_VERSION ||
+      hdr.count < 0 || hdr.arena_size < 0)
+    return -2;
+  int64_t needed = (int64_t)sizeof(hdr) + (int64_t)hdr.count * sizeof(MoviCue) +
+                   hdr.arena_size;
+  if (size < needed)
+    return -2;
+  if (hdr.stream_index < 0 || hdr.stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return -3;
+  AVStream *st = ctx->fmt_ctx->streams[hdr.stream_index];
+  if (hdr.codec_id != (int)st->codecpar->codec_id ||
+      (ctx->file_size > 0 && hdr.file_size > 0 &&
+       hdr.file_size != ctx->file_size))
+    return -3;
+
+  const uint8_t *cues = blob + sizeof(hdr);
+  const uint8_t *arena = cues + hdr.count * sizeof(MoviCue);
+  for (int i = 0; i < hdr.count; i++) {
+    MoviCue c;
+    memcpy(&c, cues + i * sizeof(MoviCue), sizeof(c));
+    if (c.text_off < 0 || c.text_len < 0 ||
+        c.text_off > hdr.arena_size - c.text_len)
+      return -2;
+  }
+
+  MoviCueIndex *idx = movi_cue_index_reset(ctx, hdr.stream_index);
+  if (!idx)
+    return AVERROR(ENOMEM);
+  idx->done = 1;
+  idx->cues = (MoviCue *)malloc((hdr.count ? hdr.count : 1) * sizeof(MoviCue));
+  idx->arena = (char *)malloc(hdr.arena_size ? hdr.arena_size : 1);
+  if (!idx->cues || !idx->arena) {
+    movi_cue_index_free(ctx);
+    return AVERROR(ENOMEM);
+  }
+  memcpy(idx->cues, cues, hdr.count * sizeof(MoviCue));
+  memcpy(idx->arena, arena, hdr.arena_size);
+  idx->count = idx->capacity = hdr.count;
+  idx->arena_size = idx->arena_capacity = hdr.arena_size;
+  // The exporter sorted them, but don't trust the blob for the search
+  idx->sorted = 0;
+  return hdr.count;
+}
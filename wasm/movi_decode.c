@@ -1,5 +1,19 @@
 #include "movi.h"
 #include <libavutil/imgutils.h>
+#include <math.h>
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+
+// build-ffmpeg.sh passes MT_POOL_SIZE; its default otherwise
+#ifndef MOVI_PTHREAD_POOL_SIZE
+#define MOVI_PTHREAD_POOL_SIZE 13
+#endif
+// Pool workers one decoder may take: the 3 RGBA row-band helpers
+// (movi_tonemap.c) and a pipeline's decode and convert threads need the rest.
+// A worker past the pool can't be spawned while JS is blocked in a decode.
+#define MOVI_DECODER_MAX_THREADS (MOVI_PTHREAD_POOL_SIZE - 3 - 2)
+#endif
 
 EMSCRIPTEN_KEEPALIVE
 int movi_enable_decoder(MoviContext *ctx, int stream_index,
@@ -36,33 +50,155 @@ int movi_enable_decoder(MoviContext *ctx, int stream_index,
   // end_display_time
   c->pkt_timebase = stream->time_base;
   c->thread_count = 1;
-  if (avcodec_open2(c, codec, NULL) < 0) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+  // Threads only pay off for video: audio/subtitle decode is a few hundred µs
+  // a packet and frame threading would just add a frame of latency per worker.
+  if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && ctx->decoder_threads > 1) {
+    c->thread_count = ctx->decoder_threads;
+    c->thread_type = ctx->decoder_thread_type
+                         ? ctx->decoder_thread_type
+                         : (FF_THREAD_FRAME | FF_THREAD_SLICE);
+  }
+#endif
+  if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && movi_frame_pool_attach(c) < 0) {
     avcodec_free_context(&c);
+    return -3;
+  }
+  if (avcodec_open2(c, codec, NULL) < 0) {
+    movi_decoder_free(&c);
     return -5;
   }
   ctx->decoders[stream_index] = c;
+  if (ctx->decoder_evicted)
+    ctx->decoder_evicted[stream_index] = 0;
+  movi_shed_apply(ctx, stream_index);
   return 0;
 }
 
+// 1 when this module was linked with -pthread (movi-mt.wasm), else 0. JS checks
+// it before offering a thread count so the same bindings drive both builds.
 EMSCRIPTEN_KEEPALIVE
-int movi_send_packet(MoviContext *ctx, int stream_index, uint8_t *data,
-                     int size, double pts, double dts, int keyframe) {
-  if (!ctx || !ctx->decoders || !ctx->decoders[stream_index])
+int movi_threads_supported(void) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+// Thread count / type for video decoders opened AFTER this call (an already
+// enabled decoder keeps its settings). thread_type is an FF_THREAD_* bitmask:
+// FF_THREAD_FRAME (1) adds one frame of latency per thread but scales best for
+// H.264/HEVC; FF_THREAD_SLICE (2) only helps multi-slice/tile streams. 0 lets
+// libavcodec use whichever the codec supports. count is clamped to the
+// logical cores and to MOVI_DECODER_MAX_THREADS. No-op in the single-threaded
+// build. Returns the count that will be used.
+EMSCRIPTEN_KEEPALIVE
+int movi_set_decoder_threads(MoviContext *ctx, int count, int thread_type) {
+  if (!ctx)
     return -1;
-  AVCodecContext *dec = ctx->decoders[stream_index];
-  AVPacket *pkt = av_packet_alloc();
-  if (!pkt)
-    return -2;
-  if (size > 0 && data) {
-    if (av_new_packet(pkt, size) < 0) {
-      av_packet_free(&pkt);
-      return -3;
-    }
+#ifdef __EMSCRIPTEN_PTHREADS__
+  int cores = emscripten_num_logical_cores();
+  if (cores > 0 && count > cores)
+    count = cores;
+  if (count > MOVI_DECODER_MAX_THREADS)
+    count = MOVI_DECODER_MAX_THREADS;
+  ctx->decoder_threads = count > 1 ? count : 1;
+  ctx->decoder_thread_type = thread_type & (FF_THREAD_FRAME | FF_THREAD_SLICE);
+  return ctx->decoder_threads;
+#else
+  (void)count;
+  (void)thread_type;
+  return 1;
+#endif
+}
+
+void movi_send_pool_free(MoviContext *ctx) {
+  if (!ctx)
+    return;
+  av_packet_free(&ctx->send_pkt);
+  // Buffers still referenced by a decoder stay valid; the pool itself goes
+  // away when the last of them is released.
+  av_buffer_pool_uninit(&ctx->send_pool);
+  ctx->send_pool_size = 0;
+}
+
+// Payloads above this skip the pool: one 4K keyframe would otherwise grow
+// every pooled buffer (and each packet a frame-threaded decoder holds) to its
+// size for the rest of the session.
+#define MOVI_SEND_POOL_MAX (1024 * 1024)
+
+int movi_packet_fill_pooled(MoviContext *ctx, AVPacket *pkt,
+                            const uint8_t *data, int size) {
+  if (size <= 0 || !data)
+    return 0; // data NULL, size 0
+
+  int needed = size + AV_INPUT_BUFFER_PADDING_SIZE;
+  if (needed > MOVI_SEND_POOL_MAX) {
+    if (av_new_packet(pkt, size) < 0)
+      return -1;
     memcpy(pkt->data, data, size);
-  } else {
-    pkt->data = NULL;
-    pkt->size = 0;
+    return 0;
   }
+  if (needed > ctx->send_pool_size) {
+    int pool_size = ctx->send_pool_size > 0 ? ctx->send_pool_size : 4096;
+    while (pool_size < needed)
+      pool_size *= 2;
+    av_buffer_pool_uninit(&ctx->send_pool);
+    ctx->send_pool = av_buffer_pool_init(pool_size, NULL);
+    if (!ctx->send_pool) {
+      ctx->send_pool_size = 0;
+      return -1;
+    }
+    ctx->send_pool_size = pool_size;
+  }
+  pkt->buf = av_buffer_pool_get(ctx->send_pool);
+  if (!pkt->buf)
+    return -1;
+  memcpy(pkt->buf->data, data, size);
+  memset(pkt->buf->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+  pkt->data = pkt->buf->data;
+  pkt->size = size;
+  return 0;
+}
+
+// Fill the reusable input packet with a pooled copy of `size` bytes of `data`
+// (NULL/0 gives an empty, flushing packet). Returns NULL on OOM.
+static AVPacket *movi_input_packet(MoviContext *ctx, const uint8_t *data,
+                                   int size) {
+  if (!ctx->send_pkt) {
+    ctx->send_pkt = av_packet_alloc();
+    if (!ctx->send_pkt)
+      return NULL;
+  }
+  AVPacket *pkt = ctx->send_pkt;
+  av_packet_unref(pkt);
+  return movi_packet_fill_pooled(ctx, pkt, data, size) < 0 ? NULL : pkt;
+}
+
+// Whether a packet for stream_index can go to its decoder: 1 yes, 0 when it
+// must be dropped because movi_trim evicted the decoder and this isn't a
+// keyframe to reopen it on, AVERROR(EBUSY) while a pipeline's decode thread
+// owns the decoder (packets go through movi_pipeline_send then), < 0 when the
+// stream has no decoder.
+static int movi_decoder_resume(MoviContext *ctx, int stream_index,
+                               int keyframe) {
+  if (stream_index < 0 || stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return -1;
+  if (movi_pipeline_owns(ctx, stream_index))
+    return AVERROR(EBUSY);
+  if (ctx->decoders[stream_index])
+    return 1;
+  if (!ctx->decoder_evicted || !ctx->decoder_evicted[stream_index])
+    return -1;
+  if (!keyframe)
+    return 0;
+  return movi_enable_decoder(ctx, stream_index, NULL, 0) == 0 ? 1 : -1;
+}
+
+static int movi_send_input(MoviContext *ctx, int stream_index, AVPacket *pkt,
+                           double pts, double dts, int keyframe) {
+  AVCodecContext *dec = ctx->decoders[stream_index];
   AVRational tb = ctx->fmt_ctx->streams[stream_index]->time_base;
   if (pts >= 0)
     pkt->pts = (int64_t)(pts / av_q2d(tb));
@@ -70,11 +206,63 @@ int movi_send_packet(MoviContext *ctx, int stream_index, uint8_t *data,
     pkt->dts = (int64_t)(dts / av_q2d(tb));
   if (keyframe)
     pkt->flags |= AV_PKT_FLAG_KEY;
+  MOVI_STAT_START(t0);
   int ret = avcodec_send_packet(dec, pkt);
-  av_packet_free(&pkt);
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_SEND, t0);
+  // The decoder holds its own reference to whatever it kept
+  av_packet_unref(pkt);
   return ret;
 }
 
+EMSCRIPTEN_KEEPALIVE
+int movi_send_packet(MoviContext *ctx, int stream_index, uint8_t *data,
+                     int size, double pts, double dts, int keyframe) {
+  if (!ctx || !ctx->decoders)
+    return -1;
+  int ready = movi_decoder_resume(ctx, stream_index, keyframe);
+  if (ready <= 0)
+    return ready;
+  AVPacket *pkt = movi_input_packet(ctx, data, size);
+  if (!pkt)
+    return -3;
+  return movi_send_input(ctx, stream_index, pkt, pts, dts, keyframe);
+}
+
+/**
+ * movi_send_packet without the copy, for payloads already in the WASM heap.
+ *
+ * Takes ownership of `data` (av_packet_from_data): it must come from malloc
+ * with `size + AV_INPUT_BUFFER_PADDING_SIZE` bytes, the padding zeroed, and
+ * the caller must not touch or free it afterwards — it is freed once the
+ * decoder drops its last reference (frame threads may keep it past this call).
+ * Freed here on every error path too.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_send_packet_owned(MoviContext *ctx, int stream_index, uint8_t *data,
+                           int size, double pts, double dts, int keyframe) {
+  int ready = ctx && ctx->decoders && data && size > 0
+                  ? movi_decoder_resume(ctx, stream_index, keyframe)
+                  : -1;
+  if (ready <= 0) {
+    av_free(data);
+    return ready;
+  }
+  if (!ctx->send_pkt) {
+    ctx->send_pkt = av_packet_alloc();
+    if (!ctx->send_pkt) {
+      av_free(data);
+      return -2;
+    }
+  }
+  AVPacket *pkt = ctx->send_pkt;
+  av_packet_unref(pkt);
+  if (av_packet_from_data(pkt, data, size) < 0) {
+    av_free(data);
+    return -3;
+  }
+  return movi_send_input(ctx, stream_index, pkt, pts, dts, keyframe);
+}
+
 EMSCRIPTEN_KEEPALIVE
 void movi_set_skip_frame(MoviContext *ctx, int stream_index, int skip_val) {
   if (!ctx || stream_index < 0 || stream_index >= ctx->fmt_ctx->nb_streams)
@@ -84,13 +272,17 @@ void movi_set_skip_frame(MoviContext *ctx, int stream_index, int skip_val) {
   if (dec) {
     // strict compliance with AVDiscard enum values
     // 0: NONE, 1: NONREF, 2: BIDIR, 3: NONKEY, 4: ALL
+    enum AVDiscard skip;
     switch (skip_val) {
-      case 1: dec->skip_frame = AVDISCARD_NONREF; break;
-      case 2: dec->skip_frame = AVDISCARD_BIDIR; break;
-      case 3: dec->skip_frame = AVDISCARD_NONKEY; break;
-      case 4: dec->skip_frame = AVDISCARD_ALL; break;
-      default: dec->skip_frame = AVDISCARD_DEFAULT; break;
+      case 1: skip = AVDISCARD_NONREF; break;
+      case 2: skip = AVDISCARD_BIDIR; break;
+      case 3: skip = AVDISCARD_NONKEY; break;
+      case 4: skip = AVDISCARD_ALL; break;
+      default: skip = AVDISCARD_DEFAULT; break;
     }
+    // A pipeline's decode thread may be inside avcodec_send_packet right now
+    if (!movi_pipeline_set_discard(ctx, stream_index, skip, MOVI_DISCARD_KEEP))
+      dec->skip_frame = skip;
   }
 }
 
@@ -120,11 +312,20 @@ int movi_receive_frame(MoviContext *ctx, int stream_index) {
     return -1;
   if (stream_index < 0 || stream_index >= ctx->fmt_ctx->nb_streams)
     return -1;
+  // Frames come from movi_pipeline_receive while its threads own the decoder
+  if (movi_pipeline_owns(ctx, stream_index))
+    return AVERROR(EBUSY);
   AVCodecContext *dec = ctx->decoders[stream_index];
-  if (!dec)
+  if (!dec) {
+    // Evicted by movi_trim and waiting for a keyframe: no frame yet
+    if (ctx->decoder_evicted && ctx->decoder_evicted[stream_index])
+      return AVERROR(EAGAIN);
     return -1;
+  }
 
+  MOVI_STAT_START(t0);
   int ret = avcodec_receive_frame(dec, ctx->frame);
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_RECEIVE, t0);
   if (ret != 0)
     return ret;
 
@@ -204,10 +405,12 @@ int movi_receive_frame(MoviContext *ctx, int stream_index) {
           return -1;
         }
 
+        MOVI_STAT_START(t1);
         int ret = swr_convert(*swr_p, ctx->resampled_frame->extended_data,
                               max_out_samples,
                               (const uint8_t **)ctx->frame->extended_data,
                               ctx->frame->nb_samples);
+        MOVI_STAT_STOP(ctx, MOVI_STAGE_RESAMPLE, t1);
 
         if (ret >= 0) {
           ctx->resampled_frame->nb_samples = ret;
@@ -236,8 +439,6 @@ int movi_receive_frame(MoviContext *ctx, int stream_index) {
 void movi_abatch_free(MoviContext *ctx) {
   if (!ctx || !ctx->abatch)
     return;
-  for (int i = 0; i < ctx->abatch_channels; i++)
-    free(ctx->abatch[i]);
   free(ctx->abatch);
   ctx->abatch = NULL;
   ctx->abatch_channels = 0;
@@ -245,8 +446,10 @@ void movi_abatch_free(MoviContext *ctx) {
   ctx->abatch_nb_samples = 0;
 }
 
-// Grow (or (re)allocate) the planes so they hold at least `need` samples.
-// A channel-count change reallocates from scratch — the planes are per-channel.
+// Lay the planes out so they hold at least `need` samples. They live in the
+// module's shared block, which another context's batch may have moved since
+// this context's last one, so the first frame of every batch lays them out
+// afresh; growing mid-batch carries the accumulated samples over.
 static int movi_abatch_ensure(MoviContext *ctx, int channels, int need) {
   if (channels <= 0)
     return -1;
@@ -259,18 +462,18 @@ static int movi_abatch_ensure(MoviContext *ctx, int channels, int need) {
     ctx->abatch_channels = channels;
     ctx->abatch_capacity = 0;
   }
-  if (need > ctx->abatch_capacity) {
-    int cap = ctx->abatch_capacity ? ctx->abatch_capacity : 8192;
-    while (cap < need)
-      cap *= 2;
-    for (int i = 0; i < channels; i++) {
-      float *p = realloc(ctx->abatch[i], (size_t)cap * sizeof(float));
-      if (!p)
-        return -1; // previously-allocated planes stay valid; freed in destroy
-      ctx->abatch[i] = p;
-    }
-    ctx->abatch_capacity = cap;
-  }
+  int keep = ctx->abatch_nb_samples;
+  if (keep > 0 && need <= ctx->abatch_capacity)
+    return 0;
+  int cap = ctx->abatch_capacity ? ctx->abatch_capacity : 8192;
+  while (cap < need)
+    cap *= 2;
+  float *base = movi_scratch_planes(channels, cap, ctx->abatch_capacity, keep);
+  if (!base)
+    return -1;
+  for (int i = 0; i < channels; i++)
+    ctx->abatch[i] = base + (size_t)i * cap;
+  ctx->abatch_capacity = cap;
   return 0;
 }
 
@@ -340,13 +543,16 @@ int movi_decode_audio_batch(MoviContext *ctx, int stream_index, uint8_t *blob,
                             int32_t *sizes, double *ptss, int count) {
   if (!ctx || !ctx->decoders || stream_index < 0 ||
       stream_index >= (int)ctx->fmt_ctx->nb_streams ||
-      !ctx->decoders[stream_index] || !blob || !sizes || !ptss || count <= 0)
+      (!ctx->decoders[stream_index] &&
+       !(ctx->decoder_evicted && ctx->decoder_evicted[stream_index])) ||
+      !blob || !sizes || !ptss || count <= 0)
     return -1;
 
   // Fresh block per call — JS drains it before calling again.
   ctx->abatch_nb_samples = 0;
   ctx->abatch_has_pts = 0;
   ctx->abatch_pts = 0;
+  ctx->abatch_stretched_frames = 0;
 
   int64_t offset = 0;
   int consumed = 0;
@@ -384,6 +590,54 @@ int movi_decode_audio_batch(MoviContext *ctx, int stream_index, uint8_t *blob,
   return consumed;
 }
 
+/**
+ * movi_decode_audio_batch fused with Signalsmith time-stretch.
+ *
+ * At non-1x rates the PCM used to go planar batch → JS interleave → heap copy
+ * → de-interleave in movi_stretch_process → re-interleave → JS copy → planar
+ * AudioBuffer. Here the batch planes go straight into the stretcher (`stretch`
+ * is a movi_stretch_new handle from this module) and the output stays planar
+ * in it: movi_audio_batch_stretched_frames() samples per channel at
+ * movi_stretch_output_plane(stretch, ch). `tempo` is the playback rate.
+ *
+ * Returns packets consumed, exactly like movi_decode_audio_batch. Blocks the
+ * stretcher can't take (more channels than it was created with) are left
+ * unstretched in the batch planes, stretched_frames 0.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_decode_audio_batch_stretch(MoviContext *ctx, int stream_index,
+                                    uint8_t *blob, int32_t *sizes,
+                                    double *ptss, int count, int stretch,
+                                    double tempo) {
+  int consumed =
+      movi_decode_audio_batch(ctx, stream_index, blob, sizes, ptss, count);
+  if (consumed <= 0 || ctx->abatch_nb_samples <= 0 || tempo <= 0.0)
+    return consumed;
+
+  int channels = ctx->abatch_channels;
+  int stretch_channels = movi_stretch_channels(stretch);
+  if (stretch_channels <= 0 || channels > stretch_channels)
+    return consumed;
+
+  int out_frames = (int)ceil(ctx->abatch_nb_samples / tempo);
+  if (out_frames <= 0)
+    return consumed;
+  MOVI_STAT_START(t0);
+  int stretched =
+      movi_stretch_process_planar(stretch, (const float *const *)ctx->abatch,
+                                  channels, ctx->abatch_nb_samples, out_frames);
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_STRETCH, t0);
+  if (stretched < 0)
+    return consumed;
+  ctx->abatch_stretched_frames = out_frames;
+  return consumed;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_audio_batch_stretched_frames(MoviContext *ctx) {
+  return ctx ? ctx->abatch_stretched_frames : 0;
+}
+
 EMSCRIPTEN_KEEPALIVE
 int movi_audio_batch_samples(MoviContext *ctx) {
   return ctx ? ctx->abatch_nb_samples : 0;
@@ -407,6 +661,9 @@ float *movi_audio_batch_plane(MoviContext *ctx, int ch) {
   return ctx->abatch[ch];
 }
 
+static uint8_t *movi_convert_frame_rgba(MoviContext *ctx, int target_width,
+                                        int target_height);
+
 /**
  * Get decoded video frame as RGBA buffer (converts any format including 10-bit HDR)
  * Returns pointer to RGBA buffer, or NULL on error
@@ -414,7 +671,14 @@ float *movi_audio_batch_plane(MoviContext *ctx, int ch) {
 EMSCRIPTEN_KEEPALIVE
 uint8_t* movi_get_frame_rgba(MoviContext *ctx, int target_width, int target_height) {
   if (!ctx || !ctx->frame) return NULL;
-  
+  MOVI_STAT_START(t0);
+  uint8_t *rgba = movi_convert_frame_rgba(ctx, target_width, target_height);
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_RGBA, t0);
+  return rgba;
+}
+
+static uint8_t *movi_convert_frame_rgba(MoviContext *ctx, int target_width,
+                                        int target_height) {
   // For audio frames, return NULL
   if (ctx->frame->width == 0 || ctx->frame->height == 0) return NULL;
   
@@ -428,18 +692,15 @@ uint8_t* movi_get_frame_rgba(MoviContext *ctx, int target_width, int target_heig
   // Calculate required buffer size
   int buffer_size = av_image_get_buffer_size(AV_PIX_FMT_RGBA, target_width, target_height, 1);
   
-  // Allocate or reallocate RGB buffer if needed
-  if (!ctx->rgb_buffer || ctx->rgb_buffer_size < buffer_size) {
-    if (ctx->rgb_buffer) {
-      av_free(ctx->rgb_buffer);
-    }
-    ctx->rgb_buffer = av_malloc(buffer_size);
-    ctx->rgb_buffer_size = buffer_size;
-    if (!ctx->rgb_buffer) {
-      av_log(NULL, AV_LOG_ERROR, "[MOVI-WASM] Failed to allocate RGB buffer\n");
-      return NULL;
-    }
+  // One RGB buffer serves every context of the module (movi_budget.c); it
+  // grows with some headroom and JS copies the frame out before the next call
+  ctx->rgb_buffer = movi_scratch_rgba(buffer_size);
+  if (!ctx->rgb_buffer) {
+    ctx->rgb_buffer_size = 0;
+    av_log(NULL, AV_LOG_ERROR, "[MOVI-WASM] Failed to allocate RGB buffer\n");
+    return NULL;
   }
+  ctx->rgb_buffer_size = buffer_size;
   
   // Allocate rgb_frame if needed
   if (!ctx->rgb_frame) {
@@ -450,6 +711,29 @@ uint8_t* movi_get_frame_rgba(MoviContext *ctx, int target_width, int target_heig
     }
   }
   
+  // av_image_fill_arrays sets the linesize movi_get_frame_rgba_linesize
+  // reports before any path writes, and every path writes with that same
+  // linesize, so the stride JS reads always matches the rows in the buffer
+  if (av_image_fill_arrays(ctx->rgb_frame->data, ctx->rgb_frame->linesize,
+                           ctx->rgb_buffer, AV_PIX_FMT_RGBA, target_width,
+                           target_height, 1) < 0)
+    return NULL;
+  uint8_t *dst = ctx->rgb_frame->data[0];
+  int dst_linesize = ctx->rgb_frame->linesize[0];
+
+  // 10/12-bit: frame-tagged matrix/range (and optional HDR tone mapping),
+  // threaded in the mt build
+  if (movi_tonemap_to_rgba(ctx, ctx->frame, dst, dst_linesize, target_width,
+                           target_height) == 0) {
+    return ctx->rgb_buffer;
+  }
+
+  // SIMD fast path for the common 8-bit 4:2:0 case at native size
+  if (target_width == src_width && target_height == src_height &&
+      movi_yuv420p_to_rgba(ctx->frame, dst, dst_linesize) == 0) {
+    return ctx->rgb_buffer;
+  }
+
   // Create or update sws context
   ctx->sws_ctx = sws_getCachedContext(ctx->sws_ctx,
       src_width, src_height, ctx->frame->format,
@@ -461,10 +745,6 @@ uint8_t* movi_get_frame_rgba(MoviContext *ctx, int target_width, int target_heig
     return NULL;
   }
   
-  // Setup rgb_frame to point to rgb_buffer
-  av_image_fill_arrays(ctx->rgb_frame->data, ctx->rgb_frame->linesize,
-                       ctx->rgb_buffer, AV_PIX_FMT_RGBA, target_width, target_height, 1);
-  
   // Convert to RGBA
   sws_scale(ctx->sws_ctx, (const uint8_t *const *)ctx->frame->data,
             ctx->frame->linesize, 0, src_height,
@@ -499,35 +779,19 @@ int movi_decode_subtitle(MoviContext *ctx, int stream_index, uint8_t *data,
   if (!dec || dec->codec_type != AVMEDIA_TYPE_SUBTITLE)
     return -1;
 
-  // Free previous subtitle if exists
+  // Free previous subtitle if exists; the struct itself is reused
   if (ctx->subtitle) {
     avsubtitle_free(ctx->subtitle);
-    av_freep(&ctx->subtitle);
+    ctx->subtitle = NULL;
   }
+  memset(&ctx->subtitle_store, 0, sizeof(AVSubtitle));
+  ctx->subtitle = &ctx->subtitle_store;
 
-  // Allocate subtitle structure
-  ctx->subtitle = av_malloc(sizeof(AVSubtitle));
-  if (!ctx->subtitle)
-    return -2;
-  memset(ctx->subtitle, 0, sizeof(AVSubtitle));
-
-  // Create packet
-  AVPacket *pkt = av_packet_alloc();
+  // Pooled input packet — payload copied so the caller can free `data`
+  AVPacket *pkt = movi_input_packet(ctx, data, size);
   if (!pkt) {
-    av_freep(&ctx->subtitle);
-    return -3;
-  }
-
-  if (size > 0 && data) {
-    if (av_new_packet(pkt, size) < 0) {
-      av_packet_free(&pkt);
-      av_freep(&ctx->subtitle);
-      return -4;
-    }
-    memcpy(pkt->data, data, size);
-  } else {
-    pkt->data = NULL;
-    pkt->size = 0;
+    ctx->subtitle = NULL;
+    return -4;
   }
 
   // Set packet PTS and DTS
@@ -576,11 +840,11 @@ int movi_decode_subtitle(MoviContext *ctx, int stream_index, uint8_t *data,
     // end_display_time is automatically set by FFmpeg from packet duration
   }
 
-  av_packet_free(&pkt);
+  av_packet_unref(pkt);
 
   if (ret < 0) {
     avsubtitle_free(ctx->subtitle);
-    av_freep(&ctx->subtitle);
+    ctx->subtitle = NULL;
     return ret;
   }
 
@@ -949,6 +1213,30 @@ int movi_get_subtitle_image_info(MoviContext *ctx, int *width, int *height,
   return -1; // No bitmap found
 }
 
+// Palettized bitmap rect (PGS/DVB/DVD) → tightly packed RGBA.
+// Format: data[0] = 8-bit indices, data[1] = palette (256 colors, each 4
+// bytes BGRA), so each pixel is a lookup plus a B/R swap.
+int movi_subtitle_rect_rgba(const AVSubtitleRect *rect, uint8_t *dst) {
+  const uint8_t *palette = rect->data[1];
+  const uint8_t *indexed_data = rect->data[0];
+  if (!palette || !indexed_data)
+    return -1;
+  int width = rect->w;
+  int linesize = rect->linesize[0];
+  for (int y = 0; y < rect->h; y++) {
+    const uint8_t *src = indexed_data + y * linesize;
+    uint8_t *out = dst + (size_t)y * width * 4;
+    for (int x = 0; x < width; x++) {
+      const uint8_t *c = palette + src[x] * 4;
+      out[x * 4 + 0] = c[2]; // Red
+      out[x * 4 + 1] = c[1]; // Green
+      out[x * 4 + 2] = c[0]; // Blue
+      out[x * 4 + 3] = c[3]; // Alpha
+    }
+  }
+  return 0;
+}
+
 EMSCRIPTEN_KEEPALIVE
 int movi_get_subtitle_image_data(MoviContext *ctx, uint8_t *buffer,
                                  int buffer_size) {
@@ -995,34 +1283,11 @@ int movi_get_subtitle_image_data(MoviContext *ctx, uint8_t *buffer,
 
   // Get indexed image data (data[0])
   uint8_t *indexed_data = bitmap_rect->data[0];
-  int linesize = bitmap_rect->linesize[0];
-
   if (!indexed_data) {
     return -4; // No image data
   }
 
-  // Convert indexed color to RGBA
-  // FFmpeg PGS decoder provides palette in BGRA format, we need RGBA
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      int src_idx = y * linesize + x;
-      int color_index = indexed_data[src_idx];
-
-      // Get color from palette (BGRA format)
-      int palette_offset = color_index * 4;
-      uint8_t b = palette[palette_offset + 0];
-      uint8_t g = palette[palette_offset + 1];
-      uint8_t r = palette[palette_offset + 2];
-      uint8_t a = palette[palette_offset + 3];
-
-      // Write RGBA to output buffer
-      int dst_idx = (y * width + x) * 4;
-      buffer[dst_idx + 0] = r; // Red
-      buffer[dst_idx + 1] = g; // Green
-      buffer[dst_idx + 2] = b; // Blue
-      buffer[dst_idx + 3] = a; // Alpha
-    }
-  }
+  movi_subtitle_rect_rgba(bitmap_rect, buffer);
 
   return required_size; // Return number of bytes written
 }
@@ -1031,7 +1296,7 @@ EMSCRIPTEN_KEEPALIVE
 void movi_free_subtitle(MoviContext *ctx) {
   if (ctx && ctx->subtitle) {
     avsubtitle_free(ctx->subtitle);
-    av_freep(&ctx->subtitle);
+    ctx->subtitle = NULL;
   }
 }
 
@@ -1055,6 +1320,10 @@ EMSCRIPTEN_KEEPALIVE
 void movi_flush_decoder(MoviContext *ctx, int stream_index) {
   if (!ctx || stream_index < 0 || stream_index >= ctx->fmt_ctx->nb_streams)
     return;
+  if (movi_pipeline_owns(ctx, stream_index)) {
+    movi_pipeline_flush(ctx);
+    return;
+  }
   AVCodecContext *dec = ctx->decoders[stream_index];
   if (dec) {
     avcodec_flush_buffers(dec);
@@ -1128,6 +1397,7 @@ int movi_prefetch_subtitle_cues(MoviContext *ctx, int stream_index) {
   // can't seek to exactly 0 (matroska likes the first cluster boundary).
   if (ctx->avio_ctx)
     avio_flush(ctx->avio_ctx);
+  movi_drop_pending_packet(ctx);
   int seek_ret = avformat_seek_file(ctx->fmt_ctx, -1, INT64_MIN, 0, INT64_MAX,
                                     AVSEEK_FLAG_BACKWARD);
   if (seek_ret < 0) {
@@ -1,4 +1,8 @@
 #include "movi.h"
+#include <libavutil/imgutils.h>
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+#endif
 
 EMSCRIPTEN_KEEPALIVE
 int movi_get_frame_width(MoviContext *ctx) {
@@ -39,3 +43,274 @@ EMSCRIPTEN_KEEPALIVE
 int movi_get_frame_sample_rate(MoviContext *ctx) {
   return ctx->frame ? ctx->frame->sample_rate : 0;
 }
+
+// ---- Pooled decoder output -----------------------------------------------
+// Video decoders draw their frames from one AVBufferPool per decoder: every
+// plane 64-byte aligned (base and stride), all planes of a frame in a single
+// buffer. A frame's buffer goes back to the pool when its last reference is
+// dropped — the decoder's own once it's done with it as a reference picture,
+// and any movi_frame_retain handle JS holds. Decoders without DR1 (libdav1d
+// hands out its own pictures) and hwaccel/paletted formats use the default
+// allocator; the handles work the same on top of it.
+
+#define MOVI_FRAME_ALIGN 64
+
+typedef struct MoviFramePool {
+  AVBufferPool *pool;
+  size_t size;
+  int allocated; // buffers the current pool has allocated (movi_trim accounting)
+#ifdef __EMSCRIPTEN_PTHREADS__
+  // Frame threads call get_buffer2 concurrently
+  pthread_mutex_t lock;
+#endif
+} MoviFramePool;
+
+static AVBufferRef *movi_frame_pool_alloc(void *opaque, size_t size) {
+  MoviFramePool *fp = (MoviFramePool *)opaque;
+  AVBufferRef *buf = av_buffer_alloc(size);
+  if (buf)
+    fp->allocated++;
+  return buf;
+}
+
+static int movi_get_buffer2(AVCodecContext *c, AVFrame *f, int flags) {
+  MoviFramePool *fp = (MoviFramePool *)c->opaque;
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(f->format);
+  if (!fp || !(c->codec->capabilities & AV_CODEC_CAP_DR1) || !desc ||
+      (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL)))
+    return avcodec_default_get_buffer2(c, f, flags);
+
+  int w = f->width, h = f->height;
+  int align[AV_NUM_DATA_POINTERS];
+  avcodec_align_dimensions2(c, &w, &h, align);
+
+  int linesize[4];
+  if (av_image_fill_linesizes(linesize, f->format, w) < 0)
+    return AVERROR(EINVAL);
+  ptrdiff_t strides[4];
+  for (int i = 0; i < 4; i++) {
+    linesize[i] = FFALIGN(linesize[i], MOVI_FRAME_ALIGN);
+    strides[i] = linesize[i];
+  }
+  size_t sizes[4];
+  if (av_image_fill_plane_sizes(sizes, f->format, h, strides) < 0)
+    return AVERROR(EINVAL);
+
+  size_t offsets[4];
+  size_t total = 0;
+  for (int i = 0; i < 4; i++) {
+    offsets[i] = total;
+    total += FFALIGN(sizes[i], MOVI_FRAME_ALIGN);
+  }
+  // Room to align the base, plus the overread slack the default allocator
+  // leaves after the last plane
+  total += MOVI_FRAME_ALIGN + 16;
+
+  AVBufferRef *buf = NULL;
+#ifdef __EMSCRIPTEN_PTHREADS__
+  pthread_mutex_lock(&fp->lock);
+#endif
+  if (!fp->pool || fp->size != total) {
+    // Size change (resolution switch): frames still out keep the old pool
+    // alive until they're released
+    av_buffer_pool_uninit(&fp->pool);
+    fp->pool = av_buffer_pool_init2(total, fp, movi_frame_pool_alloc, NULL);
+    fp->size = fp->pool ? total : 0;
+    fp->allocated = 0;
+  }
+  if (fp->pool)
+    buf = av_buffer_pool_get(fp->pool);
+#ifdef __EMSCRIPTEN_PTHREADS__
+  pthread_mutex_unlock(&fp->lock);
+#endif
+  if (!buf)
+    return AVERROR(ENOMEM);
+
+  uint8_t *base = (uint8_t *)FFALIGN((uintptr_t)buf->data, MOVI_FRAME_ALIGN);
+  f->buf[0] = buf;
+  for (int i = 0; i < 4; i++) {
+    f->data[i] = sizes[i] ? base + offsets[i] : NULL;
+    f->linesize[i] = sizes[i] ? linesize[i] : 0;
+  }
+  f->extended_data = f->data;
+  return 0;
+}
+
+int movi_frame_pool_attach(AVCodecContext *c) {
+  MoviFramePool *fp = (MoviFramePool *)calloc(1, sizeof(MoviFramePool));
+  if (!fp)
+    return -1;
+#ifdef __EMSCRIPTEN_PTHREADS__
+  pthread_mutex_init(&fp->lock, NULL);
+#endif
+  c->opaque = fp;
+  c->get_buffer2 = movi_get_buffer2;
+  return 0;
+}
+
+void movi_decoder_free(AVCodecContext **c) {
+  if (!c || !*c)
+    return;
+  MoviFramePool *fp =
+      (*c)->get_buffer2 == movi_get_buffer2 ? (MoviFramePool *)(*c)->opaque : NULL;
+  avcodec_free_context(c);
+  if (fp) {
+    av_buffer_pool_uninit(&fp->pool);
+#ifdef __EMSCRIPTEN_PTHREADS__
+    pthread_mutex_destroy(&fp->lock);
+#endif
+    free(fp);
+  }
+}
+
+static MoviFramePool *movi_frame_pool_of(const AVCodecContext *c) {
+  return c && c->get_buffer2 == movi_get_buffer2 ? (MoviFramePool *)c->opaque
+                                                 : NULL;
+}
+
+size_t movi_frame_pool_bytes(const AVCodecContext *c) {
+  MoviFramePool *fp = movi_frame_pool_of(c);
+  return fp ? fp->size * fp->allocated : 0;
+}
+
+// Drop the pool's idle buffers. The decoder's reference pictures and frames JS
+// retained keep the old pool alive until released; the next get_buffer2 starts
+// a fresh pool that only grows back to what the decoder actually holds.
+void movi_frame_pool_trim(AVCodecContext *c) {
+  MoviFramePool *fp = movi_frame_pool_of(c);
+  if (!fp)
+    return;
+#ifdef __EMSCRIPTEN_PTHREADS__
+  pthread_mutex_lock(&fp->lock);
+#endif
+  av_buffer_pool_uninit(&fp->pool);
+  fp->size = 0;
+  fp->allocated = 0;
+#ifdef __EMSCRIPTEN_PTHREADS__
+  pthread_mutex_unlock(&fp->lock);
+#endif
+}
+
+// ---- Retained frame handles ----------------------------------------------
+// The handle's planes are described in WebCodecs terms so JS can build a
+// VideoFrame (or a texSubImage2D upload) straight from HEAPU8 views: no
+// sws_scale to RGBA and no JS-side copy. Formats without a VideoFrame
+// equivalent report MOVI_VF_NONE and JS takes the RGBA path.
+
+enum {
+  MOVI_VF_NONE = 0,
+  MOVI_VF_I420 = 1,
+  MOVI_VF_I420P10 = 2,
+  MOVI_VF_I422 = 3,
+  MOVI_VF_I422P10 = 4,
+  MOVI_VF_I444 = 5,
+  MOVI_VF_I444P10 = 6,
+  MOVI_VF_NV12 = 7,
+  MOVI_VF_I420A = 8,
+  MOVI_VF_RGBA = 9, // converted by a pipeline's convert stage
+};
+
+static int movi_videoframe_format(int format) {
+  switch (format) {
+  case AV_PIX_FMT_YUV420P:
+  case AV_PIX_FMT_YUVJ420P:
+    return MOVI_VF_I420;
+  case AV_PIX_FMT_YUV420P10LE:
+    return MOVI_VF_I420P10;
+  case AV_PIX_FMT_YUV422P:
+  case AV_PIX_FMT_YUVJ422P:
+    return MOVI_VF_I422;
+  case AV_PIX_FMT_YUV422P10LE:
+    return MOVI_VF_I422P10;
+  case AV_PIX_FMT_YUV444P:
+  case AV_PIX_FMT_YUVJ444P:
+    return MOVI_VF_I444;
+  case AV_PIX_FMT_YUV444P10LE:
+    return MOVI_VF_I444P10;
+  case AV_PIX_FMT_NV12:
+    return MOVI_VF_NV12;
+  case AV_PIX_FMT_YUVA420P:
+    return MOVI_VF_I420A;
+  case AV_PIX_FMT_RGBA:
+    return MOVI_VF_RGBA;
+  default:
+    return MOVI_VF_NONE;
+  }
+}
+
+static AVFrame *movi_frame_handle(MoviContext *ctx, int handle) {
+  if (!ctx || handle < 1 || handle > MOVI_FRAME_HANDLES)
+    return NULL;
+  return ctx->frame_handles[handle - 1];
+}
+
+/**
+ * Keep the current decoded video frame alive past the next receive.
+ * Returns a handle (>= 1), -1 without a video frame, -2 when every handle is
+ * taken (JS is leaking them or decoding too far ahead).
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_frame_retain(MoviContext *ctx) {
+  if (!ctx || !ctx->frame || !ctx->frame->buf[0] || ctx->frame->width <= 0)
+    return -1;
+  for (int i = 0; i < MOVI_FRAME_HANDLES; i++) {
+    if (ctx->frame_handles[i])
+      continue;
+    AVFrame *f = av_frame_alloc();
+    if (!f)
+      return -1;
+    if (av_frame_ref(f, ctx->frame) < 0) {
+      av_frame_free(&f);
+      return -1;
+    }
+    ctx->frame_handles[i] = f;
+    return i + 1;
+  }
+  return -2;
+}
+
+/**
+ * Describe a retained frame into out[16] (uint32):
+ *   [0] MOVI_VF_* format  [1] width  [2] height  [3] plane count
+ *   [4 + 2i] plane i data pointer, [5 + 2i] plane i stride (i < 4)
+ *   [12] AVColorSpace  [13] AVColorPrimaries  [14] AVColorTransferCharacteristic
+ *   [15] AVColorRange
+ * Returns 0, or -1 for an unknown handle.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_frame_handle_info(MoviContext *ctx, int handle, uint32_t *out) {
+  AVFrame *f = movi_frame_handle(ctx, handle);
+  if (!f || !out)
+    return -1;
+  memset(out, 0, 16 * sizeof(uint32_t));
+  int planes = 0;
+  while (planes < 4 && f->data[planes])
+    planes++;
+  out[0] = movi_videoframe_format(f->format);
+  out[1] = f->width;
+  out[2] = f->height;
+  out[3] = planes;
+  for (int i = 0; i < planes; i++) {
+    out[4 + 2 * i] = (uint32_t)(uintptr_t)f->data[i];
+    out[5 + 2 * i] = f->linesize[i];
+  }
+  out[12] = f->colorspace;
+  out[13] = f->color_primaries;
+  out[14] = f->color_trc;
+  out[15] = f->color_range;
+  return 0;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void movi_frame_release(MoviContext *ctx, int handle) {
+  if (!movi_frame_handle(ctx, handle))
+    return;
+  av_frame_free(&ctx->frame_handles[handle - 1]);
+}
+
+void movi_frame_handles_free(MoviContext *ctx) {
+  if (!ctx)
+    return;
+  for (int i = 0; i < MOVI_FRAME_HANDLES; i++)
+    av_frame_free(&ctx->frame_handles[i]);
+}
@@ -0,0 +1,352 @@
+#include "movi.h"
+
+// ---- Persistent seek index ------------------------------------------------
+// movi_seek_to leans on avformat_seek_file. With a real index (MP4 sample
+// tables, Matroska Cues) that is a single jump, but Matroska without Cues,
+// MPEG-TS and raw elementary streams have nothing to jump to: every seek is a
+// byte-estimate bisection (ff_seek_frame_binary / matroska's linear cluster
+// walk), i.e. several js_read_async round-trips over HTTP per seek.
+//
+// The demuxers already know how to seek precisely once an AVStream has index
+// entries — they just only get them by reading the file. So the index is
+// built by reading the file once on a dedicated context (JS opens an isolated
+// one so playback never moves): movi_index_begin discards every other stream,
+// and movi_index_step drives av_read_frame, which makes the demuxer populate
+// the video stream's index with the positions *its own* read_seek understands
+// (cluster offsets for Matroska, packet offsets via AVFMT_GENERIC_INDEX for
+// TS/ES). movi_index_export serialises those entries plus the IDR/CRA
+// classification from movi_classify_packet; JS stores the blob (IndexedDB,
+// keyed by a source fingerprint) and movi_index_import /
+// movi_thumbnail_import_index replay it into any later context with
+// av_add_index_entry.
+
+#define MOVI_INDEX_MAGIC 0x5849564d // "MVIX"
+#define MOVI_INDEX_VERSION 1
+
+#define MOVI_INDEX_FLAG_KEY 1 // AVINDEX_KEYFRAME
+#define MOVI_INDEX_FLAG_IDR 2 // true random-access point (movi_classify_packet)
+
+// Serialised layout (little-endian, as WASM is on both ends).
+typedef struct {
+  int32_t magic;
+  int32_t version;
+  int32_t stream_index;
+  int32_t codec_id;
+  int32_t tb_num;
+  int32_t tb_den;
+  int64_t file_size;
+  int32_t count;
+  int32_t reserved;
+} MoviIndexHeader;
+
+typedef struct {
+  int64_t pos;
+  int64_t timestamp; // stream time_base
+  int32_t size;
+  int32_t flags;     // MOVI_INDEX_FLAG_*
+} MoviIndexEntry;
+
+struct MoviSeekIndex {
+  int stream_index;
+  AVRational time_base;
+
+  // Build state: timestamps (pts and dts) of keyframes that are NOT true IDRs,
+  // matched against the demuxer's index entries at export time.
+  int64_t *cra_ts;
+  int cra_count;
+  int cra_capacity;
+  int64_t last_pos;
+  int done;
+
+  // Imported table (sorted by timestamp), consulted by movi_index_seek_target.
+  MoviIndexEntry *entries;
+  int count;
+  int has_cra; // at least one keyframe entry without MOVI_INDEX_FLAG_IDR
+};
+
+void movi_seek_index_free(MoviContext *ctx) {
+  if (!ctx || !ctx->seek_index)
+    return;
+  free(ctx->seek_index->cra_ts);
+  free(ctx->seek_index->entries);
+  free(ctx->seek_index);
+  ctx->seek_index = NULL;
+}
+
+static MoviSeekIndex *movi_seek_index_reset(MoviContext *ctx,
+                                            int stream_index) {
+  movi_seek_index_free(ctx);
+  MoviSeekIndex *idx = (MoviSeekIndex *)calloc(1, sizeof(MoviSeekIndex));
+  if (!idx)
+    return NULL;
+  idx->stream_index = stream_index;
+  idx->time_base = ctx->fmt_ctx->streams[stream_index]->time_base;
+  ctx->seek_index = idx;
+  return idx;
+}
+
+// 1 when building an index for this stream is worthwhile: the container isn't
+// one whose header already carries a full sample table (MP4/MOV), and the
+// demuxer hasn't populated more than a token index at open (Matroska Cues).
+EMSCRIPTEN_KEEPALIVE
+int movi_index_needed(MoviContext *ctx, int stream_index) {
+  if (!ctx || !ctx->fmt_ctx || stream_index < 0 ||
+      stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return 0;
+  const char *name = ctx->fmt_ctx->iformat ? ctx->fmt_ctx->iformat->name : "";
+  if (strstr(name, "mov") || strstr(name, "mp4"))
+    return 0;
+  AVStream *st = ctx->fmt_ctx->streams[stream_index];
+  return avformat_index_get_entries_count(st) <= 1 ? 1 : 0;
+}
+
+// Prepare this context for an index pass over `stream_index`: every other
+// stream is discarded at the demuxer (as movi_set_stream_discard does) and
+// non-keyframes of the indexed stream are skipped where the demuxer supports
+// it. The context is only good for indexing afterwards — use a dedicated one.
+EMSCRIPTEN_KEEPALIVE
+int movi_index_begin(MoviContext *ctx, int stream_index) {
+  if (!ctx || !ctx->fmt_ctx || stream_index < 0 ||
+      stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return -1;
+  if (!movi_seek_index_reset(ctx, stream_index))
+    return AVERROR(ENOMEM);
+  for (unsigned i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+    ctx->fmt_ctx->streams[i]->discard =
+        (int)i == stream_index ? AVDISCARD_NONKEY : AVDISCARD_ALL;
+  }
+  return 0;
+}
+
+static int movi_index_note_cra(MoviSeekIndex *idx, int64_t ts) {
+  if (ts == AV_NOPTS_VALUE)
+    return 0;
+  if (idx->cra_count == idx->cra_capacity) {
+    int cap = idx->cra_capacity ? idx->cra_capacity * 2 : 256;
+    int64_t *grown = (int64_t *)realloc(idx->cra_ts, cap * sizeof(int64_t));
+    if (!grown)
+      return AVERROR(ENOMEM);
+    idx->cra_ts = grown;
+    idx->cra_capacity = cap;
+  }
+  idx->cra_ts[idx->cra_count++] = ts;
+  return 0;
+}
+
+// Read up to max_packets packets of the index pass. Returns 1 while there is
+// more to read, 0 once the whole file has been indexed, < 0 on error. JS calls
+// this in a loop, yielding between calls, so the pass can run in the
+// background and be abandoned at any point.
+EMSCRIPTEN_KEEPALIVE
+int movi_index_step(MoviContext *ctx, int max_packets) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || !ctx->seek_index)
+    return -1;
+  MoviSeekIndex *idx = ctx->seek_index;
+  if (idx->done)
+    return 0;
+  for (int n = 0; n < max_packets; n++) {
+    av_packet_unref(ctx->pkt);
+    int ret = av_read_frame(ctx->fmt_ctx, ctx->pkt);
+    if (ret == AVERROR_EOF) {
+      idx->done = 1;
+      return 0;
+    }
+    if (ret < 0)
+      return ret;
+    if (ctx->pkt->pos >= 0)
+      idx->last_pos = ctx->pkt->pos;
+    if (ctx->pkt->stream_index != idx->stream_index ||
+        !(ctx->pkt->flags & AV_PKT_FLAG_KEY))
+      continue;
+    MoviPacketClass cls;
+    movi_classify_packet(ctx, ctx->pkt, &cls);
+    if (!cls.is_idr) {
+      // Matroska indexes by pts, the generic index by dts: note both
+      if (movi_index_note_cra(idx, ctx->pkt->pts) < 0 ||
+          movi_index_note_cra(idx, ctx->pkt->dts) < 0)
+        return AVERROR(ENOMEM);
+    }
+  }
+  av_packet_unref(ctx->pkt);
+  return 1;
+}
+
+// Fraction of the file the index pass has covered (0..1), for progress UI.
+EMSCRIPTEN_KEEPALIVE
+double movi_index_progress(MoviContext *ctx) {
+  if (!ctx || !ctx->seek_index)
+    return 0.0;
+  if (ctx->seek_index->done)
+    return 1.0;
+  if (ctx->file_size <= 0)
+    return 0.0;
+  double p = (double)ctx->seek_index->last_pos / (double)ctx->file_size;
+  return p > 1.0 ? 1.0 : p;
+}
+
+static int cmp_int64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Serialise the indexed stream's entries into buffer. Returns the number of
+// bytes the index needs; writes only when buffer_size is large enough, so JS
+// calls once with buffer_size = 0 to size the allocation.
+EMSCRIPTEN_KEEPALIVE
+int movi_index_export(MoviContext *ctx, uint8_t *buffer, int buffer_size) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->seek_index)
+    return -1;
+  MoviSeekIndex *idx = ctx->seek_index;
+  AVStream *st = ctx->fmt_ctx->streams[idx->stream_index];
+  int count = avformat_index_get_entries_count(st);
+  int needed =
+      (int)sizeof(MoviIndexHeader) + count * (int)sizeof(MoviIndexEntry);
+  if (!buffer || buffer_size < needed)
+    return needed;
+
+  if (idx->cra_count > 1)
+    qsort(idx->cra_ts, idx->cra_count, sizeof(int64_t), cmp_int64);
+
+  MoviIndexHeader hdr = {0};
+  hdr.magic = MOVI_INDEX_MAGIC;
+  hdr.version = MOVI_INDEX_VERSION;
+  hdr.stream_index = idx->stream_index;
+  hdr.codec_id = st->codecpar->codec_id;
+  hdr.tb_num = st->time_base.num;
+  hdr.tb_den = st->time_base.den;
+  hdr.file_size = ctx->file_size;
+  hdr.count = count;
+  memcpy(buffer, &hdr, sizeof(hdr));
+
+  MoviIndexEntry *out = (MoviIndexEntry *)(buffer + sizeof(hdr));
+  for (int i = 0; i < count; i++) {
+    const AVIndexEntry *e = avformat_index_get_entry(st, i);
+    MoviIndexEntry entry = {0};
+    entry.pos = e->pos;
+    entry.timestamp = e->timestamp;
+    entry.size = e->size;
+    if (e->flags & AVINDEX_KEYFRAME) {
+      entry.flags = MOVI_INDEX_FLAG_KEY;
+      if (!idx->cra_count ||
+          !bsearch(&e->timestamp, idx->cra_ts, idx->cra_count, sizeof(int64_t),
+                   cmp_int64))
+        entry.flags |= MOVI_INDEX_FLAG_IDR;
+    }
+    memcpy(&out[i], &entry, sizeof(entry));
+  }
+  return needed;
+}
+
+// Validate a blob against fmt_ctx and add its entries to the indexed stream.
+// On success returns the entry count and, if out is non-NULL, a malloc'd copy
+// of the entries; < 0 when the blob is malformed or belongs to another file.
+static int movi_index_apply_entries(AVFormatContext *fmt_ctx, int64_t file_size,
+                                    const uint8_t *blob, int size,
+                                    MoviIndexEntry **out, int *stream_out) {
+  if (!fmt_ctx || !blob || size < (int)sizeof(MoviIndexHeader))
+    return -1;
+  MoviIndexHeader hdr;
+  memcpy(&hdr, blob, sizeof(hdr));
+  if (hdr.magic != MOVI_INDEX_MAGIC || hdr.version != MOVI_INDEX_VERSION)
+    return -2;
+  if (hdr.count < 0 ||
+      size < (int)sizeof(hdr) + hdr.count * (int)sizeof(MoviIndexEntry))
+    return -2;
+  if (hdr.stream_index < 0 || hdr.stream_index >= (int)fmt_ctx->nb_streams)
+    return -3;
+  AVStream *st = fmt_ctx->streams[hdr.stream_index];
+  // A fingerprint collision or a file changed in place must not inject
+  // offsets from another file: everything we can cheaply check has to match.
+  if (hdr.codec_id != (int)st->codecpar->codec_id ||
+      hdr.tb_num != st->time_base.num || hdr.tb_den != st->time_base.den ||
+      (file_size > 0 && hdr.file_size > 0 && hdr.file_size != file_size))
+    return -3;
+
+  MoviIndexEntry *copy = NULL;
+  if (out && hdr.count > 0) {
+    copy = (MoviIndexEntry *)malloc(hdr.count * sizeof(MoviIndexEntry));
+    if (!copy)
+      return AVERROR(ENOMEM);
+  }
+  const uint8_t *p = blob + sizeof(hdr);
+  for (int i = 0; i < hdr.count; i++) {
+    MoviIndexEntry e;
+    memcpy(&e, p + i * sizeof(MoviIndexEntry), sizeof(e));
+    av_add_index_entry(st, e.pos, e.timestamp, e.size, 0,
+                       (e.flags & MOVI_INDEX_FLAG_KEY) ? AVINDEX_KEYFRAME : 0);
+    if (copy)
+      copy[i] = e;
+  }
+  if (out)
+    *out = copy;
+  if (stream_out)
+    *stream_out = hdr.stream_index;
+  return hdr.count;
+}
+
+int movi_index_apply(AVFormatContext *fmt_ctx, int64_t file_size,
+                     const uint8_t *blob, int size) {
+  return movi_index_apply_entries(fmt_ctx, file_size, blob, size, NULL, NULL);
+}
+
+// Load an exported index into this (playback) context. Seeks on the indexed
+// stream then jump straight to a known offset, and prefer true IDR entries
+// over CRA ones (see movi_index_seek_target). Returns the entry count.
+EMSCRIPTEN_KEEPALIVE
+int movi_index_import(MoviContext *ctx, const uint8_t *blob, int size) {
+  if (!ctx || !ctx->fmt_ctx)
+    return -1;
+  MoviIndexEntry *entries = NULL;
+  int stream_index = -1;
+  int count = movi_index_apply_entries(ctx->fmt_ctx, ctx->file_size, blob,
+                                       size, &entries, &stream_index);
+  if (count < 0)
+    return count;
+  MoviSeekIndex *idx = movi_seek_index_reset(ctx, stream_index);
+  if (!idx) {
+    free(entries);
+    return AVERROR(ENOMEM);
+  }
+  idx->entries = entries;
+  idx->count = count;
+  idx->done = 1;
+  for (int i = 0; i < count; i++) {
+    if ((entries[i].flags & MOVI_INDEX_FLAG_KEY) &&
+        !(entries[i].flags & MOVI_INDEX_FLAG_IDR)) {
+      idx->has_cra = 1;
+      break;
+    }
+  }
+  return count;
+}
+
+// Adjust an AV_TIME_BASE seek target down to the last true-IDR index entry at
+// or before it, so a hardware decoder resumes on a `key` chunk it accepts
+// instead of a CRA (whose RASL pictures are then undecodable). Returns the
+// target unchanged without an imported index or when it has no CRA entries.
+int64_t movi_index_seek_target(MoviContext *ctx, int64_t target) {
+  MoviSeekIndex *idx = ctx ? ctx->seek_index : NULL;
+  if (!idx || !idx->has_cra || idx->count == 0)
+    return target;
+  // Same domain avformat_seek_file(stream_index = -1) uses: a plain rescale,
+  // no start_time offset.
+  int64_t ts = av_rescale_q(target, AV_TIME_BASE_Q, idx->time_base);
+  // Entries are sorted by timestamp (av_add_index_entry keeps them ordered).
+  int lo = 0, hi = idx->count - 1, best = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (idx->entries[mid].timestamp <= ts) {
+      best = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  for (; best >= 0; best--) {
+    if (idx->entries[best].flags & MOVI_INDEX_FLAG_IDR) {
+      return av_rescale_q(idx->entries[best].timestamp, idx->time_base,
+                          AV_TIME_BASE_Q);
+    }
+  }
+  return target;
+}
@@ -0,0 +1,172 @@
+#include "movi.h"
+
+// ---- Live ingest -----------------------------------------------------------
+// A live MPEG-TS / fragmented MP4 feed has no size and no Range support, and
+// the file path is tuned for the opposite: a seekable AVIO over file_size,
+// 10MB / 5s of probing and a 512KB buffer that each pull read (one Asyncify
+// round trip through HttpSource) has to fill. On a live feed that's seconds
+// before the first frame, and every buffer refill waits on the network.
+//
+// With movi_set_live (before movi_open) JS pushes the feed's bytes in as they
+// arrive (movi_push_bytes) and AVIO reads them from a FIFO here:
+//   - AVIO is non-seekable with a MOVI_LIVE_AVIO_BUFFER buffer, and a read
+//     returns whatever is queued instead of waiting for a full buffer, so the
+//     demuxer sees each chunk as soon as it lands
+//   - probing stops at MOVI_LIVE_PROBESIZE / MOVI_LIVE_ANALYZE_US with no
+//     frame-rate probing, and AVFMT_FLAG_NOBUFFER keeps find_stream_info
+//     from holding packets back
+//   - only an empty FIFO suspends (js_live_wait), resumed by the next push;
+//     movi_push_eof ends the stream
+// JS drives the latency target from there (catch-up through the stretcher).
+
+#define MOVI_LIVE_AVIO_BUFFER 32768
+#define MOVI_LIVE_PROBESIZE 32768
+#define MOVI_LIVE_ANALYZE_US 500000
+#define MOVI_LIVE_MIN_CAPACITY 262144
+// Queued bytes past this are refused (movi_push_bytes returns less than it
+// was given) so a stalled reader can't grow the heap without bound
+#define MOVI_LIVE_MAX_QUEUED (16 * 1024 * 1024)
+
+struct MoviLive {
+  uint8_t *data;
+  int capacity;
+  int start; // first unread byte
+  int end;   // one past the last queued byte
+  int eof;
+};
+
+// Suspend until JS pushes more bytes for `ctx` (or ends the stream). The
+// pending wait is keyed by context: ContextManager only runs one async call
+// per module, but pushes for any context arrive at any time.
+EM_JS(int, js_live_wait, (void *ctx), {
+  return Asyncify.handleAsync(function() {
+    return new Promise(function(resolve) {
+      Module._pendingLiveWait = {ctx : ctx, resolve : resolve};
+      if (Module.onLiveStarved)
+        Module.onLiveStarved(ctx);
+    });
+  });
+});
+
+EMSCRIPTEN_KEEPALIVE
+int movi_set_live(MoviContext *ctx, int enable) {
+  if (!ctx || ctx->fmt_ctx)
+    return -1; // only before movi_open
+  if (!enable) {
+    movi_live_free(ctx);
+    return 0;
+  }
+  if (!ctx->live) {
+    ctx->live = (MoviLive *)calloc(1, sizeof(MoviLive));
+    if (!ctx->live)
+      return -1;
+  }
+  ctx->avio_buffer_size = MOVI_LIVE_AVIO_BUFFER;
+  return 0;
+}
+
+// Append feed bytes. Returns how many were taken: fewer than `size` once
+// MOVI_LIVE_MAX_QUEUED are waiting (push the rest after the demuxer catches
+// up), -1 when the context isn't live or the stream has ended.
+EMSCRIPTEN_KEEPALIVE
+int movi_push_bytes(MoviContext *ctx, const uint8_t *data, int size) {
+  if (!ctx || !ctx->live || ctx->live->eof || (!data && size > 0) || size < 0)
+    return -1;
+  MoviLive *l = ctx->live;
+  int queued = l->end - l->start;
+  if (size > MOVI_LIVE_MAX_QUEUED - queued)
+    size = MOVI_LIVE_MAX_QUEUED - queued;
+  if (size <= 0)
+    return 0;
+  if (l->end + size > l->capacity) {
+    // Slide the unread bytes down first; grow only when that's not enough
+    if (l->start > 0) {
+      memmove(l->data, l->data + l->start, queued);
+      l->start = 0;
+      l->end = queued;
+    }
+    if (queued + size > l->capacity) {
+      int capacity = l->capacity ? l->capacity : MOVI_LIVE_MIN_CAPACITY;
+      while (capacity < queued + size)
+        capacity *= 2;
+      uint8_t *grown = (uint8_t *)realloc(l->data, capacity);
+      if (!grown)
+        return 0;
+      l->data = grown;
+      l->capacity = capacity;
+    }
+  }
+  memcpy(l->data + l->end, data, size);
+  l->end += size;
+  return size;
+}
+
+// No more bytes: reads drain what's queued, then report EOF
+EMSCRIPTEN_KEEPALIVE
+void movi_push_eof(MoviContext *ctx) {
+  if (ctx && ctx->live)
+    ctx->live->eof = 1;
+}
+
+// Bytes pushed but not yet read by the demuxer
+EMSCRIPTEN_KEEPALIVE
+int movi_live_buffered(MoviContext *ctx) {
+  return ctx && ctx->live ? ctx->live->end - ctx->live->start : 0;
+}
+
+// AVIO read for live contexts (avio_read_callback): whatever is queued, up to
+// `size`; suspends only on an empty FIFO
+int movi_live_read(MoviContext *ctx, uint8_t *buf, int size) {
+  MoviLive *l = ctx->live;
+  while (l->end == l->start) {
+    if (l->eof)
+      return AVERROR_EOF;
+    MOVI_STAT_START(t0);
+    int ret = js_live_wait(ctx);
+    MOVI_STAT_STOP(ctx, MOVI_STAGE_READ, t0);
+    if (ret < 0)
+      return AVERROR_EXIT; // context going away
+  }
+  int n = l->end - l->start;
+  if (n > size)
+    n = size;
+  memcpy(buf, l->data + l->start, n);
+  l->start += n;
+  if (l->start == l->end)
+    l->start = l->end = 0;
+  MOVI_STAT_ADD(ctx, MOVI_COUNTER_BYTES_READ, n);
+  ctx->position += n;
+  return n;
+}
+
+// Open settings for a live context, between avformat_alloc_context and
+// avformat_open_input (movi_open)
+void movi_live_configure(MoviContext *ctx) {
+  ctx->avio_ctx->seekable = 0;
+  ctx->fmt_ctx->probesize = MOVI_LIVE_PROBESIZE;
+  ctx->fmt_ctx->max_analyze_duration = MOVI_LIVE_ANALYZE_US;
+  ctx->fmt_ctx->fps_probe_size = 0;
+  ctx->fmt_ctx->flags |= AVFMT_FLAG_NOBUFFER;
+}
+
+void movi_live_free(MoviContext *ctx) {
+  if (ctx && ctx->live) {
+    free(ctx->live->data);
+    free(ctx->live);
+    ctx->live = NULL;
+  }
+}
+
+// FIFO bytes held, for movi_context_memory
+double movi_live_memory(MoviContext *ctx) {
+  return ctx && ctx->live ? ctx->live->capacity : 0;
+}
+
+// Would the next read suspend? True when both the FIFO and AVIO's own buffer
+// are drained. movi_read_frames ends a live batch here rather than waiting out
+// the feed for packets it could already have handed back.
+int movi_live_starved(MoviContext *ctx) {
+  MoviLive *l = ctx->live;
+  return l && !l->eof && l->end == l->start && ctx->avio_ctx &&
+         ctx->avio_ctx->buf_ptr >= ctx->avio_ctx->buf_end;
+}
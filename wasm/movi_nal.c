@@ -0,0 +1,506 @@
+#include "movi.h"
+
+// ---- Packet classification -------------------------------------------------
+// Every demuxed video packet gets is_idr / is_rasl / disposable / temporal_id
+// (PacketInfo). That used to be two byte-by-byte NAL walks per packet, each
+// re-detecting Annex B versus length-prefixed framing, and nothing at all for
+// AV1 beyond the first OBU header byte. The framing is a property of the
+// stream, not the packet: avcC/hvcC/vvcC extradata means length prefixes of a
+// size it records, no extradata (MPEG-TS) means start codes. So
+// movi_classifiers_init picks one classifier per stream at movi_open, from
+// the codec and the extradata, and movi_classify_packet fills all four fields
+// in one pass.
+//
+// The NAL walk is inlined into one function per codec and framing, with the
+// codec and length size as constants, so each loop only holds the branches
+// its stream can take. Length-prefixed walks hop from NAL header to NAL
+// header without reading the payloads between; Annex B has to scan for start
+// codes, but only up to the first slice. A packet whose framing contradicts
+// the stream's (an Annex B packet in a Matroska file with avcC, say) switches
+// the stream to the other framing, once, and is classified again.
+//
+// temporal_id is the sub-layer a picture belongs to: HEVC/VVC
+// nuh_temporal_id_plus1 - 1, AV1 temporal_id in the OBU extension, H.264 SVC
+// temporal_id from a prefix NAL. 0 for streams without temporal layering.
+// movi_set_max_temporal_layer drops whole sub-layers on it (end of file).
+
+#define MOVI_CLASSIFY_RUNTIME_LENGTH -1 // length size read from the classifier
+
+typedef void (*MoviClassifyFn)(MoviClassifier *c, const uint8_t *data,
+                               int size, MoviPacketClass *out);
+
+struct MoviClassifier {
+  enum AVCodecID codec_id;
+  MoviClassifyFn classify;
+  int length_size;     // NAL length prefix bytes (1..4); 0 = Annex B
+  int temporal_layers; // sub-layers the extradata signals; 0 = not signalled
+  int reduced_still;   // AV1 sequence header: reduced_still_picture_header
+  int reframed;        // framing was switched after a mismatching packet
+  int max_tid_seen;    // highest temporal_id classified so far
+  int max_tid;         // movi_set_max_temporal_layer limit; -1 = keep all
+  int layer_dropped;   // packets dropped above max_tid
+};
+
+static void classifier_reframe(MoviClassifier *c, const uint8_t *data,
+                               int size, MoviPacketClass *out);
+
+// Next NAL unit from *pos: header at *nal, at most *len bytes long. Returns 1,
+// 0 at the end of the packet, -1 when the bytes don't follow the framing.
+static av_always_inline int nal_next(const uint8_t *data, int size, int *pos,
+                                     int length_size, const uint8_t **nal,
+                                     int *len) {
+  int i = *pos;
+  if (length_size > 0) {
+    if (i + length_size >= size)
+      return 0;
+    uint32_t n = 0;
+    for (int k = 0; k < length_size; k++)
+      n = (n << 8) | data[i + k];
+    i += length_size;
+    if (n == 0 || n > (uint32_t)(size - i))
+      return -1;
+    *nal = data + i;
+    *len = (int)n;
+    *pos = i + (int)n;
+    return 1;
+  }
+  // Annex B: find the next 00 00 01. A byte above 1 at i + 2 can't end a
+  // start code at i, i + 1 or i + 2, so the scan steps by three over payload.
+  while (i + 3 < size) {
+    if (data[i + 2] > 1) {
+      i += 3;
+    } else if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      *nal = data + i + 3;
+      *len = size - (i + 3); // up to the end; only the header is read
+      *pos = i + 3;
+      return 1;
+    } else {
+      i++;
+    }
+  }
+  return *pos == 0 ? -1 : 0;
+}
+
+// One pass over the NALs up to the first VCL one, which decides. codec and
+// length_size are constants in every caller.
+static av_always_inline void classify_nals(MoviClassifier *c,
+                                           const uint8_t *data, int size,
+                                           MoviPacketClass *out,
+                                           enum AVCodecID codec,
+                                           int length_size) {
+  if (length_size == MOVI_CLASSIFY_RUNTIME_LENGTH)
+    length_size = c->length_size;
+  // 00 00 00 01 reads as a valid prefix for a 1-byte NAL, which no codec
+  // here emits: an Annex B packet in a length-prefixed stream
+  if (length_size > 0 && size >= 4 && data[0] == 0 && data[1] == 0 &&
+      data[2] == 0 && data[3] == 1) {
+    classifier_reframe(c, data, size, out);
+    return;
+  }
+  int pos = 0;
+  const uint8_t *nal;
+  int len;
+  int r;
+  while ((r = nal_next(data, size, &pos, length_size, &nal, &len)) > 0) {
+    if (codec == AV_CODEC_ID_H264) {
+      int t = nal[0] & 0x1F;
+      // SVC prefix NAL / slice extension: temporal_id in the third
+      // extension byte when svc_extension_flag is set
+      if ((t == 14 || t == 20) && len >= 4 && (nal[1] & 0x80))
+        out->temporal_id = nal[3] >> 5;
+      if (t >= 1 && t <= 5) {
+        out->is_idr = t == 5;
+        out->disposable = (nal[0] & 0x60) == 0; // nal_ref_idc == 0
+        return;
+      }
+    } else if (codec == AV_CODEC_ID_HEVC) {
+      if (len < 2)
+        continue;
+      int t = (nal[0] >> 1) & 0x3F;
+      // In-band SPS (Annex B has no hvcC): sps_max_sub_layers_minus1
+      if (t == 33 && len >= 3)
+        c->temporal_layers = ((nal[2] >> 1) & 7) + 1;
+      if (t <= 31) {
+        int tid = (nal[1] & 7) - 1;
+        out->temporal_id = tid > 0 ? tid : 0;
+        out->is_idr = t >= 16 && t <= 20; // BLA_* / IDR_*
+        out->is_rasl = t == 8 || t == 9;
+        // Sub-layer non-reference (*_N) at the highest signalled sub-layer:
+        // no picture of any sub-layer references it
+        out->disposable = t <= 14 && !(t & 1) && c->temporal_layers > 0 &&
+                          out->temporal_id == c->temporal_layers - 1;
+        return;
+      }
+    } else { // AV_CODEC_ID_VVC
+      if (len < 2)
+        continue;
+      int t = nal[1] >> 3;
+      if (t == 15 && len >= 4) // SPS: sps_max_sublayers_minus1
+        c->temporal_layers = (nal[3] >> 5) + 1;
+      if (t <= 11) {
+        int tid = (nal[1] & 7) - 1;
+        out->temporal_id = tid > 0 ? tid : 0;
+        out->is_idr = t == 7 || t == 8; // IDR_W_RADL / IDR_N_LP
+        out->is_rasl = t == 3;
+        return;
+      }
+    }
+  }
+  if (r < 0)
+    classifier_reframe(c, data, size, out);
+}
+
+#define MOVI_NAL_CLASSIFIER(name, codec, length_size)                        \
+  static void name(MoviClassifier *c, const uint8_t *data, int size,         \
+                   MoviPacketClass *out) {                                   \
+    classify_nals(c, data, size, out, codec, length_size);                   \
+  }
+
+MOVI_NAL_CLASSIFIER(classify_h264_annexb, AV_CODEC_ID_H264, 0)
+MOVI_NAL_CLASSIFIER(classify_h264_len4, AV_CODEC_ID_H264, 4)
+MOVI_NAL_CLASSIFIER(classify_h264_len, AV_CODEC_ID_H264,
+                    MOVI_CLASSIFY_RUNTIME_LENGTH)
+MOVI_NAL_CLASSIFIER(classify_hevc_annexb, AV_CODEC_ID_HEVC, 0)
+MOVI_NAL_CLASSIFIER(classify_hevc_len4, AV_CODEC_ID_HEVC, 4)
+MOVI_NAL_CLASSIFIER(classify_hevc_len, AV_CODEC_ID_HEVC,
+                    MOVI_CLASSIFY_RUNTIME_LENGTH)
+MOVI_NAL_CLASSIFIER(classify_vvc_annexb, AV_CODEC_ID_VVC, 0)
+MOVI_NAL_CLASSIFIER(classify_vvc_len4, AV_CODEC_ID_VVC, 4)
+MOVI_NAL_CLASSIFIER(classify_vvc_len, AV_CODEC_ID_VVC,
+                    MOVI_CLASSIFY_RUNTIME_LENGTH)
+
+// leb128 as in the AV1 spec (at most 8 bytes). Returns the bytes read, or -1.
+static int av1_leb128(const uint8_t *p, int size, uint64_t *value) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8 && i < size; i++) {
+    v |= (uint64_t)(p[i] & 0x7F) << (i * 7);
+    if (!(p[i] & 0x80)) {
+      *value = v;
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+// MSB-first bit reader for the AV1 sequence header; reads past the end as 0
+typedef struct {
+  const uint8_t *p;
+  int size;
+  int bit;
+} MoviBits;
+
+static uint32_t bits_read(MoviBits *b, int n) {
+  uint32_t v = 0;
+  while (n-- > 0) {
+    int byte = b->bit >> 3;
+    v <<= 1;
+    if (byte < b->size)
+      v |= (b->p[byte] >> (7 - (b->bit & 7))) & 1;
+    b->bit++;
+  }
+  return v;
+}
+
+// sequence_header_obu up to operating_point_idc[0]: operating point 0 is the
+// full stream, and the low 8 bits of its idc are the temporal layers in it
+static void av1_sequence_header(MoviClassifier *c, const uint8_t *p,
+                                int size) {
+  MoviBits b = {p, size, 0};
+  bits_read(&b, 4); // seq_profile, still_picture
+  c->reduced_still = bits_read(&b, 1);
+  if (c->reduced_still) {
+    c->temporal_layers = 1;
+    return;
+  }
+  if (bits_read(&b, 1)) { // timing_info_present_flag
+    bits_read(&b, 32);    // num_units_in_display_tick
+    bits_read(&b, 32);    // time_scale
+    if (bits_read(&b, 1)) { // equal_picture_interval: uvlc
+      int zeros = 0;
+      while (zeros < 32 && !bits_read(&b, 1))
+        zeros++;
+      bits_read(&b, zeros);
+    }
+    if (bits_read(&b, 1)) // decoder_model_info_present_flag
+      bits_read(&b, 5 + 32 + 5 + 5);
+  }
+  bits_read(&b, 1 + 5); // initial_display_delay_present, op count - 1
+  int idc = (int)bits_read(&b, 12) & 0xFF;
+  c->temporal_layers = idc ? 32 - __builtin_clz((unsigned int)idc) : 0;
+}
+
+// OBUs up to the first frame header. is_idr: a shown key frame only. A hidden
+// one (show_frame 0) decodes nothing displayable on its own, and the
+// show_existing_frame that later shows it would need the reference slots
+// tracked, so neither is taken as a seek point. Sequence headers on the way
+// update reduced_still_picture_header, which decides how the header starts.
+static void classify_av1(MoviClassifier *c, const uint8_t *data, int size,
+                         MoviPacketClass *out) {
+  int i = 0;
+  while (i < size) {
+    int h = data[i++];
+    int type = (h >> 3) & 0x0F;
+    int tid = 0;
+    if (h & 0x04) { // obu_extension_flag
+      if (i >= size)
+        return;
+      tid = data[i++] >> 5;
+    }
+    uint64_t len = (uint64_t)(size - i);
+    if (h & 0x02) { // obu_has_size_field
+      int n = av1_leb128(data + i, size - i, &len);
+      if (n < 0)
+        return;
+      i += n;
+    }
+    if (len > (uint64_t)(size - i))
+      return;
+    const uint8_t *p = data + i;
+    if (type == 1 && len > 0) { // OBU_SEQUENCE_HEADER
+      av1_sequence_header(c, p, (int)len);
+    } else if ((type == 3 || type == 6) && len > 0) { // FRAME_HEADER / FRAME
+      out->temporal_id = tid;
+      if (c->reduced_still)
+        out->is_idr = 1; // always a shown key frame
+      else
+        // show_existing_frame 0, frame_type KEY_FRAME, show_frame 1
+        out->is_idr = (p[0] & 0xF0) == 0x10;
+      return;
+    }
+    i += (int)len;
+  }
+}
+
+static void classify_none(MoviClassifier *c, const uint8_t *data, int size,
+                          MoviPacketClass *out) {
+  (void)c;
+  (void)data;
+  (void)size;
+  (void)out;
+}
+
+static MoviClassifyFn classifier_pick(const MoviClassifier *c) {
+  int ls = c->length_size;
+  switch (c->codec_id) {
+  case AV_CODEC_ID_H264:
+    return ls == 0 ? classify_h264_annexb
+                   : ls == 4 ? classify_h264_len4 : classify_h264_len;
+  case AV_CODEC_ID_HEVC:
+    return ls == 0 ? classify_hevc_annexb
+                   : ls == 4 ? classify_hevc_len4 : classify_hevc_len;
+  case AV_CODEC_ID_VVC:
+    return ls == 0 ? classify_vvc_annexb
+                   : ls == 4 ? classify_vvc_len4 : classify_vvc_len;
+  case AV_CODEC_ID_AV1:
+    return classify_av1;
+  default:
+    return classify_none;
+  }
+}
+
+// 1 when 4-byte length prefixes walk `data` exactly to its end
+static int length_walk_covers(const uint8_t *data, int size) {
+  int pos = 0;
+  while (size - pos >= 4) {
+    uint32_t n = (uint32_t)data[pos] << 24 | data[pos + 1] << 16 |
+                 data[pos + 2] << 8 | data[pos + 3];
+    pos += 4;
+    if (n == 0 || n > (uint32_t)(size - pos))
+      return 0;
+    pos += (int)n;
+  }
+  return pos == size;
+}
+
+// The packet doesn't fit the stream's framing. Switch to the other one and
+// classify again only on positive evidence: a start code at the front for a
+// length-prefixed stream, 4-byte lengths that cover the whole packet for an
+// Annex B one. Anything else is a corrupt packet, which keeps the default
+// classification and leaves the framing alone. Once per stream, so it can't
+// flip back and forth.
+static void classifier_reframe(MoviClassifier *c, const uint8_t *data,
+                               int size, MoviPacketClass *out) {
+  memset(out, 0, sizeof(*out)); // drop what the misread NALs set
+  out->is_idr = 1;
+  if (c->reframed || size < 4)
+    return;
+  int length_size;
+  if (c->length_size > 0) {
+    if (!(data[0] == 0 && data[1] == 0 &&
+          (data[2] == 1 || (data[2] == 0 && data[3] == 1))))
+      return;
+    length_size = 0;
+  } else {
+    if (!length_walk_covers(data, size))
+      return;
+    length_size = 4;
+  }
+  c->reframed = 1;
+  c->length_size = length_size;
+  c->classify = classifier_pick(c);
+  c->classify(c, data, size, out);
+}
+
+static void classifier_setup(MoviClassifier *c, const AVCodecParameters *par) {
+  memset(c, 0, sizeof(*c));
+  c->codec_id = par->codec_id;
+  c->max_tid = -1;
+  const uint8_t *x = par->extradata;
+  int n = x ? par->extradata_size : 0;
+  switch (par->codec_id) {
+  case AV_CODEC_ID_H264:
+    // avcC: configurationVersion 1, lengthSizeMinusOne in byte 4
+    if (n >= 7 && x[0] == 1)
+      c->length_size = (x[4] & 3) + 1;
+    break;
+  case AV_CODEC_ID_HEVC:
+    // hvcC (told apart from Annex B parameter sets as hevc_decode_extradata
+    // does): numTemporalLayers and lengthSizeMinusOne in byte 21
+    if (n >= 23 && (x[0] || x[1] || x[2] > 1)) {
+      c->length_size = (x[21] & 3) + 1;
+      c->temporal_layers = (x[21] >> 3) & 7;
+    }
+    break;
+  case AV_CODEC_ID_VVC:
+    // vvcC: 5 reserved 1 bits, lengthSizeMinusOne, ptl_present_flag; with
+    // PTL, num_sublayers follows the 9-bit ols_idx
+    if (n >= 1 && (x[0] & 0xF8) == 0xF8) {
+      c->length_size = ((x[0] >> 1) & 3) + 1;
+      if ((x[0] & 1) && n >= 3)
+        c->temporal_layers = (x[2] >> 4) & 7;
+    }
+    break;
+  case AV_CODEC_ID_AV1:
+    // av1C: 4-byte header, then configOBUs (the sequence header)
+    if (n > 4 && (x[0] & 0x80)) {
+      MoviPacketClass unused;
+      classify_av1(c, x + 4, n - 4, &unused);
+    }
+    break;
+  default:
+    break;
+  }
+  c->classify = classifier_pick(c);
+}
+
+int movi_classifiers_init(MoviContext *ctx) {
+  if (!ctx || !ctx->fmt_ctx)
+    return -1;
+  movi_classifiers_free(ctx);
+  ctx->layer_limits = 0;
+  int count = (int)ctx->fmt_ctx->nb_streams;
+  if (count == 0)
+    return 0;
+  ctx->classifiers = calloc(count, sizeof(MoviClassifier));
+  if (!ctx->classifiers)
+    return -1;
+  for (int i = 0; i < count; i++)
+    classifier_setup(&ctx->classifiers[i], ctx->fmt_ctx->streams[i]->codecpar);
+  ctx->classifier_count = count;
+  return 0;
+}
+
+void movi_classifiers_free(MoviContext *ctx) {
+  if (ctx) {
+    free(ctx->classifiers);
+    ctx->classifiers = NULL;
+    ctx->classifier_count = 0;
+  }
+}
+
+// Streams can appear after movi_open (MPEG-TS, NOHEADER formats): set them up
+// on their first packet
+static MoviClassifier *classifier_for(MoviContext *ctx, int stream_index) {
+  if (stream_index < 0 || stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return NULL;
+  if (stream_index >= ctx->classifier_count) {
+    int count = (int)ctx->fmt_ctx->nb_streams;
+    MoviClassifier *list =
+        realloc(ctx->classifiers, count * sizeof(MoviClassifier));
+    if (!list)
+      return NULL;
+    for (int i = ctx->classifier_count; i < count; i++)
+      classifier_setup(&list[i], ctx->fmt_ctx->streams[i]->codecpar);
+    ctx->classifiers = list;
+    ctx->classifier_count = count;
+  }
+  return &ctx->classifiers[stream_index];
+}
+
+void movi_classify_packet(MoviContext *ctx, const AVPacket *pkt,
+                          MoviPacketClass *out) {
+  memset(out, 0, sizeof(*out));
+  // No slice / frame header found: trust the container's keyframe flag
+  out->is_idr = 1;
+  if (!ctx || !ctx->fmt_ctx || !pkt || !pkt->data || pkt->size <= 0)
+    return;
+  MoviClassifier *c = classifier_for(ctx, pkt->stream_index);
+  if (c) {
+    c->classify(c, pkt->data, pkt->size, out);
+    if (out->temporal_id > c->max_tid_seen)
+      c->max_tid_seen = out->temporal_id;
+  }
+}
+
+// ---- Temporal sub-layer dropping -------------------------------------------
+// 120fps HEVC with temporal sub-layers (or AV1 with temporal operating points)
+// on a 60Hz display decodes twice the pictures it can show, and
+// movi_set_skip_frame / load shedding only drop non-reference frames, which
+// leaves uneven gaps. No picture references one in a higher sub-layer, so
+// everything above a TemporalId can go and the rest still decodes, at the
+// frame rate of that layer (half per layer in the usual dyadic hierarchy).
+// JS picks the limit from the display refresh rate; packets above it are
+// dropped in movi_next_packet, before anything copies them out or decodes.
+
+// 1 when the demuxed packet is above its stream's temporal-layer limit
+int movi_layer_drop(MoviContext *ctx, const AVPacket *pkt,
+                    const MoviPacketClass *cls) {
+  if (!ctx->layer_limits || (pkt->flags & AV_PKT_FLAG_KEY))
+    return 0;
+  MoviClassifier *c = classifier_for(ctx, pkt->stream_index);
+  if (!c || c->max_tid < 0 || cls->temporal_id <= c->max_tid)
+    return 0;
+  c->layer_dropped++;
+  return 1;
+}
+
+// Keep sub-layers 0..max_tid of `stream_index` (max_tid < 0 keeps all).
+// Applies from the next packet read; resets the stream's drop count.
+EMSCRIPTEN_KEEPALIVE
+int movi_set_max_temporal_layer(MoviContext *ctx, int stream_index,
+                                int max_tid) {
+  if (!ctx || !ctx->fmt_ctx)
+    return -1;
+  MoviClassifier *c = classifier_for(ctx, stream_index);
+  if (!c)
+    return -1;
+  int limit = max_tid < 0 ? -1 : max_tid;
+  if ((c->max_tid >= 0) != (limit >= 0))
+    ctx->layer_limits += limit >= 0 ? 1 : -1;
+  c->max_tid = limit;
+  c->layer_dropped = 0;
+  return 0;
+}
+
+// Temporal sub-layers of a stream: what its extradata, SPS or AV1 operating
+// point signals, or the highest temporal_id demuxed so far + 1 when that's
+// more. 1 = no temporal scalability (or none seen yet), -1 = bad arguments.
+EMSCRIPTEN_KEEPALIVE
+int movi_temporal_layers(MoviContext *ctx, int stream_index) {
+  if (!ctx || !ctx->fmt_ctx)
+    return -1;
+  MoviClassifier *c = classifier_for(ctx, stream_index);
+  if (!c)
+    return -1;
+  int seen = c->max_tid_seen + 1;
+  return c->temporal_layers > seen ? c->temporal_layers : seen;
+}
+
+// Packets of `stream_index` dropped above its limit since it was set
+EMSCRIPTEN_KEEPALIVE
+int movi_temporal_dropped(MoviContext *ctx, int stream_index) {
+  if (!ctx || !ctx->fmt_ctx)
+    return 0;
+  MoviClassifier *c = classifier_for(ctx, stream_index);
+  return c ? c->layer_dropped : 0;
+}
@@ -0,0 +1,715 @@
+#include "movi.h"
+#include <libavutil/imgutils.h>
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+// ---- Software video decode run-ahead (mt build) --------------------------
+// Without this, demux (Asyncify movi_read_frame), software decode
+// (movi_send_packet / movi_receive_frame) and RGBA conversion all run on the
+// JS thread one after another: a slow 4K frame holds up the next read, and a
+// network stall leaves the decoder idle. A pipeline moves one video stream's
+// decode and conversion onto two threads of its own:
+//
+//   JS thread       demux → movi_pipeline_send ──┐ packets
+//   decode thread   avcodec_send/receive ────────┤ decoded
+//   convert thread  RGBA conversion (optional) ──┤ output
+//   JS thread       movi_pipeline_receive → ctx->frame
+//
+// Each arrow is a bounded single-producer/single-consumer ring of AVPacket /
+// AVFrame references in the shared heap, so no stage takes a lock to hand work
+// on. The JS thread never waits: a full packet ring makes movi_pipeline_send
+// return AVERROR(EAGAIN) (backpressure up to the demux loop) and an empty
+// output ring makes movi_pipeline_receive return it. The worker stages sleep
+// on a futex bumped by every ring change and block while their output ring is
+// full. Demux stays on the JS thread: its reads are JS I/O callbacks.
+//
+// While a pipeline runs it owns the stream's decoder: movi_flush_decoder is
+// routed to movi_pipeline_flush, movi_trim leaves the decoder alone and
+// movi_send_packet / movi_receive_frame return AVERROR(EBUSY). The convert
+// stage keeps its own scaler and tone-mapping tables, so the JS thread can
+// still convert a frame itself meanwhile. Frames reach JS through
+// ctx->frame, so movi_get_frame_pts, movi_frame_retain and the RGBA getters
+// work on them as on directly decoded frames. The single-threaded builds
+// export the same functions; movi_pipeline_start fails there and JS keeps
+// decoding inline.
+
+#define MOVI_PIPE_MAX_DEPTH 64
+// Longest a worker sleeps before re-checking for a stop request
+#define MOVI_PIPE_WAIT_MS 50
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+
+typedef struct {
+  void *item;
+  uint32_t gen; // movi_pipeline_flush generation it belongs to
+} MoviPipeSlot;
+
+typedef struct {
+  MoviPipeSlot *slots;
+  uint32_t mask;
+  _Atomic uint32_t head; // items pushed, written by the producer only
+  _Atomic uint32_t tail; // items popped, written by the consumer only
+  _Atomic uint32_t peak; // highest occupancy seen
+  _Atomic uint32_t full; // times the producer found it full
+} MoviPipeRing;
+
+// Worker thread state: a thread that hasn't started when the pipeline stops
+// is cancelled instead of waited for (the JS thread would otherwise spin on a
+// worker that can't be brought up while it spins).
+enum { PIPE_PENDING = 0, PIPE_RUNNING, PIPE_EXITED, PIPE_CANCELLED };
+
+// Either half 0xFFFF (MOVI_DISCARD_KEEP; no AVDiscard is -1) leaves that
+// field as it is, so both halves at 0xFFFF is nothing pending
+#define PIPE_NO_DISCARD UINT32_MAX
+
+struct MoviPipeline {
+  MoviContext *ctx;
+  AVCodecContext *dec;
+  int stream_index;
+  MoviPipeRing packets;
+  MoviPipeRing decoded;
+  MoviPipeRing output;
+  _Atomic uint32_t gen;  // bumped by movi_pipeline_flush
+  _Atomic uint32_t wake; // futex word, bumped on every ring change
+  _Atomic int stop;
+  _Atomic int refs; // owner + threads; the last one out frees the struct
+  _Atomic int decode_state;
+  _Atomic int convert_state;
+  // skip_frame << 16 | skip_loop_filter queued for the decode thread by
+  // movi_pipeline_set_discard, PIPE_NO_DISCARD when nothing is pending
+  _Atomic uint32_t discard;
+  // RGBA target for the convert stage, width << 32 | height in one word so
+  // the stage never pairs one call's width with another's height; 0 passes
+  // decoded frames through
+  _Atomic uint64_t rgba_size;
+  // Convert stage only
+  struct SwsContext *sws;
+  MoviToneMap *tonemap;
+  AVBufferPool *rgba_pool;
+  int rgba_pool_size;
+  // Stage metrics (movi_pipeline_stats)
+  _Atomic uint64_t decode_us;
+  _Atomic uint64_t convert_us;
+  _Atomic uint32_t frames_decoded;
+  _Atomic uint32_t frames_converted;
+  _Atomic uint32_t decode_errors;
+};
+
+static int pipe_ring_init(MoviPipeRing *r, int depth) {
+  uint32_t cap = 2;
+  while (cap < (uint32_t)depth)
+    cap *= 2;
+  r->slots = calloc(cap, sizeof(MoviPipeSlot));
+  if (!r->slots)
+    return -1;
+  r->mask = cap - 1;
+  return 0;
+}
+
+static uint32_t pipe_ring_used(MoviPipeRing *r) {
+  return atomic_load_explicit(&r->head, memory_order_acquire) -
+         atomic_load_explicit(&r->tail, memory_order_acquire);
+}
+
+static int pipe_ring_push(MoviPipeRing *r, void *item, uint32_t gen) {
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+  if (head - tail > r->mask)
+    return 0;
+  r->slots[head & r->mask] = (MoviPipeSlot){item, gen};
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+  uint32_t used = head + 1 - tail;
+  if (used > atomic_load_explicit(&r->peak, memory_order_relaxed))
+    atomic_store_explicit(&r->peak, used, memory_order_relaxed);
+  return 1;
+}
+
+static int pipe_ring_pop(MoviPipeRing *r, MoviPipeSlot *out) {
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  if (tail == head)
+    return 0;
+  *out = r->slots[tail & r->mask];
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+static void pipe_notify(MoviPipeline *p) {
+  atomic_fetch_add(&p->wake, 1);
+  emscripten_futex_wake((void *)&p->wake, INT_MAX);
+}
+
+// Count one stall per item that finds `r` full, however often it retries
+static void pipe_ring_stalled(MoviPipeRing *r, int *blocked) {
+  if (!*blocked)
+    atomic_fetch_add_explicit(&r->full, 1, memory_order_relaxed);
+  *blocked = 1;
+}
+
+// Sleep until the wake word moves on from `seen` (read before the caller
+// found nothing to do, so a change in between isn't missed)
+static void pipe_wait(MoviPipeline *p, uint32_t seen) {
+  emscripten_futex_wait((void *)&p->wake, seen, MOVI_PIPE_WAIT_MS);
+}
+
+static uint64_t pipe_now_us(void) {
+  return (uint64_t)(emscripten_get_now() * 1000.0);
+}
+
+static void pipe_unref(MoviPipeline *p) {
+  if (atomic_fetch_sub(&p->refs, 1) != 1)
+    return;
+  free(p->packets.slots);
+  free(p->decoded.slots);
+  free(p->output.slots);
+  free(p);
+}
+
+// PIPE_PENDING → PIPE_RUNNING, unless the pipeline was stopped first
+static int pipe_thread_enter(_Atomic int *state) {
+  int expected = PIPE_PENDING;
+  return atomic_compare_exchange_strong(state, &expected, PIPE_RUNNING);
+}
+
+// Apply a movi_pipeline_set_discard change to the decoder; on the decode
+// thread, or once it's gone
+static void pipe_apply_discard(MoviPipeline *p) {
+  uint32_t d = atomic_exchange(&p->discard, PIPE_NO_DISCARD);
+  if (d == PIPE_NO_DISCARD)
+    return;
+  if ((d >> 16) != 0xFFFF)
+    p->dec->skip_frame = (enum AVDiscard)(int16_t)(d >> 16);
+  if ((d & 0xFFFF) != 0xFFFF)
+    p->dec->skip_loop_filter = (enum AVDiscard)(int16_t)(d & 0xFFFF);
+}
+
+// PIPE_RUNNING → PIPE_EXITED, waking pipe_join. Before the thread's
+// pipe_unref: the joining owner still holds its reference, so p is alive.
+static void pipe_thread_exit(MoviPipeline *p, _Atomic int *state) {
+  atomic_store(state, PIPE_EXITED);
+  emscripten_futex_wake((void *)state, INT_MAX);
+  pipe_unref(p);
+}
+
+static void *pipe_decode_main(void *arg) {
+  MoviPipeline *p = arg;
+  if (!pipe_thread_enter(&p->decode_state)) {
+    pipe_unref(p);
+    return NULL;
+  }
+  AVCodecContext *dec = p->dec;
+  AVFrame *frame = NULL; // decoded, waiting for room in p->decoded
+  AVFrame *spare = NULL; // receive target, reused while the decoder is dry
+  int blocked = 0;
+  uint32_t gen = atomic_load(&p->gen);
+  while (!atomic_load(&p->stop)) {
+    uint32_t seen = atomic_load(&p->wake);
+    uint32_t cur = atomic_load(&p->gen);
+    if (cur != gen) {
+      av_frame_free(&frame);
+      avcodec_flush_buffers(dec);
+      gen = cur;
+    }
+    pipe_apply_discard(p);
+    if (frame) {
+      if (!pipe_ring_push(&p->decoded, frame, gen)) {
+        pipe_ring_stalled(&p->decoded, &blocked);
+        pipe_wait(p, seen);
+        continue;
+      }
+      blocked = 0;
+      frame = NULL;
+      pipe_notify(p);
+    }
+
+    // Drain the decoder before feeding it, as the send/receive API expects
+    if (!spare && !(spare = av_frame_alloc())) {
+      pipe_wait(p, seen);
+      continue;
+    }
+    uint64_t t0 = pipe_now_us();
+    int ret = avcodec_receive_frame(dec, spare);
+    atomic_fetch_add(&p->decode_us, pipe_now_us() - t0);
+    if (ret == 0) {
+      atomic_fetch_add(&p->frames_decoded, 1);
+      frame = spare;
+      spare = NULL;
+      continue;
+    }
+    if (ret == AVERROR_EOF)
+      avcodec_flush_buffers(dec); // drained by an empty packet; ready again
+
+    MoviPipeSlot slot;
+    if (!pipe_ring_pop(&p->packets, &slot)) {
+      pipe_wait(p, seen);
+      continue;
+    }
+    AVPacket *pkt = slot.item;
+    if (slot.gen != gen && slot.gen == atomic_load(&p->gen)) {
+      // First packet after a flush this loop hadn't noticed yet
+      avcodec_flush_buffers(dec);
+      gen = slot.gen;
+    }
+    if (slot.gen == gen) {
+      t0 = pipe_now_us();
+      ret = avcodec_send_packet(dec, pkt->size > 0 ? pkt : NULL);
+      atomic_fetch_add(&p->decode_us, pipe_now_us() - t0);
+      if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+        atomic_fetch_add(&p->decode_errors, 1);
+    }
+    av_packet_free(&pkt);
+  }
+  av_frame_free(&frame);
+  av_frame_free(&spare);
+  pipe_thread_exit(p, &p->decode_state);
+  return NULL;
+}
+
+// RGBA copy of `src` at width x height from the stage's buffer pool, or NULL
+// to pass the frame on unconverted
+static AVFrame *pipe_convert(MoviPipeline *p, const AVFrame *src,
+                             int width, int height) {
+  int size = av_image_get_buffer_size(AV_PIX_FMT_RGBA, width, height, 1);
+  if (size <= 0)
+    return NULL;
+  if (size > p->rgba_pool_size) {
+    // Buffers still out (frames JS hasn't received) keep the old pool alive
+    av_buffer_pool_uninit(&p->rgba_pool);
+    p->rgba_pool = av_buffer_pool_init(size, NULL);
+    p->rgba_pool_size = p->rgba_pool ? size : 0;
+    if (!p->rgba_pool)
+      return NULL;
+  }
+  AVFrame *dst = av_frame_alloc();
+  if (!dst)
+    return NULL;
+  dst->buf[0] = av_buffer_pool_get(p->rgba_pool);
+  if (!dst->buf[0] || av_frame_copy_props(dst, src) < 0) {
+    av_frame_free(&dst);
+    return NULL;
+  }
+  dst->format = AV_PIX_FMT_RGBA;
+  dst->width = width;
+  dst->height = height;
+  av_image_fill_arrays(dst->data, dst->linesize, dst->buf[0]->data,
+                       AV_PIX_FMT_RGBA, width, height, 1);
+
+  // Same order as movi_get_frame_rgba: high bit depth, SIMD 4:2:0, swscale
+  int tonemapped = 0;
+  if (movi_tonemap_convert(&p->tonemap, p->ctx->hdr_tonemap, src,
+                           dst->data[0], dst->linesize[0], width, height) == 0) {
+    tonemapped = p->ctx->hdr_tonemap;
+  } else if (width != src->width || height != src->height ||
+             movi_yuv420p_to_rgba(src, dst->data[0], dst->linesize[0]) != 0) {
+    p->sws = sws_getCachedContext(p->sws, src->width, src->height, src->format,
+                                  width, height, AV_PIX_FMT_RGBA,
+                                  SWS_FAST_BILINEAR, NULL, NULL, NULL);
+    if (!p->sws) {
+      av_frame_free(&dst);
+      return NULL;
+    }
+    sws_scale(p->sws, (const uint8_t *const *)src->data, src->linesize, 0,
+              src->height, dst->data, dst->linesize);
+  }
+  dst->colorspace = AVCOL_SPC_RGB;
+  dst->color_range = AVCOL_RANGE_JPEG;
+  if (tonemapped &&
+      (src->color_trc == AVCOL_TRC_SMPTE2084 ||
+       src->color_trc == AVCOL_TRC_ARIB_STD_B67)) {
+    dst->color_trc = AVCOL_TRC_BT709;
+    dst->color_primaries = AVCOL_PRI_BT709;
+  }
+  return dst;
+}
+
+static void *pipe_convert_main(void *arg) {
+  MoviPipeline *p = arg;
+  if (!pipe_thread_enter(&p->convert_state)) {
+    pipe_unref(p);
+    return NULL;
+  }
+  AVFrame *ready = NULL; // waiting for room in p->output
+  uint32_t ready_gen = 0;
+  int blocked = 0;
+  while (!atomic_load(&p->stop)) {
+    uint32_t seen = atomic_load(&p->wake);
+    if (ready && ready_gen != atomic_load(&p->gen)) {
+      av_frame_free(&ready);
+      blocked = 0;
+    }
+    if (ready) {
+      if (!pipe_ring_push(&p->output, ready, ready_gen)) {
+        pipe_ring_stalled(&p->output, &blocked);
+        pipe_wait(p, seen);
+        continue;
+      }
+      blocked = 0;
+      ready = NULL;
+      pipe_notify(p);
+    }
+
+    MoviPipeSlot slot;
+    if (!pipe_ring_pop(&p->decoded, &slot)) {
+      pipe_wait(p, seen);
+      continue;
+    }
+    pipe_notify(p); // the decode stage may be waiting for room
+    AVFrame *frame = slot.item;
+    if (slot.gen != atomic_load(&p->gen)) {
+      av_frame_free(&frame);
+      continue;
+    }
+    uint64_t rgba_size = atomic_load(&p->rgba_size);
+    int width = (int)(rgba_size >> 32);
+    int height = (int)(uint32_t)rgba_size;
+    if (width > 0 && height > 0 && frame->width > 0) {
+      uint64_t t0 = pipe_now_us();
+      AVFrame *rgba = pipe_convert(p, frame, width, height);
+      atomic_fetch_add(&p->convert_us, pipe_now_us() - t0);
+      if (rgba) {
+        av_frame_free(&frame);
+        frame = rgba;
+        atomic_fetch_add(&p->frames_converted, 1);
+      }
+    }
+    ready = frame;
+    ready_gen = slot.gen;
+  }
+  av_frame_free(&ready);
+  sws_freeContext(p->sws);
+  p->sws = NULL;
+  av_freep(&p->tonemap);
+  av_buffer_pool_uninit(&p->rgba_pool);
+  pipe_thread_exit(p, &p->convert_state);
+  return NULL;
+}
+
+// Cancel a thread that never started, or wait for a running one to exit.
+// The worker wakes the state word when it leaves (pipe_thread_exit); the
+// timeout only re-sends the wake-up a worker between its stop check and its
+// own futex wait could have missed.
+static void pipe_join(MoviPipeline *p, _Atomic int *state) {
+  int expected = PIPE_PENDING;
+  if (atomic_compare_exchange_strong(state, &expected, PIPE_CANCELLED))
+    return;
+  while (atomic_load(state) == PIPE_RUNNING) {
+    pipe_notify(p);
+    emscripten_futex_wait((void *)state, PIPE_RUNNING, MOVI_PIPE_WAIT_MS);
+  }
+}
+
+static void pipe_ring_drain_packets(MoviPipeRing *r) {
+  MoviPipeSlot slot;
+  while (pipe_ring_pop(r, &slot)) {
+    AVPacket *pkt = slot.item;
+    av_packet_free(&pkt);
+  }
+}
+
+static void pipe_ring_drain_frames(MoviPipeRing *r) {
+  MoviPipeSlot slot;
+  while (pipe_ring_pop(r, &slot)) {
+    AVFrame *frame = slot.item;
+    av_frame_free(&frame);
+  }
+}
+
+/**
+ * Run stream_index's (already enabled) software video decoder on its own
+ * decode and convert threads, with `depth` packets / frames per ring
+ * (clamped to 2..64). Returns 0, -1 when the build has no threads or the
+ * stream has no decoder, -2 when a pipeline already runs, -3 on OOM.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_start(MoviContext *ctx, int stream_index, int depth) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->decoders || stream_index < 0 ||
+      stream_index >= (int)ctx->fmt_ctx->nb_streams ||
+      !ctx->decoders[stream_index] ||
+      ctx->decoders[stream_index]->codec_type != AVMEDIA_TYPE_VIDEO)
+    return -1;
+  if (ctx->pipeline)
+    return -2;
+  if (depth < 2)
+    depth = 2;
+  if (depth > MOVI_PIPE_MAX_DEPTH)
+    depth = MOVI_PIPE_MAX_DEPTH;
+  MoviPipeline *p = calloc(1, sizeof(*p));
+  if (!p)
+    return -3;
+  p->ctx = ctx;
+  p->dec = ctx->decoders[stream_index];
+  p->stream_index = stream_index;
+  p->discard = PIPE_NO_DISCARD;
+  if (pipe_ring_init(&p->packets, depth) < 0 ||
+      pipe_ring_init(&p->decoded, depth) < 0 ||
+      pipe_ring_init(&p->output, depth) < 0) {
+    p->refs = 1;
+    pipe_unref(p);
+    return -3;
+  }
+  // Frames already decoded inline belong to the previous regime
+  avcodec_flush_buffers(p->dec);
+
+  p->refs = 3;
+  pthread_t t;
+  if (pthread_create(&t, NULL, pipe_decode_main, p) != 0) {
+    p->refs = 1;
+    pipe_unref(p);
+    return -3;
+  }
+  pthread_detach(t);
+  if (pthread_create(&t, NULL, pipe_convert_main, p) != 0) {
+    atomic_store(&p->stop, 1);
+    pipe_join(p, &p->decode_state);
+    atomic_fetch_sub(&p->refs, 1); // the convert thread's
+    pipe_unref(p);
+    return -3;
+  }
+  pthread_detach(t);
+  ctx->pipeline = p;
+  return 0;
+}
+
+/**
+ * Queue one packet for the pipelined decoder; same arguments as
+ * movi_send_packet (NULL/0 drains the decoder). Returns 0, AVERROR(EAGAIN)
+ * when the packet ring is full (keep the packet and send it again after
+ * receiving), or < 0 on error.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_send(MoviContext *ctx, uint8_t *data, int size, double pts,
+                       double dts, int keyframe) {
+  MoviPipeline *p = ctx ? ctx->pipeline : NULL;
+  if (!p)
+    return -1;
+  if (pipe_ring_used(&p->packets) > p->packets.mask) {
+    atomic_fetch_add_explicit(&p->packets.full, 1, memory_order_relaxed);
+    return AVERROR(EAGAIN);
+  }
+  // Payload from the same pool movi_send_packet uses; the decode thread's
+  // av_packet_free hands the buffer back (AVBufferPool is thread-safe)
+  AVPacket *pkt = av_packet_alloc();
+  if (!pkt)
+    return -3;
+  if (movi_packet_fill_pooled(ctx, pkt, data, size) < 0) {
+    av_packet_free(&pkt);
+    return -3;
+  }
+  AVRational tb = ctx->fmt_ctx->streams[p->stream_index]->time_base;
+  if (pts >= 0)
+    pkt->pts = (int64_t)(pts / av_q2d(tb));
+  if (dts >= 0)
+    pkt->dts = (int64_t)(dts / av_q2d(tb));
+  if (keyframe)
+    pkt->flags |= AV_PKT_FLAG_KEY;
+  pkt->stream_index = p->stream_index;
+  // The only producer of this ring, and there was room above
+  pipe_ring_push(&p->packets, pkt, atomic_load(&p->gen));
+  pipe_notify(p);
+  return 0;
+}
+
+/**
+ * Move the next finished frame into ctx->frame. Returns 0, or AVERROR(EAGAIN)
+ * when none is ready yet.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_receive(MoviContext *ctx) {
+  MoviPipeline *p = ctx ? ctx->pipeline : NULL;
+  if (!p || !ctx->frame)
+    return -1;
+  MoviPipeSlot slot;
+  uint32_t gen = atomic_load(&p->gen);
+  while (pipe_ring_pop(&p->output, &slot)) {
+    pipe_notify(p); // room for the convert stage
+    AVFrame *frame = slot.item;
+    if (slot.gen != gen) {
+      av_frame_free(&frame);
+      continue;
+    }
+    av_frame_unref(ctx->frame);
+    av_frame_move_ref(ctx->frame, frame);
+    av_frame_free(&frame);
+    return 0;
+  }
+  return AVERROR(EAGAIN);
+}
+
+/**
+ * Drop everything queued or in flight and reset the decoder (before a seek).
+ * Packets sent after this call decode from a clean state; returns at once,
+ * the stages discard stale work as they reach it.
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_pipeline_flush(MoviContext *ctx) {
+  MoviPipeline *p = ctx ? ctx->pipeline : NULL;
+  if (!p)
+    return;
+  atomic_fetch_add(&p->gen, 1);
+  pipe_ring_drain_frames(&p->output);
+  pipe_notify(p);
+}
+
+/**
+ * Convert frames to width x height RGBA on the convert thread (for formats
+ * with no VideoFrame equivalent); 0 x 0 passes decoded frames through.
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_pipeline_set_rgba(MoviContext *ctx, int width, int height) {
+  MoviPipeline *p = ctx ? ctx->pipeline : NULL;
+  if (!p)
+    return;
+  atomic_store(&p->rgba_size, width > 0 && height > 0
+                                   ? (uint64_t)width << 32 | (uint32_t)height
+                                   : 0);
+}
+
+/**
+ * Stage occupancy and load into out[14]:
+ *   [0] ring capacity
+ *   [1] packets queued  [2] peak  [3] sends refused (ring full)
+ *   [4] frames decoded and waiting for conversion  [5] peak
+ *   [6] decode stage blocked on a full ring
+ *   [7] frames ready for JS  [8] peak  [9] convert stage blocked
+ *   [10] decode thread busy (ms)  [11] convert thread busy (ms)
+ *   [12] frames decoded  [13] frames converted to RGBA
+ * Returns 0, or -1 without a pipeline.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_stats(MoviContext *ctx, double *out) {
+  MoviPipeline *p = ctx ? ctx->pipeline : NULL;
+  if (!p || !out)
+    return -1;
+  out[0] = p->packets.mask + 1;
+  out[1] = pipe_ring_used(&p->packets);
+  out[2] = atomic_load(&p->packets.peak);
+  out[3] = atomic_load(&p->packets.full);
+  out[4] = pipe_ring_used(&p->decoded);
+  out[5] = atomic_load(&p->decoded.peak);
+  out[6] = atomic_load(&p->decoded.full);
+  out[7] = pipe_ring_used(&p->output);
+  out[8] = atomic_load(&p->output.peak);
+  out[9] = atomic_load(&p->output.full);
+  out[10] = atomic_load(&p->decode_us) / 1000.0;
+  out[11] = atomic_load(&p->convert_us) / 1000.0;
+  out[12] = atomic_load(&p->frames_decoded);
+  out[13] = atomic_load(&p->frames_converted);
+  return 0;
+}
+
+/**
+ * Stop the pipeline and hand the decoder back to inline decoding (flushed).
+ * Called from movi_destroy before the decoders are freed.
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_pipeline_stop(MoviContext *ctx) {
+  MoviPipeline *p = ctx ? ctx->pipeline : NULL;
+  if (!p)
+    return;
+  ctx->pipeline = NULL;
+  atomic_store(&p->stop, 1);
+  pipe_join(p, &p->decode_state);
+  pipe_join(p, &p->convert_state);
+  // Both stages are gone (or never ran): the rings are ours alone now
+  pipe_ring_drain_packets(&p->packets);
+  pipe_ring_drain_frames(&p->decoded);
+  pipe_ring_drain_frames(&p->output);
+  avcodec_flush_buffers(p->dec);
+  pipe_apply_discard(p); // queued after the decode stage last looked
+  pipe_unref(p);
+}
+
+int movi_pipeline_owns(const MoviContext *ctx, int stream_index) {
+  return ctx && ctx->pipeline && ctx->pipeline->stream_index == stream_index;
+}
+
+int movi_pipeline_set_discard(MoviContext *ctx, int stream_index,
+                              enum AVDiscard skip_frame,
+                              enum AVDiscard skip_loop_filter) {
+  if (!movi_pipeline_owns(ctx, stream_index))
+    return 0;
+  // Merge into whatever is still pending: movi_set_skip_frame and load
+  // shedding each queue only the fields they own
+  _Atomic uint32_t *discard = &ctx->pipeline->discard;
+  uint32_t old = atomic_load(discard);
+  uint32_t d;
+  do {
+    d = old;
+    if (skip_frame != MOVI_DISCARD_KEEP)
+      d = (d & 0xFFFF) | (uint32_t)(uint16_t)skip_frame << 16;
+    if (skip_loop_filter != MOVI_DISCARD_KEEP)
+      d = (d & 0xFFFF0000u) | (uint16_t)skip_loop_filter;
+  } while (!atomic_compare_exchange_weak(discard, &old, d));
+  return 1;
+}
+
+#else // single-threaded builds: no pipeline, JS decodes inline
+
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_start(MoviContext *ctx, int stream_index, int depth) {
+  (void)ctx;
+  (void)stream_index;
+  (void)depth;
+  return -1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_send(MoviContext *ctx, uint8_t *data, int size, double pts,
+                       double dts, int keyframe) {
+  (void)ctx;
+  (void)data;
+  (void)size;
+  (void)pts;
+  (void)dts;
+  (void)keyframe;
+  return -1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_receive(MoviContext *ctx) {
+  (void)ctx;
+  return -1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void movi_pipeline_flush(MoviContext *ctx) { (void)ctx; }
+
+EMSCRIPTEN_KEEPALIVE
+void movi_pipeline_set_rgba(MoviContext *ctx, int width, int height) {
+  (void)ctx;
+  (void)width;
+  (void)height;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_pipeline_stats(MoviContext *ctx, double *out) {
+  (void)ctx;
+  (void)out;
+  return -1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void movi_pipeline_stop(MoviContext *ctx) { (void)ctx; }
+
+int movi_pipeline_owns(const MoviContext *ctx, int stream_index) {
+  (void)ctx;
+  (void)stream_index;
+  return 0;
+}
+
+int movi_pipeline_set_discard(MoviContext *ctx, int stream_index,
+                              enum AVDiscard skip_frame,
+                              enum AVDiscard skip_loop_filter) {
+  (void)ctx;
+  (void)stream_index;
+  (void)skip_frame;
+  (void)skip_loop_filter;
+  return 0;
+}
+
+#endif
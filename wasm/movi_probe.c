@@ -0,0 +1,326 @@
+#include "movi.h"
+
+// ---- Cached stream descriptors ---------------------------------------------
+// movi_open runs avformat_find_stream_info with a 10MB / 5s budget, and every
+// isolated context (preview, storyboard workers) probed the same file again.
+// Over HTTP those probe reads dominate time-to-first-frame, yet all they add
+// to what the header already said is decoder-derived detail: pixel/sample
+// format, profile/level, colour, reorder delay, frame rates, durations.
+//
+// movi_probe_export serialises that result once a context has probed:
+// per-stream codecpar (extradata included), time base, frame rates and
+// timings, plus the format-level start/duration/bit rate that the StreamInfo
+// getters read. JS stores the blob under the source fingerprint, and
+// movi_probe_import / movi_thumbnail_import_probe hand it to a later context
+// before it opens. After avformat_open_input, movi_probe_apply checks the blob
+// against what the header produced — same file size and demuxer, same streams
+// with the same codecs and time bases, matching dimensions, sample rate and
+// extradata where the header has them — and on a match fills the rest in and
+// the probe is skipped. Any mismatch falls back to a normal probe. Demuxers
+// that create streams while reading (AVFMTCTX_NOHEADER, e.g. MPEG-TS) always
+// probe: their header says nothing a descriptor could be checked against.
+
+#define MOVI_PROBE_MAGIC 0x5250564d // "MVPR"
+#define MOVI_PROBE_VERSION 1
+
+// Serialised layout (little-endian, as WASM is on both ends). Each stream
+// record is followed by its extradata_size bytes of extradata.
+typedef struct {
+  int32_t magic;
+  int32_t version;
+  int32_t nb_streams;
+  int32_t reserved;
+  int64_t file_size;
+  int64_t start_time; // AV_TIME_BASE
+  int64_t duration;   // AV_TIME_BASE
+  int64_t bit_rate;
+  char format[32]; // iformat->name, truncated
+} MoviProbeHeader;
+
+typedef struct {
+  int32_t codec_type;
+  int32_t codec_id;
+  uint32_t codec_tag;
+  int32_t format;
+  int64_t bit_rate;
+  int32_t bits_per_coded_sample;
+  int32_t bits_per_raw_sample;
+  int32_t profile;
+  int32_t level;
+  int32_t width;
+  int32_t height;
+  int32_t sar_num;
+  int32_t sar_den;
+  int32_t field_order;
+  int32_t color_range;
+  int32_t color_primaries;
+  int32_t color_trc;
+  int32_t color_space;
+  int32_t chroma_location;
+  int32_t video_delay;
+  int32_t ch_order; // AV_CHANNEL_ORDER_NATIVE keeps ch_mask, else unspecified
+  uint64_t ch_mask;
+  int32_t nb_channels;
+  int32_t sample_rate;
+  int32_t block_align;
+  int32_t frame_size;
+  int32_t initial_padding;
+  int32_t trailing_padding;
+  int32_t seek_preroll;
+  int32_t tb_num;
+  int32_t tb_den;
+  int32_t avg_fr_num;
+  int32_t avg_fr_den;
+  int32_t r_fr_num;
+  int32_t r_fr_den;
+  int32_t extradata_size;
+  int64_t start_time; // stream time base
+  int64_t duration;   // stream time base
+  int64_t nb_frames;
+} MoviProbeStream;
+
+void movi_probe_free(MoviContext *ctx) {
+  if (!ctx)
+    return;
+  av_freep(&ctx->probe_blob);
+  ctx->probe_size = 0;
+}
+
+// Serialise the probed streams into buffer. Returns the number of bytes the
+// descriptor needs; writes only when buffer_size is large enough, so JS calls
+// once with buffer_size = 0 to size the allocation.
+EMSCRIPTEN_KEEPALIVE
+int movi_probe_export(MoviContext *ctx, uint8_t *buffer, int buffer_size) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->fmt_ctx->iformat)
+    return -1;
+  AVFormatContext *fmt_ctx = ctx->fmt_ctx;
+  int needed = (int)sizeof(MoviProbeHeader);
+  for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++)
+    needed += (int)sizeof(MoviProbeStream) +
+              fmt_ctx->streams[i]->codecpar->extradata_size;
+  if (!buffer || buffer_size < needed)
+    return needed;
+
+  MoviProbeHeader hdr = {0};
+  hdr.magic = MOVI_PROBE_MAGIC;
+  hdr.version = MOVI_PROBE_VERSION;
+  hdr.nb_streams = fmt_ctx->nb_streams;
+  hdr.file_size = ctx->file_size;
+  hdr.start_time = fmt_ctx->start_time;
+  hdr.duration = fmt_ctx->duration;
+  hdr.bit_rate = fmt_ctx->bit_rate;
+  strncpy(hdr.format, fmt_ctx->iformat->name, sizeof(hdr.format) - 1);
+  memcpy(buffer, &hdr, sizeof(hdr));
+
+  uint8_t *p = buffer + sizeof(hdr);
+  for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+    const AVStream *st = fmt_ctx->streams[i];
+    const AVCodecParameters *par = st->codecpar;
+    MoviProbeStream s = {0};
+    s.codec_type = par->codec_type;
+    s.codec_id = par->codec_id;
+    s.codec_tag = par->codec_tag;
+    s.format = par->format;
+    s.bit_rate = par->bit_rate;
+    s.bits_per_coded_sample = par->bits_per_coded_sample;
+    s.bits_per_raw_sample = par->bits_per_raw_sample;
+    s.profile = par->profile;
+    s.level = par->level;
+    s.width = par->width;
+    s.height = par->height;
+    s.sar_num = par->sample_aspect_ratio.num;
+    s.sar_den = par->sample_aspect_ratio.den;
+    s.field_order = par->field_order;
+    s.color_range = par->color_range;
+    s.color_primaries = par->color_primaries;
+    s.color_trc = par->color_trc;
+    s.color_space = par->color_space;
+    s.chroma_location = par->chroma_location;
+    s.video_delay = par->video_delay;
+    s.ch_order = par->ch_layout.order == AV_CHANNEL_ORDER_NATIVE
+                     ? AV_CHANNEL_ORDER_NATIVE
+                     : AV_CHANNEL_ORDER_UNSPEC;
+    if (s.ch_order == AV_CHANNEL_ORDER_NATIVE)
+      s.ch_mask = par->ch_layout.u.mask;
+    s.nb_channels = par->ch_layout.nb_channels;
+    s.sample_rate = par->sample_rate;
+    s.block_align = par->block_align;
+    s.frame_size = par->frame_size;
+    s.initial_padding = par->initial_padding;
+    s.trailing_padding = par->trailing_padding;
+    s.seek_preroll = par->seek_preroll;
+    s.tb_num = st->time_base.num;
+    s.tb_den = st->time_base.den;
+    s.avg_fr_num = st->avg_frame_rate.num;
+    s.avg_fr_den = st->avg_frame_rate.den;
+    s.r_fr_num = st->r_frame_rate.num;
+    s.r_fr_den = st->r_frame_rate.den;
+    s.extradata_size = par->extradata_size;
+    s.start_time = st->start_time;
+    s.duration = st->duration;
+    s.nb_frames = st->nb_frames;
+    memcpy(p, &s, sizeof(s));
+    p += sizeof(s);
+    if (par->extradata_size > 0) {
+      memcpy(p, par->extradata, par->extradata_size);
+      p += par->extradata_size;
+    }
+  }
+  return needed;
+}
+
+// Check one stream record against what the header gave the stream.
+static int movi_probe_stream_matches(const AVStream *st,
+                                     const MoviProbeStream *s,
+                                     const uint8_t *extradata) {
+  const AVCodecParameters *par = st->codecpar;
+  if (s->codec_type != (int)par->codec_type ||
+      s->codec_id != (int)par->codec_id || s->tb_num != st->time_base.num ||
+      s->tb_den != st->time_base.den)
+    return 0;
+  if ((par->width > 0 && par->width != s->width) ||
+      (par->height > 0 && par->height != s->height) ||
+      (par->sample_rate > 0 && par->sample_rate != s->sample_rate))
+    return 0;
+  // Header extradata (avcC, hvcC, CodecPrivate...) is the strongest check
+  // there is short of reading media data: it has to be byte-identical.
+  if (par->extradata_size > 0 &&
+      (par->extradata_size != s->extradata_size ||
+       memcmp(par->extradata, extradata, par->extradata_size)))
+    return 0;
+  return 1;
+}
+
+static int movi_probe_fill_stream(AVStream *st, const MoviProbeStream *s,
+                                  const uint8_t *extradata) {
+  AVCodecParameters *par = st->codecpar;
+  if (par->extradata_size <= 0 && s->extradata_size > 0) {
+    av_freep(&par->extradata);
+    par->extradata =
+        av_mallocz(s->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!par->extradata) {
+      par->extradata_size = 0;
+      return AVERROR(ENOMEM);
+    }
+    memcpy(par->extradata, extradata, s->extradata_size);
+    par->extradata_size = s->extradata_size;
+  }
+  par->codec_tag = s->codec_tag;
+  par->format = s->format;
+  par->bit_rate = s->bit_rate;
+  par->bits_per_coded_sample = s->bits_per_coded_sample;
+  par->bits_per_raw_sample = s->bits_per_raw_sample;
+  par->profile = s->profile;
+  par->level = s->level;
+  par->width = s->width;
+  par->height = s->height;
+  par->sample_aspect_ratio = (AVRational){s->sar_num, s->sar_den};
+  par->field_order = s->field_order;
+  par->color_range = s->color_range;
+  par->color_primaries = s->color_primaries;
+  par->color_trc = s->color_trc;
+  par->color_space = s->color_space;
+  par->chroma_location = s->chroma_location;
+  par->video_delay = s->video_delay;
+  if (s->nb_channels > 0) {
+    av_channel_layout_uninit(&par->ch_layout);
+    if (s->ch_order != AV_CHANNEL_ORDER_NATIVE ||
+        av_channel_layout_from_mask(&par->ch_layout, s->ch_mask) < 0 ||
+        par->ch_layout.nb_channels != s->nb_channels) {
+      av_channel_layout_uninit(&par->ch_layout);
+      par->ch_layout.order = AV_CHANNEL_ORDER_UNSPEC;
+      par->ch_layout.nb_channels = s->nb_channels;
+    }
+  }
+  par->sample_rate = s->sample_rate;
+  par->block_align = s->block_align;
+  par->frame_size = s->frame_size;
+  par->initial_padding = s->initial_padding;
+  par->trailing_padding = s->trailing_padding;
+  par->seek_preroll = s->seek_preroll;
+  st->avg_frame_rate = (AVRational){s->avg_fr_num, s->avg_fr_den};
+  st->r_frame_rate = (AVRational){s->r_fr_num, s->r_fr_den};
+  st->start_time = s->start_time;
+  st->duration = s->duration;
+  st->nb_frames = s->nb_frames;
+  return 0;
+}
+
+// Validate a descriptor against a freshly opened fmt_ctx (header read, not
+// probed) and, when everything matches, complete its streams from it.
+// Returns 0 when applied — the caller then skips avformat_find_stream_info —
+// and < 0 when the blob is malformed (-2) or doesn't match this file (-3),
+// in which case fmt_ctx is left untouched.
+int movi_probe_apply(AVFormatContext *fmt_ctx, int64_t file_size,
+                     const uint8_t *blob, int size) {
+  if (!fmt_ctx || !fmt_ctx->iformat || !blob ||
+      size < (int)sizeof(MoviProbeHeader))
+    return -1;
+  MoviProbeHeader hdr;
+  memcpy(&hdr, blob, sizeof(hdr));
+  if (hdr.magic != MOVI_PROBE_MAGIC || hdr.version != MOVI_PROBE_VERSION ||
+      hdr.nb_streams <= 0)
+    return -2;
+  hdr.format[sizeof(hdr.format) - 1] = '\0';
+  if (fmt_ctx->ctx_flags & AVFMTCTX_NOHEADER)
+    return -3;
+  if (hdr.nb_streams != (int)fmt_ctx->nb_streams ||
+      strncmp(hdr.format, fmt_ctx->iformat->name, sizeof(hdr.format) - 1) ||
+      (file_size > 0 && hdr.file_size > 0 && hdr.file_size != file_size))
+    return -3;
+
+  // Pass 1: bounds and per-stream checks, so a mismatch on the last stream
+  // doesn't leave the first ones half-filled.
+  const uint8_t *p = blob + sizeof(hdr);
+  const uint8_t *end = blob + size;
+  for (int i = 0; i < hdr.nb_streams; i++) {
+    MoviProbeStream s;
+    if (end - p < (int)sizeof(s))
+      return -2;
+    memcpy(&s, p, sizeof(s));
+    p += sizeof(s);
+    if (s.extradata_size < 0 || end - p < s.extradata_size)
+      return -2;
+    if (!movi_probe_stream_matches(fmt_ctx->streams[i], &s, p))
+      return -3;
+    p += s.extradata_size;
+  }
+
+  p = blob + sizeof(hdr);
+  for (int i = 0; i < hdr.nb_streams; i++) {
+    MoviProbeStream s;
+    memcpy(&s, p, sizeof(s));
+    p += sizeof(s);
+    int ret = movi_probe_fill_stream(fmt_ctx->streams[i], &s, p);
+    if (ret < 0)
+      return ret;
+    p += s.extradata_size;
+  }
+  fmt_ctx->start_time = hdr.start_time;
+  fmt_ctx->duration = hdr.duration;
+  fmt_ctx->bit_rate = hdr.bit_rate;
+  return 0;
+}
+
+// Hand this context a descriptor exported earlier for the same file. Must be
+// called before movi_open, which consumes it. Returns 0, or < 0 when the
+// context is already open or the blob can't be copied.
+EMSCRIPTEN_KEEPALIVE
+int movi_probe_import(MoviContext *ctx, const uint8_t *blob, int size) {
+  if (!ctx || ctx->fmt_ctx || !blob || size <= 0)
+    return -1;
+  movi_probe_free(ctx);
+  ctx->probe_blob = av_malloc(size);
+  if (!ctx->probe_blob)
+    return AVERROR(ENOMEM);
+  memcpy(ctx->probe_blob, blob, size);
+  ctx->probe_size = size;
+  return 0;
+}
+
+// 1 when movi_open took its stream parameters from an imported descriptor
+// instead of probing
+EMSCRIPTEN_KEEPALIVE
+int movi_probe_applied(MoviContext *ctx) {
+  return ctx ? ctx->probe_applied : 0;
+}
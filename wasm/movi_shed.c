@@ -0,0 +1,134 @@
+#include "movi.h"
+
+// Closed-loop load shedding for one video stream.
+//
+// PacketInfo.disposable lets JS drop non-reference frames, but only after
+// they've been demuxed, copied into the heap view and classified, and the
+// AVDISCARD levels behind movi_set_skip_frame had to be picked by hand. Here
+// JS only reports how far decode is falling behind (movi_shed_report, once per
+// renderer window: the share of frames that reached the renderer less than a
+// frame interval before they were due) and the tier is chosen in WASM:
+//
+//   0  off
+//   1  skip_frame NONREF; disposable packets dropped in movi_next_packet,
+//      before any copy, so WebCodecs never sees them either
+//   2  + skip_loop_filter NONKEY (software decode: no deblocking off keyframes)
+//   3  skip_frame BIDIR
+//   4  skip_frame NONKEY; every non-key packet of the stream dropped
+//
+// Two behind-budget windows in a row step up a tier. Stepping back down takes
+// `backoff` windows with headroom, and each step back up that follows a step
+// down doubles it (up to MOVI_SHED_MAX_BACKOFF), so a device sitting on the
+// edge settles instead of oscillating between two tiers.
+
+#define MOVI_SHED_MAX_TIER 4
+#define MOVI_SHED_OVER 0.25    // miss ratio that counts as behind budget
+#define MOVI_SHED_UNDER 0.02   // ... and as headroom
+#define MOVI_SHED_OVER_WINDOWS 2
+#define MOVI_SHED_MIN_BACKOFF 3
+#define MOVI_SHED_MAX_BACKOFF 32
+
+static void movi_shed_set_decoder(MoviContext *ctx, int tier) {
+  if (!ctx->decoders || ctx->shed_stream < 0 ||
+      ctx->shed_stream >= (int)ctx->fmt_ctx->nb_streams)
+    return;
+  AVCodecContext *dec = ctx->decoders[ctx->shed_stream];
+  if (!dec)
+    return; // hardware path: only the demuxer-side drop applies
+  static const enum AVDiscard skip_frame[MOVI_SHED_MAX_TIER + 1] = {
+      AVDISCARD_DEFAULT, AVDISCARD_NONREF, AVDISCARD_NONREF, AVDISCARD_BIDIR,
+      AVDISCARD_NONKEY};
+  enum AVDiscard skip_loop_filter =
+      tier >= 2 ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+  // A pipeline's decode thread may be inside avcodec_send_packet right now
+  if (movi_pipeline_set_discard(ctx, ctx->shed_stream, skip_frame[tier],
+                                skip_loop_filter))
+    return;
+  dec->skip_frame = skip_frame[tier];
+  dec->skip_loop_filter = skip_loop_filter;
+}
+
+// Re-apply the current tier to a decoder opened after shedding started (e.g.
+// a hardware → software fallback); called from movi_enable_decoder.
+void movi_shed_apply(MoviContext *ctx, int stream_index) {
+  if (ctx && stream_index == ctx->shed_stream && ctx->shed_tier > 0)
+    movi_shed_set_decoder(ctx, ctx->shed_tier);
+}
+
+// 1 when the packet in ctx->pkt should be dropped before it reaches JS
+int movi_shed_drop(MoviContext *ctx, const AVPacket *pkt,
+                   const MoviPacketClass *cls) {
+  if (ctx->shed_tier == 0 || pkt->stream_index != ctx->shed_stream ||
+      (pkt->flags & AV_PKT_FLAG_KEY))
+    return 0;
+  if (ctx->shed_tier < MOVI_SHED_MAX_TIER &&
+      !(pkt->flags & AV_PKT_FLAG_DISPOSABLE)) {
+    // Same test PacketInfo.disposable uses: few demuxers set the flag, the
+    // slice headers say it for H.264/HEVC (movi_classify_packet)
+    if (!cls->disposable)
+      return 0;
+  }
+  ctx->shed_dropped++;
+  return 1;
+}
+
+// Start shedding on `stream_index` (< 0 stops it and restores full decode).
+// Resets the tier, backoff and drop count.
+EMSCRIPTEN_KEEPALIVE
+void movi_shed_enable(MoviContext *ctx, int stream_index) {
+  if (!ctx || !ctx->fmt_ctx)
+    return;
+  if (ctx->shed_tier > 0)
+    movi_shed_set_decoder(ctx, 0);
+  ctx->shed_stream =
+      stream_index < (int)ctx->fmt_ctx->nb_streams ? stream_index : -1;
+  ctx->shed_tier = 0;
+  ctx->shed_over = 0;
+  ctx->shed_under = 0;
+  ctx->shed_backoff = MOVI_SHED_MIN_BACKOFF;
+  ctx->shed_last_down = 0;
+  ctx->shed_dropped = 0;
+}
+
+// Feed one renderer window's miss ratio (0 = every frame had headroom,
+// 1 = every frame arrived late). Returns the tier now in effect.
+EMSCRIPTEN_KEEPALIVE
+int movi_shed_report(MoviContext *ctx, double miss_ratio) {
+  if (!ctx || ctx->shed_stream < 0)
+    return 0;
+  int tier = ctx->shed_tier;
+  if (miss_ratio >= MOVI_SHED_OVER) {
+    ctx->shed_under = 0;
+    if (++ctx->shed_over >= MOVI_SHED_OVER_WINDOWS &&
+        tier < MOVI_SHED_MAX_TIER) {
+      if (ctx->shed_last_down && ctx->shed_backoff < MOVI_SHED_MAX_BACKOFF)
+        ctx->shed_backoff *= 2;
+      ctx->shed_last_down = 0;
+      tier++;
+    }
+  } else if (miss_ratio <= MOVI_SHED_UNDER) {
+    ctx->shed_over = 0;
+    if (tier > 0 && ++ctx->shed_under >= ctx->shed_backoff) {
+      ctx->shed_last_down = 1;
+      tier--;
+    }
+  } else {
+    // In between: hold the tier, but it isn't a streak either way
+    ctx->shed_over = 0;
+    ctx->shed_under = 0;
+  }
+  if (tier != ctx->shed_tier) {
+    ctx->shed_tier = tier;
+    ctx->shed_over = 0;
+    ctx->shed_under = 0;
+    movi_shed_set_decoder(ctx, tier);
+  }
+  return tier;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_shed_tier(MoviContext *ctx) { return ctx ? ctx->shed_tier : 0; }
+
+// Packets dropped in the demuxer since movi_shed_enable
+EMSCRIPTEN_KEEPALIVE
+int movi_shed_dropped(MoviContext *ctx) { return ctx ? ctx->shed_dropped : 0; }
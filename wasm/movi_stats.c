@@ -0,0 +1,135 @@
+#include "movi.h"
+
+// ---- Hot-path instrumentation ----------------------------------------------
+// Where does a slow frame go: waiting on the network inside js_read_async,
+// parsing in av_read_frame, the IDR scan, the decoder, the resampler, the RGBA
+// conversion or the stretcher? getStats only ever showed queue depths, so the
+// answer was a profiler session on the user's machine. With -DMOVI_STATS
+// (MOVI_BUILD_STATS=1) each context keeps a call count, total and worst time
+// and a fixed log2 latency histogram per stage, plus byte counters, and
+// movi_get_stats snapshots them for QoE reporting.
+//
+// Without the flag every MOVI_STAT_* site compiles to nothing and ctx->stats
+// is never allocated; movi_get_stats still answers (returning 0) so JS can
+// tell an uninstrumented module from an idle one.
+//
+// Everything is recorded on the thread making the module call. Stages run on
+// the decode pipeline's own threads aren't timed here; movi_pipeline_stats
+// reports those.
+//
+// Histogram bucket 0 counts calls under MOVI_STATS_BUCKET_BASE_US, bucket b
+// calls in [base << (b - 1), base << b), and the last bucket everything
+// longer (131ms and up with an 8µs base).
+
+#define MOVI_STATS_VERSION 1
+#define MOVI_STATS_BUCKET_BASE_US 8
+
+typedef struct {
+  double count;
+  double total_ms;
+  double max_ms;
+  double buckets[MOVI_STATS_BUCKETS];
+} MoviStageStats;
+
+// All fields are doubles so JS reads the snapshot straight off HEAPF64
+struct MoviStats {
+  double version;
+  double enabled;
+  double counter_count;
+  double stage_count;
+  double bucket_count;
+  double bucket_base_us;
+  double counters[MOVI_COUNTER_COUNT];
+  MoviStageStats stages[MOVI_STAGE_COUNT];
+};
+
+static void movi_stats_header(MoviStats *s, int enabled) {
+  s->version = MOVI_STATS_VERSION;
+  s->enabled = enabled;
+  s->counter_count = MOVI_COUNTER_COUNT;
+  s->stage_count = MOVI_STAGE_COUNT;
+  s->bucket_count = MOVI_STATS_BUCKETS;
+  s->bucket_base_us = MOVI_STATS_BUCKET_BASE_US;
+}
+
+#ifdef MOVI_STATS
+// Allocated on the first sample so contexts that never hit a hot path
+// (thumbnail probes, closed players) cost nothing
+static MoviStats *movi_stats_get(MoviContext *ctx) {
+  if (!ctx->stats) {
+    ctx->stats = (MoviStats *)calloc(1, sizeof(MoviStats));
+    if (ctx->stats)
+      movi_stats_header(ctx->stats, 1);
+  }
+  return ctx->stats;
+}
+
+void movi_stats_record(MoviContext *ctx, MoviStage stage, double ms) {
+  if (!ctx || stage < 0 || stage >= MOVI_STAGE_COUNT)
+    return;
+  MoviStats *s = movi_stats_get(ctx);
+  if (!s)
+    return;
+  MoviStageStats *st = &s->stages[stage];
+  if (ms < 0)
+    ms = 0;
+  st->count += 1;
+  st->total_ms += ms;
+  if (ms > st->max_ms)
+    st->max_ms = ms;
+  unsigned int v = (unsigned int)(ms * 1000.0 / MOVI_STATS_BUCKET_BASE_US);
+  int b = v ? 32 - __builtin_clz(v) : 0;
+  if (b >= MOVI_STATS_BUCKETS)
+    b = MOVI_STATS_BUCKETS - 1;
+  st->buckets[b] += 1;
+}
+
+void movi_stats_add(MoviContext *ctx, MoviCounter counter, double n) {
+  if (!ctx || counter < 0 || counter >= MOVI_COUNTER_COUNT)
+    return;
+  MoviStats *s = movi_stats_get(ctx);
+  if (s)
+    s->counters[counter] += n;
+}
+#endif
+
+void movi_stats_free(MoviContext *ctx) {
+  if (ctx) {
+    free(ctx->stats);
+    ctx->stats = NULL;
+  }
+}
+
+// Bytes JS must allocate for a movi_get_stats snapshot
+EMSCRIPTEN_KEEPALIVE
+int movi_stats_size(void) { return (int)sizeof(MoviStats); }
+
+// Copy the context's counters into *out. Returns 1 with a snapshot, 0 when the
+// module was built without MOVI_STATS (out carries only the header, with
+// enabled = 0), -1 on bad arguments. The header fields give the shape, so a
+// reader never has to hardcode the stage or bucket count.
+EMSCRIPTEN_KEEPALIVE
+int movi_get_stats(MoviContext *ctx, MoviStats *out) {
+  if (!ctx || !out)
+    return -1;
+  memset(out, 0, sizeof(*out));
+#ifdef MOVI_STATS
+  if (ctx->stats)
+    memcpy(out, ctx->stats, sizeof(*out));
+  else
+    movi_stats_header(out, 1);
+  return 1;
+#else
+  movi_stats_header(out, 0);
+  return 0;
+#endif
+}
+
+// Zero the context's counters (a new measurement window)
+EMSCRIPTEN_KEEPALIVE
+void movi_reset_stats(MoviContext *ctx) {
+  if (ctx && ctx->stats) {
+    memset(ctx->stats, 0, sizeof(*ctx->stats));
+    movi_stats_header(ctx->stats, 1);
+  }
+}
@@ -164,6 +164,8 @@ int movi_seek_to(MoviContext *ctx, double timestamp, int stream_index,
   if (!ctx || !ctx->fmt_ctx)
     return -1;
 
+  movi_drop_pending_packet(ctx);
+
   // Flush AVIO buffer before seeking to ensure clean state
   // This is critical for large files (>= 2GB) to prevent sequential reads
   // Without flushing, FFmpeg might read from cached buffer instead of seeking
@@ -180,6 +182,10 @@ int movi_seek_to(MoviContext *ctx, double timestamp, int stream_index,
   }
 
   int64_t seek_target = (int64_t)(timestamp * AV_TIME_BASE);
+  // With an imported seek index, land on a true IDR rather than a CRA the HW
+  // decoder would reject after the flush (movi_index.c).
+  if (!(seek_flags & AVSEEK_FLAG_ANY))
+    seek_target = movi_index_seek_target(ctx, seek_target);
   // Use INT64_MAX for max_ts to allow FFmpeg to find the nearest keyframe
   // The BACKWARD flag ensures we prefer positions at or before seek_target
   // Using seek_target as max_ts was too restrictive and caused seeks to fail
@@ -245,149 +251,96 @@ int movi_seek_to(MoviContext *ctx, double timestamp, int stream_index,
   return ret;
 }
 
-// Find the first VCL slice NAL in a (possibly multi-NAL) packet and return its
-// raw nal_unit_type — HEVC: (byte0 >> 1) & 0x3F (VCL = 0..31); H.264: byte0 &
-// 0x1F (VCL = 1..5). Returns -1 if no VCL slice is found, the packet is too
-// small, or the codec isn't H.264/HEVC.
-//
-// CRITICAL: a packet is NOT just one NAL. In MKV/MP4 a keyframe is typically
-// [AUD][VPS][SPS][PPS][SEI…][slice…]. Reading only the first NAL (an AUD/PS)
-// always misclassifies — we must walk every NAL and inspect the first VCL one.
-// Packets may be Annex B (00 00 01 start codes) or length-prefixed (4-byte
-// big-endian, hvcC/avcC). We detect which by probing for a leading start code.
-static int movi_first_vcl_nal_type(enum AVCodecID codec_id, const uint8_t *data,
-                                   int size) {
-  if (!data || size < 5)
-    return -1; // too small to inspect
-
-  if (codec_id != AV_CODEC_ID_HEVC && codec_id != AV_CODEC_ID_H264)
-    return -1; // only H.264/HEVC carry the NAL types we classify
-
-  // Detect format: Annex B if the packet starts with a 3- or 4-byte start code.
-  int is_annexb = (data[0] == 0 && data[1] == 0 &&
-                   (data[2] == 1 || (data[2] == 0 && data[3] == 1)));
-
-  int i = 0;
-  if (is_annexb) {
-    // Walk NAL units delimited by 00 00 01 / 00 00 00 01 start codes.
-    while (i + 3 < size) {
-      // Find next start code.
-      if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
-        int nal_off = i + 3;
-        if (nal_off >= size)
-          break;
-        int hdr = data[nal_off];
-        int t = (codec_id == AV_CODEC_ID_HEVC) ? ((hdr >> 1) & 0x3F)
-                                               : (hdr & 0x1F);
-        int is_vcl = (codec_id == AV_CODEC_ID_HEVC) ? (t >= 0 && t <= 31)
-                                                    : (t >= 1 && t <= 5);
-        if (is_vcl)
-          return t; // first VCL slice decides
-        i = nal_off + 1;
-      } else {
-        i++;
-      }
-    }
-  } else {
-    // Length-prefixed (4-byte big-endian length before each NAL).
-    while (i + 4 < size) {
-      uint32_t nal_len = ((uint32_t)data[i] << 24) | ((uint32_t)data[i + 1] << 16) |
-                         ((uint32_t)data[i + 2] << 8) | (uint32_t)data[i + 3];
-      int nal_off = i + 4;
-      if (nal_len == 0 || nal_off >= size)
-        break;
-      int hdr = data[nal_off];
-      int t = (codec_id == AV_CODEC_ID_HEVC) ? ((hdr >> 1) & 0x3F)
-                                             : (hdr & 0x1F);
-      int is_vcl = (codec_id == AV_CODEC_ID_HEVC) ? (t >= 0 && t <= 31)
-                                                  : (t >= 1 && t <= 5);
-      if (is_vcl)
-        return t;
-      i = nal_off + (int)nal_len; // advance past this NAL
-    }
+// Classify the packet just demuxed into ctx->pkt, once, for every consumer.
+// is_idr tells true IDR/BLA random-access keyframes from open-GOP CRA frames,
+// is_rasl the leading pictures after a CRA/BLA, disposable non-reference
+// frames (movi_fill_packet_info has what JS does with each).
+static void movi_classify_demuxed(MoviContext *ctx) {
+  int index = ctx->pkt->stream_index;
+  if (index < 0 || index >= (int)ctx->fmt_ctx->nb_streams ||
+      ctx->fmt_ctx->streams[index]->codecpar->codec_type !=
+          AVMEDIA_TYPE_VIDEO) {
+    memset(&ctx->pkt_class, 0, sizeof(ctx->pkt_class));
+    ctx->pkt_class.is_idr = 1;
+    return;
   }
-
-  return -1; // no VCL slice found
+  MOVI_STAT_START(t0);
+  movi_classify_packet(ctx, ctx->pkt, &ctx->pkt_class);
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_CLASSIFY, t0);
 }
 
-// Classify whether a keyframe packet is a TRUE random-access point that a
-// hardware WebCodecs decoder will accept as a `key` chunk.
-//
-// FFmpeg flags both closed-GOP IDR and open-GOP CRA pictures as AV_PKT_FLAG_KEY,
-// but WebCodecs rejects a CRA sent as `key` ("wasn't a key frame") because its
-// leading RASL pictures reference the previous GOP. We tell them apart by the
-// first VCL slice NAL type:
-//   HEVC: 19/20 = IDR, 16-18 = BLA (true RAP). 21 = CRA (open-GOP) — not a key.
-//   H.264: 5 = IDR (true key).
-//
-// Returns 1 if the keyframe is a true IDR/BLA random-access point, 0 otherwise.
-// Falls back to 1 (safe default: assume true key) when no VCL slice is found or
-// the codec isn't H.264/HEVC, so we never wedge waiting for an IDR we failed to
-// recognize.
-static int movi_packet_is_idr(enum AVCodecID codec_id, const uint8_t *data,
-                              int size) {
-  if (codec_id != AV_CODEC_ID_HEVC && codec_id != AV_CODEC_ID_H264)
-    return 1; // other codecs: honor container keyframe flag
-
-  int t = movi_first_vcl_nal_type(codec_id, data, size);
-  if (t < 0)
-    return 1; // too small / no VCL slice — assume true key (safe default)
-
-  if (codec_id == AV_CODEC_ID_HEVC)
-    return (t == 19 || t == 20 || t == 16 || t == 17 || t == 18) ? 1 : 0;
-  return (t == 5) ? 1 : 0; // H.264 IDR
+// Load the next demuxed packet into ctx->pkt. A packet movi_read_frames read
+// but couldn't fit in its arena is held back in ctx->pkt (pkt_pending) and is
+// returned first, so batched and single reads can be mixed without losing one.
+// Packets load shedding drops (movi_shed.c) and sub-layers above a temporal
+// layer limit (movi_nal.c) are skipped here, before any of the read paths
+// copies them out; each packet is classified once for all of them.
+static int movi_next_packet(MoviContext *ctx) {
+  if (ctx->pkt_pending) {
+    ctx->pkt_pending = 0;
+    return 0;
+  }
+  int ret;
+#ifdef MOVI_STATS
+  // AVIO bytes consumed minus the packet handed back: container overhead plus
+  // whatever av_read_frame skipped for AVDISCARD_ALL streams (and shed packets)
+  MOVI_STAT_START(t0);
+  int64_t pos0 = ctx->fmt_ctx->pb ? avio_tell(ctx->fmt_ctx->pb) : 0;
+#endif
+  do {
+    av_packet_unref(ctx->pkt);
+    ret = av_read_frame(ctx->fmt_ctx, ctx->pkt);
+    if (ret >= 0)
+      movi_classify_demuxed(ctx);
+  } while (ret >= 0 && (movi_shed_drop(ctx, ctx->pkt, &ctx->pkt_class) ||
+                        movi_layer_drop(ctx, ctx->pkt, &ctx->pkt_class)));
+#ifdef MOVI_STATS
+  MOVI_STAT_STOP(ctx, MOVI_STAGE_DEMUX, t0);
+  if (ctx->fmt_ctx->pb) {
+    int64_t consumed = avio_tell(ctx->fmt_ctx->pb) - pos0;
+    int64_t kept = ret >= 0 ? ctx->pkt->size : 0;
+    if (consumed > 0) {
+      MOVI_STAT_ADD(ctx, MOVI_COUNTER_BYTES_DEMUXED, consumed);
+      if (consumed > kept)
+        MOVI_STAT_ADD(ctx, MOVI_COUNTER_BYTES_DISCARDED, consumed - kept);
+    }
+  }
+  if (ret >= 0)
+    MOVI_STAT_ADD(ctx, MOVI_COUNTER_PACKETS, 1);
+#endif
+  return ret;
 }
 
-// Classify whether a packet is an HEVC RASL leading picture (NAL type 8=RASL_N
-// / 9=RASL_R). RASL pictures trail a CRA in decode order but reference the
-// pre-CRA GOP; when the CRA is a random-access resume (references flushed) they
-// are orphaned and must be discarded (NoRaslOutputFlag=1). Chrome drops them
-// internally; Safari/VideoToolbox throws a hard EncodingError — so JS skips
-// them after a CRA resume. HEVC only; 0 for every other codec and NAL type.
-static int movi_packet_is_rasl(enum AVCodecID codec_id, const uint8_t *data,
-                               int size) {
-  if (codec_id != AV_CODEC_ID_HEVC)
-    return 0;
-  int t = movi_first_vcl_nal_type(codec_id, data, size);
-  return (t == 8 || t == 9) ? 1 : 0;
+// Discard a held-back packet; every seek must call this.
+void movi_drop_pending_packet(MoviContext *ctx) {
+  if (ctx && ctx->pkt_pending) {
+    av_packet_unref(ctx->pkt);
+    ctx->pkt_pending = 0;
+  }
 }
 
-int movi_read_frame(MoviContext *ctx, PacketInfo *info, uint8_t *buffer,
-                    int buffer_size) {
-  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || !info || !buffer)
-    return -1;
-  av_packet_unref(ctx->pkt);
-  int ret = av_read_frame(ctx->fmt_ctx, ctx->pkt);
-  if (ret < 0)
-    return (ret == AVERROR_EOF) ? 0 : ret;
-  if (ctx->pkt->stream_index < 0 ||
-      ctx->pkt->stream_index >= (int)ctx->fmt_ctx->nb_streams)
-    return 0;
+// Fill *info from the packet just read into ctx->pkt. Returns 1 when the
+// emitted bytes must start with an AV1 Temporal Delimiter (see below), else 0.
+// info->size is left to the caller: it depends on how the bytes are emitted.
+static int movi_fill_packet_info(MoviContext *ctx, PacketInfo *info) {
   AVStream *stream = ctx->fmt_ctx->streams[ctx->pkt->stream_index];
   info->stream_index = ctx->pkt->stream_index;
   info->keyframe = (ctx->pkt->flags & AV_PKT_FLAG_KEY) != 0;
-  // Distinguish true IDR/BLA random-access keyframes from open-GOP CRA frames
-  // so JS can send CRA as `delta` and keep the hardware decoder running. Only
-  // meaningful for keyframes; non-keyframes carry is_idr = 0.
-  if (info->keyframe)
-    info->is_idr =
-        movi_packet_is_idr(stream->codecpar->codec_id, ctx->pkt->data,
-                           ctx->pkt->size);
-  else
-    info->is_idr = 0;
-  // Flag HEVC RASL leading pictures so JS can drop the orphaned ones after a
-  // CRA/BLA random-access resume (Safari hard-errors on them). Keyframes are
-  // never RASL; non-HEVC codecs always carry is_rasl = 0.
-  info->is_rasl =
-      info->keyframe
-          ? 0
-          : movi_packet_is_rasl(stream->codecpar->codec_id, ctx->pkt->data,
-                                ctx->pkt->size);
-  // Non-reference frame: safe for JS to drop under load (nothing references it).
-  // Keyframes are never disposable.
+  // Classified once in movi_next_packet (movi_classify_demuxed). is_idr lets
+  // JS send CRA as `delta` and keep the hardware decoder running; only
+  // meaningful for keyframes, non-keyframes carry 0. is_rasl flags the
+  // leading pictures JS drops after a CRA/BLA resume (Safari hard-errors on
+  // them); keyframes are never RASL. disposable marks non-reference frames
+  // JS may drop under load; keyframes never are.
+  const MoviPacketClass *cls = &ctx->pkt_class;
+  info->is_idr = info->keyframe ? cls->is_idr : 0;
+  info->is_rasl = info->keyframe ? 0 : cls->is_rasl;
   info->disposable =
-      (!info->keyframe && (ctx->pkt->flags & AV_PKT_FLAG_DISPOSABLE) != 0) ? 1
-                                                                           : 0;
+      (!info->keyframe &&
+       ((ctx->pkt->flags & AV_PKT_FLAG_DISPOSABLE) || cls->disposable))
+          ? 1
+          : 0;
+  info->temporal_id = cls->temporal_id;
   if (ctx->pkt->pts != AV_NOPTS_VALUE)
     info->timestamp = ctx->pkt->pts * av_q2d(stream->time_base);
   else if (ctx->pkt->dts != AV_NOPTS_VALUE)
@@ -424,6 +377,21 @@ int movi_read_frame(MoviContext *ctx, PacketInfo *info, uint8_t *buffer,
       td_prepend = 1;
   }
 
+  return td_prepend;
+}
+
+int movi_read_frame(MoviContext *ctx, PacketInfo *info, uint8_t *buffer,
+                    int buffer_size) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || !info || !buffer)
+    return -1;
+  int ret = movi_next_packet(ctx);
+  if (ret < 0)
+    return (ret == AVERROR_EOF) ? 0 : ret;
+  if (ctx->pkt->stream_index < 0 ||
+      ctx->pkt->stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return 0;
+  int td_prepend = movi_fill_packet_info(ctx, info);
+
   int copy_size = ctx->pkt->size + (td_prepend ? 2 : 0);
   if (copy_size > buffer_size) {
     // Log error or return specific code to signal buffer too small
@@ -443,6 +411,225 @@ int movi_read_frame(MoviContext *ctx, PacketInfo *info, uint8_t *buffer,
   return copy_size;
 }
 
+// ---- Batched demux -------------------------------------------------------
+// One Asyncify round-trip and one PacketInfo readback per packet is what limits
+// the demux loop on high packet-rate streams (see the abatch note in movi.h:
+// TrueHD at ~1200 packets/s), not av_read_frame itself. movi_read_frames keeps
+// reading until `max` packets, the arena byte budget, or the per-stream limit
+// (movi_set_read_frames_limit) is reached, or on a live feed the pushed bytes
+// run out, writing `count` PacketInfo records to `infos` and the payloads
+// back-to-back into `arena`: packet i starts at the sum of infos[0..i-1].size,
+// so PacketInfo needs no offset field and records are read at the same
+// PACKET_INFO_SIZE stride movi_read_frame uses.
+//
+// A packet that doesn't fit in the remaining arena is kept for the next call.
+// Returns the packet count; 0 at EOF; AVERROR(ENOBUFS) if even the first packet
+// is larger than the whole arena (it's still held, so a following
+// movi_read_frame with a bigger buffer picks it up); < 0 on other errors with
+// nothing read. An error after at least one packet ends the batch early and
+// surfaces on the next call.
+EMSCRIPTEN_KEEPALIVE
+int movi_read_frames(MoviContext *ctx, PacketInfo *infos, int max,
+                     uint8_t *arena, int arena_size) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || !infos || !arena || max <= 0)
+    return -1;
+
+  int count = 0;
+  int used = 0;
+  int limited = 0;
+  while (count < max) {
+    int ret = movi_next_packet(ctx);
+    if (ret < 0) {
+      if (count > 0)
+        break;
+      return (ret == AVERROR_EOF) ? 0 : ret;
+    }
+    if (ctx->pkt->stream_index < 0 ||
+        ctx->pkt->stream_index >= (int)ctx->fmt_ctx->nb_streams)
+      break;
+
+    PacketInfo *info = &infos[count];
+    int td_prepend = movi_fill_packet_info(ctx, info);
+    int size = ctx->pkt->size + (td_prepend ? 2 : 0);
+    if (size > arena_size - used) {
+      ctx->pkt_pending = 1;
+      if (count == 0)
+        return AVERROR(ENOBUFS);
+      break;
+    }
+
+    uint8_t *dst = arena + used;
+    if (td_prepend) {
+      dst[0] = 0x12; // TD OBU header: obu_type=2, obu_has_size_field=1
+      dst[1] = 0x00; // leb128 payload size = 0
+      memcpy(dst + 2, ctx->pkt->data, ctx->pkt->size);
+    } else {
+      memcpy(dst, ctx->pkt->data, ctx->pkt->size);
+    }
+    info->size = size;
+    used += size;
+    count++;
+
+    if (info->stream_index == ctx->read_limit_stream &&
+        ++limited >= ctx->read_limit_packets)
+      break;
+    // Live: hand back what's here instead of suspending for the rest
+    if (ctx->live && movi_live_starved(ctx))
+      break;
+  }
+  return count;
+}
+
+// Cap how many packets of one stream a single movi_read_frames call returns
+// (e.g. stop a batch after a few video packets so a 4K GOP doesn't push the
+// audio packets behind it into the next batch). Persists until changed;
+// stream_index < 0 or max_packets <= 0 disables the cap.
+EMSCRIPTEN_KEEPALIVE
+void movi_set_read_frames_limit(MoviContext *ctx, int stream_index,
+                                int max_packets) {
+  if (!ctx)
+    return;
+  if (stream_index < 0 || max_packets <= 0) {
+    ctx->read_limit_stream = -1;
+    ctx->read_limit_packets = 0;
+  } else {
+    ctx->read_limit_stream = stream_index;
+    ctx->read_limit_packets = max_packets;
+  }
+}
+
+// ---- Packet ring (zero-copy read path) -----------------------------------
+// movi_read_frame copies every packet into a JS-provided buffer, and JS then
+// copies it again out of the heap — two full copies of the bitstream per packet
+// before WebCodecs makes its own (~20 MB/s of memcpy for an 80 Mbps 4K
+// remux). movi_read_frame_ref instead moves the demuxed AVPacket reference into
+// one of MOVI_PACKET_SLOTS ring slots and hands JS a pointer straight into the
+// demuxer's buffer; JS views it with HEAPU8.subarray and calls
+// movi_packet_release once it has taken what it needs. The slot holds the only
+// reference, so releasing it is what returns the buffer to FFmpeg.
+//
+// The AV1 Temporal Delimiter prepend can't be done in place (demuxer buffers
+// have no headroom), so those packets are copied once into the slot's own
+// buffer at MOVI_PACKET_HEADROOM and the TD is written into the headroom just
+// before the payload.
+
+static int movi_packet_ring_init(MoviContext *ctx) {
+  if (ctx->pkt_slots)
+    return 0;
+  ctx->pkt_slots =
+      (MoviPacketSlot *)calloc(MOVI_PACKET_SLOTS, sizeof(MoviPacketSlot));
+  if (!ctx->pkt_slots)
+    return AVERROR(ENOMEM);
+  for (int i = 0; i < MOVI_PACKET_SLOTS; i++) {
+    ctx->pkt_slots[i].pkt = av_packet_alloc();
+    if (!ctx->pkt_slots[i].pkt) {
+      movi_packet_ring_free(ctx);
+      return AVERROR(ENOMEM);
+    }
+  }
+  ctx->pkt_slot_next = 0;
+  return 0;
+}
+
+void movi_packet_ring_free(MoviContext *ctx) {
+  if (!ctx || !ctx->pkt_slots)
+    return;
+  for (int i = 0; i < MOVI_PACKET_SLOTS; i++) {
+    av_packet_free(&ctx->pkt_slots[i].pkt);
+    av_freep(&ctx->pkt_slots[i].own);
+  }
+  free(ctx->pkt_slots);
+  ctx->pkt_slots = NULL;
+}
+
+// Next free slot after the last one handed out, or -1 when JS is holding all
+// of them (it forgot to release, or is retaining views across reads).
+static int movi_packet_ring_acquire(MoviContext *ctx) {
+  for (int n = 0; n < MOVI_PACKET_SLOTS; n++) {
+    int i = (ctx->pkt_slot_next + n) % MOVI_PACKET_SLOTS;
+    if (!ctx->pkt_slots[i].in_use) {
+      ctx->pkt_slot_next = (i + 1) % MOVI_PACKET_SLOTS;
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Move ctx->pkt into ring slot `slot` and return a pointer to the bytes JS
+// should see (TD already prepended when requested). Sets info->size.
+static uint8_t *movi_packet_ring_take(MoviContext *ctx, int slot,
+                                      PacketInfo *info, int td_prepend) {
+  MoviPacketSlot *s = &ctx->pkt_slots[slot];
+  av_packet_move_ref(s->pkt, ctx->pkt);
+  uint8_t *data = s->pkt->data;
+  int size = s->pkt->size;
+  if (td_prepend) {
+    int need = MOVI_PACKET_HEADROOM + size + AV_INPUT_BUFFER_PADDING_SIZE;
+    if (s->own_capacity < need) {
+      av_freep(&s->own);
+      s->own = av_malloc(need);
+      s->own_capacity = s->own ? need : 0;
+      if (!s->own) {
+        av_packet_unref(s->pkt);
+        return NULL;
+      }
+    }
+    uint8_t *payload = s->own + MOVI_PACKET_HEADROOM;
+    memcpy(payload, s->pkt->data, size);
+    memset(payload + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    payload[-2] = 0x12; // TD OBU header: obu_type=2, obu_has_size_field=1
+    payload[-1] = 0x00; // leb128 payload size = 0
+    data = payload - 2;
+    size += 2;
+    // The copy is self-contained; drop the demuxer reference right away.
+    av_packet_unref(s->pkt);
+  }
+  s->in_use = 1;
+  info->size = size;
+  return data;
+}
+
+// Zero-copy variant of movi_read_frame. Returns the ring slot id (>= 1) and
+// stores the payload pointer in *data_out; 0 at EOF; < 0 on error
+// (AVERROR(EAGAIN) when every slot is still held by JS). The payload stays
+// valid until movi_packet_release(ctx, slot) — JS must release every slot it
+// receives, including after seeks.
+EMSCRIPTEN_KEEPALIVE
+int movi_read_frame_ref(MoviContext *ctx, PacketInfo *info,
+                        uint8_t **data_out) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt || !info || !data_out)
+    return -1;
+  int ret = movi_packet_ring_init(ctx);
+  if (ret < 0)
+    return ret;
+  int slot = movi_packet_ring_acquire(ctx);
+  if (slot < 0)
+    return AVERROR(EAGAIN);
+  ret = movi_next_packet(ctx);
+  if (ret < 0)
+    return (ret == AVERROR_EOF) ? 0 : ret;
+  if (ctx->pkt->stream_index < 0 ||
+      ctx->pkt->stream_index >= (int)ctx->fmt_ctx->nb_streams)
+    return 0;
+  int td_prepend = movi_fill_packet_info(ctx, info);
+  uint8_t *data = movi_packet_ring_take(ctx, slot, info, td_prepend);
+  if (!data)
+    return AVERROR(ENOMEM);
+  *data_out = data;
+  return slot + 1;
+}
+
+// Give a ring slot back. Unknown / already-released ids are ignored so JS can
+// release defensively from finally blocks.
+EMSCRIPTEN_KEEPALIVE
+void movi_packet_release(MoviContext *ctx, int slot_id) {
+  if (!ctx || !ctx->pkt_slots || slot_id < 1 || slot_id > MOVI_PACKET_SLOTS)
+    return;
+  MoviPacketSlot *s = &ctx->pkt_slots[slot_id - 1];
+  av_packet_unref(s->pkt);
+  s->in_use = 0;
+}
+
 // Chapter support
 EMSCRIPTEN_KEEPALIVE
 int movi_get_chapter_count(MoviContext *ctx) {
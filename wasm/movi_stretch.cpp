@@ -7,17 +7,64 @@
 // implicitly sets the time-stretch factor. We expose that directly: callers
 // pass interleaved Float32 buffers from JS, we de-interleave to planar
 // scratch, run the stretcher, and re-interleave on the way out.
+//
+// Decoded audio is planar to begin with, so movi_stretch_process_planar takes
+// channel pointers and leaves its output in the instance's planar scratch
+// (movi_stretch_output_plane) — no interleave round trip. The demuxer-side
+// movi_decode_audio_batch_stretch (movi_decode.c) feeds it the batch planes
+// directly, decode and stretch in one call.
+//
+// The same file also builds on its own (no FFmpeg) as movi-stretch.wasm, a
+// standalone module the movi-pcm-ring AudioWorklet instantiates so stretching
+// runs per render quantum on the audio thread. For that, movi_stretch_new_preset
+// adds a low-latency configuration: shorter blocks and split computation, so
+// a 128-frame quantum does a bounded slice of the FFT work.
+//
+// An instance is one or more channel groups, each its own stretcher: channels
+// in a group share its phase analysis (Signalsmith sums energy and predicts
+// phase across the group's channels). movi_stretch_new puts every channel in
+// one group. movi_stretch_new_grouped splits a 5.1/7.1 layout by channel mask
+// into groups at their own quality tier, so the fronts get the full 4x
+// overlap while surrounds and LFE run fewer FFTs per second — cost follows
+// what's audible rather than the source channel count.
 
 #include "signalsmith-stretch/signalsmith-stretch.h"
 #include <emscripten.h>
 #include <unordered_map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace {
 
-struct StretchInstance {
+// movi_stretch_new_preset() presets
+enum {
+    MOVI_STRETCH_PRESET_DEFAULT = 0,     // presetDefault: 120ms blocks, best quality
+    MOVI_STRETCH_PRESET_CHEAPER = 1,     // presetCheaper: 100ms blocks, 2.5x overlap
+    MOVI_STRETCH_PRESET_LOW_LATENCY = 2, // 60ms blocks, 3x overlap, split per call
+};
+
+// movi_stretch_new_grouped() tiers. All groups of an instance share one block
+// length — STFT latency depends only on it, so the groups stay sample-aligned
+// — and differ in hop size, i.e. how many blocks are analysed per second.
+enum {
+    MOVI_STRETCH_TIER_FULL = 0,    // 4x overlap, as presetDefault
+    MOVI_STRETCH_TIER_CHEAP = 1,   // 2.5x overlap, presetCheaper's ratio
+    MOVI_STRETCH_TIER_MINIMAL = 2, // 2x overlap: LFE, the least-heard channels
+};
+
+struct StretchGroup {
     signalsmith::stretch::SignalsmithStretch<float> stretch;
+    std::vector<int> map; // instance channel of each group channel
+    std::vector<float *> inPtrs;
+    std::vector<float *> outPtrs;
+
+    explicit StretchGroup(std::vector<int> channels)
+        : map(std::move(channels)), inPtrs(map.size()), outPtrs(map.size()) {}
+};
+
+struct StretchInstance {
+    std::vector<std::unique_ptr<StretchGroup>> groups;
     int channels;
     // Scratch buffers reused across process() calls — grow as needed.
     std::vector<std::vector<float>> planarIn;
@@ -25,12 +72,86 @@ struct StretchInstance {
     std::vector<float *> inPtrs;
     std::vector<float *> outPtrs;
 
-    StretchInstance(int ch, float sampleRate) : channels(ch) {
-        stretch.presetDefault(ch, sampleRate);
-        planarIn.resize(ch);
-        planarOut.resize(ch);
-        inPtrs.resize(ch);
-        outPtrs.resize(ch);
+    StretchInstance(int ch, float sampleRate, int preset) : channels(ch) {
+        std::vector<int> all(ch);
+        for (int c = 0; c < ch; ++c) all[c] = c;
+        groups.push_back(std::make_unique<StretchGroup>(std::move(all)));
+        auto &stretch = groups[0]->stretch;
+        switch (preset) {
+        case MOVI_STRETCH_PRESET_CHEAPER:
+            stretch.presetCheaper(ch, sampleRate);
+            break;
+        case MOVI_STRETCH_PRESET_LOW_LATENCY:
+            // Half presetDefault's block: about half the input + output
+            // latency. splitComputation spreads each block's analysis over
+            // the process() calls of the next interval instead of landing it
+            // all in whichever call crosses the block boundary — what keeps a
+            // 128-frame render quantum inside its deadline.
+            stretch.configure(ch, static_cast<int>(sampleRate * 0.06f),
+                              static_cast<int>(sampleRate * 0.02f), true);
+            break;
+        default:
+            stretch.presetDefault(ch, sampleRate);
+            break;
+        }
+        allocScratch();
+    }
+
+    // masks[g] picks the channels of group g (bit c = channel c; a channel
+    // already taken by an earlier group is skipped), tiers[g] its tier.
+    // Channels no mask covers go to MOVI_STRETCH_TIER_MINIMAL. Groups with
+    // the same tier are merged: each stretcher has a per-block cost
+    // independent of its channel count, so fewer, wider groups are cheaper.
+    StretchInstance(int ch, float sampleRate, const unsigned *masks,
+                    const int *tiers, int count) : channels(ch) {
+        const unsigned all = ch >= 32 ? ~0u : (1u << ch) - 1;
+        unsigned tierMask[3] = {0, 0, 0};
+        unsigned taken = 0;
+        for (int g = 0; g < count; ++g) {
+            const int tier = (tiers[g] >= 0 && tiers[g] <= MOVI_STRETCH_TIER_MINIMAL)
+                ? tiers[g] : MOVI_STRETCH_TIER_FULL;
+            const unsigned mask = masks[g] & all & ~taken;
+            tierMask[tier] |= mask;
+            taken |= mask;
+        }
+        tierMask[MOVI_STRETCH_TIER_MINIMAL] |= all & ~taken;
+
+        const int block = static_cast<int>(sampleRate * 0.12f);
+        const int intervals[3] = {block / 4, block * 2 / 5, block / 2};
+        for (int tier = 0; tier < 3; ++tier) {
+            std::vector<int> members;
+            for (int c = 0; c < ch; ++c) {
+                if (tierMask[tier] & (1u << c)) members.push_back(c);
+            }
+            if (members.empty()) continue;
+            groups.push_back(std::make_unique<StretchGroup>(std::move(members)));
+            auto &group = *groups.back();
+            group.stretch.configure(static_cast<int>(group.map.size()), block, intervals[tier]);
+        }
+        allocScratch();
+    }
+
+    void allocScratch() {
+        planarIn.resize(channels);
+        planarOut.resize(channels);
+        inPtrs.resize(channels);
+        outPtrs.resize(channels);
+    }
+
+    // Every group's latency is the same (see the tiers above)
+    signalsmith::stretch::SignalsmithStretch<float> &primary() {
+        return groups[0]->stretch;
+    }
+
+    // Stretch inPtrs → outPtrs (one pointer per instance channel)
+    void process(int inFrames, int outFrames) {
+        for (auto &group : groups) {
+            for (size_t i = 0; i < group->map.size(); ++i) {
+                group->inPtrs[i] = inPtrs[group->map[i]];
+                group->outPtrs[i] = outPtrs[group->map[i]];
+            }
+            group->stretch.process(group->inPtrs, inFrames, group->outPtrs, outFrames);
+        }
     }
 };
 
@@ -48,10 +169,29 @@ int nextHandle() {
 
 extern "C" {
 
+EMSCRIPTEN_KEEPALIVE
+int movi_stretch_new_preset(int channels, float sampleRate, int preset) {
+    if (channels <= 0 || sampleRate <= 0) return 0;
+    int h = nextHandle();
+    instances()[h] = std::make_unique<StretchInstance>(channels, sampleRate, preset);
+    return h;
+}
+
 EMSCRIPTEN_KEEPALIVE
 int movi_stretch_new(int channels, float sampleRate) {
+    return movi_stretch_new_preset(channels, sampleRate, MOVI_STRETCH_PRESET_DEFAULT);
+}
+
+// Channel-group instance: `groups` entries of masks[] / tiers[] (see
+// StretchInstance). Same process/output API as movi_stretch_new; 0 for
+// invalid arguments or more than 32 channels.
+EMSCRIPTEN_KEEPALIVE
+int movi_stretch_new_grouped(int channels, float sampleRate,
+                             const unsigned *masks, const int *tiers, int groups) {
+    if (channels <= 0 || channels > 32 || sampleRate <= 0 || groups < 0) return 0;
+    if (groups > 0 && (!masks || !tiers)) return 0;
     int h = nextHandle();
-    instances()[h] = std::make_unique<StretchInstance>(channels, sampleRate);
+    instances()[h] = std::make_unique<StretchInstance>(channels, sampleRate, masks, tiers, groups);
     return h;
 }
 
@@ -63,28 +203,30 @@ void movi_stretch_delete(int handle) {
 EMSCRIPTEN_KEEPALIVE
 void movi_stretch_reset(int handle) {
     auto it = instances().find(handle);
-    if (it != instances().end()) it->second->stretch.reset();
+    if (it == instances().end()) return;
+    for (auto &group : it->second->groups) group->stretch.reset();
 }
 
 // Pitch shift in semitones; 0 = pitch-preserving (the time-stretch case).
 EMSCRIPTEN_KEEPALIVE
 void movi_stretch_set_transpose_semitones(int handle, float semitones) {
     auto it = instances().find(handle);
-    if (it != instances().end()) {
-        it->second->stretch.setTransposeSemitones(semitones);
+    if (it == instances().end()) return;
+    for (auto &group : it->second->groups) {
+        group->stretch.setTransposeSemitones(semitones);
     }
 }
 
 EMSCRIPTEN_KEEPALIVE
 int movi_stretch_input_latency(int handle) {
     auto it = instances().find(handle);
-    return (it != instances().end()) ? it->second->stretch.inputLatency() : 0;
+    return (it != instances().end()) ? it->second->primary().inputLatency() : 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
 int movi_stretch_output_latency(int handle) {
     auto it = instances().find(handle);
-    return (it != instances().end()) ? it->second->stretch.outputLatency() : 0;
+    return (it != instances().end()) ? it->second->primary().outputLatency() : 0;
 }
 
 // Sync time-stretch. inFrames input → outFrames output, both interleaved.
@@ -119,7 +261,7 @@ void movi_stretch_process(int handle,
         inst.outPtrs[c] = inst.planarOut[c].data();
     }
 
-    inst.stretch.process(inst.inPtrs, inFrames, inst.outPtrs, outFrames);
+    inst.process(inFrames, outFrames);
 
     // Interleave back out.
     for (int c = 0; c < channels; ++c) {
@@ -130,4 +272,44 @@ void movi_stretch_process(int handle,
     }
 }
 
+// Planar time-stretch: in[c] holds inFrames samples of channel c. Mono input
+// to a stereo instance is duplicated; extra input channels are ignored. The
+// result stays in the instance — read outFrames samples per channel from
+// movi_stretch_output_plane(). Returns 0, or -1 for an unknown handle.
+EMSCRIPTEN_KEEPALIVE
+int movi_stretch_process_planar(int handle, const float *const *in,
+                                int inChannels, int inFrames, int outFrames) {
+    auto it = instances().find(handle);
+    if (it == instances().end() || inChannels <= 0 || inFrames < 0 || outFrames < 0)
+        return -1;
+    auto &inst = *it->second;
+    const int channels = inst.channels;
+
+    for (int c = 0; c < channels; ++c) {
+        inst.inPtrs[c] = const_cast<float *>(in[c < inChannels ? c : inChannels - 1]);
+        if ((int)inst.planarOut[c].size() < outFrames) {
+            inst.planarOut[c].resize(outFrames);
+        }
+        inst.outPtrs[c] = inst.planarOut[c].data();
+    }
+
+    inst.process(inFrames, outFrames);
+    return 0;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int movi_stretch_channels(int handle) {
+    auto it = instances().find(handle);
+    return (it != instances().end()) ? it->second->channels : 0;
+}
+
+// Channel `ch` of the last movi_stretch_process_planar output.
+EMSCRIPTEN_KEEPALIVE
+float *movi_stretch_output_plane(int handle, int ch) {
+    auto it = instances().find(handle);
+    if (it == instances().end() || ch < 0 || ch >= it->second->channels)
+        return nullptr;
+    return it->second->planarOut[ch].data();
+}
+
 } // extern "C"
@@ -0,0 +1,455 @@
+#include "movi.h"
+
+// ---- Batched subtitle decode ----------------------------------------------
+// The per-packet path costs JS four crossings and an allocation per cue:
+// movi_decode_subtitle, movi_get_subtitle_times, movi_get_subtitle_text into a
+// fresh 4KB buffer, movi_free_subtitle — plus two more and an RGBA copy for a
+// bitmap. Karaoke-heavy ASS tracks carry hundreds of events a minute, so that
+// overhead shows up in the demux tick the same way TrueHD's tiny access units
+// did for audio (see movi_decode_audio_batch).
+//
+// movi_decode_subtitle_batch decodes many packets in one call into a compact
+// table owned by the context: one MoviSubCue per displayable event, the text
+// of every cue back to back in one UTF-8 arena (each NUL-terminated, in cue
+// order, so JS decodes the arena with a single TextDecoder pass and splits on
+// NUL), and for bitmap subtitles (PGS/DVB/DVD) a rect table pointing into an
+// RGBA pixel arena. movi_subtitle_batch_info hands JS all four locations at
+// once. Everything is reused across calls; JS reads a batch out before the
+// next one.
+//
+// ASS style names are interned into a per-context table, so a cue carries a
+// small id and JS looks each name up (movi_subtitle_style_name) once.
+//
+// Bitmap rects are 8-bit palettized, and a full-screen 4K PGS object expanded
+// to RGBA is a 33MB copy. With movi_subtitle_batch_set_palettized the rect
+// is exported as its index plane plus a 256-entry RGBA palette instead, which
+// the renderer expands on the GPU. Consecutive display sets mostly reuse the
+// same objects (a palette fade, a second line appearing), so each rect's
+// index plane is hashed and, when it matches a rect of the previous bitmap
+// cue (hash first, then the indices themselves, kept from that cue), only the
+// palette is written and `ref` names the rect to reuse.
+
+// Stop taking packets once this much bitmap data has accumulated; JS drains the batch
+// and calls again with the remainder, as with a short audio batch.
+#define MOVI_SUB_BATCH_PIXELS (16 * 1024 * 1024)
+
+typedef struct {
+  double start_sec;
+  double end_sec;
+  int32_t style;      // movi_subtitle_style_name id, -1 when the event has none
+  int32_t text_off;   // into the text arena, NUL-terminated
+  int32_t text_len;   // bytes, excluding the NUL
+  int32_t rect_first; // index into the rect table, -1 for a text cue
+  int32_t rect_count;
+  int32_t reserved;
+} MoviSubCue; // 40 bytes, mirrored by SUB_CUE_OFFSETS in types.ts
+
+typedef struct {
+  int32_t x;
+  int32_t y;
+  int32_t w;
+  int32_t h;
+  int32_t data_off;    // w * h RGBA, or w * h indices when palettized; -1
+                       // when the indices are those of rect `ref`
+  int32_t palette_off; // 256 RGBA entries when palettized, else -1
+  int32_t ref; // rect of the previous bitmap cue with the same indices, or -1
+} MoviSubRect; // 28 bytes, mirrored by SUB_RECT_OFFSETS in types.ts
+
+// What palettized diffing remembers about a rect of the previous bitmap cue
+typedef struct {
+  int w;
+  int h;
+  uint64_t hash;
+  int indices_off; // w * h indices in the cue's copy (prev_indices/cur_indices)
+} MoviSubPrevRect;
+
+struct MoviSubBatch {
+  MoviSubCue *cues;
+  int count;
+  int cue_capacity;
+  MoviSubRect *rects;
+  int rect_count;
+  int rect_capacity;
+  char *text;
+  int text_size;
+  int text_capacity;
+  uint8_t *pixels;
+  int pixel_size;
+  int pixel_capacity;
+  char **styles;
+  int style_count;
+  int style_capacity;
+  int palettized;
+  // Rects of the last bitmap cue (prev) and of the one being built (cur)
+  MoviSubPrevRect *prev;
+  int prev_count;
+  int prev_capacity;
+  MoviSubPrevRect *cur;
+  int cur_capacity;
+  // Their index planes, so a hash match can be confirmed byte for byte
+  uint8_t *prev_indices;
+  int prev_indices_capacity;
+  uint8_t *cur_indices;
+  int cur_indices_capacity;
+  int prev_stream;
+  // movi_subtitle_batch_info: cues, count, text, text bytes, rects, rect
+  // count, pixels, pixel bytes (wasm32 pointers fit an int32)
+  int32_t info[8];
+};
+
+void movi_sub_batch_free(MoviContext *ctx) {
+  if (!ctx || !ctx->sub_batch)
+    return;
+  MoviSubBatch *b = ctx->sub_batch;
+  for (int i = 0; i < b->style_count; i++)
+    free(b->styles[i]);
+  free(b->styles);
+  free(b->cues);
+  free(b->rects);
+  free(b->text);
+  free(b->pixels);
+  free(b->prev);
+  free(b->cur);
+  free(b->prev_indices);
+  free(b->cur_indices);
+  free(b);
+  ctx->sub_batch = NULL;
+}
+
+// Grow `*p` to hold at least `need` elements of `elem` bytes (doubling)
+static int movi_subs_grow(void **p, int *capacity, int64_t need, size_t elem) {
+  if (need <= *capacity)
+    return 0;
+  if (need > INT_MAX / 2)
+    return -1;
+  int cap = *capacity ? *capacity : 16;
+  while (cap < need)
+    cap *= 2;
+  void *grown = realloc(*p, (size_t)cap * elem);
+  if (!grown)
+    return -1;
+  *p = grown;
+  *capacity = cap;
+  return 0;
+}
+
+static MoviSubBatch *movi_subs_batch(MoviContext *ctx) {
+  if (!ctx->sub_batch) {
+    ctx->sub_batch = calloc(1, sizeof(MoviSubBatch));
+    if (ctx->sub_batch)
+      ctx->sub_batch->prev_stream = -1;
+  }
+  return ctx->sub_batch;
+}
+
+// Identity of a rect's index plane, 8 bytes at a time along each row
+static uint64_t movi_subs_hash_indices(const AVSubtitleRect *rect) {
+  uint64_t h =
+      0x9e3779b97f4a7c15ull ^ ((uint64_t)rect->w << 32 | (uint32_t)rect->h);
+  for (int y = 0; y < rect->h; y++) {
+    const uint8_t *row = rect->data[0] + (size_t)y * rect->linesize[0];
+    int x = 0;
+    for (; x + 8 <= rect->w; x += 8) {
+      uint64_t v;
+      memcpy(&v, row + x, 8);
+      h = (h ^ v) * 0x100000001b3ull;
+      h ^= h >> 29;
+    }
+    for (; x < rect->w; x++)
+      h = (h ^ row[x]) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+// Style of an ASS event: the third field of ff_ass_get_dialog's
+// "ReadOrder,Layer,Style,Name,..." or the fourth of a full
+// "Dialogue: Layer,Start,End,Style,..." line. Interned; -1 when absent.
+static int32_t movi_subs_style_id(MoviSubBatch *b, const char *ass) {
+  const char *p = ass;
+  int skip = 2;
+  if (strncmp(p, "Dialogue:", 9) == 0) {
+    p += 9;
+    skip = 3;
+  }
+  for (; *p && skip > 0; p++) {
+    if (*p == ',')
+      skip--;
+  }
+  if (skip > 0)
+    return -1;
+  while (*p == ' ')
+    p++;
+  const char *end = p;
+  while (*end && *end != ',')
+    end++;
+  while (end > p && end[-1] == ' ')
+    end--;
+  int len = (int)(end - p);
+  if (len <= 0)
+    return -1;
+
+  for (int i = 0; i < b->style_count; i++) {
+    if (strncmp(b->styles[i], p, len) == 0 && b->styles[i][len] == '\0')
+      return i;
+  }
+  if (movi_subs_grow((void **)&b->styles, &b->style_capacity,
+                     b->style_count + 1, sizeof(char *)) < 0)
+    return -1;
+  char *name = malloc(len + 1);
+  if (!name)
+    return -1;
+  memcpy(name, p, len);
+  name[len] = '\0';
+  b->styles[b->style_count] = name;
+  return b->style_count++;
+}
+
+// Append ctx->subtitle to the batch. Returns 1 when a cue was added, 0 when
+// the event had nothing to show (or no usable times, which the per-packet path
+// also drops), -1 on OOM.
+static int movi_subs_append(MoviContext *ctx, MoviSubBatch *b) {
+  AVSubtitle *sub = ctx->subtitle;
+  double start, end;
+  if (movi_get_subtitle_times(ctx, &start, &end) < 0)
+    return 0;
+
+  // movi_get_subtitle_text only ever shortens its source (ASS tags collapse,
+  // \N becomes \n) and adds one newline between rects, so this bounds it.
+  int64_t text_bound = 1;
+  int64_t pixel_bytes = 0;
+  int64_t index_bytes = 0;
+  int bitmaps = 0;
+  int32_t style = -1;
+  for (unsigned i = 0; i < sub->num_rects; i++) {
+    AVSubtitleRect *rect = sub->rects[i];
+    if (!rect)
+      continue;
+    if (rect->type == SUBTITLE_TEXT && rect->text) {
+      text_bound += (int64_t)strlen(rect->text) + 1;
+    } else if (rect->type == SUBTITLE_ASS && rect->ass) {
+      text_bound += (int64_t)strlen(rect->ass) + 1;
+      if (style < 0)
+        style = movi_subs_style_id(b, rect->ass);
+    } else if (rect->type == SUBTITLE_BITMAP && rect->data[0] && rect->w > 0 &&
+               rect->h > 0) {
+      bitmaps++;
+      index_bytes += (int64_t)rect->w * rect->h;
+      pixel_bytes += b->palettized ? (int64_t)rect->w * rect->h + AVPALETTE_SIZE
+                                   : (int64_t)rect->w * rect->h * 4;
+    }
+  }
+
+  if (movi_subs_grow((void **)&b->cues, &b->cue_capacity, b->count + 1,
+                     sizeof(MoviSubCue)) < 0 ||
+      movi_subs_grow((void **)&b->text, &b->text_capacity,
+                     (int64_t)b->text_size + text_bound, 1) < 0 ||
+      movi_subs_grow((void **)&b->rects, &b->rect_capacity,
+                     (int64_t)b->rect_count + bitmaps,
+                     sizeof(MoviSubRect)) < 0 ||
+      movi_subs_grow((void **)&b->pixels, &b->pixel_capacity,
+                     (int64_t)b->pixel_size + pixel_bytes, 1) < 0 ||
+      (b->palettized &&
+       (movi_subs_grow((void **)&b->cur, &b->cur_capacity, bitmaps,
+                       sizeof(MoviSubPrevRect)) < 0 ||
+        movi_subs_grow((void **)&b->cur_indices, &b->cur_indices_capacity,
+                       index_bytes, 1) < 0)))
+    return -1;
+
+  MoviSubCue *cue = &b->cues[b->count];
+  cue->start_sec = start;
+  cue->end_sec = end;
+  cue->style = style;
+  cue->text_off = b->text_size;
+  cue->rect_first = b->rect_count;
+  cue->rect_count = 0;
+  cue->reserved = 0;
+
+  // No rects returns 0 without terminating the buffer
+  char *text = b->text + b->text_size;
+  text[0] = '\0';
+  int len = movi_get_subtitle_text(ctx, text, (int)text_bound);
+  cue->text_len = len > 0 ? len : 0;
+
+  int indices_size = 0;
+  for (unsigned i = 0; i < sub->num_rects && bitmaps > 0; i++) {
+    AVSubtitleRect *rect = sub->rects[i];
+    if (!rect || rect->type != SUBTITLE_BITMAP || !rect->data[0] ||
+        rect->w <= 0 || rect->h <= 0)
+      continue;
+    if (b->palettized
+            ? !rect->data[1]
+            : movi_subtitle_rect_rgba(rect, b->pixels + b->pixel_size) < 0)
+      continue;
+    MoviSubRect *r = &b->rects[b->rect_count++];
+    r->x = rect->x;
+    r->y = rect->y;
+    r->w = rect->w;
+    r->h = rect->h;
+    r->palette_off = -1;
+    r->ref = -1;
+    cue->rect_count++;
+    if (!b->palettized) {
+      r->data_off = b->pixel_size;
+      b->pixel_size += rect->w * rect->h * 4;
+      continue;
+    }
+
+    MoviSubPrevRect *cur = &b->cur[cue->rect_count - 1];
+    cur->w = rect->w;
+    cur->h = rect->h;
+    cur->hash = movi_subs_hash_indices(rect);
+    cur->indices_off = indices_size;
+    uint8_t *indices = b->cur_indices + indices_size;
+    for (int y = 0; y < rect->h; y++)
+      memcpy(indices + (size_t)y * rect->w,
+             rect->data[0] + (size_t)y * rect->linesize[0], rect->w);
+    indices_size += rect->w * rect->h;
+    for (int j = 0; j < b->prev_count; j++) {
+      if (b->prev[j].w == cur->w && b->prev[j].h == cur->h &&
+          b->prev[j].hash == cur->hash &&
+          memcmp(b->prev_indices + b->prev[j].indices_off, indices,
+                 (size_t)rect->w * rect->h) == 0) {
+        r->ref = j;
+        break;
+      }
+    }
+    if (r->ref >= 0) {
+      r->data_off = -1;
+    } else {
+      r->data_off = b->pixel_size;
+      memcpy(b->pixels + b->pixel_size, indices, (size_t)rect->w * rect->h);
+      b->pixel_size += rect->w * rect->h;
+    }
+    // Palette is BGRA in FFmpeg; RGBA here, as movi_subtitle_rect_rgba emits
+    const uint8_t *pal = rect->data[1];
+    uint8_t *out = b->pixels + b->pixel_size;
+    for (int c = 0; c < AVPALETTE_COUNT; c++) {
+      out[c * 4 + 0] = pal[c * 4 + 2];
+      out[c * 4 + 1] = pal[c * 4 + 1];
+      out[c * 4 + 2] = pal[c * 4 + 0];
+      out[c * 4 + 3] = pal[c * 4 + 3];
+    }
+    r->palette_off = b->pixel_size;
+    b->pixel_size += AVPALETTE_SIZE;
+  }
+  if (cue->rect_count == 0)
+    cue->rect_first = -1;
+
+  if (cue->text_len == 0 && cue->rect_count == 0)
+    return 0;
+  if (b->palettized && cue->rect_count > 0) {
+    // This cue's rects are what the next one diffs against
+    MoviSubPrevRect *swap = b->prev;
+    int swap_capacity = b->prev_capacity;
+    b->prev = b->cur;
+    b->prev_capacity = b->cur_capacity;
+    b->prev_count = cue->rect_count;
+    b->cur = swap;
+    b->cur_capacity = swap_capacity;
+    uint8_t *swap_indices = b->prev_indices;
+    int swap_indices_capacity = b->prev_indices_capacity;
+    b->prev_indices = b->cur_indices;
+    b->prev_indices_capacity = b->cur_indices_capacity;
+    b->cur_indices = swap_indices;
+    b->cur_indices_capacity = swap_indices_capacity;
+  }
+  b->text_size += cue->text_len + 1;
+  b->count++;
+  return 1;
+}
+
+/**
+ * Decode up to `count` subtitle packets in one call into the batch cue table
+ * (read it with movi_subtitle_batch_info).
+ *
+ * `blob` holds the payloads back to back; `sizes[i]`, `ptss[i]` and
+ * `durations[i]` describe packet i, with the same meaning as
+ * movi_decode_subtitle's arguments. Packets that fail to decode are skipped,
+ * as the per-packet path skips them. Returns the number of packets CONSUMED,
+ * < count when the pixel budget filled up: JS reads the batch out and calls
+ * again with the remainder. Negative only when nothing could be decoded.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_decode_subtitle_batch(MoviContext *ctx, int stream_index,
+                               uint8_t *blob, int32_t *sizes, double *ptss,
+                               double *durations, int count) {
+  if (!ctx || !ctx->decoders || stream_index < 0 ||
+      stream_index >= (int)ctx->fmt_ctx->nb_streams ||
+      !ctx->decoders[stream_index] || !blob || !sizes || !ptss || !durations ||
+      count <= 0)
+    return -1;
+
+  MoviSubBatch *b = movi_subs_batch(ctx);
+  if (!b)
+    return -1;
+  if (b->prev_stream != stream_index) {
+    b->prev_count = 0;
+    b->prev_stream = stream_index;
+  }
+  b->count = 0;
+  b->rect_count = 0;
+  b->text_size = 0;
+  b->pixel_size = 0;
+
+  int64_t offset = 0;
+  int consumed = 0;
+  for (int i = 0; i < count; i++) {
+    if (sizes[i] < 0 ||
+        (consumed > 0 && b->pixel_size >= MOVI_SUB_BATCH_PIXELS))
+      break;
+    int ret = movi_decode_subtitle(ctx, stream_index, blob + offset, sizes[i],
+                                   ptss[i], durations[i]);
+    offset += sizes[i];
+    consumed++;
+    if (ret != 0)
+      continue; // EAGAIN (no event yet) or a broken packet
+    int added = movi_subs_append(ctx, b);
+    movi_free_subtitle(ctx);
+    if (added < 0)
+      break; // OOM: this event is lost, the ones before it still go out
+  }
+
+  b->info[0] = (int32_t)(intptr_t)b->cues;
+  b->info[1] = b->count;
+  b->info[2] = (int32_t)(intptr_t)b->text;
+  b->info[3] = b->text_size;
+  b->info[4] = (int32_t)(intptr_t)b->rects;
+  b->info[5] = b->rect_count;
+  b->info[6] = (int32_t)(intptr_t)b->pixels;
+  b->info[7] = b->pixel_size;
+  return consumed > 0 ? consumed : -1;
+}
+
+/**
+ * Export bitmap rects as index plane + RGBA palette (1) or expanded RGBA (0,
+ * the default). Also forgets the previous cue's rects, so JS calls it when it
+ * drops its own copies (track change, decoder reconfigure) and the next cue
+ * carries every index plane again. Returns 0, or -1 without a context.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_subtitle_batch_set_palettized(MoviContext *ctx, int enable) {
+  if (!ctx)
+    return -1;
+  MoviSubBatch *b = movi_subs_batch(ctx);
+  if (!b)
+    return -1;
+  b->palettized = enable ? 1 : 0;
+  b->prev_count = 0;
+  return 0;
+}
+
+// Where the last batch landed: 8 int32s, see MoviSubBatch.info. NULL before
+// the first movi_decode_subtitle_batch.
+EMSCRIPTEN_KEEPALIVE
+const int32_t *movi_subtitle_batch_info(MoviContext *ctx) {
+  if (!ctx || !ctx->sub_batch)
+    return NULL;
+  return ctx->sub_batch->info;
+}
+
+EMSCRIPTEN_KEEPALIVE
+const char *movi_subtitle_style_name(MoviContext *ctx, int id) {
+  if (!ctx || !ctx->sub_batch || id < 0 || id >= ctx->sub_batch->style_count)
+    return NULL;
+  return ctx->sub_batch->styles[id];
+}
@@ -7,6 +7,8 @@
 #include "movi.h"
 #include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
+#include <math.h>
+#include <string.h>
 
 // Thumbnail context
 struct MoviThumbnailContext {
@@ -31,8 +33,217 @@ struct MoviThumbnailContext {
   // Result storage
   int last_packet_size;
   double last_packet_pts;
+
+  // Fast preview decode (movi_thumbnail_set_fast_decode): output width the
+  // caller will scale to, applied when the decoder opens. 0 = full quality.
+  int fast_target_width;
+
+  // Storyboard sweep (movi_thumbnail_storyboard_*). Tiles are stored back to
+  // back, tile i at sb_tiles + i * sb_tile_w * sb_tile_h * 4 (RGBA).
+  uint8_t *sb_tiles;
+  double *sb_pts;
+  int sb_tile_w;
+  int sb_tile_h;
+  int sb_max_tiles;
+  struct SwsContext *sb_sws;
+  // Keyframe already read past the previous target (held for the next one)
+  AVPacket *sb_next;
+  int sb_has_next;
+  // ctx->frame holds the decoded keyframe at sb_cur_ts (stream time base)
+  int sb_has_cur;
+  int64_t sb_cur_ts;
+
+  // Scrub cursor (movi_thumbnail_scrub_keyframe). ctx->pkt holds the keyframe
+  // at scrub_key_ts; scrub_next_ts is the next keyframe (AV_NOPTS_VALUE when
+  // not known yet, INT64_MAX past the last one) and scrub_next the packet
+  // already read for it.
+  int scrub_active;
+  int scrub_has_key;
+  int64_t scrub_key_ts;
+  int64_t scrub_next_ts;
+  AVPacket *scrub_next;
+  int scrub_has_next;
+
+  // movi_thumbnail_set_header_only: open without avformat_find_stream_info
+  // when the container header already describes the video stream
+  int header_only;
+  // movi_thumbnail_import_probe: descriptor consumed by movi_thumbnail_open
+  uint8_t *probe_blob;
+  int probe_size;
 };
 
+// A storyboard target this close after the previous one (seconds) is reached
+// by reading forward through keyframes instead of seeking. With the stream at
+// AVDISCARD_NONKEY, MP4 skips straight between sync samples; Matroska still
+// walks the clusters, so keep the window to a few GOPs.
+#define MOVI_STORYBOARD_SWEEP_SEC 12.0
+
+// ---- Fast preview decode ---------------------------------------------------
+// A 4K HDR keyframe decoded at full quality and then scaled to a 160-px tile
+// spends nearly all its time on work the tile can't show: deblocking/SAO/CDEF,
+// film-grain synthesis, full-resolution reconstruction. Fast mode trades that
+// away where the decoder allows it:
+//   lowres            — decoders with max_lowres (MJPEG, MPEG-1/2/4, H.263)
+//                       output 1/2..1/8 size, chosen not to undershoot the
+//                       target width; H.264/HEVC/AV1 have no reduced output
+//   skip_loop_filter  — AVDISCARD_ALL: no deblock (H.264/HEVC), no in-loop
+//                       filters (libdav1d maps it to inloop_filters)
+//   skip_idct         — AVDISCARD_NONKEY: only affects non-key pictures; the
+//                       keyframe itself must reconstruct fully
+//   film grain        — exported as side data instead of applied (dav1d)
+// and sws uses the fast bilinear scaler straight from the decoder output.
+
+EMSCRIPTEN_KEEPALIVE
+void movi_thumbnail_set_fast_decode(struct MoviThumbnailContext *ctx,
+                                    int target_width) {
+  if (!ctx)
+    return;
+  // Takes effect at movi_thumbnail_open (lowres can't change on an open
+  // decoder); the skip flags are also applied to a decoder already open.
+  ctx->fast_target_width = target_width > 0 ? target_width : 0;
+  if (ctx->dec_ctx && ctx->fast_target_width) {
+    ctx->dec_ctx->skip_loop_filter = AVDISCARD_ALL;
+    ctx->dec_ctx->skip_idct = AVDISCARD_NONKEY;
+  }
+}
+
+static void thumbnail_apply_fast_decode(struct MoviThumbnailContext *ctx,
+                                        const AVCodec *codec,
+                                        AVDictionary **opts) {
+  if (!ctx->fast_target_width)
+    return;
+  AVCodecContext *dec = ctx->dec_ctx;
+  int lowres = 0;
+  while (lowres < codec->max_lowres &&
+         (dec->width >> (lowres + 1)) >= ctx->fast_target_width)
+    lowres++;
+  dec->lowres = lowres;
+  dec->skip_loop_filter = AVDISCARD_ALL;
+  dec->skip_idct = AVDISCARD_NONKEY;
+  dec->export_side_data |= AV_CODEC_EXPORT_DATA_FILM_GRAIN;
+  if (!strcmp(codec->name, "libdav1d"))
+    av_dict_set(opts, "max_frame_delay", "1", 0);
+  av_log(NULL, AV_LOG_DEBUG, "[THUMB] Fast decode: target=%d lowres=%d\n",
+         ctx->fast_target_width, lowres);
+}
+
+// ---- HDR → SDR for tiles that bypass ThumbnailRenderer --------------------
+// readKeyframe output goes through ThumbnailRenderer, which tone-maps PQ in
+// its shader (or shows it natively), so movi_thumbnail_decode_frame keeps the
+// signal as-is. Storyboard tiles are composited straight into a JPEG, so they
+// are tone-mapped here, in the same pass as the downscale: sws goes directly
+// to RGB48 at tile size (BT.2020 matrix), then a per-channel LUT applies the
+// transfer's EOTF, the renderer's Reinhard curve (exposure 35) and gamma 2.2,
+// so tiles match the hover preview.
+#define TONEMAP_LUT_BITS 12
+#define TONEMAP_LUT_SIZE (1 << TONEMAP_LUT_BITS)
+
+static uint8_t tonemap_lut_pq[TONEMAP_LUT_SIZE];
+static uint8_t tonemap_lut_hlg[TONEMAP_LUT_SIZE];
+static int tonemap_lut_ready;
+
+static void tonemap_build_luts(void) {
+  const double m1 = 2610.0 / 16384.0, m2 = 2523.0 / 4096.0 * 128.0;
+  const double c1 = 3424.0 / 4096.0, c2 = 2413.0 / 4096.0 * 32.0;
+  const double c3 = 2392.0 / 4096.0 * 32.0;
+  const double ha = 0.17883277, hb = 0.28466892, hc = 0.55991073;
+  const double exposure = 35.0;
+  for (int i = 0; i < TONEMAP_LUT_SIZE; i++) {
+    double v = (double)i / (TONEMAP_LUT_SIZE - 1);
+
+    // PQ: linear light, 1.0 = 10000 nits
+    double p = pow(v, 1.0 / m2);
+    double num = p - c1 > 0.0 ? p - c1 : 0.0;
+    double pq_lin = pow(num / (c2 - c3 * p), 1.0 / m1);
+
+    // HLG: inverse OETF, OOTF (gamma 1.2) for a 1000-nit display, same scale
+    double scene = v <= 0.5 ? v * v / 3.0 : (exp((v - hc) / ha) + hb) / 12.0;
+    double hlg_lin = 0.1 * pow(scene, 1.2);
+
+    double pq = pq_lin * exposure;
+    double hlg = hlg_lin * exposure;
+    tonemap_lut_pq[i] = (uint8_t)(pow(pq / (1.0 + pq), 1.0 / 2.2) * 255.0 + 0.5);
+    tonemap_lut_hlg[i] = (uint8_t)(pow(hlg / (1.0 + hlg), 1.0 / 2.2) * 255.0 + 0.5);
+  }
+  tonemap_lut_ready = 1;
+}
+
+static const uint8_t *thumbnail_tonemap_lut(const AVFrame *frame) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+  if (!desc || desc->comp[0].depth <= 8)
+    return NULL;
+  if (frame->color_trc != AVCOL_TRC_SMPTE2084 &&
+      frame->color_trc != AVCOL_TRC_ARIB_STD_B67)
+    return NULL;
+  if (!tonemap_lut_ready)
+    tonemap_build_luts();
+  return frame->color_trc == AVCOL_TRC_SMPTE2084 ? tonemap_lut_pq
+                                                 : tonemap_lut_hlg;
+}
+
+/**
+ * Scale a decoded frame to width x height RGBA at dst. With `tonemap`, PQ/HLG
+ * high-bit-depth frames come out tone-mapped to SDR. Returns 0 or < 0.
+ */
+static int thumbnail_frame_to_rgba(struct MoviThumbnailContext *ctx,
+                                   struct SwsContext **sws,
+                                   const AVFrame *frame, uint8_t *dst,
+                                   int dst_linesize, int width, int height,
+                                   int tonemap) {
+  int flags = ctx->fast_target_width ? SWS_FAST_BILINEAR : SWS_BILINEAR;
+  const uint8_t *lut = tonemap ? thumbnail_tonemap_lut(frame) : NULL;
+
+  if (!lut) {
+    *sws = sws_getCachedContext(*sws, frame->width, frame->height,
+                                frame->format, width, height, AV_PIX_FMT_RGBA,
+                                flags, NULL, NULL, NULL);
+    if (!*sws)
+      return -1;
+    uint8_t *dst_data[4] = {dst, NULL, NULL, NULL};
+    int dst_ls[4] = {dst_linesize, 0, 0, 0};
+    sws_scale(*sws, (const uint8_t *const *)frame->data, frame->linesize, 0,
+              frame->height, dst_data, dst_ls);
+    return 0;
+  }
+
+  *sws = sws_getCachedContext(*sws, frame->width, frame->height, frame->format,
+                              width, height, AV_PIX_FMT_RGB48, flags, NULL,
+                              NULL, NULL);
+  if (!*sws)
+    return -1;
+  int src_range = frame->color_range == AVCOL_RANGE_JPEG;
+  int cs = frame->colorspace == AVCOL_SPC_BT2020_CL ? SWS_CS_BT2020
+         : frame->colorspace == AVCOL_SPC_BT2020_NCL ? SWS_CS_BT2020
+         : frame->colorspace == AVCOL_SPC_BT709 ? SWS_CS_ITU709
+         : SWS_CS_BT2020; // PQ/HLG without tagged matrix: assume BT.2020
+  sws_setColorspaceDetails(*sws, sws_getCoefficients(cs), src_range,
+                           sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16,
+                           1 << 16);
+
+  int rgb48_linesize = width * 6;
+  uint16_t *rgb48 = av_malloc((size_t)rgb48_linesize * height);
+  if (!rgb48)
+    return AVERROR(ENOMEM);
+  uint8_t *tmp_data[4] = {(uint8_t *)rgb48, NULL, NULL, NULL};
+  int tmp_ls[4] = {rgb48_linesize, 0, 0, 0};
+  sws_scale(*sws, (const uint8_t *const *)frame->data, frame->linesize, 0,
+            frame->height, tmp_data, tmp_ls);
+
+  const int shift = 16 - TONEMAP_LUT_BITS;
+  for (int y = 0; y < height; y++) {
+    const uint16_t *in = rgb48 + (size_t)y * width * 3;
+    uint8_t *out = dst + (size_t)y * dst_linesize;
+    for (int x = 0; x < width; x++) {
+      out[x * 4 + 0] = lut[in[x * 3 + 0] >> shift];
+      out[x * 4 + 1] = lut[in[x * 3 + 1] >> shift];
+      out[x * 4 + 2] = lut[in[x * 3 + 2] >> shift];
+      out[x * 4 + 3] = 255;
+    }
+  }
+  av_free(rgb48);
+  return 0;
+}
+
 extern int js_read_async(uint8_t *buffer, int offset_low, int offset_high,
                          int size);
 extern int64_t js_seek_async(int offset_low, int offset_high, int whence);
@@ -125,6 +336,60 @@ static enum AVPixelFormat get_format(AVCodecContext *s, const enum AVPixelFormat
     return AV_PIX_FMT_NONE;
 }
 
+// ---- Header-only open ------------------------------------------------------
+// The preview pipeline configures its WebCodecs decoder from the playback
+// context's already-probed track (codec string, extradata, size, profile), so
+// a second avformat_find_stream_info here only buys the software fallback
+// decoder what the header gave it anyway — at the price of up to probesize of
+// extra reads before the first preview. MP4/MOV and Matroska carry the codec
+// configuration (avcC/hvcC/av1C, CodecPrivate) and dimensions in the header;
+// other containers (MPEG-TS, raw streams) still probe.
+EMSCRIPTEN_KEEPALIVE
+void movi_thumbnail_set_header_only(struct MoviThumbnailContext *ctx,
+                                    int enable) {
+  if (ctx)
+    ctx->header_only = enable != 0;
+}
+
+static int thumbnail_header_complete(const AVFormatContext *fmt_ctx) {
+  const char *name = fmt_ctx->iformat ? fmt_ctx->iformat->name : "";
+  if (!strstr(name, "mov") && !strstr(name, "matroska"))
+    return 0;
+  for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+    const AVCodecParameters *par = fmt_ctx->streams[i]->codecpar;
+    if (par->codec_type != AVMEDIA_TYPE_VIDEO)
+      continue;
+    // The first video stream is the one movi_thumbnail_open picks
+    if (par->codec_id == AV_CODEC_ID_NONE || par->width <= 0 ||
+        par->height <= 0)
+      return 0;
+    // Length-prefixed H.264/HEVC can't be decoded without the parameter sets
+    if ((par->codec_id == AV_CODEC_ID_H264 ||
+         par->codec_id == AV_CODEC_ID_HEVC) &&
+        par->extradata_size <= 0)
+      return 0;
+    return 1;
+  }
+  return 0;
+}
+
+// Hand the context a stream descriptor exported by the playback context
+// (movi_probe_export). Before movi_thumbnail_open; when the header matches it,
+// the open skips the probe for every container, not just MP4/Matroska.
+EMSCRIPTEN_KEEPALIVE
+int movi_thumbnail_import_probe(struct MoviThumbnailContext *ctx,
+                                const uint8_t *blob, int size) {
+  if (!ctx || ctx->fmt_ctx || !blob || size <= 0)
+    return -1;
+  av_freep(&ctx->probe_blob);
+  ctx->probe_blob = av_malloc(size);
+  if (!ctx->probe_blob)
+    return AVERROR(ENOMEM);
+  memcpy(ctx->probe_blob, blob, size);
+  ctx->probe_size = size;
+  return 0;
+}
+
 EMSCRIPTEN_KEEPALIVE
 int movi_thumbnail_open(struct MoviThumbnailContext *ctx) {
   if (!ctx || !ctx->pkt)
@@ -154,8 +419,17 @@ int movi_thumbnail_open(struct MoviThumbnailContext *ctx) {
 
   if (avformat_open_input(&ctx->fmt_ctx, NULL, NULL, NULL) < 0)
     return -5;
-  if (avformat_find_stream_info(ctx->fmt_ctx, NULL) < 0)
+  int from_probe = ctx->probe_blob &&
+                   movi_probe_apply(ctx->fmt_ctx, ctx->file_size,
+                                    ctx->probe_blob, ctx->probe_size) == 0;
+  av_freep(&ctx->probe_blob);
+  if (from_probe) {
+    av_log(NULL, AV_LOG_DEBUG, "[THUMB] Stream descriptor matched, skipping probe\n");
+  } else if (ctx->header_only && thumbnail_header_complete(ctx->fmt_ctx)) {
+    av_log(NULL, AV_LOG_DEBUG, "[THUMB] Header-only open, skipping probe\n");
+  } else if (avformat_find_stream_info(ctx->fmt_ctx, NULL) < 0) {
     return -6;
+  }
 
   for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
     if (ctx->fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
@@ -198,7 +472,11 @@ int movi_thumbnail_open(struct MoviThumbnailContext *ctx) {
               // (Though they shouldn't be present in WASM build anyway)
               ctx->dec_ctx->get_format = get_format; // Register helper
 
-              if (avcodec_open2(ctx->dec_ctx, codec, NULL) < 0) {
+              AVDictionary *dec_opts = NULL;
+              thumbnail_apply_fast_decode(ctx, codec, &dec_opts);
+              int open_ret = avcodec_open2(ctx->dec_ctx, codec, &dec_opts);
+              av_dict_free(&dec_opts);
+              if (open_ret < 0) {
                    av_log(NULL, AV_LOG_ERROR, "[THUMB] Failed to open software decoder: %s\n", codec->name);
                    avcodec_free_context(&ctx->dec_ctx);
               } else {
@@ -227,35 +505,12 @@ int movi_thumbnail_open(struct MoviThumbnailContext *ctx) {
 }
 
 /**
- * Seek and read keyframe - uses callback pattern
- * Reads frames until we get close to target timestamp
+ * Seek to the keyframe at-or-before timestamp (seconds). target_ts is the
+ * same target in the video stream's time base, used for the fallback.
+ * Shared by readKeyframe and the storyboard sweep.
  */
-EMSCRIPTEN_KEEPALIVE
-void movi_thumbnail_read_keyframe(struct MoviThumbnailContext *ctx,
-                                  double timestamp) {
-  av_log(NULL, AV_LOG_DEBUG, "[THUMB] readKeyframe called: ts=%.2f\n", timestamp);
-
-  if (!ctx || !ctx->fmt_ctx || !ctx->pkt) {
-    av_log(NULL, AV_LOG_ERROR, "[THUMB] ERROR: null context\n");
-    js_thumbnail_packet_ready(-1, 0.0);
-    return;
-  }
-  if (ctx->video_stream_index < 0) {
-    av_log(NULL, AV_LOG_ERROR, "[THUMB] ERROR: video_stream_index=%d\n",
-            ctx->video_stream_index);
-    js_thumbnail_packet_ready(-2, 0.0);
-    return;
-  }
-
-  AVStream *st = ctx->fmt_ctx->streams[ctx->video_stream_index];
-  int64_t target_ts = (int64_t)(timestamp * (double)st->time_base.den /
-                                (double)st->time_base.num);
-  
-  // Adjust for stream start time (MPEG-TS, etc.)
-  if (st->start_time != AV_NOPTS_VALUE) {
-      target_ts += st->start_time;
-  }
-
+static int thumbnail_seek(struct MoviThumbnailContext *ctx, double timestamp,
+                          int64_t target_ts) {
   int64_t seek_target = (int64_t)(timestamp * AV_TIME_BASE);
   // Adjust avformat_seek_file target for start_time
   if (ctx->fmt_ctx->start_time != AV_NOPTS_VALUE) {
@@ -280,11 +535,8 @@ void movi_thumbnail_read_keyframe(struct MoviThumbnailContext *ctx,
                         AVSEEK_FLAG_BACKWARD);
   }
 
-  if (ret < 0) {
-    av_log(NULL, AV_LOG_ERROR, "[THUMB] ERROR: seek failed\n");
-    js_thumbnail_packet_ready(-3, 0.0);
-    return;
-  }
+  if (ret < 0)
+    return ret;
 
   // Flush after seek to clear internal buffers
   if (ctx->avio_ctx) {
@@ -296,6 +548,67 @@ void movi_thumbnail_read_keyframe(struct MoviThumbnailContext *ctx,
       int64_t current_pos = avio_tell(ctx->fmt_ctx->pb);
       ctx->position = current_pos;
   }
+  return 0;
+}
+
+// Forget the scrub cursor's keyframe (anything that moves the demuxer or
+// overwrites ctx->pkt must call this)
+static void thumbnail_scrub_reset(struct MoviThumbnailContext *ctx) {
+  ctx->scrub_has_key = 0;
+  ctx->scrub_next_ts = AV_NOPTS_VALUE;
+  if (ctx->scrub_has_next)
+    av_packet_unref(ctx->scrub_next);
+  ctx->scrub_has_next = 0;
+}
+
+// Leave scrub mode and demux every stream again
+static void thumbnail_scrub_stop(struct MoviThumbnailContext *ctx) {
+  if (!ctx->scrub_active)
+    return;
+  thumbnail_scrub_reset(ctx);
+  ctx->scrub_active = 0;
+  for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++)
+    ctx->fmt_ctx->streams[i]->discard = AVDISCARD_DEFAULT;
+}
+
+/**
+ * Seek and read keyframe - uses callback pattern
+ * Reads frames until we get close to target timestamp
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_thumbnail_read_keyframe(struct MoviThumbnailContext *ctx,
+                                  double timestamp) {
+  av_log(NULL, AV_LOG_DEBUG, "[THUMB] readKeyframe called: ts=%.2f\n", timestamp);
+
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt) {
+    av_log(NULL, AV_LOG_ERROR, "[THUMB] ERROR: null context\n");
+    js_thumbnail_packet_ready(-1, 0.0);
+    return;
+  }
+  if (ctx->video_stream_index < 0) {
+    av_log(NULL, AV_LOG_ERROR, "[THUMB] ERROR: video_stream_index=%d\n",
+            ctx->video_stream_index);
+    js_thumbnail_packet_ready(-2, 0.0);
+    return;
+  }
+
+  // The seek below moves the demuxer out from under the scrub cursor
+  thumbnail_scrub_reset(ctx);
+
+  AVStream *st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+  int64_t target_ts = (int64_t)(timestamp * (double)st->time_base.den /
+                                (double)st->time_base.num);
+  
+  // Adjust for stream start time (MPEG-TS, etc.)
+  if (st->start_time != AV_NOPTS_VALUE) {
+      target_ts += st->start_time;
+  }
+
+  if (thumbnail_seek(ctx, timestamp, target_ts) < 0) {
+    av_log(NULL, AV_LOG_ERROR, "[THUMB] ERROR: seek failed\n");
+    js_thumbnail_packet_ready(-3, 0.0);
+    return;
+  }
 
   av_log(NULL, AV_LOG_DEBUG,
           "[THUMB] Seek OK, reading packets to find closest keyframe...\n");
@@ -465,6 +778,19 @@ int movi_thumbnail_get_extradata(struct MoviThumbnailContext *ctx, uint8_t *buff
   return copy_size;
 }
 
+/**
+ * Load a seek index exported by movi_index_export (see movi_index.c) so
+ * keyframe seeks jump straight to the indexed offset instead of bisecting.
+ * Returns the entry count, negative if the index doesn't match this file.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_thumbnail_import_index(struct MoviThumbnailContext *ctx,
+                                const uint8_t *blob, int size) {
+  if (!ctx || !ctx->fmt_ctx)
+    return -1;
+  return movi_index_apply(ctx->fmt_ctx, ctx->file_size, blob, size);
+}
+
 /**
  * Decode frame and keep in YUV format (preserves HDR)
  * Returns 0 on success, negative on error
@@ -577,27 +903,353 @@ uint8_t *movi_thumbnail_decode_frame(struct MoviThumbnailContext *ctx, int width
          return NULL;
     }
 
-    // SwsContext
-    ctx->sws_ctx = sws_getCachedContext(ctx->sws_ctx,
-        ctx->frame->width, ctx->frame->height, ctx->frame->format,
-        width, height, AV_PIX_FMT_RGBA,
-        SWS_BILINEAR, NULL, NULL, NULL);
-
-    if (!ctx->sws_ctx) {
+    // Scale straight from the decoder's output (reduced with lowres in fast
+    // mode). No tone-map: ThumbnailRenderer handles PQ itself.
+    if (thumbnail_frame_to_rgba(ctx, &ctx->sws_ctx, ctx->frame, ctx->rgb_buffer,
+                                width * 4, width, height, 0) < 0) {
         av_log(NULL, AV_LOG_ERROR, "[THUMB] Failed to create SwsContext for format %d, size %dx%d\n", 
            ctx->frame->format, ctx->frame->width, ctx->frame->height);
         return NULL;
     }
 
-    // Setup wrapper frame for buffer
-    av_image_fill_arrays(ctx->rgb_frame->data, ctx->rgb_frame->linesize,
-                         ctx->rgb_buffer, AV_PIX_FMT_RGBA, width, height, 1);
+    return ctx->rgb_buffer;
+}
+
+/**
+ * Storyboard: decode keyframes for many timestamps in one sorted sweep.
+ *
+ * Seekbar previews via readKeyframe pay a seek, a full decoder flush and a
+ * JS round trip per tile. For a storyboard the targets are known up front, so
+ * JS sorts them (timestamp order is file order) and feeds them here in turn:
+ *  - the video stream is demuxed at AVDISCARD_NONKEY and every other stream
+ *    discarded, and the decoder skips non-keyframes;
+ *  - a target within MOVI_STORYBOARD_SWEEP_SEC of the previous keyframe is
+ *    reached by reading forward, not seeking; the first keyframe past it is
+ *    held for the next target;
+ *  - targets that share a GOP reuse the already-decoded keyframe;
+ *  - each tile is scaled straight to its final size into the tile buffer.
+ * Several contexts (one per isolated WASM instance) can sweep disjoint slices
+ * of the timeline in parallel; JS composites the tiles into the sprite sheet.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_thumbnail_storyboard_begin(struct MoviThumbnailContext *ctx,
+                                    int tile_width, int tile_height,
+                                    int max_tiles) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->dec_ctx || ctx->video_stream_index < 0)
+    return -1;
+  if (tile_width <= 0 || tile_height <= 0 || max_tiles <= 0)
+    return -2;
 
-    sws_scale(ctx->sws_ctx, (const uint8_t *const *)ctx->frame->data,
-              ctx->frame->linesize, 0, ctx->frame->height,
-              ctx->rgb_frame->data, ctx->rgb_frame->linesize);
+  av_freep(&ctx->sb_tiles);
+  av_freep(&ctx->sb_pts);
+  size_t tile_bytes = (size_t)tile_width * tile_height * 4;
+  ctx->sb_tiles = av_mallocz(tile_bytes * max_tiles);
+  ctx->sb_pts = av_calloc(max_tiles, sizeof(double));
+  if (!ctx->sb_next)
+    ctx->sb_next = av_packet_alloc();
+  if (!ctx->sb_tiles || !ctx->sb_pts || !ctx->sb_next) {
+    av_freep(&ctx->sb_tiles);
+    av_freep(&ctx->sb_pts);
+    return AVERROR(ENOMEM);
+  }
+  ctx->sb_tile_w = tile_width;
+  ctx->sb_tile_h = tile_height;
+  ctx->sb_max_tiles = max_tiles;
+  ctx->sb_has_next = 0;
+  ctx->sb_has_cur = 0;
+  thumbnail_scrub_stop(ctx);
 
-    return ctx->rgb_buffer;
+  for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+    ctx->fmt_ctx->streams[i]->discard =
+        (int)i == ctx->video_stream_index ? AVDISCARD_NONKEY : AVDISCARD_ALL;
+  }
+  ctx->dec_ctx->skip_frame = AVDISCARD_NONKEY;
+  return 0;
+}
+
+// Next video keyframe from the demuxer into out (0), or < 0 at EOF/error.
+static int storyboard_read_keyframe(struct MoviThumbnailContext *ctx,
+                                    AVPacket *out) {
+  for (int n = 0; n < 2000; n++) {
+    int ret = av_read_frame(ctx->fmt_ctx, out);
+    if (ret < 0)
+      return ret;
+    if (out->stream_index == ctx->video_stream_index &&
+        (out->flags & AV_PKT_FLAG_KEY) && out->size > 0)
+      return 0;
+    av_packet_unref(out);
+  }
+  return AVERROR_INVALIDDATA;
+}
+
+static int64_t storyboard_pkt_ts(const AVPacket *pkt) {
+  return pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+}
+
+/**
+ * Decode the keyframe for `timestamp` (seconds) into tile `slot`. Call with
+ * ascending timestamps for the sweep to pay off (any order still works, at
+ * the cost of a seek). Returns 0 on success; the keyframe's pts is then
+ * available from movi_thumbnail_storyboard_pts.
+ */
+EMSCRIPTEN_KEEPALIVE
+int movi_thumbnail_storyboard_add(struct MoviThumbnailContext *ctx, int slot,
+                                  double timestamp) {
+  if (!ctx || !ctx->sb_tiles || !ctx->pkt || slot < 0 ||
+      slot >= ctx->sb_max_tiles)
+    return -1;
+
+  AVStream *st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+  int64_t target_ts = (int64_t)(timestamp * (double)st->time_base.den /
+                                (double)st->time_base.num);
+  if (st->start_time != AV_NOPTS_VALUE)
+    target_ts += st->start_time;
+
+  int have_pkt = 0;
+  int sweep = ctx->sb_has_cur && target_ts >= ctx->sb_cur_ts &&
+              (target_ts - ctx->sb_cur_ts) * av_q2d(st->time_base) <=
+                  MOVI_STORYBOARD_SWEEP_SEC;
+  if (sweep) {
+    AVPacket *tmp = av_packet_alloc();
+    if (!tmp)
+      return AVERROR(ENOMEM);
+    for (;;) {
+      if (ctx->sb_has_next) {
+        av_packet_move_ref(tmp, ctx->sb_next);
+        ctx->sb_has_next = 0;
+      } else if (storyboard_read_keyframe(ctx, tmp) < 0) {
+        break; // EOF: the last keyframe read (or the current one) is closest
+      }
+      if (storyboard_pkt_ts(tmp) > target_ts) {
+        av_packet_move_ref(ctx->sb_next, tmp);
+        ctx->sb_has_next = 1;
+        break;
+      }
+      av_packet_unref(ctx->pkt);
+      av_packet_move_ref(ctx->pkt, tmp);
+      have_pkt = 1;
+    }
+    av_packet_free(&tmp);
+    // No keyframe at-or-before the target since the current one: same GOP,
+    // the decoded frame is already the right tile.
+  } else {
+    if (ctx->sb_has_next) {
+      av_packet_unref(ctx->sb_next);
+      ctx->sb_has_next = 0;
+    }
+    ctx->sb_has_cur = 0;
+    if (thumbnail_seek(ctx, timestamp, target_ts) < 0)
+      return -3;
+    av_packet_unref(ctx->pkt);
+    if (storyboard_read_keyframe(ctx, ctx->pkt) < 0)
+      return -6;
+    have_pkt = 1;
+  }
+
+  if (have_pkt) {
+    avcodec_flush_buffers(ctx->dec_ctx);
+    int ret = avcodec_send_packet(ctx->dec_ctx, ctx->pkt);
+    if (ret >= 0) {
+      ret = avcodec_receive_frame(ctx->dec_ctx, ctx->frame);
+      if (ret == AVERROR(EAGAIN)) {
+        avcodec_send_packet(ctx->dec_ctx, NULL);
+        ret = avcodec_receive_frame(ctx->dec_ctx, ctx->frame);
+      }
+    }
+    if (ret < 0) {
+      ctx->sb_has_cur = 0;
+      av_log(NULL, AV_LOG_ERROR, "[THUMB] Storyboard decode error: %d\n", ret);
+      return ret;
+    }
+    ctx->sb_has_cur = 1;
+    ctx->sb_cur_ts = storyboard_pkt_ts(ctx->pkt);
+  }
+  if (!ctx->sb_has_cur)
+    return -6;
+
+  // Tiles go straight into a JPEG sprite sheet, so HDR is tone-mapped here
+  uint8_t *tile = ctx->sb_tiles + (size_t)slot * ctx->sb_tile_w * ctx->sb_tile_h * 4;
+  if (thumbnail_frame_to_rgba(ctx, &ctx->sb_sws, ctx->frame, tile,
+                              ctx->sb_tile_w * 4, ctx->sb_tile_w,
+                              ctx->sb_tile_h, 1) < 0)
+    return -8;
+
+  ctx->sb_pts[slot] = ctx->sb_cur_ts * av_q2d(st->time_base);
+  return 0;
+}
+
+EMSCRIPTEN_KEEPALIVE
+uint8_t *movi_thumbnail_storyboard_tiles(struct MoviThumbnailContext *ctx) {
+  return ctx ? ctx->sb_tiles : NULL;
+}
+
+EMSCRIPTEN_KEEPALIVE
+double movi_thumbnail_storyboard_pts(struct MoviThumbnailContext *ctx, int slot) {
+  if (!ctx || !ctx->sb_pts || slot < 0 || slot >= ctx->sb_max_tiles)
+    return -1.0;
+  return ctx->sb_pts[slot];
+}
+
+/**
+ * Release the tile buffer and restore normal demux/decode so the context can
+ * serve readKeyframe again.
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_thumbnail_storyboard_end(struct MoviThumbnailContext *ctx) {
+  if (!ctx)
+    return;
+  av_freep(&ctx->sb_tiles);
+  av_freep(&ctx->sb_pts);
+  ctx->sb_max_tiles = 0;
+  ctx->sb_has_cur = 0;
+  if (ctx->sb_next) {
+    av_packet_unref(ctx->sb_next);
+    ctx->sb_has_next = 0;
+  }
+  if (ctx->fmt_ctx) {
+    for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++)
+      ctx->fmt_ctx->streams[i]->discard = AVDISCARD_DEFAULT;
+  }
+  if (ctx->dec_ctx)
+    ctx->dec_ctx->skip_frame = AVDISCARD_DEFAULT;
+}
+
+// ---- Scrub cursor -----------------------------------------------------------
+// A seek-bar drag asks for a keyframe every few tens of milliseconds, mostly a
+// few seconds from the previous one, and readKeyframe pays a seek and a fresh
+// read for each. The scrub cursor keeps its place in the file instead:
+//  - a target inside the GOP of the keyframe it holds returns that packet
+//    again with no I/O (the next keyframe's time comes from the stream index,
+//    or from the packet read past it);
+//  - a target up to MOVI_STORYBOARD_SWEEP_SEC after it reads forward through
+//    keyframes, like the storyboard sweep, holding the one it overshoots;
+//  - anything else seeks.
+// Only the video stream's keyframes are demuxed while the cursor is active.
+// The packet is reported through js_thumbnail_packet_ready like readKeyframe,
+// and movi_thumbnail_scrub_next_pts bounds the keyframe's GOP, so JS knows for
+// which seek targets the decoded picture can stand in on release.
+
+// Next keyframe after ts in the stream's index, or AV_NOPTS_VALUE. MP4 index
+// entries are DTS, a little before the PTS; the GOP just ends a bit early.
+static int64_t thumbnail_index_next_key(AVStream *st, int64_t ts) {
+  int i = av_index_search_timestamp(st, ts + 1, 0);
+  if (i < 0)
+    return AV_NOPTS_VALUE;
+  const AVIndexEntry *e = avformat_index_get_entry(st, i);
+  return e && e->timestamp > ts ? e->timestamp : AV_NOPTS_VALUE;
+}
+
+/**
+ * Keyframe at-or-before timestamp (seconds) through the scrub cursor. Same
+ * callback contract as movi_thumbnail_read_keyframe.
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_thumbnail_scrub_keyframe(struct MoviThumbnailContext *ctx,
+                                   double timestamp) {
+  if (!ctx || !ctx->fmt_ctx || !ctx->pkt) {
+    js_thumbnail_packet_ready(-1, 0.0);
+    return;
+  }
+  if (ctx->video_stream_index < 0) {
+    js_thumbnail_packet_ready(-2, 0.0);
+    return;
+  }
+  if (!ctx->scrub_next && !(ctx->scrub_next = av_packet_alloc())) {
+    js_thumbnail_packet_ready(-4, 0.0);
+    return;
+  }
+  if (!ctx->scrub_active) {
+    for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+      ctx->fmt_ctx->streams[i]->discard =
+          (int)i == ctx->video_stream_index ? AVDISCARD_NONKEY : AVDISCARD_ALL;
+    }
+    thumbnail_scrub_reset(ctx);
+    ctx->scrub_active = 1;
+  }
+
+  AVStream *st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+  int64_t target_ts = (int64_t)(timestamp * (double)st->time_base.den /
+                                (double)st->time_base.num);
+  if (st->start_time != AV_NOPTS_VALUE)
+    target_ts += st->start_time;
+
+  int ahead = ctx->scrub_has_key && target_ts >= ctx->scrub_key_ts;
+  if (ahead && ctx->scrub_next_ts != AV_NOPTS_VALUE &&
+      target_ts < ctx->scrub_next_ts) {
+    // Same GOP: the held keyframe is still the answer
+  } else if (ahead && (target_ts - ctx->scrub_key_ts) * av_q2d(st->time_base) <=
+                          MOVI_STORYBOARD_SWEEP_SEC) {
+    AVPacket *tmp = av_packet_alloc();
+    if (!tmp) {
+      js_thumbnail_packet_ready(-4, 0.0);
+      return;
+    }
+    for (;;) {
+      if (ctx->scrub_has_next) {
+        av_packet_move_ref(tmp, ctx->scrub_next);
+        ctx->scrub_has_next = 0;
+      } else if (storyboard_read_keyframe(ctx, tmp) < 0) {
+        ctx->scrub_next_ts = INT64_MAX; // EOF: the held keyframe is the last
+        break;
+      }
+      int64_t ts = storyboard_pkt_ts(tmp);
+      if (ts > target_ts) {
+        av_packet_move_ref(ctx->scrub_next, tmp);
+        ctx->scrub_has_next = 1;
+        ctx->scrub_next_ts = ts;
+        break;
+      }
+      av_packet_unref(ctx->pkt);
+      av_packet_move_ref(ctx->pkt, tmp);
+      ctx->scrub_key_ts = ts;
+    }
+    av_packet_free(&tmp);
+  } else {
+    thumbnail_scrub_reset(ctx);
+    if (thumbnail_seek(ctx, timestamp, target_ts) < 0) {
+      js_thumbnail_packet_ready(-3, 0.0);
+      return;
+    }
+    av_packet_unref(ctx->pkt);
+    if (storyboard_read_keyframe(ctx, ctx->pkt) < 0) {
+      js_thumbnail_packet_ready(-6, 0.0);
+      return;
+    }
+    ctx->scrub_has_key = 1;
+    ctx->scrub_key_ts = storyboard_pkt_ts(ctx->pkt);
+    ctx->scrub_next_ts = thumbnail_index_next_key(st, ctx->scrub_key_ts);
+  }
+
+  if (ctx->scrub_key_ts == AV_NOPTS_VALUE)
+    ctx->scrub_has_key = 0; // untimed packet: usable once, never reused
+  double pts =
+      ctx->scrub_has_key ? ctx->scrub_key_ts * av_q2d(st->time_base) : 0.0;
+  ctx->last_packet_size = ctx->pkt->size;
+  ctx->last_packet_pts = pts;
+  js_thumbnail_packet_ready(ctx->pkt->size, pts);
+}
+
+/**
+ * End of the held keyframe's GOP in seconds (stream time, like the packet
+ * pts): the next keyframe, +inf after the last one, -1 when not known.
+ */
+EMSCRIPTEN_KEEPALIVE
+double movi_thumbnail_scrub_next_pts(struct MoviThumbnailContext *ctx) {
+  if (!ctx || !ctx->scrub_has_key || ctx->scrub_next_ts == AV_NOPTS_VALUE)
+    return -1.0;
+  if (ctx->scrub_next_ts == INT64_MAX)
+    return INFINITY;
+  AVStream *st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+  return ctx->scrub_next_ts * av_q2d(st->time_base);
+}
+
+/**
+ * Leave scrub mode: drop the held packets and demux every stream again.
+ */
+EMSCRIPTEN_KEEPALIVE
+void movi_thumbnail_scrub_end(struct MoviThumbnailContext *ctx) {
+  if (ctx && ctx->fmt_ctx)
+    thumbnail_scrub_stop(ctx);
 }
 
 /**
@@ -626,6 +1278,12 @@ void movi_thumbnail_destroy(struct MoviThumbnailContext *ctx) {
   if (ctx->rgb_frame) av_frame_free(&ctx->rgb_frame);
   if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
   if (ctx->rgb_buffer) av_free(ctx->rgb_buffer);
+  if (ctx->sb_sws) sws_freeContext(ctx->sb_sws);
+  av_freep(&ctx->sb_tiles);
+  av_freep(&ctx->sb_pts);
+  if (ctx->sb_next) av_packet_free(&ctx->sb_next);
+  if (ctx->scrub_next) av_packet_free(&ctx->scrub_next);
+  av_freep(&ctx->probe_blob);
 
   if (ctx->pkt)
     av_packet_free(&ctx->pkt);
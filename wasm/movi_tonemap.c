@@ -0,0 +1,495 @@
+#include "movi.h"
+#include <libavutil/mastering_display_metadata.h>
+#include <math.h>
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#endif
+
+// 10/12-bit YUV → 8-bit RGBA for movi_get_frame_rgba.
+//
+// sws_scale drops the low bits and applies a BT.601 matrix to everything, so
+// 10-bit BT.2020/709 content comes out with shifted hues and banding, and at
+// ~100ms a 4K frame on one core it can't keep up anyway. This converts planar
+// 4:2:0/4:2:2/4:4:4 at native size, or at exactly half size
+// (SoftwareVideoDecoder caps the RGBA fallback at 1920 wide), using the matrix
+// and range the frame is tagged with and rounding to 8 bits.
+//
+// By default PQ/HLG frames keep their transfer and BT.2020 primaries: the
+// renderer tags the canvas rec2100-pq/hlg or decodes PQ in its shader. With
+// movi_set_hdr_tonemap(ctx, 1) they're tone-mapped to SDR BT.709 instead, for
+// consumers that display RGBA as sRGB:
+//
+//   - a per-transfer EOTF table into linear light where 1.0 is SDR reference
+//     white (203 nits, BT.2408), plus the HLG OOTF for a 1000 nit display,
+//   - BT.2020 → BT.709 primaries,
+//   - a max-RGB rolloff from the content's peak (MaxCLL / mastering
+//     metadata) down to SDR white,
+//   - an sRGB encode table back to 8 bits.
+//
+// Tables are rebuilt only when the frame's transfer/matrix/range/peak change.
+// Pixel math is written with vector extensions so -msimd128 maps it onto
+// SIMD128 four pixels at a time (the table lookups stay per-lane); without
+// -msimd128 the same code is lowered to scalar. In the pthreads build rows are
+// split into bands shared with a few helper threads.
+
+#define TM_LUT_BITS 12
+#define TM_LUT_SIZE (1 << TM_LUT_BITS)
+#define TM_LUT_MAX ((float)(TM_LUT_SIZE - 1))
+// Linear → sRGB is steepest near black (12.92x); 16K entries keep every step
+// under a quarter of an 8-bit code
+#define TM_OUT_SIZE (1 << 14)
+#define TM_OUT_MAX ((float)(TM_OUT_SIZE - 1))
+
+#define TM_REF_WHITE 203.0f // nits mapped to SDR white
+#define TM_HLG_PEAK 1000.0f // nominal HLG display
+#define TM_KNEE 0.5f        // linear below this, rolled off above
+
+enum { TM_CURVE_SDR, TM_CURVE_PQ, TM_CURVE_HLG };
+
+typedef float f32x4 __attribute__((vector_size(16)));
+typedef int32_t i32x4 __attribute__((vector_size(16)));
+
+struct MoviToneMap {
+  // Cache key
+  int trc, colorspace, range, depth, to_sdr;
+  float peak_nits;
+
+  int curve;
+  int gamut; // BT.2020 primaries → BT.709
+  float inv_span2; // tone curve: 1 / s^2, s = peak above the knee
+  float y_off, y_scale, c_off, c_scale;
+  float rv, gu, gv, bu; // R = Y + rv*V, G = Y - gu*U - gv*V, B = Y + bu*U
+
+  float eotf[TM_LUT_SIZE];   // signal → linear (HLG: scene linear)
+  float ootf[TM_LUT_SIZE];   // HLG gain by scene luminance
+  uint8_t oetf[TM_OUT_SIZE]; // linear → sRGB
+};
+
+typedef struct {
+  const MoviToneMap *tm;
+  const AVFrame *src;
+  uint8_t *dst;
+  int dst_linesize;
+  int width;
+  int height;
+  int chroma_w; // log2 chroma subsampling
+  int chroma_h;
+  int half;     // 2x2 box-downscale luma
+} MoviToneJob;
+
+static float tm_pq_eotf(float e) {
+  const float m1 = 2610.0f / 16384.0f, m2 = 2523.0f / 4096.0f * 128.0f;
+  const float c1 = 3424.0f / 4096.0f, c2 = 2413.0f / 4096.0f * 32.0f;
+  const float c3 = 2392.0f / 4096.0f * 32.0f;
+  float p = powf(e, 1.0f / m2);
+  float num = p - c1 > 0.0f ? p - c1 : 0.0f;
+  return powf(num / (c2 - c3 * p), 1.0f / m1) * 10000.0f / TM_REF_WHITE;
+}
+
+static float tm_hlg_inverse_oetf(float e) {
+  const float a = 0.17883277f, b = 0.28466892f, c = 0.55991073f;
+  return e <= 0.5f ? e * e / 3.0f : (expf((e - c) / a) + b) / 12.0f;
+}
+
+static float tm_srgb_oetf(float v) {
+  return v <= 0.0031308f ? 12.92f * v : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+}
+
+// Content peak in nits from the frame's HDR side data, or the usual 1000 nit
+// mastering default when there is none.
+static float tm_peak_nits(const AVFrame *src, int curve) {
+  if (curve == TM_CURVE_HLG)
+    return TM_HLG_PEAK;
+  float peak = 0.0f;
+  AVFrameSideData *sd =
+      av_frame_get_side_data(src, AV_FRAME_DATA_CONTENT_LIGHT_LEVEL);
+  if (sd)
+    peak = (float)((const AVContentLightMetadata *)sd->data)->MaxCLL;
+  sd = av_frame_get_side_data(src, AV_FRAME_DATA_MASTERING_DISPLAY_METADATA);
+  if (peak <= 0.0f && sd) {
+    const AVMasteringDisplayMetadata *md =
+        (const AVMasteringDisplayMetadata *)sd->data;
+    if (md->has_luminance)
+      peak = (float)av_q2d(md->max_luminance);
+  }
+  if (peak <= 0.0f)
+    peak = 1000.0f;
+  // Below ~1.5x SDR white there is nothing to roll off
+  if (peak < TM_REF_WHITE * 1.5f)
+    peak = TM_REF_WHITE * 1.5f;
+  return peak > 10000.0f ? 10000.0f : peak;
+}
+
+static void tm_setup(MoviToneMap *tm, const AVFrame *src, int depth,
+                     int to_sdr) {
+  int trc = src->color_trc;
+  int hdr = trc == AVCOL_TRC_SMPTE2084      ? TM_CURVE_PQ
+            : trc == AVCOL_TRC_ARIB_STD_B67 ? TM_CURVE_HLG
+                                            : TM_CURVE_SDR;
+  // Signal-domain output is the SDR path: matrix and range only
+  int curve = to_sdr ? hdr : TM_CURVE_SDR;
+  int cs = src->colorspace;
+  if (cs == AVCOL_SPC_UNSPECIFIED || cs == AVCOL_SPC_RESERVED) {
+    // Same guess players make for untagged content
+    cs = hdr != TM_CURVE_SDR || src->color_primaries == AVCOL_PRI_BT2020
+             ? AVCOL_SPC_BT2020_NCL
+         : src->height > 576 ? AVCOL_SPC_BT709
+                             : AVCOL_SPC_SMPTE170M;
+  }
+  int range = src->color_range == AVCOL_RANGE_JPEG ? AVCOL_RANGE_JPEG
+                                                   : AVCOL_RANGE_MPEG;
+  float peak_nits = tm_peak_nits(src, curve);
+
+  if (tm->depth == depth && tm->trc == trc && tm->colorspace == cs &&
+      tm->range == range && tm->to_sdr == to_sdr && tm->peak_nits == peak_nits)
+    return;
+  tm->to_sdr = to_sdr;
+  tm->trc = trc;
+  tm->colorspace = cs;
+  tm->range = range;
+  tm->depth = depth;
+  tm->peak_nits = peak_nits;
+  tm->curve = curve;
+  float span = (peak_nits / TM_REF_WHITE - TM_KNEE) / (1.0f - TM_KNEE);
+  tm->inv_span2 = 1.0f / (span * span);
+  tm->gamut = curve != TM_CURVE_SDR && src->color_primaries != AVCOL_PRI_BT709;
+
+  float kr, kb;
+  switch (cs) {
+  case AVCOL_SPC_BT2020_NCL:
+  case AVCOL_SPC_BT2020_CL:
+    kr = 0.2627f, kb = 0.0593f;
+    break;
+  case AVCOL_SPC_BT709:
+    kr = 0.2126f, kb = 0.0722f;
+    break;
+  default:
+    kr = 0.299f, kb = 0.114f;
+    break;
+  }
+  float kg = 1.0f - kr - kb;
+  tm->rv = 2.0f * (1.0f - kr);
+  tm->bu = 2.0f * (1.0f - kb);
+  tm->gu = tm->bu * kb / kg;
+  tm->gv = tm->rv * kr / kg;
+
+  float scale = (float)(1 << (depth - 8));
+  if (range == AVCOL_RANGE_JPEG) {
+    float max = (float)((1 << depth) - 1);
+    tm->y_off = 0.0f;
+    tm->y_scale = 1.0f / max;
+    tm->c_off = (float)(1 << (depth - 1));
+    tm->c_scale = 1.0f / max;
+  } else {
+    tm->y_off = 16.0f * scale;
+    tm->y_scale = 1.0f / (219.0f * scale);
+    tm->c_off = 128.0f * scale;
+    tm->c_scale = 1.0f / (224.0f * scale);
+  }
+
+  if (curve == TM_CURVE_SDR)
+    return;
+  for (int i = 0; i < TM_LUT_SIZE; i++) {
+    float e = (float)i / TM_LUT_MAX;
+    tm->eotf[i] =
+        curve == TM_CURVE_PQ ? tm_pq_eotf(e) : tm_hlg_inverse_oetf(e);
+    // System gamma 1.2 at 1000 nits (BT.2100): Fd = Lw * Ys^0.2 * E
+    tm->ootf[i] = TM_HLG_PEAK / TM_REF_WHITE * powf(e, 0.2f);
+  }
+  for (int i = 0; i < TM_OUT_SIZE; i++) {
+    float s = tm_srgb_oetf((float)i / TM_OUT_MAX) * 255.0f + 0.5f;
+    tm->oetf[i] = (uint8_t)(s > 255.0f ? 255.0f : s);
+  }
+}
+
+
+static inline f32x4 tm_clamp01(f32x4 v) {
+  const f32x4 one = {1.0f, 1.0f, 1.0f, 1.0f};
+  i32x4 lo = v < 0.0f;
+  i32x4 hi = v > 1.0f;
+  return (f32x4)(((i32x4)v & ~(lo | hi)) | ((i32x4)one & hi));
+}
+
+static inline f32x4 tm_max(f32x4 a, f32x4 b) {
+  i32x4 m = a > b;
+  return (f32x4)(((i32x4)a & m) | ((i32x4)b & ~m));
+}
+
+// Nearest table entry for v in [0, 1] (clamped) over `size` entries
+static inline i32x4 tm_index(f32x4 v, float max) {
+  return __builtin_convertvector(tm_clamp01(v) * max + 0.5f, i32x4);
+}
+
+static inline f32x4 tm_lookup(const float *lut, i32x4 i) {
+  return (f32x4){lut[i[0]], lut[i[1]], lut[i[2]], lut[i[3]]};
+}
+
+static inline i32x4 tm_lookup_u8(const uint8_t *lut, i32x4 i) {
+  return (i32x4){lut[i[0]], lut[i[1]], lut[i[2]], lut[i[3]]};
+}
+
+// Four pixels of Y'CbCr code values → RGBA words (little-endian R,G,B,A)
+static inline i32x4 tm_pixels4(const MoviToneMap *tm, i32x4 yc, i32x4 uc,
+                               i32x4 vc) {
+  f32x4 y = (__builtin_convertvector(yc, f32x4) - tm->y_off) * tm->y_scale;
+  f32x4 u = (__builtin_convertvector(uc, f32x4) - tm->c_off) * tm->c_scale;
+  f32x4 v = (__builtin_convertvector(vc, f32x4) - tm->c_off) * tm->c_scale;
+  f32x4 r = y + tm->rv * v;
+  f32x4 g = y - tm->gu * u - tm->gv * v;
+  f32x4 b = y + tm->bu * u;
+  i32x4 ri, gi, bi;
+
+  if (tm->curve == TM_CURVE_SDR) {
+    ri = tm_index(r, 255.0f);
+    gi = tm_index(g, 255.0f);
+    bi = tm_index(b, 255.0f);
+  } else {
+    r = tm_lookup(tm->eotf, tm_index(r, TM_LUT_MAX));
+    g = tm_lookup(tm->eotf, tm_index(g, TM_LUT_MAX));
+    b = tm_lookup(tm->eotf, tm_index(b, TM_LUT_MAX));
+    if (tm->curve == TM_CURVE_HLG) {
+      f32x4 ys = 0.2627f * r + 0.6780f * g + 0.0593f * b;
+      f32x4 gain = tm_lookup(tm->ootf, tm_index(ys, TM_LUT_MAX));
+      r *= gain;
+      g *= gain;
+      b *= gain;
+    }
+    if (tm->gamut) {
+      f32x4 r2 = 1.6605f * r - 0.5876f * g - 0.0728f * b;
+      f32x4 g2 = -0.1246f * r + 1.1329f * g - 0.0083f * b;
+      f32x4 b2 = -0.0182f * r - 0.1006f * g + 1.1187f * b;
+      r = r2, g = g2, b = b2;
+    }
+
+    // Extended Reinhard on the part of max(R,G,B) above the knee, reaching
+    // 1.0 exactly at the content peak, with a continuous slope at the knee:
+    //   t = (m - k) / (1 - k),  m' = k + (1 - k) * t (1 + t / s^2) / (1 + t)
+    // folded into one division for the per-pixel gain m'/m.
+    const f32x4 knee = {TM_KNEE, TM_KNEE, TM_KNEE, TM_KNEE};
+    f32x4 m = tm_max(tm_max(r, g), tm_max(b, knee));
+    f32x4 t = (m - TM_KNEE) * (1.0f / (1.0f - TM_KNEE));
+    f32x4 gain = (TM_KNEE * (1.0f + t) +
+                  (1.0f - TM_KNEE) * t * (1.0f + t * tm->inv_span2)) /
+                 ((1.0f + t) * m);
+    r *= gain;
+    g *= gain;
+    b *= gain;
+    ri = tm_lookup_u8(tm->oetf, tm_index(r, TM_OUT_MAX));
+    gi = tm_lookup_u8(tm->oetf, tm_index(g, TM_OUT_MAX));
+    bi = tm_lookup_u8(tm->oetf, tm_index(b, TM_OUT_MAX));
+  }
+  return ri | (gi << 8) | (bi << 16) | (int32_t)0xff000000;
+}
+
+static inline __attribute__((always_inline)) void
+tm_row(const MoviToneJob *job, int row, const int half, const int cw) {
+  const AVFrame *f = job->src;
+  int y0row = row << half;
+  const uint16_t *y0 =
+      (const uint16_t *)(f->data[0] + (ptrdiff_t)y0row * f->linesize[0]);
+  const uint16_t *y1 = (const uint16_t *)((const uint8_t *)y0 + f->linesize[0]);
+  // Nearest chroma, as in the 8-bit SIMD path; at half size 4:2:0 chroma is
+  // already at output resolution
+  ptrdiff_t crow = (ptrdiff_t)(y0row >> job->chroma_h);
+  const uint16_t *u = (const uint16_t *)(f->data[1] + crow * f->linesize[1]);
+  const uint16_t *v = (const uint16_t *)(f->data[2] + crow * f->linesize[2]);
+  uint8_t *out = job->dst + (ptrdiff_t)row * job->dst_linesize;
+
+  const MoviToneMap *tm = job->tm;
+  int width = job->width;
+  for (int x = 0; x < width; x += 4) {
+    // Tail lanes repeat the last pixel and aren't stored
+    int n = width - x < 4 ? width - x : 4;
+    int s0 = x << half;
+    int s1 = (x + (n > 1)) << half;
+    int s2 = (x + (n > 2 ? 2 : n - 1)) << half;
+    int s3 = (x + n - 1) << half;
+    i32x4 yc;
+    if (half) {
+      yc = (i32x4){y0[s0] + y0[s0 + 1] + y1[s0] + y1[s0 + 1],
+                   y0[s1] + y0[s1 + 1] + y1[s1] + y1[s1 + 1],
+                   y0[s2] + y0[s2 + 1] + y1[s2] + y1[s2 + 1],
+                   y0[s3] + y0[s3 + 1] + y1[s3] + y1[s3 + 1]};
+      yc = (yc + 2) >> 2;
+    } else {
+      yc = (i32x4){y0[s0], y0[s1], y0[s2], y0[s3]};
+    }
+    i32x4 uc = {u[s0 >> cw], u[s1 >> cw], u[s2 >> cw], u[s3 >> cw]};
+    i32x4 vc = {v[s0 >> cw], v[s1 >> cw], v[s2 >> cw], v[s3 >> cw]};
+    i32x4 px = tm_pixels4(tm, yc, uc, vc);
+    memcpy(out + x * 4, &px, (size_t)n * 4);
+  }
+}
+
+static void tm_rows(const MoviToneJob *job, int row0, int row1) {
+  // Constant subsampling/scale per loop so the gathers above compile to
+  // plain loads
+  for (int row = row0; row < row1; row++) {
+    switch (job->half * 2 + job->chroma_w) {
+    case 0: tm_row(job, row, 0, 0); break;
+    case 1: tm_row(job, row, 0, 1); break;
+    case 2: tm_row(job, row, 1, 0); break;
+    default: tm_row(job, row, 1, 1); break;
+    }
+  }
+}
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+// Helper threads (the caller takes bands too). They are spawned on the first
+// HDR frame and count against the mt build's PTHREAD_POOL_SIZE; one that
+// hasn't started yet simply never claims a band, so a blocked main thread
+// can't wait on it.
+#define TM_THREADS 3
+#define TM_BAND_ROWS 16
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int spawned;
+  uint32_t gen;
+  MoviToneJob job;
+  int bands;
+  _Atomic uint64_t next; // gen << 32 | next unclaimed band
+  _Atomic int done;
+} tm_pool = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER};
+
+// The pool runs one job at a time. Conversions can now come from several
+// threads (the JS thread and each pipeline's convert stage, movi_pipeline.c);
+// whoever finds it busy converts its frame alone rather than waiting.
+static pthread_mutex_t tm_job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void tm_run_bands(const MoviToneJob *job, uint32_t gen, int bands) {
+  for (;;) {
+    uint64_t cur = atomic_load(&tm_pool.next);
+    if ((uint32_t)(cur >> 32) != gen || (int)(uint32_t)cur >= bands)
+      return;
+    if (!atomic_compare_exchange_weak(&tm_pool.next, &cur, cur + 1))
+      continue;
+    int row0 = (int)(uint32_t)cur * TM_BAND_ROWS;
+    int row1 = row0 + TM_BAND_ROWS;
+    tm_rows(job, row0, row1 < job->height ? row1 : job->height);
+    atomic_fetch_add(&tm_pool.done, 1);
+  }
+}
+
+static void *tm_worker(void *arg) {
+  (void)arg;
+  uint32_t seen = 0;
+  for (;;) {
+    pthread_mutex_lock(&tm_pool.lock);
+    while (tm_pool.gen == seen)
+      pthread_cond_wait(&tm_pool.wake, &tm_pool.lock);
+    seen = tm_pool.gen;
+    MoviToneJob job = tm_pool.job;
+    int bands = tm_pool.bands;
+    pthread_mutex_unlock(&tm_pool.lock);
+    // A job that finished while this thread was waking has no bands left
+    tm_run_bands(&job, seen, bands);
+  }
+  return NULL;
+}
+
+static void tm_run(const MoviToneJob *job) {
+  if (!movi_threads_supported() || job->height < TM_BAND_ROWS * 2 ||
+      pthread_mutex_trylock(&tm_job_lock) != 0) {
+    tm_rows(job, 0, job->height);
+    return;
+  }
+  if (!tm_pool.spawned) {
+    tm_pool.spawned = 1;
+    for (int i = 0; i < TM_THREADS; i++) {
+      pthread_t t;
+      if (pthread_create(&t, NULL, tm_worker, NULL) != 0)
+        break;
+      pthread_detach(t);
+    }
+  }
+
+  int bands = (job->height + TM_BAND_ROWS - 1) / TM_BAND_ROWS;
+  pthread_mutex_lock(&tm_pool.lock);
+  uint32_t gen = ++tm_pool.gen;
+  tm_pool.job = *job;
+  tm_pool.bands = bands;
+  atomic_store(&tm_pool.done, 0);
+  atomic_store(&tm_pool.next, (uint64_t)gen << 32);
+  pthread_cond_broadcast(&tm_pool.wake);
+  pthread_mutex_unlock(&tm_pool.lock);
+
+  tm_run_bands(job, gen, bands);
+  // Only bands a running helper already claimed are left
+  while (atomic_load(&tm_pool.done) < bands)
+    sched_yield();
+  pthread_mutex_unlock(&tm_job_lock);
+}
+#else
+static void tm_run(const MoviToneJob *job) { tm_rows(job, 0, job->height); }
+#endif
+
+int movi_tonemap_convert(MoviToneMap **tables, int hdr_tonemap,
+                         const AVFrame *src, uint8_t *dst, int dst_linesize,
+                         int width, int height) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src->format);
+  if (!desc || desc->nb_components != 3 ||
+      !(desc->flags & AV_PIX_FMT_FLAG_PLANAR) ||
+      (desc->flags & (AV_PIX_FMT_FLAG_BE | AV_PIX_FMT_FLAG_RGB |
+                      AV_PIX_FMT_FLAG_PAL)))
+    return -1;
+  int depth = desc->comp[0].depth;
+  if ((depth != 10 && depth != 12) || desc->comp[0].step != 2)
+    return -1;
+
+  int half;
+  if (width == src->width && height == src->height)
+    half = 0;
+  else if (width == src->width / 2 && height == src->height / 2 && width > 0 &&
+           height > 0)
+    half = 1;
+  else
+    return -1;
+
+  if (!*tables) {
+    *tables = av_mallocz(sizeof(MoviToneMap));
+    if (!*tables)
+      return -1;
+  }
+  tm_setup(*tables, src, depth, hdr_tonemap);
+
+  MoviToneJob job = {
+      .tm = *tables,
+      .src = src,
+      .dst = dst,
+      .dst_linesize = dst_linesize,
+      .width = width,
+      .height = height,
+      .chroma_w = desc->log2_chroma_w,
+      .chroma_h = desc->log2_chroma_h,
+      .half = half,
+  };
+  tm_run(&job);
+  return 0;
+}
+
+int movi_tonemap_to_rgba(MoviContext *ctx, const AVFrame *src, uint8_t *dst,
+                         int dst_linesize, int width, int height) {
+  return movi_tonemap_convert(&ctx->tonemap, ctx->hdr_tonemap, src, dst,
+                              dst_linesize, width, height);
+}
+
+// Tone-map PQ/HLG frames to SDR BT.709 in movi_get_frame_rgba (1) or keep
+// their transfer for a renderer that handles HDR itself (0, the default).
+EMSCRIPTEN_KEEPALIVE
+void movi_set_hdr_tonemap(MoviContext *ctx, int enable) {
+  if (ctx)
+    ctx->hdr_tonemap = enable ? 1 : 0;
+}
+
+size_t movi_tonemap_size(void) { return sizeof(MoviToneMap); }
+
+void movi_tonemap_free(MoviContext *ctx) {
+  if (!ctx)
+    return;
+  av_freep(&ctx->tonemap);
+}
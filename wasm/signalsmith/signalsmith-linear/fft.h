@@ -1375,6 +1375,8 @@ using ModifiedRealFFT = RealFFT<Sample, splitComputation, true>;
 #	include "./platform/fft-accelerate.h"
 #elif defined(SIGNALSMITH_USE_IPP)
 #	include "./platform/fft-ipp.h"
+#elif defined(SIGNALSMITH_USE_SIMD128) || (defined(__wasm_simd128__) && !defined(SIGNALSMITH_NO_SIMD128))
+#	include "./platform/fft-simd128.h"
 #endif
 
 #endif // include guard
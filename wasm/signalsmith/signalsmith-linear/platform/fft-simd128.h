@@ -0,0 +1,259 @@
+#ifndef SIGNALSMITH_LINEAR_PLATFORM_FFT_SIMD128_H
+#define SIGNALSMITH_LINEAR_PLATFORM_FFT_SIMD128_H
+
+// Four-lane float FFT for WebAssembly SIMD128 (selected in fft.h when building
+// with -msimd128). Same radix-4 decomposition as SimpleFFT's split-complex path,
+// but every butterfly loop runs four complex values at a time using generic
+// vector extensions, which clang lowers to v128 f32x4 ops. No dependency on
+// pffft: its SIMD layers are keyed on x86/ARM/PPC macros, so on wasm32 it
+// would build its scalar path.
+//
+// Lanes run over the contiguous `stride` index wherever stride >= 4; only the
+// outermost pass (stride 1) gathers across butterflies instead.
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+namespace signalsmith { namespace linear {
+
+namespace _impl { namespace simd128 {
+	typedef float V4 __attribute__((vector_size(16)));
+
+	inline V4 load(const float *p) {
+		V4 v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+	inline void store(float *p, V4 v) {
+		std::memcpy(p, &v, sizeof(v));
+	}
+	inline V4 splat(float x) {
+		return V4{x, x, x, x};
+	}
+	inline V4 gather4(const float *p, size_t step) {
+		return V4{p[0], p[step], p[2*step], p[3*step]};
+	}
+}} // namespace
+
+template<>
+struct Pow2FFT<float> {
+	static constexpr bool prefersSplit = true;
+	using Complex = std::complex<float>;
+
+	Pow2FFT(size_t size=0) {
+		resize(size);
+	}
+	// Allow move, but not copy
+	Pow2FFT(const Pow2FFT &other) = delete;
+	Pow2FFT(Pow2FFT &&other) = default;
+
+	void resize(size_t size) {
+		_size = size;
+		twiddleR.resize(size*3/4);
+		twiddleI.resize(size*3/4);
+		for (size_t i = 0; i < size*3/4; ++i) {
+			double phase = -2*M_PI*double(i)/double(size);
+			twiddleR[i] = float(std::cos(phase));
+			twiddleI[i] = float(std::sin(phase));
+		}
+		working.resize(size*2);
+		interleaved.resize(size*4);
+	}
+
+	void fft(const Complex *time, Complex *freq) {
+		complexPass<false>(time, freq);
+	}
+	void fft(const float *inR, const float *inI, float *outR, float *outI) {
+		if (_size <= 1) {
+			*outR = *inR;
+			*outI = *inI;
+			return;
+		}
+		fftPass<false>(_size, 1, inR, inI, outR, outI, working.data(), working.data() + _size);
+	}
+
+	void ifft(const Complex *freq, Complex *time) {
+		complexPass<true>(freq, time);
+	}
+	void ifft(const float *inR, const float *inI, float *outR, float *outI) {
+		if (_size <= 1) {
+			*outR = *inR;
+			*outI = *inI;
+			return;
+		}
+		fftPass<true>(_size, 1, inR, inI, outR, outI, working.data(), working.data() + _size);
+	}
+
+private:
+	using V4 = _impl::simd128::V4;
+
+	size_t _size = 0;
+	std::vector<float> twiddleR, twiddleI;
+	std::vector<float> working;
+	std::vector<float> interleaved; // split scratch for the interleaved API
+
+	// Interleaved callers (prefersSplit says they should be rare): split, run, re-interleave
+	template<bool inverse>
+	void complexPass(const Complex *input, Complex *output) {
+		if (_size <= 1) {
+			*output = *input;
+			return;
+		}
+		float *inR = interleaved.data(), *inI = inR + _size;
+		float *outR = inI + _size, *outI = outR + _size;
+		const float *in = (const float *)input;
+		for (size_t i = 0; i < _size; ++i) {
+			inR[i] = in[2*i];
+			inI[i] = in[2*i + 1];
+		}
+		fftPass<inverse>(_size, 1, inR, inI, outR, outI, working.data(), working.data() + _size);
+		float *out = (float *)output;
+		for (size_t i = 0; i < _size; ++i) {
+			out[2*i] = outR[i];
+			out[2*i + 1] = outI[i];
+		}
+	}
+
+	// [size]-point FFT where each element is a block of [stride] values (as SimpleFFT)
+	template<bool inverse>
+	void fftPass(size_t size, size_t stride, const float *inputR, const float *inputI, float *outputR, float *outputI, float *workingR, float *workingI) const {
+		if (size/4 > 1) {
+			fftPass<inverse>(size/4, stride*4, inputR, inputI, workingR, workingI, outputR, outputI);
+			combine4<inverse>(size, stride, workingR, workingI, outputR, outputI);
+		} else if (size == 4) {
+			combine4<inverse>(4, stride, inputR, inputI, outputR, outputI);
+		} else if (stride%4 == 0) {
+			// 2-point FFT
+			for (size_t s = 0; s < stride; s += 4) {
+				V4 ar = _impl::simd128::load(inputR + s), ai = _impl::simd128::load(inputI + s);
+				V4 br = _impl::simd128::load(inputR + s + stride), bi = _impl::simd128::load(inputI + s + stride);
+				_impl::simd128::store(outputR + s, ar + br);
+				_impl::simd128::store(outputI + s, ai + bi);
+				_impl::simd128::store(outputR + s + stride, ar - br);
+				_impl::simd128::store(outputI + s + stride, ai - bi);
+			}
+		} else {
+			for (size_t s = 0; s < stride; ++s) {
+				float ar = inputR[s], ai = inputI[s];
+				float br = inputR[s + stride], bi = inputI[s + stride];
+				outputR[s] = ar + br;
+				outputI[s] = ai + bi;
+				outputR[s + stride] = ar - br;
+				outputI[s + stride] = ai - bi;
+			}
+		}
+	}
+
+	// One radix-4 butterfly on four lanes; twiddles already split into lanes
+	template<bool inverse>
+	static void butterfly(V4 ar, V4 ai, V4 br, V4 bi, V4 cr, V4 ci, V4 dr, V4 di,
+			V4 tbr, V4 tbi, V4 tcr, V4 tci, V4 tdr, V4 tdi,
+			float *oAr, float *oAi, float *oBr, float *oBi, float *oCr, float *oCi, float *oDr, float *oDi) {
+		V4 bR, bI, cR, cI, dR, dI;
+		if (inverse) { // multiply by the conjugate twiddle
+			bR = br*tbr + bi*tbi; bI = bi*tbr - br*tbi;
+			cR = cr*tcr + ci*tci; cI = ci*tcr - cr*tci;
+			dR = dr*tdr + di*tdi; dI = di*tdr - dr*tdi;
+		} else {
+			bR = br*tbr - bi*tbi; bI = bi*tbr + br*tbi;
+			cR = cr*tcr - ci*tci; cI = ci*tcr + cr*tci;
+			dR = dr*tdr - di*tdi; dI = di*tdr + dr*tdi;
+		}
+		V4 ac0r = ar + cR, ac0i = ai + cI;
+		V4 ac1r = ar - cR, ac1i = ai - cI;
+		V4 bd0r = bR + dR, bd0i = bI + dI;
+		V4 bd1r = inverse ? (bR - dR) : (dR - bR);
+		V4 bd1i = inverse ? (bI - dI) : (dI - bI);
+		// bd1 × i
+		V4 rotR = -bd1i, rotI = bd1r;
+		_impl::simd128::store(oAr, ac0r + bd0r);
+		_impl::simd128::store(oAi, ac0i + bd0i);
+		_impl::simd128::store(oBr, ac1r + rotR);
+		_impl::simd128::store(oBi, ac1i + rotI);
+		_impl::simd128::store(oCr, ac0r - bd0r);
+		_impl::simd128::store(oCi, ac0i - bd0i);
+		_impl::simd128::store(oDr, ac1r - rotR);
+		_impl::simd128::store(oDi, ac1i - rotI);
+	}
+
+	template<bool inverse>
+	void combine4(size_t size, size_t stride, const float *inputR, const float *inputI, float *outputR, float *outputI) const {
+		using namespace _impl::simd128;
+		const size_t quarter = size/4;
+		const size_t twiddleStep = _size/size;
+
+		if (stride%4 == 0) {
+			// Lanes along stride: one twiddle set per butterfly group, broadcast
+			for (size_t i = 0; i < quarter; ++i) {
+				V4 tbr = splat(twiddleR[i*twiddleStep]), tbi = splat(twiddleI[i*twiddleStep]);
+				V4 tcr = splat(twiddleR[i*2*twiddleStep]), tci = splat(twiddleI[i*2*twiddleStep]);
+				V4 tdr = splat(twiddleR[i*3*twiddleStep]), tdi = splat(twiddleI[i*3*twiddleStep]);
+				const float *iAr = inputR + 4*i*stride, *iAi = inputI + 4*i*stride;
+				const float *iBr = iAr + stride, *iBi = iAi + stride;
+				const float *iCr = iBr + stride, *iCi = iBi + stride;
+				const float *iDr = iCr + stride, *iDi = iCi + stride;
+				float *oAr = outputR + i*stride, *oAi = outputI + i*stride;
+				float *oBr = oAr + quarter*stride, *oBi = oAi + quarter*stride;
+				float *oCr = oBr + quarter*stride, *oCi = oBi + quarter*stride;
+				float *oDr = oCr + quarter*stride, *oDi = oCi + quarter*stride;
+				for (size_t s = 0; s < stride; s += 4) {
+					butterfly<inverse>(
+						load(iAr + s), load(iAi + s), load(iBr + s), load(iBi + s),
+						load(iCr + s), load(iCi + s), load(iDr + s), load(iDi + s),
+						tbr, tbi, tcr, tci, tdr, tdi,
+						oAr + s, oAi + s, oBr + s, oBi + s, oCr + s, oCi + s, oDr + s, oDi + s);
+				}
+			}
+		} else if (stride == 1 && quarter%4 == 0) {
+			// Outermost pass: lanes across four consecutive butterflies. Inputs
+			// for butterfly i sit at 4i..4i+3, so each lane set is a stride-4
+			// gather; outputs (i + k*quarter) are contiguous.
+			for (size_t i = 0; i < quarter; i += 4) {
+				const size_t tb = i*twiddleStep, tc = 2*i*twiddleStep, td = 3*i*twiddleStep;
+				const float *r = inputR + 4*i, *im = inputI + 4*i;
+				butterfly<inverse>(
+					gather4(r, 4), gather4(im, 4), gather4(r + 1, 4), gather4(im + 1, 4),
+					gather4(r + 2, 4), gather4(im + 2, 4), gather4(r + 3, 4), gather4(im + 3, 4),
+					gather4(twiddleR.data() + tb, twiddleStep), gather4(twiddleI.data() + tb, twiddleStep),
+					gather4(twiddleR.data() + tc, 2*twiddleStep), gather4(twiddleI.data() + tc, 2*twiddleStep),
+					gather4(twiddleR.data() + td, 3*twiddleStep), gather4(twiddleI.data() + td, 3*twiddleStep),
+					outputR + i, outputI + i, outputR + i + quarter, outputI + i + quarter,
+					outputR + i + 2*quarter, outputI + i + 2*quarter, outputR + i + 3*quarter, outputI + i + 3*quarter);
+			}
+		} else {
+			// Tiny sizes (4 and 8 points): scalar, as SimpleFFT
+			for (size_t i = 0; i < quarter; ++i) {
+				Complex tb = {twiddleR[i*twiddleStep], twiddleI[i*twiddleStep]};
+				Complex tc = {twiddleR[i*2*twiddleStep], twiddleI[i*2*twiddleStep]};
+				Complex td = {twiddleR[i*3*twiddleStep], twiddleI[i*3*twiddleStep]};
+				if (inverse) {
+					tb = std::conj(tb);
+					tc = std::conj(tc);
+					td = std::conj(td);
+				}
+				for (size_t s = 0; s < stride; ++s) {
+					size_t in = 4*i*stride + s;
+					Complex a = {inputR[in], inputI[in]};
+					Complex b = Complex{inputR[in + stride], inputI[in + stride]}*tb;
+					Complex c = Complex{inputR[in + 2*stride], inputI[in + 2*stride]}*tc;
+					Complex d = Complex{inputR[in + 3*stride], inputI[in + 3*stride]}*td;
+					Complex ac0 = a + c, ac1 = a - c;
+					Complex bd0 = b + d, bd1 = inverse ? (b - d) : (d - b);
+					Complex bd1i = {-bd1.imag(), bd1.real()};
+					size_t out = i*stride + s;
+					Complex oA = ac0 + bd0, oB = ac1 + bd1i, oC = ac0 - bd0, oD = ac1 - bd1i;
+					outputR[out] = oA.real(); outputI[out] = oA.imag();
+					outputR[out + quarter*stride] = oB.real(); outputI[out + quarter*stride] = oB.imag();
+					outputR[out + 2*quarter*stride] = oC.real(); outputI[out + 2*quarter*stride] = oC.imag();
+					outputR[out + 3*quarter*stride] = oD.real(); outputI[out + 3*quarter*stride] = oD.imag();
+				}
+			}
+		}
+	}
+};
+
+}} // namespace
+
+#endif // include guard